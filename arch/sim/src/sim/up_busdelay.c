@@ -0,0 +1,62 @@
+/****************************************************************************
+ * arch/sim/src/sim/up_busdelay.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/signal.h>
+
+#include "up_internal.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_busdelay
+ *
+ * Description:
+ *   Spend 'usec' microseconds on a simulated bus.  Long transfers sleep,
+ *   like an interrupt or DMA driven transfer would let the CPU do other
+ *   work.  Short ones busy wait, like a driver polling the controller.
+ *
+ * Input Parameters:
+ *   usec - The time that the transfer takes on the bus.
+ *
+ ****************************************************************************/
+
+void sim_busdelay(uint32_t usec)
+{
+  if (usec >= USEC_PER_TICK)
+    {
+      nxsig_usleep(usec);
+    }
+  else if (usec > 0)
+    {
+      up_udelay(usec);
+    }
+}
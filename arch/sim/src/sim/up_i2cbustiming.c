@@ -0,0 +1,212 @@
+/****************************************************************************
+ * arch/sim/src/sim/up_i2cbustiming.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/i2c/i2c_master.h>
+
+#include "up_internal.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A simulated I2C bus that takes as long as a real bus would:  Each
+ * transfer costs a fixed overhead for the setup and the completion
+ * interrupt, plus the time to clock the START, address, data, ACK and STOP
+ * bits at the frequency of the messages.
+ *
+ * Every address answers as a simple device with 256 byte-wide registers:
+ * The first byte written selects the register and the following bytes are
+ * written to it.  Reads return the registers from the selected one on.
+ */
+
+struct sim_i2ctiming_s
+{
+  struct i2c_master_s dev;   /* Externally visible part of the I2C interface */
+  sem_t exclsem;             /* Only one transfer at a time */
+  uint8_t reg;               /* The selected register */
+  uint8_t regs[256];         /* The registers of the simulated device */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int i2ctiming_transfer(FAR struct i2c_master_s *dev,
+                              FAR struct i2c_msg_s *msgs, int count);
+#ifdef CONFIG_I2C_RESET
+static int i2ctiming_reset(FAR struct i2c_master_s *dev);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct i2c_ops_s g_i2ctiming_ops =
+{
+  .transfer = i2ctiming_transfer,
+#ifdef CONFIG_I2C_RESET
+  .reset    = i2ctiming_reset,
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: i2ctiming_transfer
+ ****************************************************************************/
+
+static int i2ctiming_transfer(FAR struct i2c_master_s *dev,
+                              FAR struct i2c_msg_s *msgs, int count)
+{
+  FAR struct sim_i2ctiming_s *priv = (FAR struct sim_i2ctiming_s *)dev;
+  uint64_t usec = CONFIG_SIM_I2CBUS_TIMING_OVERHEAD;
+  uint32_t nbits;
+  ssize_t i;
+  int ret;
+  int m;
+
+  ret = nxsem_wait_uninterruptible(&priv->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (m = 0; m < count; m++)
+    {
+      FAR struct i2c_msg_s *msg = &msgs[m];
+
+      /* START and address, unless this continues the previous message */
+
+      nbits = msg->length * 9;
+      if ((msg->flags & I2C_M_NOSTART) == 0)
+        {
+          nbits += (msg->flags & I2C_M_TEN) != 0 ? 19 : 10;
+        }
+
+      /* STOP, unless the next message continues or restarts */
+
+      if (m == count - 1 ||
+          ((msg->flags & I2C_M_NOSTOP) == 0 &&
+           (msgs[m + 1].flags & I2C_M_NOSTART) == 0))
+        {
+          nbits++;
+        }
+
+      if (msg->frequency > 0)
+        {
+          usec += (uint64_t)nbits * USEC_PER_SEC / msg->frequency;
+        }
+
+      /* Move the data */
+
+      i = 0;
+      if ((msg->flags & I2C_M_READ) != 0)
+        {
+          for (; i < msg->length; i++)
+            {
+              msg->buffer[i] = priv->regs[priv->reg++];
+            }
+        }
+      else
+        {
+          if ((msg->flags & I2C_M_NOSTART) == 0 && msg->length > 0)
+            {
+              priv->reg = msg->buffer[i++];
+            }
+
+          for (; i < msg->length; i++)
+            {
+              priv->regs[priv->reg++] = msg->buffer[i];
+            }
+        }
+    }
+
+  sim_busdelay(usec);
+  nxsem_post(&priv->exclsem);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: i2ctiming_reset
+ ****************************************************************************/
+
+#ifdef CONFIG_I2C_RESET
+static int i2ctiming_reset(FAR struct i2c_master_s *dev)
+{
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_i2cbus_initialize
+ *
+ * Description:
+ *   Create a simulated I2C bus with realistic timing.  'bus' is not used.
+ *
+ ****************************************************************************/
+
+FAR struct i2c_master_s *sim_i2cbus_initialize(int bus)
+{
+  FAR struct sim_i2ctiming_s *priv;
+
+  priv = kmm_zalloc(sizeof(struct sim_i2ctiming_s));
+  if (priv == NULL)
+    {
+      return NULL;
+    }
+
+  priv->dev.ops = &g_i2ctiming_ops;
+  nxsem_init(&priv->exclsem, 0, 1);
+
+  return &priv->dev;
+}
+
+/****************************************************************************
+ * Name: sim_i2cbus_uninitialize
+ ****************************************************************************/
+
+int sim_i2cbus_uninitialize(FAR struct i2c_master_s *dev)
+{
+  FAR struct sim_i2ctiming_s *priv = (FAR struct sim_i2ctiming_s *)dev;
+
+  nxsem_destroy(&priv->exclsem);
+  kmm_free(priv);
+  return OK;
+}
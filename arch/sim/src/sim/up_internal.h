@@ -96,6 +96,7 @@ struct spi_dev_s;
 struct qspi_dev_s;
 struct ioexpander_dev_s;
 struct i2c_master_s;
+struct sdio_dev_s;
 
 /****************************************************************************
  * Public Data
@@ -366,6 +367,19 @@ struct spi_dev_s *sim_spi_initialize(const char *filename);
 int sim_spi_uninitialize(struct spi_dev_s *dev);
 #endif
 
+/* up_busdelay.c ************************************************************/
+
+#if defined(CONFIG_SIM_I2CBUS_TIMING) || defined(CONFIG_SIM_SPI_TIMING) || \
+    defined(CONFIG_SIM_SDIO)
+void sim_busdelay(uint32_t usec);
+#endif
+
+/* up_sdio.c ****************************************************************/
+
+#ifdef CONFIG_SIM_SDIO
+struct sdio_dev_s *sim_sdio_initialize(int slotno);
+#endif
+
 /* Debug ********************************************************************/
 
 #ifdef CONFIG_STACK_COLORATION
@@ -0,0 +1,786 @@
+/****************************************************************************
+ * arch/sim/src/sim/up_sdio.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/sdio.h>
+
+#include "up_internal.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The card is an SDHC card with 512 byte blocks.  Its capacity is a
+ * multiple of 512KiB, the unit of C_SIZE in a version 2.0 CSD.
+ */
+
+#define SDIO_BLOCKSIZE       512
+#define SDIO_NBLOCKS         ((CONFIG_SIM_SDIO_SIZE / 512) * 1024)
+#define SDIO_RCA             0x1234
+
+/* Card states, as reported in the CURRENT_STATE field of R1 */
+
+#define SDIO_STATE_IDLE      0
+#define SDIO_STATE_READY     1
+#define SDIO_STATE_IDENT     2
+#define SDIO_STATE_STBY      3
+#define SDIO_STATE_TRAN      4
+#define SDIO_STATE_DATA      5
+#define SDIO_STATE_RCV       6
+
+/* Bits of the card status returned in R1 */
+
+#define SDIO_R1_OUTOFRANGE   ((uint32_t)1 << 31)
+#define SDIO_R1_ILLEGALCMD   ((uint32_t)1 << 22)
+#define SDIO_R1_STATE(s)     ((uint32_t)(s) << 9)
+#define SDIO_R1_READY        ((uint32_t)1 << 8)
+#define SDIO_R1_APPCMD       ((uint32_t)1 << 5)
+
+/* OCR returned in R3:  Powered up, high capacity, 2.7-3.6V */
+
+#define SDIO_OCR_BUSY        ((uint32_t)1 << 31)
+#define SDIO_OCR_CCS         ((uint32_t)1 << 30)
+#define SDIO_OCR_VOLTAGES    ((uint32_t)0x00ff8000)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The data transfer started by the last command */
+
+enum sim_sdio_xfer_e
+{
+  SDIO_XFER_NONE = 0,        /* No data transfer */
+  SDIO_XFER_READ,            /* CMD17/18: Blocks from the card */
+  SDIO_XFER_WRITE,           /* CMD24/25: Blocks to the card */
+  SDIO_XFER_SCR              /* ACMD51: The SCR register */
+};
+
+/* A simulated SD card in a slot that is never empty.  The blocks of the
+ * card are kept in RAM.  Each command takes a fixed time for the command
+ * and its response.  Each transfer takes the access time of the card plus
+ * the time to clock the data over the 1- or 4-bit bus.  A write keeps the
+ * card busy programming for a while after the transfer, just like a real
+ * card, so that the cost of many small writes, compared to fewer large
+ * ones, shows up in the throughput of the MMC/SD driver.
+ */
+
+struct sim_sdio_s
+{
+  struct sdio_dev_s dev;     /* Externally visible part of the SDIO interface */
+  FAR uint8_t *data;         /* The blocks of the card */
+  uint32_t frequency;        /* Bus clock frequency (Hz) */
+  uint64_t busyuntil;        /* The time when the card is done programming */
+  uint8_t state;             /* Card state (SDIO_STATE_*) */
+  bool appcmd;               /* The last command was CMD55 */
+  bool widebus;              /* 4-bit bus selected */
+  sdio_eventset_t events;    /* Events enabled by waitenable */
+
+  /* The last command and its response */
+
+  uint32_t cmd;
+  int result;
+  uint32_t response[4];
+
+  /* The pending data transfer */
+
+  uint8_t xfer;              /* See enum sim_sdio_xfer_e */
+  uint32_t block;            /* The first block of the transfer */
+  FAR uint8_t *buffer;       /* Data buffer set up by recvsetup/sendsetup */
+  size_t nbytes;             /* Size of the data buffer */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_MUXBUS
+static int  sim_sdio_lock(FAR struct sdio_dev_s *dev, bool lock);
+#endif
+static void sim_sdio_reset(FAR struct sdio_dev_s *dev);
+static sdio_capset_t sim_sdio_capabilities(FAR struct sdio_dev_s *dev);
+static sdio_statset_t sim_sdio_status(FAR struct sdio_dev_s *dev);
+static void sim_sdio_widebus(FAR struct sdio_dev_s *dev, bool enable);
+static void sim_sdio_clock(FAR struct sdio_dev_s *dev,
+                           enum sdio_clock_e rate);
+static int  sim_sdio_attach(FAR struct sdio_dev_s *dev);
+static int  sim_sdio_sendcmd(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                             uint32_t arg);
+#ifdef CONFIG_SDIO_BLOCKSETUP
+static void sim_sdio_blocksetup(FAR struct sdio_dev_s *dev,
+                                unsigned int blocklen, unsigned int nblocks);
+#endif
+static int  sim_sdio_recvsetup(FAR struct sdio_dev_s *dev,
+                               FAR uint8_t *buffer, size_t nbytes);
+static int  sim_sdio_sendsetup(FAR struct sdio_dev_s *dev,
+                               FAR const uint8_t *buffer, size_t nbytes);
+static int  sim_sdio_cancel(FAR struct sdio_dev_s *dev);
+static int  sim_sdio_waitresponse(FAR struct sdio_dev_s *dev, uint32_t cmd);
+static int  sim_sdio_recvshort(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                               FAR uint32_t *rshort);
+static int  sim_sdio_recvlong(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                              uint32_t rlong[4]);
+static void sim_sdio_waitenable(FAR struct sdio_dev_s *dev,
+                                sdio_eventset_t eventset, uint32_t timeout);
+static sdio_eventset_t sim_sdio_eventwait(FAR struct sdio_dev_s *dev);
+static void sim_sdio_callbackenable(FAR struct sdio_dev_s *dev,
+                                    sdio_eventset_t eventset);
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_HPWORK)
+static int  sim_sdio_registercallback(FAR struct sdio_dev_s *dev,
+                                      worker_t callback, FAR void *arg);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct sdio_dev_s g_sim_sdio_ops =
+{
+#ifdef CONFIG_SDIO_MUXBUS
+  .lock             = sim_sdio_lock,
+#endif
+  .reset            = sim_sdio_reset,
+  .capabilities     = sim_sdio_capabilities,
+  .status           = sim_sdio_status,
+  .widebus          = sim_sdio_widebus,
+  .clock            = sim_sdio_clock,
+  .attach           = sim_sdio_attach,
+  .sendcmd          = sim_sdio_sendcmd,
+#ifdef CONFIG_SDIO_BLOCKSETUP
+  .blocksetup       = sim_sdio_blocksetup,
+#endif
+  .recvsetup        = sim_sdio_recvsetup,
+  .sendsetup        = sim_sdio_sendsetup,
+  .cancel           = sim_sdio_cancel,
+  .waitresponse     = sim_sdio_waitresponse,
+  .recv_r1          = sim_sdio_recvshort,
+  .recv_r2          = sim_sdio_recvlong,
+  .recv_r3          = sim_sdio_recvshort,
+  .recv_r4          = sim_sdio_recvshort,
+  .recv_r5          = sim_sdio_recvshort,
+  .recv_r6          = sim_sdio_recvshort,
+  .recv_r7          = sim_sdio_recvshort,
+  .waitenable       = sim_sdio_waitenable,
+  .eventwait        = sim_sdio_eventwait,
+  .callbackenable   = sim_sdio_callbackenable,
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_HPWORK)
+  .registercallback = sim_sdio_registercallback,
+#endif
+#ifdef CONFIG_SDIO_DMA
+#ifdef CONFIG_ARCH_HAVE_SDIO_PREFLIGHT
+  .dmapreflight     = NULL,
+#endif
+  .dmarecvsetup     = sim_sdio_recvsetup,
+  .dmasendsetup     = sim_sdio_sendsetup,
+#endif
+};
+
+/* The CID:  Manufacturer 0x03, OEM "NX", product "SIMSD", revision 1.0 */
+
+static const uint32_t g_sim_sdio_cid[4] =
+{
+  0x034e5853, 0x494d5344, 0x10000001, 0x00016501
+};
+
+/* The SCR:  SD physical layer 2.0, 1- and 4-bit bus widths.  The SCR is
+ * sent most significant byte first.
+ */
+
+static const uint8_t g_sim_sdio_scr[8] =
+{
+  0x02, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_sdio_now
+ *
+ * Description:
+ *   Return the system time in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t sim_sdio_now(void)
+{
+  struct timespec ts;
+
+  clock_systime_timespec(&ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_waitbusy
+ *
+ * Description:
+ *   Wait until the card is done programming the data of the last write.
+ *
+ ****************************************************************************/
+
+static void sim_sdio_waitbusy(FAR struct sim_sdio_s *priv)
+{
+  uint64_t now = sim_sdio_now();
+
+  if (priv->busyuntil > now)
+    {
+      sim_busdelay(priv->busyuntil - now);
+    }
+}
+
+/****************************************************************************
+ * Name: sim_sdio_csd
+ *
+ * Description:
+ *   Build the version 2.0 CSD of the card.
+ *
+ ****************************************************************************/
+
+static void sim_sdio_csd(uint32_t csd[4])
+{
+  uint32_t csize = SDIO_NBLOCKS / 1024 - 1;
+
+  /* CSD_STRUCTURE=1, TAAC=1ms, TRAN_SPEED=25MHz, READ_BL_LEN=9, C_SIZE,
+   * ERASE_BLK_EN=1, SECTOR_SIZE=127, WRITE_BL_LEN=9.
+   */
+
+  csd[0] = 0x400e0032;
+  csd[1] = 0x5b590000 | (csize >> 16);
+  csd[2] = (csize << 16) | 0x7f80;
+  csd[3] = 0x0a400001;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_lock
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_MUXBUS
+static int sim_sdio_lock(FAR struct sdio_dev_s *dev, bool lock)
+{
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: sim_sdio_reset
+ ****************************************************************************/
+
+static void sim_sdio_reset(FAR struct sdio_dev_s *dev)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->state     = SDIO_STATE_IDLE;
+  priv->appcmd    = false;
+  priv->widebus   = false;
+  priv->frequency = 0;
+  priv->xfer      = SDIO_XFER_NONE;
+  priv->buffer    = NULL;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_capabilities
+ ****************************************************************************/
+
+static sdio_capset_t sim_sdio_capabilities(FAR struct sdio_dev_s *dev)
+{
+  return SDIO_CAPS_4BIT;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_status
+ ****************************************************************************/
+
+static sdio_statset_t sim_sdio_status(FAR struct sdio_dev_s *dev)
+{
+  return SDIO_STATUS_PRESENT;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_widebus
+ ****************************************************************************/
+
+static void sim_sdio_widebus(FAR struct sdio_dev_s *dev, bool enable)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->widebus = enable;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_clock
+ ****************************************************************************/
+
+static void sim_sdio_clock(FAR struct sdio_dev_s *dev,
+                           enum sdio_clock_e rate)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  switch (rate)
+    {
+      case CLOCK_IDMODE:
+        priv->frequency = 400000;
+        break;
+
+      case CLOCK_MMC_TRANSFER:
+        priv->frequency = 20000000;
+        break;
+
+      case CLOCK_SD_TRANSFER_1BIT:
+      case CLOCK_SD_TRANSFER_4BIT:
+        priv->frequency = 25000000;
+        break;
+
+      default:
+        priv->frequency = 0;
+        break;
+    }
+}
+
+/****************************************************************************
+ * Name: sim_sdio_attach
+ ****************************************************************************/
+
+static int sim_sdio_attach(FAR struct sdio_dev_s *dev)
+{
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_sendcmd
+ *
+ * Description:
+ *   Execute a command on the card and prepare its response.  Commands that
+ *   transfer data only record the transfer:  The data moves when the
+ *   transfer is waited for.
+ *
+ ****************************************************************************/
+
+static int sim_sdio_sendcmd(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                            uint32_t arg)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  bool appcmd = priv->appcmd;
+  uint32_t r1;
+
+  /* R1 reports the state in which the card received the command */
+
+  r1 = SDIO_R1_STATE(priv->state) | SDIO_R1_READY;
+  if (appcmd)
+    {
+      r1 |= SDIO_R1_APPCMD;
+    }
+
+  priv->cmd         = cmd;
+  priv->result      = OK;
+  priv->appcmd      = false;
+  priv->response[0] = r1;
+
+  if (appcmd)
+    {
+      /* Application specific commands, following CMD55 */
+
+      switch (cmd & MMCSD_CMDIDX_MASK)
+        {
+          case SD_ACMDIDX41: /* SD_SEND_OP_COND */
+            priv->response[0] = SDIO_OCR_BUSY | SDIO_OCR_VOLTAGES |
+                                (arg & SDIO_OCR_CCS);
+            priv->state       = SDIO_STATE_READY;
+            return OK;
+
+          case SD_ACMDIDX51: /* SEND_SCR */
+            priv->xfer        = SDIO_XFER_SCR;
+            return OK;
+
+          case SD_ACMDIDX6:  /* SET_BUS_WIDTH */
+          case SD_ACMDIDX23: /* SET_WR_BLK_ERASE_COUNT */
+          case SD_ACMDIDX42: /* SET_CLR_CARD_DETECT */
+            return OK;
+
+          default:
+            break;
+        }
+    }
+
+  switch (cmd & MMCSD_CMDIDX_MASK)
+    {
+      case MMCSD_CMDIDX0:  /* GO_IDLE_STATE */
+        sim_sdio_reset(dev);
+        break;
+
+      case MMC_CMDIDX1:    /* SEND_OP_COND: MMC only, no response */
+        priv->result = -ETIMEDOUT;
+        break;
+
+      case MMCSD_CMDIDX2:  /* ALL_SEND_CID */
+      case MMCSD_CMDIDX10: /* SEND_CID */
+        memcpy(priv->response, g_sim_sdio_cid, sizeof(g_sim_sdio_cid));
+        if (priv->state == SDIO_STATE_READY)
+          {
+            priv->state = SDIO_STATE_IDENT;
+          }
+        break;
+
+      case SD_CMDIDX3:     /* SEND_RELATIVE_ADDR: R6 */
+        priv->response[0] = ((uint32_t)SDIO_RCA << 16) | (r1 & 0x1fff);
+        priv->state       = SDIO_STATE_STBY;
+        break;
+
+      case MMCSD_CMDIDX7:  /* SELECT/DESELECT_CARD */
+        priv->state = (arg >> 16) == SDIO_RCA ? SDIO_STATE_TRAN :
+                                                SDIO_STATE_STBY;
+        break;
+
+      case SD_CMDIDX8:     /* SEND_IF_COND: Echo voltage and pattern */
+        priv->response[0] = arg & 0xfff;
+        break;
+
+      case MMCSD_CMDIDX9:  /* SEND_CSD */
+        sim_sdio_csd(priv->response);
+        break;
+
+      case MMCSD_CMDIDX12: /* STOP_TRANSMISSION */
+        priv->xfer  = SDIO_XFER_NONE;
+        priv->state = SDIO_STATE_TRAN;
+        break;
+
+      case MMCSD_CMDIDX13: /* SEND_STATUS */
+
+        /* Report the transfer state only when programming is done */
+
+        sim_sdio_waitbusy(priv);
+        break;
+
+      case MMCSD_CMDIDX4:  /* SET_DSR */
+      case MMCSD_CMDIDX16: /* SET_BLOCKLEN */
+        break;
+
+      case MMCSD_CMDIDX17: /* READ_SINGLE_BLOCK */
+      case MMCSD_CMDIDX18: /* READ_MULTIPLE_BLOCK */
+      case MMCSD_CMDIDX24: /* WRITE_BLOCK */
+      case MMCSD_CMDIDX25: /* WRITE_MULTIPLE_BLOCK */
+        if (arg >= SDIO_NBLOCKS)
+          {
+            priv->response[0] |= SDIO_R1_OUTOFRANGE;
+            break;
+          }
+
+        priv->block = arg;
+        if ((cmd & MMCSD_DATAXFR_MASK) == MMCSD_RDDATAXFR)
+          {
+            priv->xfer  = SDIO_XFER_READ;
+            priv->state = SDIO_STATE_DATA;
+          }
+        else
+          {
+            priv->xfer  = SDIO_XFER_WRITE;
+            priv->state = SDIO_STATE_RCV;
+          }
+        break;
+
+      case SD_CMDIDX55:    /* APP_CMD */
+        priv->appcmd       = true;
+        priv->response[0] |= SDIO_R1_APPCMD;
+        break;
+
+      default:
+        priv->response[0] |= SDIO_R1_ILLEGALCMD;
+        break;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_blocksetup
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_BLOCKSETUP
+static void sim_sdio_blocksetup(FAR struct sdio_dev_s *dev,
+                                unsigned int blocklen, unsigned int nblocks)
+{
+}
+#endif
+
+/****************************************************************************
+ * Name: sim_sdio_recvsetup
+ ****************************************************************************/
+
+static int sim_sdio_recvsetup(FAR struct sdio_dev_s *dev,
+                              FAR uint8_t *buffer, size_t nbytes)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->buffer = buffer;
+  priv->nbytes = nbytes;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_sendsetup
+ ****************************************************************************/
+
+static int sim_sdio_sendsetup(FAR struct sdio_dev_s *dev,
+                              FAR const uint8_t *buffer, size_t nbytes)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->buffer = (FAR uint8_t *)buffer;
+  priv->nbytes = nbytes;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_cancel
+ ****************************************************************************/
+
+static int sim_sdio_cancel(FAR struct sdio_dev_s *dev)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->xfer   = SDIO_XFER_NONE;
+  priv->buffer = NULL;
+  priv->events = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_waitresponse
+ ****************************************************************************/
+
+static int sim_sdio_waitresponse(FAR struct sdio_dev_s *dev, uint32_t cmd)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  sim_busdelay(CONFIG_SIM_SDIO_CMDTIME);
+  return cmd == priv->cmd ? priv->result : -EINVAL;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_recvshort
+ *
+ * Description:
+ *   Return a 48-bit response:  R1, R3, R4, R5, R6 or R7.
+ *
+ ****************************************************************************/
+
+static int sim_sdio_recvshort(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                              FAR uint32_t *rshort)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  if (cmd != priv->cmd)
+    {
+      return -EINVAL;
+    }
+
+  *rshort = priv->response[0];
+  return priv->result;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_recvlong
+ *
+ * Description:
+ *   Return a 136-bit response:  R2.
+ *
+ ****************************************************************************/
+
+static int sim_sdio_recvlong(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                             uint32_t rlong[4])
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  if (cmd != priv->cmd)
+    {
+      return -EINVAL;
+    }
+
+  memcpy(rlong, priv->response, sizeof(priv->response));
+  return priv->result;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_waitenable
+ ****************************************************************************/
+
+static void sim_sdio_waitenable(FAR struct sdio_dev_s *dev,
+                                sdio_eventset_t eventset, uint32_t timeout)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->events = eventset;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_eventwait
+ *
+ * Description:
+ *   Move the data of the pending transfer in the time that it takes on the
+ *   bus.
+ *
+ ****************************************************************************/
+
+static sdio_eventset_t sim_sdio_eventwait(FAR struct sdio_dev_s *dev)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  sdio_eventset_t events = priv->events;
+  FAR uint8_t *blocks;
+  uint64_t usec;
+
+  priv->events = 0;
+
+  if ((events & SDIOWAIT_TRANSFERDONE) == 0)
+    {
+      /* Waiting for the end of programming (SDIOWAIT_WRCOMPLETE) */
+
+      sim_sdio_waitbusy(priv);
+      return events & ~(SDIOWAIT_TIMEOUT | SDIOWAIT_ERROR);
+    }
+
+  if (priv->xfer == SDIO_XFER_NONE || priv->buffer == NULL)
+    {
+      return SDIOWAIT_TIMEOUT;
+    }
+
+  blocks = priv->data + (size_t)priv->block * SDIO_BLOCKSIZE;
+  if (priv->xfer != SDIO_XFER_SCR &&
+      priv->nbytes > (size_t)(SDIO_NBLOCKS - priv->block) * SDIO_BLOCKSIZE)
+    {
+      priv->xfer = SDIO_XFER_NONE;
+      return SDIOWAIT_ERROR;
+    }
+
+  usec = 0;
+  switch (priv->xfer)
+    {
+      case SDIO_XFER_READ:
+        memcpy(priv->buffer, blocks, priv->nbytes);
+        usec = CONFIG_SIM_SDIO_READTIME;
+        break;
+
+      case SDIO_XFER_WRITE:
+        sim_sdio_waitbusy(priv);
+        memcpy(blocks, priv->buffer, priv->nbytes);
+        break;
+
+      case SDIO_XFER_SCR:
+        memcpy(priv->buffer, g_sim_sdio_scr,
+               priv->nbytes < sizeof(g_sim_sdio_scr) ?
+               priv->nbytes : sizeof(g_sim_sdio_scr));
+        break;
+    }
+
+  /* Clock the data over the bus */
+
+  if (priv->frequency > 0)
+    {
+      usec += (uint64_t)priv->nbytes * 8 * USEC_PER_SEC /
+              ((uint64_t)priv->frequency * (priv->widebus ? 4 : 1));
+    }
+
+  sim_busdelay(usec);
+
+  /* The card programs the written data once it has received it all */
+
+  if (priv->xfer == SDIO_XFER_WRITE)
+    {
+      priv->busyuntil = sim_sdio_now() + CONFIG_SIM_SDIO_WRITETIME;
+    }
+
+  if ((priv->cmd & MMCSD_MULTIBLOCK) == 0)
+    {
+      priv->state = SDIO_STATE_TRAN;
+    }
+
+  priv->xfer   = SDIO_XFER_NONE;
+  priv->buffer = NULL;
+  return SDIOWAIT_TRANSFERDONE;
+}
+
+/****************************************************************************
+ * Name: sim_sdio_callbackenable
+ ****************************************************************************/
+
+static void sim_sdio_callbackenable(FAR struct sdio_dev_s *dev,
+                                    sdio_eventset_t eventset)
+{
+  /* The card is never inserted or removed */
+}
+
+/****************************************************************************
+ * Name: sim_sdio_registercallback
+ ****************************************************************************/
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_HPWORK)
+static int sim_sdio_registercallback(FAR struct sdio_dev_s *dev,
+                                     worker_t callback, FAR void *arg)
+{
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_sdio_initialize
+ *
+ * Description:
+ *   Create a simulated SDIO slot holding an SD card in RAM that takes as
+ *   long as a real card to execute commands and transfer data.  'slotno' is
+ *   not used.
+ *
+ ****************************************************************************/
+
+FAR struct sdio_dev_s *sim_sdio_initialize(int slotno)
+{
+  FAR struct sim_sdio_s *priv;
+
+  priv = kmm_zalloc(sizeof(struct sim_sdio_s));
+  if (priv == NULL)
+    {
+      return NULL;
+    }
+
+  priv->data = kmm_zalloc((size_t)SDIO_NBLOCKS * SDIO_BLOCKSIZE);
+  if (priv->data == NULL)
+    {
+      kmm_free(priv);
+      return NULL;
+    }
+
+  memcpy(&priv->dev, &g_sim_sdio_ops, sizeof(struct sdio_dev_s));
+  return &priv->dev;
+}
@@ -0,0 +1,342 @@
+/****************************************************************************
+ * arch/sim/src/sim/up_spitiming.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/spi/spi.h>
+
+#include "up_internal.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A simulated SPI bus that loops the data sent back to the receiver and
+ * takes as long as a real bus would:  Each exchange takes the time to
+ * clock its bits out at the configured frequency, plus a fixed overhead
+ * for the DMA setup and the completion interrupt.  Changing the frequency,
+ * mode or width costs the time to reprogram the controller.
+ */
+
+struct sim_spitiming_s
+{
+  struct spi_dev_s spidev;   /* Externally visible part of the SPI interface */
+  sem_t exclsem;             /* Held while the bus is locked */
+  uint32_t frequency;        /* Requested clock frequency */
+  uint8_t mode;              /* Mode 0,1,2,3 */
+  uint8_t nbits;             /* Width of word in bits (1 to 32) */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int      spitiming_lock(FAR struct spi_dev_s *dev, bool lock);
+static void     spitiming_select(FAR struct spi_dev_s *dev, uint32_t devid,
+                                 bool selected);
+static uint32_t spitiming_setfrequency(FAR struct spi_dev_s *dev,
+                                       uint32_t frequency);
+static void     spitiming_setmode(FAR struct spi_dev_s *dev,
+                                  enum spi_mode_e mode);
+static void     spitiming_setbits(FAR struct spi_dev_s *dev, int nbits);
+static uint8_t  spitiming_status(FAR struct spi_dev_s *dev, uint32_t devid);
+#ifdef CONFIG_SPI_CMDDATA
+static int      spitiming_cmddata(FAR struct spi_dev_s *dev, uint32_t devid,
+                                  bool cmd);
+#endif
+static uint32_t spitiming_send(FAR struct spi_dev_s *dev, uint32_t wd);
+#ifdef CONFIG_SPI_EXCHANGE
+static void     spitiming_exchange(FAR struct spi_dev_s *dev,
+                                   FAR const void *txbuffer,
+                                   FAR void *rxbuffer, size_t nwords);
+#else
+static void     spitiming_sndblock(FAR struct spi_dev_s *dev,
+                                   FAR const void *buffer, size_t nwords);
+static void     spitiming_recvblock(FAR struct spi_dev_s *dev,
+                                    FAR void *buffer, size_t nwords);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct spi_ops_s g_spitiming_ops =
+{
+  .lock              = spitiming_lock,
+  .select            = spitiming_select,
+  .setfrequency      = spitiming_setfrequency,
+  .setmode           = spitiming_setmode,
+  .setbits           = spitiming_setbits,
+  .status            = spitiming_status,
+#ifdef CONFIG_SPI_CMDDATA
+  .cmddata           = spitiming_cmddata,
+#endif
+  .send              = spitiming_send,
+#ifdef CONFIG_SPI_EXCHANGE
+  .exchange          = spitiming_exchange,
+#else
+  .sndblock          = spitiming_sndblock,
+  .recvblock         = spitiming_recvblock,
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spitiming_lock
+ ****************************************************************************/
+
+static int spitiming_lock(FAR struct spi_dev_s *dev, bool lock)
+{
+  FAR struct sim_spitiming_s *priv = (FAR struct sim_spitiming_s *)dev;
+
+  if (lock)
+    {
+      return nxsem_wait_uninterruptible(&priv->exclsem);
+    }
+
+  return nxsem_post(&priv->exclsem);
+}
+
+/****************************************************************************
+ * Name: spitiming_select
+ ****************************************************************************/
+
+static void spitiming_select(FAR struct spi_dev_s *dev, uint32_t devid,
+                             bool selected)
+{
+}
+
+/****************************************************************************
+ * Name: spitiming_setfrequency
+ ****************************************************************************/
+
+static uint32_t spitiming_setfrequency(FAR struct spi_dev_s *dev,
+                                       uint32_t frequency)
+{
+  FAR struct sim_spitiming_s *priv = (FAR struct sim_spitiming_s *)dev;
+
+  if (frequency != priv->frequency)
+    {
+      priv->frequency = frequency;
+      sim_busdelay(CONFIG_SIM_SPI_TIMING_RECONFIG);
+    }
+
+  return frequency;
+}
+
+/****************************************************************************
+ * Name: spitiming_setmode
+ ****************************************************************************/
+
+static void spitiming_setmode(FAR struct spi_dev_s *dev,
+                              enum spi_mode_e mode)
+{
+  FAR struct sim_spitiming_s *priv = (FAR struct sim_spitiming_s *)dev;
+
+  if (mode != priv->mode)
+    {
+      priv->mode = mode;
+      sim_busdelay(CONFIG_SIM_SPI_TIMING_RECONFIG);
+    }
+}
+
+/****************************************************************************
+ * Name: spitiming_setbits
+ ****************************************************************************/
+
+static void spitiming_setbits(FAR struct spi_dev_s *dev, int nbits)
+{
+  FAR struct sim_spitiming_s *priv = (FAR struct sim_spitiming_s *)dev;
+
+  if (nbits != priv->nbits)
+    {
+      priv->nbits = nbits;
+      sim_busdelay(CONFIG_SIM_SPI_TIMING_RECONFIG);
+    }
+}
+
+/****************************************************************************
+ * Name: spitiming_status
+ ****************************************************************************/
+
+static uint8_t spitiming_status(FAR struct spi_dev_s *dev, uint32_t devid)
+{
+  return 0;
+}
+
+/****************************************************************************
+ * Name: spitiming_cmddata
+ ****************************************************************************/
+
+#ifdef CONFIG_SPI_CMDDATA
+static int spitiming_cmddata(FAR struct spi_dev_s *dev, uint32_t devid,
+                             bool cmd)
+{
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: spitiming_transfer
+ *
+ * Description:
+ *   Loop 'nwords' words back from 'txbuffer' to 'rxbuffer' in the time it
+ *   takes on the bus.  Either buffer may be NULL.  Nothing sent reads as
+ *   all ones.
+ *
+ ****************************************************************************/
+
+static void spitiming_transfer(FAR struct sim_spitiming_s *priv,
+                               FAR const void *txbuffer,
+                               FAR void *rxbuffer, size_t nwords)
+{
+  size_t nbytes = nwords * (priv->nbits > 16 ? 4 : priv->nbits > 8 ? 2 : 1);
+  uint64_t nbits = (uint64_t)nwords * priv->nbits;
+
+  if (rxbuffer != NULL)
+    {
+      if (txbuffer != NULL)
+        {
+          memmove(rxbuffer, txbuffer, nbytes);
+        }
+      else
+        {
+          memset(rxbuffer, 0xff, nbytes);
+        }
+    }
+
+  sim_busdelay(CONFIG_SIM_SPI_TIMING_OVERHEAD +
+                  (priv->frequency > 0 ?
+                   nbits * USEC_PER_SEC / priv->frequency : 0));
+}
+
+/****************************************************************************
+ * Name: spitiming_send
+ ****************************************************************************/
+
+static uint32_t spitiming_send(FAR struct spi_dev_s *dev, uint32_t wd)
+{
+  FAR struct sim_spitiming_s *priv = (FAR struct sim_spitiming_s *)dev;
+
+  /* A single word is polled: No DMA overhead */
+
+  if (priv->frequency > 0)
+    {
+      sim_busdelay(priv->nbits * USEC_PER_SEC / priv->frequency);
+    }
+
+  return wd;
+}
+
+/****************************************************************************
+ * Name: spitiming_exchange
+ ****************************************************************************/
+
+#ifdef CONFIG_SPI_EXCHANGE
+static void spitiming_exchange(FAR struct spi_dev_s *dev,
+                               FAR const void *txbuffer,
+                               FAR void *rxbuffer, size_t nwords)
+{
+  spitiming_transfer((FAR struct sim_spitiming_s *)dev, txbuffer, rxbuffer,
+                     nwords);
+}
+
+#else
+/****************************************************************************
+ * Name: spitiming_sndblock
+ ****************************************************************************/
+
+static void spitiming_sndblock(FAR struct spi_dev_s *dev,
+                               FAR const void *buffer, size_t nwords)
+{
+  spitiming_transfer((FAR struct sim_spitiming_s *)dev, buffer, NULL,
+                     nwords);
+}
+
+/****************************************************************************
+ * Name: spitiming_recvblock
+ ****************************************************************************/
+
+static void spitiming_recvblock(FAR struct spi_dev_s *dev,
+                                FAR void *buffer, size_t nwords)
+{
+  spitiming_transfer((FAR struct sim_spitiming_s *)dev, NULL, buffer,
+                     nwords);
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_spi_initialize
+ *
+ * Description:
+ *   Create a simulated SPI bus with realistic timing.  'filename' is not
+ *   used.
+ *
+ ****************************************************************************/
+
+FAR struct spi_dev_s *sim_spi_initialize(FAR const char *filename)
+{
+  FAR struct sim_spitiming_s *priv;
+
+  priv = kmm_zalloc(sizeof(struct sim_spitiming_s));
+  if (priv == NULL)
+    {
+      return NULL;
+    }
+
+  priv->spidev.ops = &g_spitiming_ops;
+  priv->nbits      = 8;
+  nxsem_init(&priv->exclsem, 0, 1);
+
+  return &priv->spidev;
+}
+
+/****************************************************************************
+ * Name: sim_spi_uninitialize
+ ****************************************************************************/
+
+int sim_spi_uninitialize(FAR struct spi_dev_s *dev)
+{
+  FAR struct sim_spitiming_s *priv = (FAR struct sim_spitiming_s *)dev;
+
+  nxsem_destroy(&priv->exclsem);
+  kmm_free(priv);
+  return OK;
+}
@@ -23,11 +23,13 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+#include <nuttx/irq.h>
 #include <nuttx/serial/serial.h>
 #include <nuttx/fs/ioctl.h>
 #include <sys/types.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string.h>
 
 #include "up_internal.h"
 
@@ -95,6 +97,65 @@ static const struct uart_ops_s g_tty_ops =
 };
 #endif
 
+#ifdef CONFIG_SIM_UART_LOOPBACK
+static int  loop_setup(FAR struct uart_dev_s *dev);
+static void loop_shutdown(FAR struct uart_dev_s *dev);
+static int  loop_attach(FAR struct uart_dev_s *dev);
+static void loop_detach(FAR struct uart_dev_s *dev);
+static int  loop_ioctl(FAR struct file *filep, int cmd,
+                       unsigned long arg);
+static int  loop_receive(FAR struct uart_dev_s *dev,
+                         FAR unsigned int *status);
+static void loop_rxint(FAR struct uart_dev_s *dev, bool enable);
+static bool loop_rxavailable(FAR struct uart_dev_s *dev);
+static void loop_dmasend(FAR struct uart_dev_s *dev);
+static void loop_dmareceive(FAR struct uart_dev_s *dev);
+static void loop_dmarxfree(FAR struct uart_dev_s *dev);
+static void loop_dmatxavail(FAR struct uart_dev_s *dev);
+static void loop_send(FAR struct uart_dev_s *dev, int ch);
+static void loop_txint(FAR struct uart_dev_s *dev, bool enable);
+static bool loop_txready(FAR struct uart_dev_s *dev);
+static bool loop_txempty(FAR struct uart_dev_s *dev);
+
+static const struct uart_ops_s g_loop_ops =
+{
+  .setup          = loop_setup,
+  .shutdown       = loop_shutdown,
+  .attach         = loop_attach,
+  .detach         = loop_detach,
+  .ioctl          = loop_ioctl,
+  .receive        = loop_receive,
+  .rxint          = loop_rxint,
+  .rxavailable    = loop_rxavailable,
+  .dmasend        = loop_dmasend,
+  .dmareceive     = loop_dmareceive,
+  .dmarxfree      = loop_dmarxfree,
+  .dmatxavail     = loop_dmatxavail,
+  .send           = loop_send,
+  .txint          = loop_txint,
+  .txready        = loop_txready,
+  .txempty        = loop_txempty,
+};
+
+static char g_loop_rxbuf[CONFIG_SIM_UART_LOOPBACK_BUFSIZE];
+static char g_loop_txbuf[CONFIG_SIM_UART_LOOPBACK_BUFSIZE];
+
+static struct uart_dev_s g_loop_dev =
+{
+  .ops            = &g_loop_ops,
+  .xmit =
+  {
+    .size         = CONFIG_SIM_UART_LOOPBACK_BUFSIZE,
+    .buffer       = g_loop_txbuf,
+  },
+  .recv =
+  {
+    .size         = CONFIG_SIM_UART_LOOPBACK_BUFSIZE,
+    .buffer       = g_loop_rxbuf,
+  },
+};
+#endif
+
 #ifdef USE_DEVCONSOLE
 static char g_console_rxbuf[BUFSIZE];
 static char g_console_txbuf[BUFSIZE];
@@ -490,6 +551,302 @@ static bool tty_txempty(struct uart_dev_s *dev)
 }
 #endif
 
+#ifdef CONFIG_SIM_UART_LOOPBACK
+/****************************************************************************
+ * Name: loop_region
+ *
+ * Description:
+ *   Return the address of the byte at 'offset' in a DMA transfer and the
+ *   number of contiguous bytes from there.
+ *
+ ****************************************************************************/
+
+static FAR char *loop_region(FAR struct uart_dmaxfer_s *xfer,
+                             size_t offset, FAR size_t *len)
+{
+  if (offset < xfer->length)
+    {
+      *len = xfer->length - offset;
+      return xfer->buffer + offset;
+    }
+
+  offset -= xfer->length;
+  *len = xfer->nlength - offset;
+  return xfer->nbuffer + offset;
+}
+
+/****************************************************************************
+ * Name: loop_startrx
+ *
+ * Description:
+ *   Arm the RX DMA if it is not running
+ *
+ ****************************************************************************/
+
+static void loop_startrx(FAR struct uart_dev_s *dev)
+{
+  if (dev->dmarx.length + dev->dmarx.nlength == 0)
+    {
+      uart_recvchars_dma(dev);
+    }
+}
+
+/****************************************************************************
+ * Name: loop_starttx
+ *
+ * Description:
+ *   Start a TX DMA from the TX buffer if no transfer is running
+ *
+ ****************************************************************************/
+
+static void loop_starttx(FAR struct uart_dev_s *dev)
+{
+  if (dev->dmatx.length + dev->dmatx.nlength == 0)
+    {
+      uart_xmitchars_dma(dev);
+    }
+}
+
+/****************************************************************************
+ * Name: loop_dma
+ *
+ * Description:
+ *   The simulated DMA engine.  Copy as much of the running TX transfer as
+ *   the running RX transfer can take and complete the transfers.  The TX
+ *   side stalls while the RX buffer is full, like hardware flow control.
+ *
+ ****************************************************************************/
+
+static void loop_dma(FAR struct uart_dev_s *dev)
+{
+  FAR struct uart_dmaxfer_s *tx = &dev->dmatx;
+  FAR struct uart_dmaxfer_s *rx = &dev->dmarx;
+  FAR char *src;
+  FAR char *dst;
+  irqstate_t flags;
+  size_t nsrc;
+  size_t ndst;
+  size_t n;
+
+  flags = enter_critical_section();
+
+  loop_startrx(dev);
+
+  while (tx->nbytes < tx->length + tx->nlength &&
+         rx->nbytes < rx->length + rx->nlength)
+    {
+      src = loop_region(tx, tx->nbytes, &nsrc);
+      dst = loop_region(rx, rx->nbytes, &ndst);
+      n   = nsrc < ndst ? nsrc : ndst;
+
+      memcpy(dst, src, n);
+      tx->nbytes += n;
+      rx->nbytes += n;
+    }
+
+  if (rx->length + rx->nlength > 0)
+    {
+      if (rx->nbytes == rx->length + rx->nlength)
+        {
+          /* The RX transfer is complete, start the next one */
+
+          uart_recvchars_done(dev);
+          uart_recvchars_dma(dev);
+        }
+      else
+        {
+          /* The transmitter ran dry:  Report an idle line */
+
+          uart_recvchars_update(dev);
+        }
+    }
+
+  if (tx->length + tx->nlength > 0 &&
+      tx->nbytes == tx->length + tx->nlength)
+    {
+      uart_xmitchars_done(dev);
+      loop_starttx(dev);
+    }
+
+  leave_critical_section(flags);
+}
+
+/****************************************************************************
+ * Name: loop_setup
+ ****************************************************************************/
+
+static int loop_setup(FAR struct uart_dev_s *dev)
+{
+  return OK;
+}
+
+/****************************************************************************
+ * Name: loop_shutdown
+ ****************************************************************************/
+
+static void loop_shutdown(FAR struct uart_dev_s *dev)
+{
+}
+
+/****************************************************************************
+ * Name: loop_attach
+ ****************************************************************************/
+
+static int loop_attach(FAR struct uart_dev_s *dev)
+{
+  return OK;
+}
+
+/****************************************************************************
+ * Name: loop_detach
+ ****************************************************************************/
+
+static void loop_detach(FAR struct uart_dev_s *dev)
+{
+}
+
+/****************************************************************************
+ * Name: loop_ioctl
+ ****************************************************************************/
+
+static int loop_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
+{
+  return -ENOTTY;
+}
+
+/****************************************************************************
+ * Name: loop_receive
+ *
+ * Description:
+ *   All data is received by DMA
+ *
+ ****************************************************************************/
+
+static int loop_receive(FAR struct uart_dev_s *dev,
+                        FAR unsigned int *status)
+{
+  *status = 0;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: loop_rxint
+ ****************************************************************************/
+
+static void loop_rxint(FAR struct uart_dev_s *dev, bool enable)
+{
+  if (enable)
+    {
+      loop_startrx(dev);
+    }
+}
+
+/****************************************************************************
+ * Name: loop_rxavailable
+ ****************************************************************************/
+
+static bool loop_rxavailable(FAR struct uart_dev_s *dev)
+{
+  return false;
+}
+
+/****************************************************************************
+ * Name: loop_dmasend
+ *
+ * Description:
+ *   Nothing to do, loop_dma() picks up the transfer described by dmatx
+ *
+ ****************************************************************************/
+
+static void loop_dmasend(FAR struct uart_dev_s *dev)
+{
+}
+
+/****************************************************************************
+ * Name: loop_dmareceive
+ *
+ * Description:
+ *   Nothing to do, loop_dma() picks up the transfer described by dmarx
+ *
+ ****************************************************************************/
+
+static void loop_dmareceive(FAR struct uart_dev_s *dev)
+{
+}
+
+/****************************************************************************
+ * Name: loop_dmarxfree
+ ****************************************************************************/
+
+static void loop_dmarxfree(FAR struct uart_dev_s *dev)
+{
+  loop_startrx(dev);
+}
+
+/****************************************************************************
+ * Name: loop_dmatxavail
+ ****************************************************************************/
+
+static void loop_dmatxavail(FAR struct uart_dev_s *dev)
+{
+  loop_starttx(dev);
+}
+
+/****************************************************************************
+ * Name: loop_send
+ *
+ * Description:
+ *   Loop back one byte written with the interrupts disabled.  The byte is
+ *   dropped if the RX buffer is full.
+ *
+ ****************************************************************************/
+
+static void loop_send(FAR struct uart_dev_s *dev, int ch)
+{
+  FAR struct uart_dmaxfer_s *rx = &dev->dmarx;
+  FAR char *dst;
+  size_t ndst;
+
+  loop_startrx(dev);
+  if (rx->nbytes < rx->length + rx->nlength)
+    {
+      dst  = loop_region(rx, rx->nbytes, &ndst);
+      *dst = ch;
+      rx->nbytes++;
+    }
+}
+
+/****************************************************************************
+ * Name: loop_txint
+ ****************************************************************************/
+
+static void loop_txint(FAR struct uart_dev_s *dev, bool enable)
+{
+  if (enable)
+    {
+      loop_starttx(dev);
+    }
+}
+
+/****************************************************************************
+ * Name: loop_txready
+ ****************************************************************************/
+
+static bool loop_txready(FAR struct uart_dev_s *dev)
+{
+  return true;
+}
+
+/****************************************************************************
+ * Name: loop_txempty
+ ****************************************************************************/
+
+static bool loop_txempty(FAR struct uart_dev_s *dev)
+{
+  return dev->dmatx.length + dev->dmatx.nlength == 0;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -525,6 +882,10 @@ void up_uartinit(void)
 #ifdef CONFIG_SIM_UART3_NAME
   uart_register(CONFIG_SIM_UART3_NAME, &g_tty3_dev);
 #endif
+
+#ifdef CONFIG_SIM_UART_LOOPBACK
+  uart_register(CONFIG_SIM_UART_LOOPBACK_NAME, &g_loop_dev);
+#endif
 }
 
 /****************************************************************************
@@ -567,6 +928,10 @@ void up_uartloop(void)
       uart_recvchars(&g_tty3_dev);
     }
 #endif
+
+#ifdef CONFIG_SIM_UART_LOOPBACK
+  loop_dma(&g_loop_dev);
+#endif
 }
 
 /****************************************************************************
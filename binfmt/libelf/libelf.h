@@ -137,6 +137,22 @@ int elf_findsymtab(FAR struct elf_loadinfo_s *loadinfo);
 int elf_readsym(FAR struct elf_loadinfo_s *loadinfo, int index,
                 FAR Elf_Sym *sym);
 
+/****************************************************************************
+ * Name: elf_loadsymtab
+ *
+ * Description:
+ *   Read the whole symbol table and its string table into memory.
+ *
+ * Returned Value:
+ *   0 (OK) is returned on success and a negated errno is returned on
+ *   failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+int elf_loadsymtab(FAR struct elf_loadinfo_s *loadinfo);
+#endif
+
 /****************************************************************************
  * Name: elf_symvalue
  *
@@ -27,6 +27,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -56,6 +57,14 @@
 # define elf_dumpbuffer(m,b,n)
 #endif
 
+/* Use clock monotonic, if possible, to time the relocations */
+
+#ifdef CONFIG_CLOCK_MONOTONIC
+#  define ELF_CLOCK CLOCK_MONOTONIC
+#else
+#  define ELF_CLOCK CLOCK_REALTIME
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -340,6 +349,17 @@ static int elf_relocate(FAR struct elf_loadinfo_s *loadinfo, int relidx,
         {
           berr("ERROR: Section %d reloc %d: Relocation failed: %d\n",
                relidx, i, ret);
+#ifdef CONFIG_ELF_XIP
+          /* The architecture reports a target out of range as -EINVAL.
+           * Tell elf_bind() that loading without XIP may help.
+           */
+
+          if (ret == -EINVAL && loadinfo->xipbase != 0)
+            {
+              ret = -ERANGE;
+            }
+#endif
+
           break;
         }
     }
@@ -525,6 +545,17 @@ static int elf_relocateadd(FAR struct elf_loadinfo_s *loadinfo, int relidx,
         {
           berr("ERROR: Section %d reloc %d: Relocation failed: %d\n",
                relidx, i, ret);
+#ifdef CONFIG_ELF_XIP
+          /* The architecture reports a target out of range as -EINVAL.
+           * Tell elf_bind() that loading without XIP may help.
+           */
+
+          if (ret == -EINVAL && loadinfo->xipbase != 0)
+            {
+              ret = -ERANGE;
+            }
+#endif
+
           break;
         }
     }
@@ -559,12 +590,20 @@ static int elf_relocateadd(FAR struct elf_loadinfo_s *loadinfo, int relidx,
 int elf_bind(FAR struct elf_loadinfo_s *loadinfo,
              FAR const struct symtab_s *exports, int nexports)
 {
+#ifdef CONFIG_DEBUG_BINFMT_INFO
+  struct timespec start;
+  struct timespec end;
+#endif
 #ifdef CONFIG_ARCH_ADDRENV
   int status;
 #endif
   int ret;
   int i;
 
+#ifdef CONFIG_DEBUG_BINFMT_INFO
+  clock_gettime(ELF_CLOCK, &start);
+#endif
+
   /* Find the symbol and string tables */
 
   ret = elf_findsymtab(loadinfo);
@@ -573,6 +612,19 @@ int elf_bind(FAR struct elf_loadinfo_s *loadinfo,
       return ret;
     }
 
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+  /* Read the symbol and string tables into memory so that resolving the
+   * relocations needs no further file I/O for symbols.  If there is not
+   * enough memory, the tables are read from the file as needed.
+   */
+
+  ret = elf_loadsymtab(loadinfo);
+  if (ret < 0)
+    {
+      bwarn("WARNING: elf_loadsymtab failed: %d\n", ret);
+    }
+#endif
+
   /* Allocate an I/O buffer.  This buffer is used by elf_symname() to
    * accumulate the variable length symbol name.
    */
@@ -672,5 +724,37 @@ int elf_bind(FAR struct elf_loadinfo_s *loadinfo,
 
 #endif
 
+#ifdef CONFIG_ELF_XIP
+  /* A relocation may be unable to reach a section used in place, e.g. a
+   * branch from RAM into the media may be out of range.  Load the program
+   * again with all sections copied to RAM and retry.  Other errors, such
+   * as undefined symbols, would not go away.
+   */
+
+  if (ret == -ERANGE && loadinfo->xipbase != 0)
+    {
+      bwarn("WARNING: Relocation failed, retrying without XIP: %d\n", ret);
+
+      elf_unload(loadinfo);
+      loadinfo->noxip = true;
+
+      ret = elf_load(loadinfo);
+      if (ret < 0)
+        {
+          berr("ERROR: elf_load failed: %d\n", ret);
+          return ret;
+        }
+
+      return elf_bind(loadinfo, exports, nexports);
+    }
+#endif
+
+#ifdef CONFIG_DEBUG_BINFMT_INFO
+  clock_gettime(ELF_CLOCK, &end);
+  binfo("Relocation took %ld us\n",
+        (long)((end.tv_sec - start.tv_sec) * 1000000 +
+               (end.tv_nsec - start.tv_nsec) / 1000));
+#endif
+
   return ret;
 }
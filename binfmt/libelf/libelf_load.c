@@ -25,7 +25,9 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/statfs.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -37,6 +39,8 @@
 #include <nuttx/arch.h>
 #include <nuttx/addrenv.h>
 #include <nuttx/elf.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/binfmt/elf.h>
 
 #include "libelf.h"
@@ -65,6 +69,129 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: elf_xipinit
+ *
+ * Description:
+ *   Get the address of the ELF file if it lies in memory-mapped media, such
+ *   as a ROMFS volume on a device that supports BIOC_XIPBASE.  Other file
+ *   systems, e.g. TMPFS, may also support FIOC_MMAP, but their files can
+ *   be modified or freed while the program runs.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ELF_XIP
+static void elf_xipinit(FAR struct elf_loadinfo_s *loadinfo)
+{
+  FAR struct inode *inode = loadinfo->file.f_inode;
+  FAR void *xipbase = NULL;
+  struct statfs buf;
+  int ret;
+
+  loadinfo->xipbase = 0;
+  if (loadinfo->noxip || !INODE_IS_MOUNTPT(inode) ||
+      inode->u.i_mops->statfs == NULL ||
+      inode->u.i_mops->statfs(inode, &buf) < 0 ||
+      buf.f_type != ROMFS_MAGIC)
+    {
+      return;
+    }
+
+  ret = file_ioctl(&loadinfo->file, FIOC_MMAP,
+                   (unsigned long)((uintptr_t)&xipbase));
+  if (ret >= 0 && xipbase != NULL)
+    {
+      binfo("Executing in place at %p\n", xipbase);
+      loadinfo->xipbase = (uintptr_t)xipbase;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: elf_xipsection
+ *
+ * Description:
+ *   Return true if the section can be used in place in the memory-mapped
+ *   file instead of being copied to RAM.  That is the case for read-only
+ *   sections with data in the file that are suitably aligned in the media
+ *   and that no relocation section modifies.  The media cannot be written,
+ *   so a .text section with external calls is always copied.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ELF_XIP
+static bool elf_xipsection(FAR struct elf_loadinfo_s *loadinfo, int index)
+{
+  FAR Elf_Shdr *shdr = &loadinfo->shdr[index];
+  int i;
+
+  if (loadinfo->xipbase == 0 ||
+      (shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) != SHF_ALLOC ||
+      shdr->sh_type == SHT_NOBITS)
+    {
+      return false;
+    }
+
+  if (shdr->sh_addralign > 1 &&
+      (loadinfo->xipbase + shdr->sh_offset) % shdr->sh_addralign != 0)
+    {
+      return false;
+    }
+
+  for (i = 1; i < loadinfo->ehdr.e_shnum; i++)
+    {
+      FAR Elf_Shdr *relsec = &loadinfo->shdr[i];
+
+      if ((relsec->sh_type == SHT_REL || relsec->sh_type == SHT_RELA) &&
+          relsec->sh_info == index)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+#endif
+
+/****************************************************************************
+ * Name: elf_xipentry
+ *
+ * Description:
+ *   e_entry is an offset into the read-only sections as they would be laid
+ *   out in the .text allocation.  If some of those sections are used in
+ *   place, find the section that holds the entry point and convert the
+ *   offset into an address within that section.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ELF_XIP
+static void elf_xipentry(FAR struct elf_loadinfo_s *loadinfo)
+{
+  size_t textoff = 0;
+  int i;
+
+  for (i = 0; i < loadinfo->ehdr.e_shnum; i++)
+    {
+      FAR Elf_Shdr *shdr = &loadinfo->shdr[i];
+
+      if ((shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) != SHF_ALLOC)
+        {
+          continue;
+        }
+
+      if (loadinfo->ehdr.e_entry >= textoff &&
+          loadinfo->ehdr.e_entry < textoff + shdr->sh_size)
+        {
+          loadinfo->entrypt = shdr->sh_addr +
+                              (loadinfo->ehdr.e_entry - textoff);
+          return;
+        }
+
+      textoff += ELF_ALIGNUP(shdr->sh_size);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: elf_elfsize
  *
@@ -106,6 +233,12 @@ static void elf_elfsize(struct elf_loadinfo_s *loadinfo)
             {
               datasize += ELF_ALIGNUP(shdr->sh_size);
             }
+#ifdef CONFIG_ELF_XIP
+          else if (elf_xipsection(loadinfo, i))
+            {
+              /* The section will be used in place and needs no memory */
+            }
+#endif
           else
             {
               textsize += ELF_ALIGNUP(shdr->sh_size);
@@ -172,6 +305,20 @@ static inline int elf_loadfile(FAR struct elf_loadinfo_s *loadinfo)
           pptr = &text;
         }
 
+#ifdef CONFIG_ELF_XIP
+      /* Use read-only sections in place if possible */
+
+      if (pptr == &text && elf_xipsection(loadinfo, i))
+        {
+          binfo("%d. %08lx->%08lx (XIP)\n", i,
+                (unsigned long)shdr->sh_addr,
+                (unsigned long)(loadinfo->xipbase + shdr->sh_offset));
+
+          shdr->sh_addr = loadinfo->xipbase + shdr->sh_offset;
+          continue;
+        }
+#endif
+
       /* SHT_NOBITS indicates that there is no data in the file for the
        * section.
        */
@@ -249,6 +396,12 @@ int elf_load(FAR struct elf_loadinfo_s *loadinfo)
       goto errout_with_buffers;
     }
 
+#ifdef CONFIG_ELF_XIP
+  /* Check if the file can be executed in place */
+
+  elf_xipinit(loadinfo);
+#endif
+
   /* Determine total size to allocate */
 
   elf_elfsize(loadinfo);
@@ -301,6 +454,16 @@ int elf_load(FAR struct elf_loadinfo_s *loadinfo)
       goto errout_with_addrenv;
     }
 
+  /* Get the address of the entry point */
+
+  loadinfo->entrypt = loadinfo->textalloc + loadinfo->ehdr.e_entry;
+#ifdef CONFIG_ELF_XIP
+  if (loadinfo->xipbase != 0)
+    {
+      elf_xipentry(loadinfo);
+    }
+#endif
+
   /* Load static constructors and destructors. */
 
 #ifdef CONFIG_BINFMT_CONSTRUCTORS
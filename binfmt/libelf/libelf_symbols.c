@@ -30,6 +30,7 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/kmalloc.h>
 #include <nuttx/binfmt/elf.h>
 #include <nuttx/binfmt/symtab.h>
 
@@ -51,7 +52,8 @@
  * Name: elf_symname
  *
  * Description:
- *   Get the symbol name in loadinfo->iobuffer[].
+ *   Get the symbol name, either in the cached string table or, if the
+ *   string table is not cached, in loadinfo->iobuffer[].
  *
  * Returned Value:
  *   0 (OK) is returned on success and a negated errno is returned on
@@ -64,7 +66,7 @@
  ****************************************************************************/
 
 static int elf_symname(FAR struct elf_loadinfo_s *loadinfo,
-                       FAR const Elf_Sym *sym)
+                       FAR const Elf_Sym *sym, FAR const char **name)
 {
   FAR uint8_t *buffer;
   off_t  offset;
@@ -82,6 +84,23 @@ static int elf_symname(FAR struct elf_loadinfo_s *loadinfo,
       return -ESRCH;
     }
 
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+  /* The cached string table is always NUL terminated */
+
+  if (loadinfo->strtab != NULL)
+    {
+      if (sym->st_name >= loadinfo->strtablen)
+        {
+          berr("Symbol name offset out of range\n");
+          return -EINVAL;
+        }
+
+      *name = &loadinfo->strtab[sym->st_name];
+      return OK;
+    }
+#endif
+
+  *name  = (FAR const char *)loadinfo->iobuffer;
   offset = loadinfo->shdr[loadinfo->strtabidx].sh_offset + sym->st_name;
 
   /* Loop until we get the entire symbol name into memory */
@@ -140,6 +159,37 @@ static int elf_symname(FAR struct elf_loadinfo_s *loadinfo,
   return OK;
 }
 
+/****************************************************************************
+ * Name: elf_findexport
+ *
+ * Description:
+ *   Find an exported symbol by name.  If CONFIG_SYMTAB_HASH is selected,
+ *   a hash index over the exported symbols is built on the first lookup
+ *   and used for the rest of the load.
+ *
+ ****************************************************************************/
+
+static FAR const struct symtab_s *
+elf_findexport(FAR struct elf_loadinfo_s *loadinfo, FAR const char *name,
+               FAR const struct symtab_s *exports, int nexports)
+{
+#ifdef CONFIG_SYMTAB_HASH
+  if (exports != NULL && (loadinfo->exphash.symtab != exports ||
+                          loadinfo->exphash.nsyms != nexports))
+    {
+      symtab_hashfree(&loadinfo->exphash);
+      symtab_hashinit(&loadinfo->exphash, exports, nexports);
+    }
+
+  if (exports != NULL && loadinfo->exphash.symtab == exports)
+    {
+      return symtab_hashfind(&loadinfo->exphash, name);
+    }
+#endif
+
+  return symtab_findbyname(exports, name, nexports);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -208,12 +258,20 @@ int elf_readsym(FAR struct elf_loadinfo_s *loadinfo, int index,
 
   /* Verify that the symbol table index lies within symbol table */
 
-  if (index < 0 || index > (symtab->sh_size / sizeof(Elf_Sym)))
+  if (index < 0 || index >= (symtab->sh_size / sizeof(Elf_Sym)))
     {
       berr("Bad relocation symbol index: %d\n", index);
       return -EINVAL;
     }
 
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+  if (loadinfo->symtab != NULL)
+    {
+      memcpy(sym, &loadinfo->symtab[index], sizeof(Elf_Sym));
+      return OK;
+    }
+#endif
+
   /* Get the file offset to the symbol table entry */
 
   offset = symtab->sh_offset + sizeof(Elf_Sym) * index;
@@ -223,6 +281,73 @@ int elf_readsym(FAR struct elf_loadinfo_s *loadinfo, int index,
   return elf_read(loadinfo, (FAR uint8_t *)sym, sizeof(Elf_Sym), offset);
 }
 
+/****************************************************************************
+ * Name: elf_loadsymtab
+ *
+ * Description:
+ *   Read the whole symbol table and its string table into memory so that
+ *   elf_readsym() and the symbol name lookups need no file I/O.  This is
+ *   only an optimization; on failure, the tables continue to be read from
+ *   the file one entry at a time.
+ *
+ * Returned Value:
+ *   0 (OK) is returned on success and a negated errno is returned on
+ *   failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+int elf_loadsymtab(FAR struct elf_loadinfo_s *loadinfo)
+{
+  FAR Elf_Shdr *symtab = &loadinfo->shdr[loadinfo->symtabidx];
+  FAR Elf_Shdr *strtab;
+  int ret;
+
+  if (loadinfo->strtabidx >= loadinfo->ehdr.e_shnum)
+    {
+      berr("Bad string table index: %d\n", loadinfo->strtabidx);
+      return -EINVAL;
+    }
+
+  strtab = &loadinfo->shdr[loadinfo->strtabidx];
+
+  /* Allocate one more byte so that the string table is always terminated */
+
+  loadinfo->symtab = (FAR Elf_Sym *)kmm_malloc(symtab->sh_size);
+  loadinfo->strtab = (FAR char *)kmm_malloc(strtab->sh_size + 1);
+  if (loadinfo->symtab == NULL || loadinfo->strtab == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  ret = elf_read(loadinfo, (FAR uint8_t *)loadinfo->symtab,
+                 symtab->sh_size, symtab->sh_offset);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  ret = elf_read(loadinfo, (FAR uint8_t *)loadinfo->strtab,
+                 strtab->sh_size, strtab->sh_offset);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  loadinfo->strtab[strtab->sh_size] = '\0';
+  loadinfo->strtablen = strtab->sh_size;
+  return OK;
+
+errout:
+  kmm_free(loadinfo->symtab);
+  kmm_free(loadinfo->strtab);
+  loadinfo->symtab = NULL;
+  loadinfo->strtab = NULL;
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: elf_symvalue
  *
@@ -250,6 +375,7 @@ int elf_symvalue(FAR struct elf_loadinfo_s *loadinfo, FAR Elf_Sym *sym,
                  FAR const struct symtab_s *exports, int nexports)
 {
   FAR const struct symtab_s *symbol;
+  FAR const char *name;
   uintptr_t secbase;
   int ret;
 
@@ -275,7 +401,7 @@ int elf_symvalue(FAR struct elf_loadinfo_s *loadinfo, FAR Elf_Sym *sym,
       {
         /* Get the name of the undefined symbol */
 
-        ret = elf_symname(loadinfo, sym);
+        ret = elf_symname(loadinfo, sym, &name);
         if (ret < 0)
           {
             /* There are a few relocations for a few architectures that do
@@ -290,12 +416,10 @@ int elf_symvalue(FAR struct elf_loadinfo_s *loadinfo, FAR Elf_Sym *sym,
 
         /* Check if the base code exports a symbol of this name */
 
-        symbol = symtab_findbyname(exports, (FAR char *)loadinfo->iobuffer,
-                                   nexports);
+        symbol = elf_findexport(loadinfo, name, exports, nexports);
         if (!symbol)
           {
-            berr("SHN_UNDEF: Exported symbol \"%s\" not found\n",
-                 loadinfo->iobuffer);
+            berr("SHN_UNDEF: Exported symbol \"%s\" not found\n", name);
             return -ENOENT;
           }
 
@@ -305,7 +429,7 @@ int elf_symvalue(FAR struct elf_loadinfo_s *loadinfo, FAR Elf_Sym *sym,
 
         binfo("SHN_UNDEF: name=%s "
               "%08" PRIxPTR "+%08" PRIxPTR "=%08" PRIxPTR "\n",
-              loadinfo->iobuffer, (uintptr_t)sym->st_value,
+              name, (uintptr_t)sym->st_value,
               (uintptr_t)symbol->sym_value,
               (uintptr_t)(sym->st_value + symbol->sym_value));
 
@@ -107,5 +107,24 @@ int elf_freebuffers(struct elf_loadinfo_s *loadinfo)
       loadinfo->buflen    = 0;
     }
 
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+  if (loadinfo->symtab)
+    {
+      kmm_free((FAR void *)loadinfo->symtab);
+      loadinfo->symtab    = NULL;
+    }
+
+  if (loadinfo->strtab)
+    {
+      kmm_free((FAR void *)loadinfo->strtab);
+      loadinfo->strtab    = NULL;
+      loadinfo->strtablen = 0;
+    }
+#endif
+
+#ifdef CONFIG_SYMTAB_HASH
+  symtab_hashfree(&loadinfo->exphash);
+#endif
+
   return OK;
 }
@@ -36,6 +36,7 @@
 #include <nuttx/fs/nxffs.h>
 #include <nuttx/fs/hostfs_rpmsg.h>
 #include <nuttx/i2c/i2c_master.h>
+#include <nuttx/mmcsd.h>
 #include <nuttx/spi/spi_transfer.h>
 #include <nuttx/rc/lirc_dev.h>
 #include <nuttx/rc/dummy.h>
@@ -105,6 +106,9 @@ int sim_bringup(void)
 #ifdef CONFIG_SIM_SPI
   FAR struct spi_dev_s *spidev;
 #endif
+#if defined(CONFIG_SIM_SDIO) && defined(CONFIG_MMCSD_SDIO)
+  FAR struct sdio_dev_s *sdio;
+#endif
 
   int ret = OK;
 
@@ -241,6 +245,15 @@ int sim_bringup(void)
               syslog(LOG_ERR, "ERROR: NXFFS initialization failed: %d\n",
                      ret);
             }
+
+#elif defined(CONFIG_FTL_LOG)
+          /* Provide a log-structured block device at /dev/mtdblock0 */
+
+          ret = ftl_initialize(0, mtd);
+          if (ret < 0)
+            {
+              syslog(LOG_ERR, "ERROR: ftl_initialize failed: %d\n", ret);
+            }
 #endif
         }
     }
@@ -429,6 +442,24 @@ int sim_bringup(void)
 #endif /* CONFIG_SYSTEM_SPITOOL */
 #endif /* CONFIG_SIM_SPI */
 
+#if defined(CONFIG_SIM_SDIO) && defined(CONFIG_MMCSD_SDIO)
+  /* Register the simulated SD card as /dev/mmcsd0 */
+
+  sdio = sim_sdio_initialize(0);
+  if (sdio == NULL)
+    {
+      syslog(LOG_ERR, "ERROR: sim_sdio_initialize failed.\n");
+    }
+  else
+    {
+      ret = mmcsd_slotinitialize(0, sdio);
+      if (ret < 0)
+        {
+          syslog(LOG_ERR, "ERROR: mmcsd_slotinitialize failed: %d\n", ret);
+        }
+    }
+#endif
+
 #if defined(CONFIG_INPUT_BUTTONS_LOWER) && defined(CONFIG_SIM_BUTTONS)
   ret = btn_lower_initialize("/dev/buttons");
   if (ret < 0)
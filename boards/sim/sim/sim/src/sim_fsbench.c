@@ -0,0 +1,1285 @@
+/****************************************************************************
+ * boards/sim/sim/sim/src/sim_fsbench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/boardctl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/fs/nxffs.h>
+#include <nuttx/mtd/mtd.h>
+
+#include "up_internal.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifndef CONFIG_SIM_FSBENCH_MTDSIZE
+#  define CONFIG_SIM_FSBENCH_MTDSIZE 512
+#endif
+
+#ifndef CONFIG_SIM_FSBENCH_OPS
+#  define CONFIG_SIM_FSBENCH_OPS 256
+#endif
+
+#if !defined(CONFIG_FS_SMARTFS) || !defined(CONFIG_MTD_SMART)
+#  undef HAVE_SMARTFS
+#else
+#  define HAVE_SMARTFS 1
+#endif
+
+#define FSBENCH_MTDSIZE       (CONFIG_SIM_FSBENCH_MTDSIZE * 1024)
+#define FSBENCH_NOPS          CONFIG_SIM_FSBENCH_OPS
+#define FSBENCH_MOUNTPT       "/mnt/fsbench"
+#define FSBENCH_MTDPATH       "/dev/fsbench"
+#define FSBENCH_SMART_MINOR   7
+#define FSBENCH_PATHMAX       64
+
+/* Workload parameters */
+
+#define FSBENCH_CHURN_FILES   16    /* Files rewritten round robin */
+#define FSBENCH_CHURN_MIN     64    /* Smallest small file */
+#define FSBENCH_CHURN_MAX     1024  /* Largest small file */
+#define FSBENCH_RECORD_SIZE   64    /* Size of one log record */
+#define FSBENCH_SYNC_EVERY    8     /* Records or overwrites per fsync */
+#define FSBENCH_CHUNK_SIZE    256   /* Size of one random overwrite */
+#define FSBENCH_READ_SIZE     16    /* Size of one small read() */
+#define FSBENCH_READ_BATCH    64    /* Small reads timed as one operation */
+#define FSBENCH_BUFSIZE       FSBENCH_CHURN_MAX
+
+/* The metadata workload adds the mkdir and rmdir to its operations */
+
+#define FSBENCH_MAXOPS        (FSBENCH_NOPS + 2)
+
+/* The random overwrite file takes an eighth of the media */
+
+#define FSBENCH_OVERWRITE_SIZE \
+  (FSBENCH_MTDSIZE / 8 / FSBENCH_CHUNK_SIZE * FSBENCH_CHUNK_SIZE)
+
+/* File system capabilities */
+
+#define FSBENCH_DIRS          (1 << 0)  /* Supports directories */
+#define FSBENCH_REWRITE       (1 << 1)  /* Files can be modified in place */
+#define FSBENCH_RENAME        (1 << 2)  /* Supports rename */
+#define FSBENCH_SYNC          (1 << 3)  /* Supports fsync */
+#define FSBENCH_PERSIST       (1 << 4)  /* Keeps the MTD after unmount */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* MTD access counters */
+
+struct fsbench_counts_s
+{
+  uint64_t rdbytes;                     /* Bytes read from the media */
+  uint64_t wrbytes;                     /* Bytes programmed to the media */
+  uint32_t erases;                      /* Erase blocks erased */
+};
+
+/* An MTD device that counts the accesses to the MTD below it */
+
+struct fsbench_mtd_s
+{
+  struct mtd_dev_s mtd;                 /* Externally visible MTD interface */
+  FAR struct mtd_dev_s *lower;          /* The MTD being measured */
+  struct mtd_geometry_s geo;            /* Geometry of the lower MTD */
+  struct fsbench_counts_s counts;       /* Accesses so far */
+#ifndef CONFIG_SIM_FSBENCH_FILEMTD
+  FAR uint8_t *ramstart;                /* Memory of the RAM MTD */
+#endif
+};
+
+/* One of the file systems under test */
+
+struct fsbench_fs_s
+{
+  FAR const char *name;                 /* File system type for mount() */
+  FAR const char *data;                 /* Mount options */
+  uint8_t flags;                        /* See FSBENCH_* capabilities */
+  CODE int (*bind)(FAR struct mtd_dev_s *mtd, FAR const char **source);
+  CODE void (*unbind)(void);
+};
+
+/* The result of one workload */
+
+struct fsbench_result_s
+{
+  uint32_t nops;                        /* Operations completed */
+  uint64_t payload;                     /* File data bytes transferred */
+  uint64_t elapsed;                     /* Total time (nsec) */
+  FAR uint32_t *latency;                /* Latency of each op (usec) */
+  struct fsbench_counts_s counts;       /* MTD accesses of the workload */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+#if defined(CONFIG_FS_LITTLEFS) || defined(CONFIG_FS_SPIFFS)
+static int  fsbench_bind_mtddriver(FAR struct mtd_dev_s *mtd,
+                                   FAR const char **source);
+static void fsbench_unbind_mtddriver(void);
+#endif
+#ifdef HAVE_SMARTFS
+static int  fsbench_bind_smart(FAR struct mtd_dev_s *mtd,
+                               FAR const char **source);
+#endif
+#ifdef CONFIG_FS_NXFFS
+static int  fsbench_bind_nxffs(FAR struct mtd_dev_s *mtd,
+                               FAR const char **source);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct fsbench_fs_s g_fsbench_fs[] =
+{
+#ifdef CONFIG_FS_LITTLEFS
+  {
+    "littlefs", "forceformat",
+    FSBENCH_DIRS | FSBENCH_REWRITE | FSBENCH_RENAME | FSBENCH_SYNC,
+    fsbench_bind_mtddriver, fsbench_unbind_mtddriver
+  },
+#endif
+#ifdef HAVE_SMARTFS
+  {
+    "smartfs", NULL,
+    FSBENCH_DIRS | FSBENCH_REWRITE | FSBENCH_RENAME | FSBENCH_SYNC |
+    FSBENCH_PERSIST,
+    fsbench_bind_smart, NULL
+  },
+#endif
+#ifdef CONFIG_FS_SPIFFS
+  {
+    "spiffs", NULL,
+    FSBENCH_REWRITE | FSBENCH_RENAME | FSBENCH_SYNC,
+    fsbench_bind_mtddriver, fsbench_unbind_mtddriver
+  },
+#endif
+#ifdef CONFIG_FS_NXFFS
+  {
+    "nxffs", NULL,
+    FSBENCH_PERSIST,
+    fsbench_bind_nxffs, NULL
+  },
+#endif
+};
+
+#define FSBENCH_NFS (sizeof(g_fsbench_fs) / sizeof(g_fsbench_fs[0]))
+
+static uint32_t g_fsbench_seed;
+static uint8_t  g_fsbench_buffer[FSBENCH_BUFSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fsbench_erase, fsbench_bread, fsbench_bwrite, fsbench_read,
+ *       fsbench_write and fsbench_ioctl
+ *
+ * Description:
+ *   Count the accesses and pass them on to the lower MTD.
+ *
+ ****************************************************************************/
+
+static int fsbench_erase(FAR struct mtd_dev_s *dev, off_t startblock,
+                         size_t nblocks)
+{
+  FAR struct fsbench_mtd_s *priv = (FAR struct fsbench_mtd_s *)dev;
+  int ret;
+
+  ret = MTD_ERASE(priv->lower, startblock, nblocks);
+  if (ret >= 0)
+    {
+      priv->counts.erases += nblocks;
+    }
+
+  return ret;
+}
+
+static ssize_t fsbench_bread(FAR struct mtd_dev_s *dev, off_t startblock,
+                             size_t nblocks, FAR uint8_t *buffer)
+{
+  FAR struct fsbench_mtd_s *priv = (FAR struct fsbench_mtd_s *)dev;
+  ssize_t ret;
+
+  ret = MTD_BREAD(priv->lower, startblock, nblocks, buffer);
+  if (ret > 0)
+    {
+      priv->counts.rdbytes += (uint64_t)ret * priv->geo.blocksize;
+    }
+
+  return ret;
+}
+
+static ssize_t fsbench_bwrite(FAR struct mtd_dev_s *dev, off_t startblock,
+                              size_t nblocks, FAR const uint8_t *buffer)
+{
+  FAR struct fsbench_mtd_s *priv = (FAR struct fsbench_mtd_s *)dev;
+  ssize_t ret;
+
+  ret = MTD_BWRITE(priv->lower, startblock, nblocks, buffer);
+  if (ret > 0)
+    {
+      priv->counts.wrbytes += (uint64_t)ret * priv->geo.blocksize;
+    }
+
+  return ret;
+}
+
+static ssize_t fsbench_read(FAR struct mtd_dev_s *dev, off_t offset,
+                            size_t nbytes, FAR uint8_t *buffer)
+{
+  FAR struct fsbench_mtd_s *priv = (FAR struct fsbench_mtd_s *)dev;
+  ssize_t ret;
+
+  ret = MTD_READ(priv->lower, offset, nbytes, buffer);
+  if (ret > 0)
+    {
+      priv->counts.rdbytes += ret;
+    }
+
+  return ret;
+}
+
+#ifdef CONFIG_MTD_BYTE_WRITE
+static ssize_t fsbench_write(FAR struct mtd_dev_s *dev, off_t offset,
+                             size_t nbytes, FAR const uint8_t *buffer)
+{
+  FAR struct fsbench_mtd_s *priv = (FAR struct fsbench_mtd_s *)dev;
+  ssize_t ret;
+
+  ret = MTD_WRITE(priv->lower, offset, nbytes, buffer);
+  if (ret > 0)
+    {
+      priv->counts.wrbytes += ret;
+    }
+
+  return ret;
+}
+#endif
+
+static int fsbench_ioctl(FAR struct mtd_dev_s *dev, int cmd,
+                         unsigned long arg)
+{
+  FAR struct fsbench_mtd_s *priv = (FAR struct fsbench_mtd_s *)dev;
+  int ret;
+
+  ret = MTD_IOCTL(priv->lower, cmd, arg);
+  if (ret >= 0 && cmd == MTDIOC_BULKERASE)
+    {
+      priv->counts.erases += priv->geo.neraseblocks;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fsbench_mtd_create
+ *
+ * Description:
+ *   Create the erased MTD that one file system is measured on and wrap it
+ *   in the counting MTD.
+ *
+ ****************************************************************************/
+
+static FAR struct fsbench_mtd_s *fsbench_mtd_create(void)
+{
+  FAR struct fsbench_mtd_s *priv;
+  FAR struct mtd_dev_s *lower;
+  int ret;
+
+#ifdef CONFIG_SIM_FSBENCH_FILEMTD
+  int fd;
+  int i;
+
+  /* Create a backing file of the configured size */
+
+  fd = open(CONFIG_SIM_FSBENCH_FILEMTD_PATH, O_WRONLY | O_CREAT | O_TRUNC,
+            0644);
+  if (fd < 0)
+    {
+      printf("fsbench: Failed to create %s: %d\n",
+             CONFIG_SIM_FSBENCH_FILEMTD_PATH, errno);
+      return NULL;
+    }
+
+  memset(g_fsbench_buffer, CONFIG_FILEMTD_ERASESTATE, FSBENCH_BUFSIZE);
+  for (i = 0; i < FSBENCH_MTDSIZE / FSBENCH_BUFSIZE; i++)
+    {
+      if (write(fd, g_fsbench_buffer, FSBENCH_BUFSIZE) != FSBENCH_BUFSIZE)
+        {
+          printf("fsbench: Failed to write %s: %d\n",
+                 CONFIG_SIM_FSBENCH_FILEMTD_PATH, errno);
+          close(fd);
+          return NULL;
+        }
+    }
+
+  close(fd);
+
+  lower = filemtd_initialize(CONFIG_SIM_FSBENCH_FILEMTD_PATH, 0,
+                             CONFIG_FILEMTD_BLOCKSIZE,
+                             CONFIG_FILEMTD_ERASESIZE);
+  if (lower == NULL)
+    {
+      printf("fsbench: filemtd_initialize failed\n");
+      return NULL;
+    }
+#else
+  FAR uint8_t *start;
+
+  start = (FAR uint8_t *)kmm_malloc(FSBENCH_MTDSIZE);
+  if (start == NULL)
+    {
+      printf("fsbench: Failed to allocate %d bytes of RAM MTD\n",
+             FSBENCH_MTDSIZE);
+      return NULL;
+    }
+
+  lower = rammtd_initialize(start, FSBENCH_MTDSIZE);
+  if (lower == NULL)
+    {
+      printf("fsbench: rammtd_initialize failed\n");
+      kmm_free(start);
+      return NULL;
+    }
+#endif
+
+  priv = (FAR struct fsbench_mtd_s *)
+    kmm_zalloc(sizeof(struct fsbench_mtd_s));
+  if (priv == NULL)
+    {
+      goto errout;
+    }
+
+  ret = MTD_IOCTL(lower, MTDIOC_GEOMETRY, (unsigned long)&priv->geo);
+  if (ret >= 0)
+    {
+      ret = MTD_IOCTL(lower, MTDIOC_BULKERASE, 0);
+    }
+
+  if (ret < 0)
+    {
+      printf("fsbench: Failed to prepare the MTD: %d\n", ret);
+      kmm_free(priv);
+      goto errout;
+    }
+
+  priv->mtd.erase  = fsbench_erase;
+  priv->mtd.bread  = fsbench_bread;
+  priv->mtd.bwrite = fsbench_bwrite;
+  priv->mtd.read   = lower->read != NULL ? fsbench_read : NULL;
+#ifdef CONFIG_MTD_BYTE_WRITE
+  priv->mtd.write  = lower->write != NULL ? fsbench_write : NULL;
+#endif
+  priv->mtd.ioctl  = fsbench_ioctl;
+  priv->mtd.name   = "fsbench";
+  priv->lower      = lower;
+#ifndef CONFIG_SIM_FSBENCH_FILEMTD
+  priv->ramstart   = start;
+#endif
+
+  return priv;
+
+errout:
+#ifdef CONFIG_SIM_FSBENCH_FILEMTD
+  filemtd_teardown(lower);
+#else
+  kmm_free(lower);
+  kmm_free(start);
+#endif
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: fsbench_mtd_destroy
+ ****************************************************************************/
+
+static void fsbench_mtd_destroy(FAR struct fsbench_mtd_s *priv)
+{
+#ifdef CONFIG_SIM_FSBENCH_FILEMTD
+  filemtd_teardown(priv->lower);
+  unlink(CONFIG_SIM_FSBENCH_FILEMTD_PATH);
+#else
+  /* The RAM MTD has no teardown.  Its state structure was allocated by
+   * rammtd_initialize().
+   */
+
+  kmm_free(priv->lower);
+  kmm_free(priv->ramstart);
+#endif
+
+  kmm_free(priv);
+}
+
+/****************************************************************************
+ * Name: fsbench_bind_*
+ *
+ * Description:
+ *   Put the MTD where each file system expects it and return the mount
+ *   source and options.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_FS_LITTLEFS) || defined(CONFIG_FS_SPIFFS)
+static int fsbench_bind_mtddriver(FAR struct mtd_dev_s *mtd,
+                                  FAR const char **source)
+{
+  *source = FSBENCH_MTDPATH;
+  return register_mtddriver(FSBENCH_MTDPATH, mtd, 0755, NULL);
+}
+
+static void fsbench_unbind_mtddriver(void)
+{
+  unregister_mtddriver(FSBENCH_MTDPATH);
+}
+#endif
+
+#ifdef HAVE_SMARTFS
+static int fsbench_bind_smart(FAR struct mtd_dev_s *mtd,
+                              FAR const char **source)
+{
+  static char path[16];
+  FAR struct inode *inode;
+  int ret;
+
+  /* SMART cannot be detached from its MTD again, so the device stays
+   * registered after the benchmark.
+   */
+
+  ret = smart_initialize(FSBENCH_SMART_MINOR, mtd, NULL);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+  snprintf(path, sizeof(path), "/dev/smart%dd1", FSBENCH_SMART_MINOR);
+#else
+  snprintf(path, sizeof(path), "/dev/smart%d", FSBENCH_SMART_MINOR);
+#endif
+
+  /* Low-level format it, like mksmartfs does */
+
+  ret = open_blockdriver(path, 0, &inode);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = inode->u.i_bops->ioctl(inode, BIOC_LLFORMAT,
+                               (CONFIG_MTD_SMART_SECTOR_SIZE << 16) | 1);
+  close_blockdriver(inode);
+
+  *source = path;
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_FS_NXFFS
+static int fsbench_bind_nxffs(FAR struct mtd_dev_s *mtd,
+                              FAR const char **source)
+{
+  /* NXFFS formats the erased volume when it is initialized.  There is only
+   * one NXFFS volume and it keeps the MTD.
+   */
+
+  *source = NULL;
+  return nxffs_initialize(mtd);
+}
+#endif
+
+/****************************************************************************
+ * Name: fsbench_random
+ *
+ * Description:
+ *   A small deterministic pseudo-random generator, so that every file
+ *   system sees the same sequence of operations.
+ *
+ ****************************************************************************/
+
+static uint32_t fsbench_random(void)
+{
+  g_fsbench_seed ^= g_fsbench_seed << 13;
+  g_fsbench_seed ^= g_fsbench_seed >> 17;
+  g_fsbench_seed ^= g_fsbench_seed << 5;
+  return g_fsbench_seed;
+}
+
+/****************************************************************************
+ * Name: fsbench_now
+ *
+ * Description:
+ *   Return the host monotonic time in nanoseconds.  The system timer only
+ *   has tick resolution, which is too coarse for single file operations.
+ *
+ ****************************************************************************/
+
+static inline uint64_t fsbench_now(void)
+{
+  return host_gettime(false);
+}
+
+/****************************************************************************
+ * Name: fsbench_start and fsbench_stop
+ *
+ * Description:
+ *   Bracket one workload: Remember the MTD counters at the start and turn
+ *   them into the counts of the workload at the end.
+ *
+ ****************************************************************************/
+
+static void fsbench_start(FAR struct fsbench_mtd_s *priv,
+                          FAR struct fsbench_result_s *result)
+{
+  result->nops    = 0;
+  result->payload = 0;
+  result->counts  = priv->counts;
+  result->elapsed = fsbench_now();
+}
+
+static void fsbench_stop(FAR struct fsbench_mtd_s *priv,
+                         FAR struct fsbench_result_s *result)
+{
+  result->elapsed         = fsbench_now() - result->elapsed;
+  result->counts.rdbytes  = priv->counts.rdbytes - result->counts.rdbytes;
+  result->counts.wrbytes  = priv->counts.wrbytes - result->counts.wrbytes;
+  result->counts.erases   = priv->counts.erases - result->counts.erases;
+}
+
+/****************************************************************************
+ * Name: fsbench_record
+ *
+ * Description:
+ *   Record the latency of one operation that started at 'start'.
+ *
+ ****************************************************************************/
+
+static void fsbench_record(FAR struct fsbench_result_s *result,
+                           uint64_t start)
+{
+  result->latency[result->nops++] = (fsbench_now() - start) / 1000;
+}
+
+/****************************************************************************
+ * Name: fsbench_writefile
+ *
+ * Description:
+ *   Create 'path' and write 'size' bytes of pattern to it.
+ *
+ ****************************************************************************/
+
+static int fsbench_writefile(FAR const char *path, size_t size)
+{
+  size_t nbytes;
+  int fd;
+
+  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  while (size > 0)
+    {
+      nbytes = size < FSBENCH_BUFSIZE ? size : FSBENCH_BUFSIZE;
+      if (write(fd, g_fsbench_buffer, nbytes) != (ssize_t)nbytes)
+        {
+          int errcode = errno;
+          close(fd);
+          return -errcode;
+        }
+
+      size -= nbytes;
+    }
+
+  return close(fd) < 0 ? -errno : OK;
+}
+
+/****************************************************************************
+ * Name: fsbench_churn
+ *
+ * Description:
+ *   Small file churn:  Replace a set of small files of random size round
+ *   robin, like a configuration store or a cache would.
+ *
+ ****************************************************************************/
+
+static int fsbench_churn(FAR const struct fsbench_fs_s *fs,
+                         FAR struct fsbench_mtd_s *priv,
+                         FAR struct fsbench_result_s *result)
+{
+  char path[FSBENCH_PATHMAX];
+  uint64_t start;
+  size_t size;
+  int ret = OK;
+  int i;
+
+  fsbench_start(priv, result);
+  for (i = 0; i < FSBENCH_NOPS; i++)
+    {
+      snprintf(path, sizeof(path), FSBENCH_MOUNTPT "/churn%02d",
+               i % FSBENCH_CHURN_FILES);
+      size = FSBENCH_CHURN_MIN + fsbench_random() %
+             (FSBENCH_CHURN_MAX - FSBENCH_CHURN_MIN + 1);
+
+      start = fsbench_now();
+      if (unlink(path) < 0 && errno != ENOENT)
+        {
+          ret = -errno;
+          break;
+        }
+
+      ret = fsbench_writefile(path, size);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      fsbench_record(result, start);
+      result->payload += size;
+    }
+
+  fsbench_stop(priv, result);
+
+  for (i = 0; i < FSBENCH_CHURN_FILES; i++)
+    {
+      snprintf(path, sizeof(path), FSBENCH_MOUNTPT "/churn%02d", i);
+      unlink(path);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fsbench_append
+ *
+ * Description:
+ *   Append log:  Append small records to one file and sync it every few
+ *   records.
+ *
+ ****************************************************************************/
+
+static int fsbench_append(FAR const struct fsbench_fs_s *fs,
+                          FAR struct fsbench_mtd_s *priv,
+                          FAR struct fsbench_result_s *result)
+{
+  uint64_t start;
+  int ret = OK;
+  int fd;
+  int i;
+
+  fd = open(FSBENCH_MOUNTPT "/log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  fsbench_start(priv, result);
+  for (i = 0; i < FSBENCH_NOPS; i++)
+    {
+      start = fsbench_now();
+      if (write(fd, g_fsbench_buffer, FSBENCH_RECORD_SIZE) !=
+          FSBENCH_RECORD_SIZE)
+        {
+          ret = -errno;
+          break;
+        }
+
+      if ((fs->flags & FSBENCH_SYNC) != 0 &&
+          (i + 1) % FSBENCH_SYNC_EVERY == 0 && fsync(fd) < 0)
+        {
+          ret = -errno;
+          break;
+        }
+
+      fsbench_record(result, start);
+      result->payload += FSBENCH_RECORD_SIZE;
+    }
+
+  close(fd);
+  fsbench_stop(priv, result);
+
+  unlink(FSBENCH_MOUNTPT "/log");
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fsbench_overwrite
+ *
+ * Description:
+ *   Random overwrite:  Rewrite random aligned chunks of a preallocated file,
+ *   like a database or a key-value store would.
+ *
+ ****************************************************************************/
+
+static int fsbench_overwrite(FAR const struct fsbench_fs_s *fs,
+                             FAR struct fsbench_mtd_s *priv,
+                             FAR struct fsbench_result_s *result)
+{
+  uint64_t start;
+  off_t offset;
+  int ret;
+  int fd;
+  int i;
+
+  /* Create the file outside of the measurement */
+
+  ret = fsbench_writefile(FSBENCH_MOUNTPT "/data", FSBENCH_OVERWRITE_SIZE);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  fd = open(FSBENCH_MOUNTPT "/data", O_RDWR);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  fsbench_start(priv, result);
+  for (i = 0; i < FSBENCH_NOPS; i++)
+    {
+      offset = fsbench_random() %
+               (FSBENCH_OVERWRITE_SIZE / FSBENCH_CHUNK_SIZE) *
+               FSBENCH_CHUNK_SIZE;
+
+      start = fsbench_now();
+      if (lseek(fd, offset, SEEK_SET) != offset ||
+          write(fd, g_fsbench_buffer, FSBENCH_CHUNK_SIZE) !=
+          FSBENCH_CHUNK_SIZE)
+        {
+          ret = -errno;
+          break;
+        }
+
+      if ((fs->flags & FSBENCH_SYNC) != 0 &&
+          (i + 1) % FSBENCH_SYNC_EVERY == 0 && fsync(fd) < 0)
+        {
+          ret = -errno;
+          break;
+        }
+
+      fsbench_record(result, start);
+      result->payload += FSBENCH_CHUNK_SIZE;
+    }
+
+  close(fd);
+  fsbench_stop(priv, result);
+
+  unlink(FSBENCH_MOUNTPT "/data");
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fsbench_smallread
+ *
+ * Description:
+ *   Small reads:  Read a file sequentially in small pieces, as a parser
+ *   reading a configuration file would.  The data is usually cached by the
+ *   file system, so this mostly measures the cost of the read() call
+ *   itself, including the file descriptor lookup.  Batches of reads are
+ *   timed as one operation because a single read is shorter than the
+ *   latency resolution.
+ *
+ ****************************************************************************/
+
+static int fsbench_smallread(FAR const struct fsbench_fs_s *fs,
+                             FAR struct fsbench_mtd_s *priv,
+                             FAR struct fsbench_result_s *result)
+{
+  uint64_t start;
+  ssize_t nread;
+  int ret;
+  int fd;
+  int i;
+  int j;
+
+  /* Create the file outside of the measurement */
+
+  ret = fsbench_writefile(FSBENCH_MOUNTPT "/read", FSBENCH_OVERWRITE_SIZE);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  fd = open(FSBENCH_MOUNTPT "/read", O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  fsbench_start(priv, result);
+  for (i = 0; i < FSBENCH_NOPS; i++)
+    {
+      start = fsbench_now();
+      for (j = 0; j < FSBENCH_READ_BATCH; j++)
+        {
+          nread = read(fd, g_fsbench_buffer, FSBENCH_READ_SIZE);
+          if (nread == 0 && lseek(fd, 0, SEEK_SET) == 0)
+            {
+              nread = read(fd, g_fsbench_buffer, FSBENCH_READ_SIZE);
+            }
+
+          if (nread <= 0)
+            {
+              ret = nread < 0 ? -errno : -EIO;
+              goto errout;
+            }
+
+          result->payload += nread;
+        }
+
+      fsbench_record(result, start);
+    }
+
+errout:
+  close(fd);
+  fsbench_stop(priv, result);
+
+  unlink(FSBENCH_MOUNTPT "/read");
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fsbench_devzero
+ *
+ * Description:
+ *   The small read loop on /dev/zero.  No file system or media is involved,
+ *   so this is the cost of the read() system call alone; the difference to
+ *   the smallread workload is what the file system adds.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DEV_ZERO
+static int fsbench_devzero(FAR struct fsbench_result_s *result)
+{
+  uint64_t start;
+  ssize_t nread;
+  int ret = OK;
+  int fd;
+  int i;
+  int j;
+
+  fd = open("/dev/zero", O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  /* There is no MTD to count, so start the result by hand */
+
+  result->nops    = 0;
+  result->payload = 0;
+  memset(&result->counts, 0, sizeof(result->counts));
+  result->elapsed = fsbench_now();
+
+  for (i = 0; i < FSBENCH_NOPS; i++)
+    {
+      start = fsbench_now();
+      for (j = 0; j < FSBENCH_READ_BATCH; j++)
+        {
+          nread = read(fd, g_fsbench_buffer, FSBENCH_READ_SIZE);
+          if (nread <= 0)
+            {
+              ret = nread < 0 ? -errno : -EIO;
+              goto errout;
+            }
+
+          result->payload += nread;
+        }
+
+      fsbench_record(result, start);
+    }
+
+errout:
+  result->elapsed = fsbench_now() - result->elapsed;
+  close(fd);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: fsbench_metadata
+ *
+ * Description:
+ *   Metadata heavy directory operations:  Create, stat, rename and remove
+ *   empty files.  Each of those is one operation.  Inside a subdirectory
+ *   if the file system has directories.
+ *
+ ****************************************************************************/
+
+static int fsbench_metadata(FAR const struct fsbench_fs_s *fs,
+                            FAR struct fsbench_mtd_s *priv,
+                            FAR struct fsbench_result_s *result)
+{
+  FAR const char *dir = FSBENCH_MOUNTPT;
+  char path[FSBENCH_PATHMAX];
+  char newpath[FSBENCH_PATHMAX];
+  struct stat buf;
+  uint64_t start;
+  int nfiles = FSBENCH_NOPS / 4;
+  int ret = OK;
+  int fd;
+  int i;
+
+  fsbench_start(priv, result);
+
+  if ((fs->flags & FSBENCH_DIRS) != 0)
+    {
+      dir = FSBENCH_MOUNTPT "/dir";
+      start = fsbench_now();
+      if (mkdir(dir, 0755) < 0)
+        {
+          ret = -errno;
+          goto errout;
+        }
+
+      fsbench_record(result, start);
+    }
+
+  for (i = 0; i < nfiles; i++)
+    {
+      snprintf(path, sizeof(path), "%s/entry%03d", dir, i);
+
+      start = fsbench_now();
+      fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0 || close(fd) < 0)
+        {
+          ret = -errno;
+          goto errout;
+        }
+
+      fsbench_record(result, start);
+    }
+
+  for (i = 0; i < nfiles; i++)
+    {
+      snprintf(path, sizeof(path), "%s/entry%03d", dir, i);
+
+      start = fsbench_now();
+      if (stat(path, &buf) < 0)
+        {
+          ret = -errno;
+          goto errout;
+        }
+
+      fsbench_record(result, start);
+    }
+
+  for (i = 0; i < nfiles; i++)
+    {
+      snprintf(path, sizeof(path), "%s/entry%03d", dir, i);
+      if ((fs->flags & FSBENCH_RENAME) != 0)
+        {
+          snprintf(newpath, sizeof(newpath), "%s/moved%03d", dir, i);
+
+          start = fsbench_now();
+          if (rename(path, newpath) < 0)
+            {
+              ret = -errno;
+              goto errout;
+            }
+
+          fsbench_record(result, start);
+          strcpy(path, newpath);
+        }
+
+      start = fsbench_now();
+      if (unlink(path) < 0)
+        {
+          ret = -errno;
+          goto errout;
+        }
+
+      fsbench_record(result, start);
+    }
+
+  if ((fs->flags & FSBENCH_DIRS) != 0)
+    {
+      start = fsbench_now();
+      if (rmdir(dir) < 0)
+        {
+          ret = -errno;
+          goto errout;
+        }
+
+      fsbench_record(result, start);
+    }
+
+errout:
+  fsbench_stop(priv, result);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fsbench_compare
+ ****************************************************************************/
+
+static int fsbench_compare(FAR const void *a, FAR const void *b)
+{
+  uint32_t x = *(FAR const uint32_t *)a;
+  uint32_t y = *(FAR const uint32_t *)b;
+
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/****************************************************************************
+ * Name: fsbench_report
+ *
+ * Description:
+ *   Print one line of results:  Throughput, latency percentiles, MTD
+ *   accesses and write amplification (bytes programmed to the media per
+ *   byte of file data written).  Workloads that write nothing have no
+ *   write amplification.
+ *
+ ****************************************************************************/
+
+static void fsbench_report(FAR const char *name, int ret,
+                           FAR struct fsbench_result_s *result)
+{
+  uint64_t usec = result->elapsed / 1000;
+  uint32_t n = result->nops;
+  FAR uint32_t *lat = result->latency;
+
+  if (usec == 0)
+    {
+      usec = 1;
+    }
+
+  if (n == 0)
+    {
+      printf("  %-9s failed: %d\n", name, ret);
+      return;
+    }
+
+  qsort(lat, n, sizeof(uint32_t), fsbench_compare);
+
+  printf("  %-9s %5" PRIu32 " %7" PRIu64 " %7" PRIu64
+         " %6" PRIu32 " %6" PRIu32 " %6" PRIu32 " %7" PRIu32
+         " %7" PRIu64 " %7" PRIu64 " %6" PRIu32,
+         name, n, result->payload * 1000000 / 1024 / usec,
+         (uint64_t)n * 1000000 / usec,
+         lat[n / 2], lat[n * 9 / 10], lat[n * 99 / 100], lat[n - 1],
+         result->counts.rdbytes / 1024, result->counts.wrbytes / 1024,
+         result->counts.erases);
+
+  if (result->payload > 0 && result->counts.wrbytes > 0)
+    {
+      uint32_t wa = result->counts.wrbytes * 100 / result->payload;
+      printf(" %3" PRIu32 ".%02" PRIu32, wa / 100, wa % 100);
+    }
+  else
+    {
+      printf("     -");
+    }
+
+  if (ret < 0)
+    {
+      printf(" (stopped: %d)", ret);
+    }
+
+  printf("\n");
+}
+
+/****************************************************************************
+ * Name: fsbench_run
+ *
+ * Description:
+ *   Mount one file system on a fresh MTD and run all workloads on it.
+ *
+ ****************************************************************************/
+
+static void fsbench_run(FAR const struct fsbench_fs_s *fs,
+                        FAR struct fsbench_result_s *result)
+{
+  FAR struct fsbench_mtd_s *priv;
+  FAR const char *source;
+  int ret;
+
+  priv = fsbench_mtd_create();
+  if (priv == NULL)
+    {
+      return;
+    }
+
+  printf("\n%s: %" PRIu32 " x %" PRIu32 " byte erase blocks, "
+         "%" PRIu32 " byte pages\n",
+         fs->name, priv->geo.neraseblocks, priv->geo.erasesize,
+         priv->geo.blocksize);
+
+  ret = fs->bind(&priv->mtd, &source);
+  if (ret < 0)
+    {
+      printf("  Failed to prepare the MTD: %d\n", ret);
+      goto errout;
+    }
+
+  ret = mount(source, FSBENCH_MOUNTPT, fs->name, 0, fs->data);
+  if (ret < 0)
+    {
+      printf("  Failed to mount: %d\n", errno);
+      goto errout_with_bind;
+    }
+
+  printf("  workload    ops   KiB/s   ops/s  p50us  p90us  p99us   maxus"
+         "  rd-KiB  wr-KiB erases     WA\n");
+
+  ret = fsbench_churn(fs, priv, result);
+  fsbench_report("churn", ret, result);
+
+  ret = fsbench_append(fs, priv, result);
+  fsbench_report("append", ret, result);
+
+  if ((fs->flags & FSBENCH_REWRITE) != 0)
+    {
+      ret = fsbench_overwrite(fs, priv, result);
+      fsbench_report("overwrite", ret, result);
+    }
+  else
+    {
+      printf("  %-9s not supported\n", "overwrite");
+    }
+
+  ret = fsbench_smallread(fs, priv, result);
+  fsbench_report("smallread", ret, result);
+
+  ret = fsbench_metadata(fs, priv, result);
+  fsbench_report("metadata", ret, result);
+
+  umount(FSBENCH_MOUNTPT);
+
+errout_with_bind:
+  if (fs->unbind != NULL)
+    {
+      fs->unbind();
+    }
+
+errout:
+  if ((fs->flags & FSBENCH_PERSIST) == 0)
+    {
+      fsbench_mtd_destroy(priv);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fsbench_main
+ *
+ * Description:
+ *   Benchmark each configured flash file system on the same simulated
+ *   FLASH and with the same workloads.  Select it as the user entry point
+ *   (CONFIG_USER_ENTRYPOINT="fsbench_main").  An optional argument selects
+ *   a single file system by name, or "devzero" for the read() loop on
+ *   /dev/zero alone.
+ *
+ ****************************************************************************/
+
+int fsbench_main(int argc, FAR char *argv[])
+{
+  struct fsbench_result_s result;
+  int i;
+
+  result.latency = malloc(FSBENCH_MAXOPS * sizeof(uint32_t));
+  if (result.latency == NULL)
+    {
+      printf("fsbench: Failed to allocate the latency buffer\n");
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < FSBENCH_BUFSIZE; i++)
+    {
+      g_fsbench_buffer[i] = (uint8_t)i;
+    }
+
+  printf("fsbench: %d KiB %s, %d operations per workload\n",
+         CONFIG_SIM_FSBENCH_MTDSIZE,
+#ifdef CONFIG_SIM_FSBENCH_FILEMTD
+         "filemtd",
+#else
+         "rammtd",
+#endif
+         FSBENCH_NOPS);
+
+#ifdef CONFIG_DEV_ZERO
+  if (argc < 2 || strcmp(argv[1], "devzero") == 0)
+    {
+      int ret;
+
+      printf("\n/dev/zero: read() without a file system\n");
+      printf("  workload    ops   KiB/s   ops/s  p50us  p90us  p99us   maxus"
+             "  rd-KiB  wr-KiB erases     WA\n");
+
+      ret = fsbench_devzero(&result);
+      fsbench_report("devzero", ret, &result);
+    }
+#endif
+
+  for (i = 0; i < FSBENCH_NFS; i++)
+    {
+      if (argc > 1 && strcmp(argv[1], g_fsbench_fs[i].name) != 0)
+        {
+          continue;
+        }
+
+      g_fsbench_seed = 0x2545f491;
+      fsbench_run(&g_fsbench_fs[i], &result);
+    }
+
+  free(result.latency);
+
+#ifdef CONFIG_BOARDCTL_POWEROFF
+  /* Leave the simulation so that the benchmark can be scripted */
+
+  boardctl(BOARDIOC_POWEROFF, 0);
+#endif
+
+  return EXIT_SUCCESS;
+}
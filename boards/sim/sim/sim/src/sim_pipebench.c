@@ -0,0 +1,312 @@
+/****************************************************************************
+ * boards/sim/sim/sim/src/sim_pipebench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/boardctl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <nuttx/fs/ioctl.h>
+
+#include "up_internal.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifndef CONFIG_SIM_PIPEBENCH_KBYTES
+#  define CONFIG_SIM_PIPEBENCH_KBYTES 4096
+#endif
+
+#define PIPEBENCH_NBYTES      ((size_t)CONFIG_SIM_PIPEBENCH_KBYTES * 1024)
+#define PIPEBENCH_MAXCHUNK    4096
+#define PIPEBENCH_NULLDEV     "/dev/null"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The writer side of one run */
+
+struct pipebench_writer_s
+{
+  int fd;                               /* Write end of the pipe */
+  size_t chunk;                         /* Bytes per write() */
+  int ret;                              /* Result of the writer */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const size_t g_pipebench_chunks[] =
+{
+  16, 256, PIPEBENCH_MAXCHUNK
+};
+
+#define PIPEBENCH_NCHUNKS \
+  (sizeof(g_pipebench_chunks) / sizeof(g_pipebench_chunks[0]))
+
+static uint8_t g_pipebench_wrbuf[PIPEBENCH_MAXCHUNK];
+static uint8_t g_pipebench_rdbuf[PIPEBENCH_MAXCHUNK];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pipebench_now
+ *
+ * Description:
+ *   Return the host monotonic time in nanoseconds.
+ *
+ ****************************************************************************/
+
+static inline uint64_t pipebench_now(void)
+{
+  return host_gettime(false);
+}
+
+/****************************************************************************
+ * Name: pipebench_writer
+ *
+ * Description:
+ *   Write PIPEBENCH_NBYTES to the pipe in chunks, then close the write end
+ *   so that the reader sees the end of file.
+ *
+ ****************************************************************************/
+
+static FAR void *pipebench_writer(FAR void *arg)
+{
+  FAR struct pipebench_writer_s *writer = arg;
+  size_t remaining = PIPEBENCH_NBYTES;
+  size_t nbytes;
+  ssize_t nwritten;
+
+  writer->ret = OK;
+  while (remaining > 0)
+    {
+      nbytes   = remaining < writer->chunk ? remaining : writer->chunk;
+      nwritten = write(writer->fd, g_pipebench_wrbuf, nbytes);
+      if (nwritten <= 0)
+        {
+          writer->ret = nwritten < 0 ? -errno : -EIO;
+          break;
+        }
+
+      remaining -= nwritten;
+    }
+
+  close(writer->fd);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: pipebench_run
+ *
+ * Description:
+ *   Move PIPEBENCH_NBYTES through a new pipe from a writer thread to the
+ *   calling thread and print the throughput.  The reader either read()s
+ *   'chunk' bytes at a time or, with 'splice', moves the data straight
+ *   from the pipe buffer to /dev/null with sendfile().
+ *
+ ****************************************************************************/
+
+static void pipebench_run(FAR const char *name, size_t chunk, bool spsc,
+                          bool splice)
+{
+  struct pipebench_writer_s writer;
+  pthread_t thread;
+  uint64_t elapsed;
+  uint64_t total = 0;
+  ssize_t nread;
+  int nullfd = -1;
+  int fd[2];
+  int ret;
+
+  if (pipe(fd) < 0)
+    {
+      printf("  %-8s %5zu failed to create the pipe: %d\n",
+             name, chunk, errno);
+      return;
+    }
+
+  if (spsc && ioctl(fd[0], PIPEIOC_SPSC, 1) < 0)
+    {
+      printf("  %-8s %5zu PIPEIOC_SPSC failed: %d\n", name, chunk, errno);
+      goto errout;
+    }
+
+  if (splice)
+    {
+      nullfd = open(PIPEBENCH_NULLDEV, O_WRONLY);
+      if (nullfd < 0)
+        {
+          printf("  %-8s %5zu failed to open %s: %d\n",
+                 name, chunk, PIPEBENCH_NULLDEV, errno);
+          goto errout;
+        }
+    }
+
+  writer.fd    = fd[1];
+  writer.chunk = chunk;
+
+  elapsed = pipebench_now();
+  ret = pthread_create(&thread, NULL, pipebench_writer, &writer);
+  if (ret != 0)
+    {
+      printf("  %-8s %5zu failed to start the writer: %d\n",
+             name, chunk, ret);
+      goto errout;
+    }
+
+  /* The write end now belongs to the writer */
+
+  fd[1] = -1;
+
+  for (; ; )
+    {
+      if (splice)
+        {
+          nread = sendfile(nullfd, fd[0], NULL, chunk);
+        }
+      else
+        {
+          nread = read(fd[0], g_pipebench_rdbuf, chunk);
+        }
+
+      if (nread <= 0)
+        {
+          break;
+        }
+
+      total += nread;
+    }
+
+  /* Closing the read end also releases a writer that is still blocked if
+   * the reader stopped early.
+   */
+
+  close(fd[0]);
+  fd[0] = -1;
+
+  pthread_join(thread, NULL);
+  elapsed = pipebench_now() - elapsed;
+  if (elapsed < 1000)
+    {
+      elapsed = 1000;
+    }
+
+  printf("  %-8s %5zu %8" PRIu64 " %10" PRIu64,
+         name, chunk, total / 1024,
+         total * 1000000 / 1024 / (elapsed / 1000));
+
+  if (total != PIPEBENCH_NBYTES || writer.ret < 0)
+    {
+      printf(" (stopped: %d)", writer.ret < 0 ? writer.ret : (int)nread);
+    }
+
+  printf("\n");
+
+errout:
+  if (nullfd >= 0)
+    {
+      close(nullfd);
+    }
+
+  if (fd[1] >= 0)
+    {
+      close(fd[1]);
+    }
+
+  if (fd[0] >= 0)
+    {
+      close(fd[0]);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pipebench_main
+ *
+ * Description:
+ *   Measure the pipe throughput between two threads for several transfer
+ *   sizes:  With all accesses serialized, in single reader/writer mode and
+ *   with the reader splicing the data out of the pipe.  Select it as the
+ *   user entry point (CONFIG_USER_ENTRYPOINT="pipebench_main").
+ *
+ ****************************************************************************/
+
+int pipebench_main(int argc, FAR char *argv[])
+{
+  int i;
+
+  for (i = 0; i < PIPEBENCH_MAXCHUNK; i++)
+    {
+      g_pipebench_wrbuf[i] = (uint8_t)i;
+    }
+
+  printf("pipebench: %d KiB per run, %d byte pipe buffer\n",
+         CONFIG_SIM_PIPEBENCH_KBYTES, CONFIG_DEV_PIPE_SIZE);
+  printf("  mode     chunk      KiB      KiB/s\n");
+
+  for (i = 0; i < PIPEBENCH_NCHUNKS; i++)
+    {
+      pipebench_run("locked", g_pipebench_chunks[i], false, false);
+    }
+
+  for (i = 0; i < PIPEBENCH_NCHUNKS; i++)
+    {
+      pipebench_run("spsc", g_pipebench_chunks[i], true, false);
+    }
+
+  for (i = 0; i < PIPEBENCH_NCHUNKS; i++)
+    {
+      pipebench_run("splice", g_pipebench_chunks[i], false, true);
+    }
+
+#ifdef CONFIG_BOARDCTL_POWEROFF
+  /* Leave the simulation so that the benchmark can be scripted */
+
+  boardctl(BOARDIOC_POWEROFF, 0);
+#endif
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1058 @@
+/****************************************************************************
+ * drivers/bcache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <queue.h>
+#include <sched.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/fs/procfs.h>
+#include <nuttx/drivers/bcache.h>
+
+#ifdef CONFIG_DRVR_BCACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_DRVR_BCACHE_NSECTORS
+#  define CONFIG_DRVR_BCACHE_NSECTORS 32
+#endif
+
+#ifndef CONFIG_DRVR_BCACHE_READAHEAD
+#  define CONFIG_DRVR_BCACHE_READAHEAD 4
+#endif
+
+#ifndef CONFIG_DRVR_BCACHE_FLUSHDELAY
+#  ifdef CONFIG_SCHED_LPWORK
+#    define CONFIG_DRVR_BCACHE_FLUSHDELAY 1000
+#  else
+#    define CONFIG_DRVR_BCACHE_FLUSHDELAY 0
+#  endif
+#endif
+
+#if CONFIG_DRVR_BCACHE_FLUSHDELAY > 0 && !defined(CONFIG_SCHED_LPWORK)
+#  error CONFIG_DRVR_BCACHE_FLUSHDELAY requires CONFIG_SCHED_LPWORK
+#endif
+
+/* Requests larger than this many sectors bypass the cache so that one big
+ * transfer does not flush everything else out of it.
+ */
+
+#define BCACHE_BYPASS(dev)   ((dev)->nentries / 2)
+
+#define BCACHE_LINELEN       80
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One cached sector */
+
+struct bcache_entry_s
+{
+  dq_entry_t lru;                      /* LRU list link, must be first */
+  FAR struct bcache_entry_s *hnext;    /* Hash chain */
+  blkcnt_t sector;                     /* The sector held in this entry */
+  bool valid;                          /* True: sector holds valid data */
+  bool dirty;                          /* True: not yet written to media */
+  FAR uint8_t *data;                   /* Sector data */
+};
+
+/* Cache statistics */
+
+struct bcache_stats_s
+{
+  uint32_t hits;                       /* Sectors read from the cache */
+  uint32_t misses;                     /* Sectors read from the media */
+  uint32_t readahead;                  /* Sectors read ahead of a miss */
+  uint32_t bypass;                     /* Sectors transferred uncached */
+  uint32_t writebacks;                 /* Sectors written to the media */
+  uint32_t evictions;                  /* Valid sectors evicted */
+};
+
+/* The state of one caching block driver */
+
+struct bcache_dev_s
+{
+  FAR struct bcache_dev_s *flink;      /* Supports a singly linked list */
+  FAR struct inode *inode;             /* The cached block driver */
+  FAR char *name;                      /* Path of the caching driver */
+  sem_t exclsem;                       /* Exclusive access to the cache */
+  blkcnt_t nsectors;                   /* Number of sectors on the media */
+  uint16_t sectsize;                   /* Size of one sector */
+  uint16_t nentries;                   /* Number of cached sectors */
+  uint16_t hmask;                      /* Hash table size - 1 */
+  uint16_t nstaging;                   /* Sectors in the staging buffer */
+  uint8_t crefs;                       /* Open reference count */
+  dq_queue_t lru;                      /* Least recently used at the head */
+  FAR struct bcache_entry_s **hash;    /* Hash of cached sectors */
+  FAR struct bcache_entry_s *entries;  /* The cached sectors */
+  FAR uint8_t *staging;                /* Read-ahead buffer */
+  FAR uint8_t *wrbuf;                  /* Write-back buffer */
+#if CONFIG_DRVR_BCACHE_FLUSHDELAY > 0
+  struct work_s work;                  /* Deferred write-back */
+#endif
+  struct bcache_stats_s stats;         /* Cache statistics */
+};
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+/* This structure describes one open "file" */
+
+struct bcache_file_s
+{
+  struct procfs_file_s base;           /* Base open file structure */
+  char line[BCACHE_LINELEN];           /* Pre-allocated buffer for lines */
+};
+#endif
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     bcache_open(FAR struct inode *inode);
+static int     bcache_close(FAR struct inode *inode);
+static ssize_t bcache_read(FAR struct inode *inode,
+                 FAR unsigned char *buffer, blkcnt_t start_sector,
+                 unsigned int nsectors);
+static ssize_t bcache_write(FAR struct inode *inode,
+                 FAR const unsigned char *buffer, blkcnt_t start_sector,
+                 unsigned int nsectors);
+static int     bcache_geometry(FAR struct inode *inode,
+                 FAR struct geometry *geometry);
+static int     bcache_ioctl(FAR struct inode *inode, int cmd,
+                 unsigned long arg);
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+static int     bcache_procfs_open(FAR struct file *filep,
+                 FAR const char *relpath, int oflags, mode_t mode);
+static int     bcache_procfs_close(FAR struct file *filep);
+static ssize_t bcache_procfs_read(FAR struct file *filep,
+                 FAR char *buffer, size_t buflen);
+static int     bcache_procfs_dup(FAR const struct file *oldp,
+                 FAR struct file *newp);
+static int     bcache_procfs_stat(FAR const char *relpath,
+                 FAR struct stat *buf);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct block_operations g_bcache_bops =
+{
+  bcache_open,     /* open     */
+  bcache_close,    /* close    */
+  bcache_read,     /* read     */
+  bcache_write,    /* write    */
+  bcache_geometry, /* geometry */
+  bcache_ioctl     /* ioctl    */
+#ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
+  , NULL           /* unlink   */
+#endif
+};
+
+/* The list of all caches, used by procfs */
+
+static FAR struct bcache_dev_s *g_bcache_head;
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+const struct procfs_operations bcache_procfsoperations =
+{
+  bcache_procfs_open,   /* open */
+  bcache_procfs_close,  /* close */
+  bcache_procfs_read,   /* read */
+  NULL,                 /* write */
+
+  bcache_procfs_dup,    /* dup */
+
+  NULL,                 /* opendir */
+  NULL,                 /* closedir */
+  NULL,                 /* readdir */
+  NULL,                 /* rewinddir */
+
+  bcache_procfs_stat    /* stat */
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcache_lookup
+ ****************************************************************************/
+
+static FAR struct bcache_entry_s *
+bcache_lookup(FAR struct bcache_dev_s *dev, blkcnt_t sector)
+{
+  FAR struct bcache_entry_s *entry;
+
+  for (entry = dev->hash[sector & dev->hmask];
+       entry != NULL && entry->sector != sector;
+       entry = entry->hnext);
+
+  return entry;
+}
+
+/****************************************************************************
+ * Name: bcache_unhash
+ ****************************************************************************/
+
+static void bcache_unhash(FAR struct bcache_dev_s *dev,
+                          FAR struct bcache_entry_s *entry)
+{
+  FAR struct bcache_entry_s **prev;
+
+  for (prev = &dev->hash[entry->sector & dev->hmask];
+       *prev != entry;
+       prev = &(*prev)->hnext);
+
+  *prev = entry->hnext;
+  entry->valid = false;
+}
+
+/****************************************************************************
+ * Name: bcache_touch
+ *
+ * Description:
+ *   Mark the entry as the most recently used.
+ *
+ ****************************************************************************/
+
+static inline void bcache_touch(FAR struct bcache_dev_s *dev,
+                                FAR struct bcache_entry_s *entry)
+{
+  dq_rem(&entry->lru, &dev->lru);
+  dq_addlast(&entry->lru, &dev->lru);
+}
+
+/****************************************************************************
+ * Name: bcache_devwrite
+ ****************************************************************************/
+
+static ssize_t bcache_devwrite(FAR struct bcache_dev_s *dev,
+                               FAR const uint8_t *buffer, blkcnt_t sector,
+                               unsigned int nsectors)
+{
+  FAR struct inode *inode = dev->inode;
+
+  if (inode->u.i_bops->write == NULL)
+    {
+      return -EACCES;
+    }
+
+  dev->stats.writebacks += nsectors;
+  return inode->u.i_bops->write(inode, buffer, sector, nsectors);
+}
+
+/****************************************************************************
+ * Name: bcache_writeback
+ *
+ * Description:
+ *   Write a dirty entry back to the media together with the dirty entries
+ *   of the sectors that follow it, in as few transfers as the staging
+ *   buffer allows.  The entries stay dirty if the write fails.
+ *
+ ****************************************************************************/
+
+static int bcache_writeback(FAR struct bcache_dev_s *dev,
+                            FAR struct bcache_entry_s *entry)
+{
+  FAR struct bcache_entry_s *next;
+  blkcnt_t sector = entry->sector;
+  unsigned int nrun;
+  ssize_t ret;
+
+  unsigned int i;
+
+  memcpy(dev->wrbuf, entry->data, dev->sectsize);
+
+  for (nrun = 1; nrun < dev->nstaging; nrun++)
+    {
+      next = bcache_lookup(dev, sector + nrun);
+      if (next == NULL || !next->dirty)
+        {
+          break;
+        }
+
+      memcpy(dev->wrbuf + nrun * dev->sectsize, next->data,
+             dev->sectsize);
+    }
+
+  ret = bcache_devwrite(dev, dev->wrbuf, sector, nrun);
+  if (ret <= 0)
+    {
+      ferr("ERROR: Write-back of %" PRIu32 " sectors at %" PRIu32
+           " failed: %zd\n", (uint32_t)nrun, (uint32_t)sector, ret);
+      return ret < 0 ? ret : -EIO;
+    }
+
+  /* Only the sectors that reached the media are clean now */
+
+  entry->dirty = false;
+  for (i = 1; i < (unsigned int)ret; i++)
+    {
+      bcache_lookup(dev, sector + i)->dirty = false;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_flush
+ *
+ * Description:
+ *   Write all dirty sectors to the media.  Sectors are written in
+ *   ascending order so that runs of adjacent sectors are combined.
+ *
+ ****************************************************************************/
+
+static int bcache_flush(FAR struct bcache_dev_s *dev)
+{
+  FAR struct bcache_entry_s *lowest;
+  blkcnt_t first = 0;
+  int ret = OK;
+  int status;
+  int i;
+
+  /* Entries that fail to write back stay dirty, so the scan only moves
+   * forward to visit each sector once.
+   */
+
+  for (; ; )
+    {
+      lowest = NULL;
+      for (i = 0; i < dev->nentries; i++)
+        {
+          if (dev->entries[i].dirty && dev->entries[i].sector >= first &&
+              (lowest == NULL || dev->entries[i].sector < lowest->sector))
+            {
+              lowest = &dev->entries[i];
+            }
+        }
+
+      if (lowest == NULL)
+        {
+          break;
+        }
+
+      first  = lowest->sector + 1;
+      status = bcache_writeback(dev, lowest);
+      if (status < 0 && ret == OK)
+        {
+          ret = status;
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_timeout
+ ****************************************************************************/
+
+#if CONFIG_DRVR_BCACHE_FLUSHDELAY > 0
+static void bcache_timeout(FAR void *arg)
+{
+  FAR struct bcache_dev_s *dev = (FAR struct bcache_dev_s *)arg;
+
+  if (nxsem_wait_uninterruptible(&dev->exclsem) >= 0)
+    {
+      bcache_flush(dev);
+      nxsem_post(&dev->exclsem);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: bcache_alloc
+ *
+ * Description:
+ *   Re-use the least recently used entry for 'sector'.  The entry is
+ *   returned as the most recently used.  Fails if the entry is dirty and
+ *   cannot be written back, so that its data is not lost.
+ *
+ ****************************************************************************/
+
+static int bcache_alloc(FAR struct bcache_dev_s *dev, blkcnt_t sector,
+                        FAR struct bcache_entry_s **entryp)
+{
+  FAR struct bcache_entry_s *entry;
+  int ret;
+
+  entry = (FAR struct bcache_entry_s *)dev->lru.head;
+  DEBUGASSERT(entry != NULL);
+
+  if (entry->dirty)
+    {
+      ret = bcache_writeback(dev, entry);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  if (entry->valid)
+    {
+      bcache_unhash(dev, entry);
+      dev->stats.evictions++;
+    }
+
+  entry->sector = sector;
+  entry->valid  = true;
+  entry->hnext  = dev->hash[sector & dev->hmask];
+  dev->hash[sector & dev->hmask] = entry;
+
+  bcache_touch(dev, entry);
+  *entryp = entry;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_open
+ ****************************************************************************/
+
+static int bcache_open(FAR struct inode *inode)
+{
+  FAR struct bcache_dev_s *dev = inode->i_private;
+  int ret;
+
+  ret = nxsem_wait(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (dev->crefs == UINT8_MAX)
+    {
+      ret = -EMFILE;
+    }
+  else
+    {
+      dev->crefs++;
+    }
+
+  nxsem_post(&dev->exclsem);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_close
+ ****************************************************************************/
+
+static int bcache_close(FAR struct inode *inode)
+{
+  FAR struct bcache_dev_s *dev = inode->i_private;
+  int ret;
+
+  ret = nxsem_wait_uninterruptible(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  DEBUGASSERT(dev->crefs > 0);
+  if (--dev->crefs == 0)
+    {
+      /* Nothing is left in the cache after the last user goes away */
+
+      ret = bcache_flush(dev);
+    }
+
+  nxsem_post(&dev->exclsem);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_read
+ ****************************************************************************/
+
+static ssize_t bcache_read(FAR struct inode *inode,
+                           FAR unsigned char *buffer, blkcnt_t start_sector,
+                           unsigned int nsectors)
+{
+  FAR struct bcache_dev_s *dev = inode->i_private;
+  FAR struct inode *blkdrv = dev->inode;
+  FAR struct bcache_entry_s *entry;
+  blkcnt_t sector;
+  blkcnt_t end;
+  unsigned int nrun;
+  unsigned int i;
+  ssize_t ret;
+
+  if (start_sector >= dev->nsectors)
+    {
+      return 0;
+    }
+
+  if (nsectors > dev->nsectors - start_sector)
+    {
+      nsectors = dev->nsectors - start_sector;
+    }
+
+  ret = nxsem_wait(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  end = start_sector + nsectors;
+
+  /* Large reads go directly to the media.  Any cached sector that has not
+   * been written back yet is newer than the media copy.
+   */
+
+  if (nsectors > BCACHE_BYPASS(dev))
+    {
+      ret = blkdrv->u.i_bops->read(blkdrv, buffer, start_sector, nsectors);
+      if (ret > 0)
+        {
+          for (sector = start_sector; sector < start_sector + ret; sector++)
+            {
+              entry = bcache_lookup(dev, sector);
+              if (entry != NULL && entry->dirty)
+                {
+                  memcpy(buffer + (sector - start_sector) * dev->sectsize,
+                         entry->data, dev->sectsize);
+                }
+            }
+
+          dev->stats.bypass += ret;
+        }
+
+      goto out;
+    }
+
+  for (sector = start_sector; sector < end; )
+    {
+      entry = bcache_lookup(dev, sector);
+      if (entry != NULL)
+        {
+          memcpy(buffer, entry->data, dev->sectsize);
+          bcache_touch(dev, entry);
+          dev->stats.hits++;
+
+          buffer += dev->sectsize;
+          sector++;
+          continue;
+        }
+
+      /* A miss.  Read the run of missing sectors, extended by the
+       * read-ahead, into the staging buffer with one transfer.
+       */
+
+      for (nrun = 1;
+           nrun < dev->nstaging && sector + nrun < dev->nsectors &&
+           nrun < end - sector + CONFIG_DRVR_BCACHE_READAHEAD &&
+           bcache_lookup(dev, sector + nrun) == NULL;
+           nrun++);
+
+      ret = blkdrv->u.i_bops->read(blkdrv, dev->staging, sector, nrun);
+      if (ret <= 0)
+        {
+          ferr("ERROR: Read of %u sectors at %" PRIu32 " failed: %zd\n",
+               nrun, (uint32_t)sector, ret);
+          goto out;
+        }
+
+      nrun = ret;
+      for (i = 0; i < nrun; i++, sector++)
+        {
+          ret = bcache_alloc(dev, sector, &entry);
+          if (ret < 0)
+            {
+              goto out;
+            }
+
+          memcpy(entry->data, dev->staging + i * dev->sectsize,
+                 dev->sectsize);
+
+          if (sector < end)
+            {
+              memcpy(buffer, entry->data, dev->sectsize);
+              buffer += dev->sectsize;
+              dev->stats.misses++;
+            }
+          else
+            {
+              dev->stats.readahead++;
+            }
+        }
+    }
+
+  ret = nsectors;
+
+out:
+  nxsem_post(&dev->exclsem);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_write
+ ****************************************************************************/
+
+static ssize_t bcache_write(FAR struct inode *inode,
+                            FAR const unsigned char *buffer,
+                            blkcnt_t start_sector, unsigned int nsectors)
+{
+  FAR struct bcache_dev_s *dev = inode->i_private;
+  FAR struct bcache_entry_s *entry;
+  blkcnt_t sector;
+  ssize_t ret;
+
+  if (start_sector >= dev->nsectors)
+    {
+      return -EFBIG;
+    }
+
+  if (nsectors > dev->nsectors - start_sector)
+    {
+      nsectors = dev->nsectors - start_sector;
+    }
+
+  ret = nxsem_wait(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Large writes go directly to the media.  Cached copies are updated so
+   * that they stay coherent.  They are clean only if the new data reached
+   * the media; otherwise they are left dirty to be written back later.
+   */
+
+  if (nsectors > BCACHE_BYPASS(dev))
+    {
+      ret = bcache_devwrite(dev, buffer, start_sector, nsectors);
+      if (ret > 0)
+        {
+          dev->stats.bypass += ret;
+        }
+
+      for (sector = start_sector; sector < start_sector + nsectors;
+           sector++)
+        {
+          entry = bcache_lookup(dev, sector);
+          if (entry != NULL)
+            {
+              memcpy(entry->data,
+                     buffer + (sector - start_sector) * dev->sectsize,
+                     dev->sectsize);
+              entry->dirty = ret <= 0 || sector >= start_sector + ret;
+            }
+        }
+
+      goto out;
+    }
+
+  /* Write-back: just update the cache.  Whole sectors are written so there
+   * is no need to read a missing sector first.
+   */
+
+  for (sector = start_sector; sector < start_sector + nsectors; sector++)
+    {
+      entry = bcache_lookup(dev, sector);
+      if (entry != NULL)
+        {
+          bcache_touch(dev, entry);
+        }
+      else
+        {
+          ret = bcache_alloc(dev, sector, &entry);
+          if (ret < 0)
+            {
+              goto out;
+            }
+        }
+
+      memcpy(entry->data, buffer, dev->sectsize);
+      entry->dirty = true;
+      buffer += dev->sectsize;
+    }
+
+#if CONFIG_DRVR_BCACHE_FLUSHDELAY > 0
+  /* Bound the time that the data may stay in the cache */
+
+  if (work_available(&dev->work))
+    {
+      work_queue(LPWORK, &dev->work, bcache_timeout, dev,
+                 MSEC2TICK(CONFIG_DRVR_BCACHE_FLUSHDELAY));
+    }
+#endif
+
+  ret = nsectors;
+
+out:
+  nxsem_post(&dev->exclsem);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bcache_geometry
+ ****************************************************************************/
+
+static int bcache_geometry(FAR struct inode *inode,
+                           FAR struct geometry *geometry)
+{
+  FAR struct bcache_dev_s *dev = inode->i_private;
+  FAR struct inode *blkdrv = dev->inode;
+
+  return blkdrv->u.i_bops->geometry(blkdrv, geometry);
+}
+
+/****************************************************************************
+ * Name: bcache_ioctl
+ ****************************************************************************/
+
+static int bcache_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
+{
+  FAR struct bcache_dev_s *dev = inode->i_private;
+  FAR struct inode *blkdrv = dev->inode;
+  int ret;
+
+  if (cmd == BIOC_FLUSH)
+    {
+      ret = nxsem_wait(&dev->exclsem);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ret = bcache_flush(dev);
+      nxsem_post(&dev->exclsem);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  /* Everything else, and the flush itself, is passed to the media */
+
+  if (blkdrv->u.i_bops->ioctl == NULL)
+    {
+      return cmd == BIOC_FLUSH ? OK : -ENOTTY;
+    }
+
+  ret = blkdrv->u.i_bops->ioctl(blkdrv, cmd, arg);
+  if (cmd == BIOC_FLUSH && ret == -ENOTTY)
+    {
+      ret = OK;
+    }
+
+  return ret;
+}
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+
+/****************************************************************************
+ * Name: bcache_procfs_open
+ ****************************************************************************/
+
+static int bcache_procfs_open(FAR struct file *filep,
+                              FAR const char *relpath, int oflags,
+                              mode_t mode)
+{
+  FAR struct bcache_file_s *attr;
+
+  finfo("Open '%s'\n", relpath);
+
+  /* PROCFS is read-only.  Any attempt to open with any kind of write
+   * access is not permitted.
+   */
+
+  if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0)
+    {
+      ferr("ERROR: Only O_RDONLY supported\n");
+      return -EACCES;
+    }
+
+  attr = (FAR struct bcache_file_s *)
+         kmm_zalloc(sizeof(struct bcache_file_s));
+  if (!attr)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  filep->f_priv = (FAR void *)attr;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_close
+ ****************************************************************************/
+
+static int bcache_procfs_close(FAR struct file *filep)
+{
+  FAR struct bcache_file_s *attr;
+
+  attr = (FAR struct bcache_file_s *)filep->f_priv;
+  DEBUGASSERT(attr);
+
+  kmm_free(attr);
+  filep->f_priv = NULL;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_read
+ ****************************************************************************/
+
+static ssize_t bcache_procfs_read(FAR struct file *filep,
+                                  FAR char *buffer, size_t buflen)
+{
+  FAR struct bcache_file_s *attr;
+  FAR struct bcache_dev_s *dev;
+  struct bcache_stats_s stats;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  off_t offset;
+
+  attr = (FAR struct bcache_file_s *)filep->f_priv;
+  DEBUGASSERT(attr);
+
+  offset    = filep->f_pos;
+  linesize  = procfs_snprintf(attr->line, BCACHE_LINELEN,
+                              "%-16s %8s %8s %8s %8s %8s %8s\n",
+                              "Device", "Hits", "Misses", "Ahead",
+                              "Bypass", "Writes", "Evicts");
+  copysize  = procfs_memcpy(attr->line, linesize, buffer, buflen, &offset);
+  totalsize = copysize;
+
+  for (dev = g_bcache_head; dev != NULL; dev = dev->flink)
+    {
+      /* A consistent snapshot is not important here */
+
+      stats     = dev->stats;
+      linesize  = procfs_snprintf(attr->line, BCACHE_LINELEN,
+                                  "%-16s %8" PRIu32 " %8" PRIu32
+                                  " %8" PRIu32 " %8" PRIu32 " %8" PRIu32
+                                  " %8" PRIu32 "\n",
+                                  dev->name, stats.hits, stats.misses,
+                                  stats.readahead, stats.bypass,
+                                  stats.writebacks, stats.evictions);
+      copysize  = procfs_memcpy(attr->line, linesize, buffer + totalsize,
+                                buflen - totalsize, &offset);
+      totalsize += copysize;
+    }
+
+  filep->f_pos += totalsize;
+  return totalsize;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_dup
+ ****************************************************************************/
+
+static int bcache_procfs_dup(FAR const struct file *oldp,
+                             FAR struct file *newp)
+{
+  FAR struct bcache_file_s *oldattr;
+  FAR struct bcache_file_s *newattr;
+
+  oldattr = (FAR struct bcache_file_s *)oldp->f_priv;
+  DEBUGASSERT(oldattr);
+
+  newattr = (FAR struct bcache_file_s *)
+            kmm_malloc(sizeof(struct bcache_file_s));
+  if (!newattr)
+    {
+      ferr("ERROR: Failed to allocate file attributes\n");
+      return -ENOMEM;
+    }
+
+  memcpy(newattr, oldattr, sizeof(struct bcache_file_s));
+  newp->f_priv = (FAR void *)newattr;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bcache_procfs_stat
+ ****************************************************************************/
+
+static int bcache_procfs_stat(FAR const char *relpath, FAR struct stat *buf)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+  return OK;
+}
+
+#endif /* CONFIG_FS_PROCFS && !CONFIG_FS_PROCFS_EXCLUDE_BCACHE */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bcache_register
+ *
+ * Description:
+ *   Register a block driver that caches the sectors of another block
+ *   driver.
+ *
+ * Input Parameters:
+ *   blkdev   - The path to the block driver to be cached, e.g. /dev/mmcsd0
+ *   cachedev - The path of the caching block driver to create
+ *   nsectors - The number of sectors to cache.  Zero selects
+ *              CONFIG_DRVR_BCACHE_NSECTORS.
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int bcache_register(FAR const char *blkdev, FAR const char *cachedev,
+                    uint16_t nsectors)
+{
+  FAR struct bcache_dev_s *dev;
+  struct geometry geo;
+  uint32_t nbuckets;
+  int ret;
+  int i;
+
+  DEBUGASSERT(blkdev != NULL && cachedev != NULL);
+
+  if (nsectors == 0)
+    {
+      nsectors = CONFIG_DRVR_BCACHE_NSECTORS;
+    }
+
+  dev = (FAR struct bcache_dev_s *)kmm_zalloc(sizeof(struct bcache_dev_s));
+  if (dev == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = open_blockdriver(blkdev, 0, &dev->inode);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to open %s: %d\n", blkdev, ret);
+      goto errout_with_dev;
+    }
+
+  ret = dev->inode->u.i_bops->geometry(dev->inode, &geo);
+  if (ret < 0 || !geo.geo_available || geo.geo_sectorsize <= 0)
+    {
+      ferr("ERROR: No geometry for %s: %d\n", blkdev, ret);
+      ret = ret < 0 ? ret : -ENODEV;
+      goto errout_with_inode;
+    }
+
+  dev->nsectors = geo.geo_nsectors;
+  dev->sectsize = geo.geo_sectorsize;
+  dev->nentries = nsectors;
+  dev->nstaging = CONFIG_DRVR_BCACHE_READAHEAD + 1;
+
+  /* The hash table has a power of two buckets, at least one per entry.
+   * nbuckets is wider than nsectors so that this ends for any nsectors.
+   */
+
+  for (nbuckets = 1; nbuckets < nsectors; nbuckets <<= 1);
+  dev->hmask = nbuckets - 1;
+
+  dev->name    = (FAR char *)kmm_malloc(strlen(cachedev) + 1);
+  dev->hash    = (FAR struct bcache_entry_s **)
+                 kmm_zalloc(nbuckets * sizeof(FAR struct bcache_entry_s *));
+  dev->entries = (FAR struct bcache_entry_s *)
+                 kmm_zalloc(nsectors * sizeof(struct bcache_entry_s));
+  dev->staging = (FAR uint8_t *)
+                 kmm_malloc((nsectors + 2 * dev->nstaging) * dev->sectsize);
+
+  if (dev->name == NULL || dev->hash == NULL || dev->entries == NULL ||
+      dev->staging == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout_with_memory;
+    }
+
+  strcpy(dev->name, cachedev);
+
+  /* The write-back and the sector buffers follow the staging buffer */
+
+  dev->wrbuf = dev->staging + dev->nstaging * dev->sectsize;
+  for (i = 0; i < nsectors; i++)
+    {
+      dev->entries[i].data = dev->staging +
+                             (2 * dev->nstaging + i) * dev->sectsize;
+      dq_addlast(&dev->entries[i].lru, &dev->lru);
+    }
+
+  nxsem_init(&dev->exclsem, 0, 1);
+
+  ret = register_blockdriver(cachedev, &g_bcache_bops, 0, dev);
+  if (ret < 0)
+    {
+      ferr("ERROR: register_blockdriver %s failed: %d\n", cachedev, ret);
+      nxsem_destroy(&dev->exclsem);
+      goto errout_with_memory;
+    }
+
+  /* Add the cache to the list reported by procfs */
+
+  sched_lock();
+  dev->flink    = g_bcache_head;
+  g_bcache_head = dev;
+  sched_unlock();
+
+  finfo("%s: %u sectors of %u bytes cached as %s\n",
+        blkdev, nsectors, dev->sectsize, cachedev);
+  return OK;
+
+errout_with_memory:
+  kmm_free(dev->staging);
+  kmm_free(dev->entries);
+  kmm_free(dev->hash);
+  kmm_free(dev->name);
+
+errout_with_inode:
+  close_blockdriver(dev->inode);
+
+errout_with_dev:
+  kmm_free(dev);
+  return ret;
+}
+
+#endif /* CONFIG_DRVR_BCACHE */
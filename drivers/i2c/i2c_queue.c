@@ -0,0 +1,475 @@
+/****************************************************************************
+ * drivers/i2c/i2c_queue.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/kthread.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/i2c/i2c_master.h>
+
+#ifdef CONFIG_I2C_QUEUE
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct i2c_queue_s
+{
+  FAR struct i2c_master_s *i2c;   /* The I2C bus */
+  sq_queue_t pending;             /* Requests waiting to be performed */
+  sem_t wakeup;                   /* Wakes up the queue thread */
+  sem_t exited;                   /* Posted when the queue thread exits */
+  volatile bool stop;             /* Asks the queue thread to exit */
+  struct i2c_queue_stats_s stats; /* Statistics of the queue */
+  uint64_t reset;                 /* Time of the last statistics reset */
+
+  /* The messages of a combined transfer */
+
+  struct i2c_msg_s msgs[CONFIG_I2C_QUEUE_MAXMSGS];
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: i2c_queue_now
+ *
+ * Description:
+ *   Return the system time in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t i2c_queue_now(void)
+{
+  struct timespec ts;
+
+  clock_systime_timespec(&ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/****************************************************************************
+ * Name: i2c_queue_combinable
+ *
+ * Description:
+ *   Return true if request 'next' may be appended to the transfer of
+ *   request 'prev', which holds 'nmsgs' messages so far.
+ *
+ ****************************************************************************/
+
+static bool i2c_queue_combinable(FAR const struct i2c_request_s *prev,
+                                 FAR const struct i2c_request_s *next,
+                                 int nmsgs)
+{
+  FAR const struct i2c_msg_s *last  = &prev->msgs[prev->nmsgs - 1];
+  FAR const struct i2c_msg_s *first = &next->msgs[0];
+
+  /* The requests must address the same device at the same speed and the
+   * STOP condition between them must be kept.
+   */
+
+  return nmsgs + next->nmsgs <= CONFIG_I2C_QUEUE_MAXMSGS &&
+         first->addr == prev->msgs[0].addr &&
+         first->frequency == prev->msgs[0].frequency &&
+         (last->flags & I2C_M_NOSTOP) == 0 &&
+         (first->flags & I2C_M_NOSTART) == 0;
+}
+
+/****************************************************************************
+ * Name: i2c_queue_transfer
+ *
+ * Description:
+ *   Perform one I2C_TRANSFER() and account for it in the statistics.
+ *
+ ****************************************************************************/
+
+static int i2c_queue_transfer(FAR struct i2c_queue_s *queue,
+                              FAR struct i2c_msg_s *msgs, int nmsgs)
+{
+  uint64_t start;
+  irqstate_t flags;
+  int ret;
+
+  start = i2c_queue_now();
+  ret   = I2C_TRANSFER(queue->i2c, msgs, nmsgs);
+
+  flags = enter_critical_section();
+  queue->stats.nbatches++;
+  queue->stats.busy += i2c_queue_now() - start;
+  leave_critical_section(flags);
+
+  /* Some lower halves return the number of messages transferred */
+
+  return ret > 0 ? OK : ret;
+}
+
+/****************************************************************************
+ * Name: i2c_queue_batch
+ *
+ * Description:
+ *   Perform the request at the head of the queue, combined with the
+ *   requests to the same device that follow it.  If the combined transfer
+ *   fails, it is not known which request failed, so the requests are
+ *   performed again one by one to give each its own result.
+ *
+ ****************************************************************************/
+
+static void i2c_queue_batch(FAR struct i2c_queue_s *queue)
+{
+  FAR struct i2c_request_s *first;
+  FAR struct i2c_request_s *prev;
+  FAR struct i2c_request_s *req;
+  FAR struct i2c_request_s *next;
+  FAR struct i2c_msg_s *msgs;
+  uint32_t maxlatency = 0;
+  uint64_t latency = 0;
+  uint64_t start;
+  irqstate_t flags;
+  uint32_t n = 1;
+  int nmsgs;
+  int ret;
+
+  flags = enter_critical_section();
+  first = (FAR struct i2c_request_s *)sq_remfirst(&queue->pending);
+  if (first == NULL)
+    {
+      leave_critical_section(flags);
+      return;
+    }
+
+  msgs  = first->msgs;
+  nmsgs = first->nmsgs;
+
+  /* Append the requests that follow to the same device */
+
+  prev = first;
+  req  = (FAR struct i2c_request_s *)sq_peek(&queue->pending);
+
+  while (req != NULL && i2c_queue_combinable(prev, req, nmsgs))
+    {
+      if (msgs == first->msgs)
+        {
+          memcpy(queue->msgs, first->msgs,
+                 first->nmsgs * sizeof(struct i2c_msg_s));
+          msgs = queue->msgs;
+        }
+
+      memcpy(&msgs[nmsgs], req->msgs, req->nmsgs * sizeof(struct i2c_msg_s));
+      nmsgs += req->nmsgs;
+
+      sq_remfirst(&queue->pending);
+      sq_next(&prev->node) = &req->node;
+      prev = req;
+      req  = (FAR struct i2c_request_s *)sq_peek(&queue->pending);
+      n++;
+    }
+
+  sq_next(&prev->node) = NULL;
+  leave_critical_section(flags);
+
+  /* Account for the time that the requests waited */
+
+  start = i2c_queue_now();
+  for (req = first; req != NULL;
+       req = (FAR struct i2c_request_s *)sq_next(&req->node))
+    {
+      if (start - req->submitted > maxlatency)
+        {
+          maxlatency = start - req->submitted;
+        }
+
+      latency += start - req->submitted;
+    }
+
+  flags = enter_critical_section();
+  queue->stats.nrequests += n;
+  queue->stats.latency += latency;
+
+  if (n > queue->stats.maxbatch)
+    {
+      queue->stats.maxbatch = n;
+    }
+
+  if (maxlatency > queue->stats.maxlatency)
+    {
+      queue->stats.maxlatency = maxlatency;
+    }
+
+  leave_critical_section(flags);
+
+  ret = i2c_queue_transfer(queue, msgs, nmsgs);
+
+  /* The callback may submit the request again, so get the next one
+   * first.
+   */
+
+  for (req = first; req != NULL; req = next)
+    {
+      next = (FAR struct i2c_request_s *)sq_next(&req->node);
+
+      req->result = ret;
+      if (ret < 0 && n > 1)
+        {
+          req->result = i2c_queue_transfer(queue, req->msgs, req->nmsgs);
+        }
+
+      req->callback(req, req->result);
+    }
+}
+
+/****************************************************************************
+ * Name: i2c_queue_thread
+ *
+ * Description:
+ *   The thread that performs the requests of a queue.
+ *
+ ****************************************************************************/
+
+static int i2c_queue_thread(int argc, FAR char *argv[])
+{
+  FAR struct i2c_queue_s *queue;
+  FAR struct i2c_request_s *req;
+  irqstate_t flags;
+
+  queue = (FAR struct i2c_queue_s *)((uintptr_t)strtoul(argv[1], NULL, 0));
+
+  while (!queue->stop)
+    {
+      nxsem_wait_uninterruptible(&queue->wakeup);
+
+      while (!queue->stop && !sq_empty(&queue->pending))
+        {
+          i2c_queue_batch(queue);
+        }
+    }
+
+  /* Cancel the requests that are left */
+
+  do
+    {
+      flags = enter_critical_section();
+      req = (FAR struct i2c_request_s *)sq_remfirst(&queue->pending);
+      leave_critical_section(flags);
+
+      if (req != NULL)
+        {
+          req->callback(req, -ECANCELED);
+        }
+    }
+  while (req != NULL);
+
+  nxsem_post(&queue->exited);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: i2c_queue_create
+ *
+ * Description:
+ *   Create a queue of asynchronous requests for an I2C bus.
+ *
+ * Input Parameters:
+ *   i2c - An instance of the lower half I2C driver
+ *
+ * Returned Value:
+ *   The new queue on success; NULL on failure.
+ *
+ ****************************************************************************/
+
+FAR struct i2c_queue_s *i2c_queue_create(FAR struct i2c_master_s *i2c)
+{
+  FAR struct i2c_queue_s *queue;
+  FAR char *argv[2];
+  char arg1[32];
+  int ret;
+
+  DEBUGASSERT(i2c != NULL);
+
+  queue = kmm_zalloc(sizeof(struct i2c_queue_s));
+  if (queue == NULL)
+    {
+      return NULL;
+    }
+
+  queue->i2c   = i2c;
+  queue->reset = i2c_queue_now();
+  sq_init(&queue->pending);
+
+  nxsem_init(&queue->wakeup, 0, 0);
+  nxsem_init(&queue->exited, 0, 0);
+  nxsem_set_protocol(&queue->wakeup, SEM_PRIO_NONE);
+  nxsem_set_protocol(&queue->exited, SEM_PRIO_NONE);
+
+  snprintf(arg1, sizeof(arg1), "%p", queue);
+  argv[0] = arg1;
+  argv[1] = NULL;
+
+  ret = kthread_create("i2cq", CONFIG_I2C_QUEUE_PRIORITY,
+                       CONFIG_I2C_QUEUE_STACKSIZE, i2c_queue_thread, argv);
+  if (ret < 0)
+    {
+      i2cerr("ERROR: Failed to start the queue thread: %d\n", ret);
+      nxsem_destroy(&queue->wakeup);
+      nxsem_destroy(&queue->exited);
+      kmm_free(queue);
+      return NULL;
+    }
+
+  return queue;
+}
+
+/****************************************************************************
+ * Name: i2c_queue_destroy
+ *
+ * Description:
+ *   Stop the queue thread and free the queue.  This must not be called from
+ *   a request callback.
+ *
+ ****************************************************************************/
+
+void i2c_queue_destroy(FAR struct i2c_queue_s *queue)
+{
+  DEBUGASSERT(queue != NULL);
+
+  queue->stop = true;
+  nxsem_post(&queue->wakeup);
+  nxsem_wait_uninterruptible(&queue->exited);
+
+  nxsem_destroy(&queue->wakeup);
+  nxsem_destroy(&queue->exited);
+  kmm_free(queue);
+}
+
+/****************************************************************************
+ * Name: i2c_queue_submit
+ *
+ * Description:
+ *   Add a request to the end of the queue.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int i2c_queue_submit(FAR struct i2c_queue_s *queue,
+                     FAR struct i2c_request_s *req)
+{
+  irqstate_t flags;
+
+  DEBUGASSERT(queue != NULL && req != NULL && req->msgs != NULL &&
+              req->nmsgs > 0 && req->callback != NULL);
+
+  if (queue->stop)
+    {
+      return -ESHUTDOWN;
+    }
+
+  req->submitted = i2c_queue_now();
+
+  flags = enter_critical_section();
+  sq_addlast(&req->node, &queue->pending);
+  leave_critical_section(flags);
+
+  return nxsem_post(&queue->wakeup);
+}
+
+/****************************************************************************
+ * Name: i2c_queue_cancel
+ *
+ * Description:
+ *   Remove a request that has not been started from the queue.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOENT if the request is not queued.
+ *
+ ****************************************************************************/
+
+int i2c_queue_cancel(FAR struct i2c_queue_s *queue,
+                     FAR struct i2c_request_s *req)
+{
+  FAR sq_entry_t *node;
+  irqstate_t flags;
+  int ret = -ENOENT;
+
+  DEBUGASSERT(queue != NULL && req != NULL);
+
+  flags = enter_critical_section();
+  for (node = sq_peek(&queue->pending); node != NULL; node = sq_next(node))
+    {
+      if (node == &req->node)
+        {
+          sq_rem(node, &queue->pending);
+          ret = OK;
+          break;
+        }
+    }
+
+  leave_critical_section(flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: i2c_queue_stats
+ *
+ * Description:
+ *   Return the statistics of the queue and optionally reset them.
+ *
+ ****************************************************************************/
+
+void i2c_queue_stats(FAR struct i2c_queue_s *queue,
+                     FAR struct i2c_queue_stats_s *stats, bool reset)
+{
+  uint64_t now = i2c_queue_now();
+  irqstate_t flags;
+
+  DEBUGASSERT(queue != NULL && stats != NULL);
+
+  flags = enter_critical_section();
+  *stats = queue->stats;
+  stats->elapsed = now - queue->reset;
+
+  if (reset)
+    {
+      memset(&queue->stats, 0, sizeof(queue->stats));
+      queue->reset = now;
+    }
+
+  leave_critical_section(flags);
+}
+
+#endif /* CONFIG_I2C_QUEUE */
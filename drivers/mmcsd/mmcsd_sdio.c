@@ -51,6 +51,7 @@
 #include <nuttx/sdio.h>
 #include <nuttx/mmcsd.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/drivers/rwbuffer.h>
 
 #include "mmcsd.h"
 #include "mmcsd_sdio.h"
@@ -87,6 +88,12 @@
 
 #define IS_EMPTY(priv) (priv->type == MMCSD_CARDTYPE_UNKNOWN)
 
+/* Check if read/write buffer support is needed */
+
+#if defined(CONFIG_MMCSD_READAHEAD) || defined(CONFIG_MMCSD_WRITEBUFFER)
+#  define MMCSD_HAVE_RWBUFFER 1
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -130,6 +137,12 @@ struct mmcsd_state_s
 #else
   uint32_t capacity;               /* Total capacity of volume (Limited to 4Gb) */
 #endif
+
+#ifdef MMCSD_HAVE_RWBUFFER
+  struct rwbuffer_s rwbuffer;      /* Read-ahead/write buffer support */
+  uint8_t rwbremoved;              /* Card removals, changed with sem held */
+  uint8_t rwbdiscarded;            /* Removals whose buffers were discarded */
+#endif
 };
 
 /****************************************************************************
@@ -193,6 +206,13 @@ static ssize_t mmcsd_writemultiple(FAR struct mmcsd_state_s *priv,
                  FAR const uint8_t *buffer, off_t startblock,
                  size_t nblocks);
 #endif
+static ssize_t mmcsd_reload(FAR void *dev, FAR uint8_t *buffer,
+                 off_t startblock, size_t nblocks);
+static ssize_t mmcsd_flush(FAR void *dev, FAR const uint8_t *buffer,
+                 off_t startblock, size_t nblocks);
+#ifdef MMCSD_HAVE_RWBUFFER
+static int     mmcsd_rwbcheck(FAR struct mmcsd_state_s *priv);
+#endif
 
 /* Block driver methods *****************************************************/
 
@@ -2010,6 +2030,206 @@ static ssize_t mmcsd_writemultiple(FAR struct mmcsd_state_s *priv,
 }
 #endif
 
+/****************************************************************************
+ * Name: mmcsd_reload
+ *
+ * Description:
+ *   Read blocks from the physical device.  This is the read-ahead reload
+ *   callback of the read/write buffer.  Reads of more than one block are
+ *   done with one multiple block transfer.
+ *
+ ****************************************************************************/
+
+static ssize_t mmcsd_reload(FAR void *dev, FAR uint8_t *buffer,
+                            off_t startblock, size_t nblocks)
+{
+  FAR struct mmcsd_state_s *priv = (FAR struct mmcsd_state_s *)dev;
+#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
+  size_t block;
+  size_t endblock;
+#endif
+  ssize_t ret;
+
+  ret = mmcsd_takesem(priv);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
+  /* Read each block using only the single block transfer method */
+
+  ret = nblocks;
+  endblock = startblock + nblocks - 1;
+  for (block = startblock; block <= endblock; block++)
+    {
+      /* Read this block into the user buffer */
+
+      ssize_t nread = mmcsd_readsingle(priv, buffer, block);
+      if (nread < 0)
+        {
+          ret = nread;
+          break;
+        }
+
+      /* Increment the buffer pointer by the block size */
+
+      buffer += priv->blocksize;
+    }
+
+#else
+  /* Use either the single- or multiple-block transfer method */
+
+  if (nblocks == 1)
+    {
+      ret = mmcsd_readsingle(priv, buffer, startblock);
+    }
+  else
+    {
+      ret = mmcsd_readmultiple(priv, buffer, startblock, nblocks);
+    }
+
+#endif
+  mmcsd_givesem(priv);
+
+  /* On success, return the number of blocks read */
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: mmcsd_flush
+ *
+ * Description:
+ *   Write blocks to the physical device.  This is the flush callback of the
+ *   read/write buffer, which merges the writes to adjacent blocks so that
+ *   they reach the card as one multiple block transfer.
+ *
+ ****************************************************************************/
+
+static ssize_t mmcsd_flush(FAR void *dev, FAR const uint8_t *buffer,
+                           off_t startblock, size_t nblocks)
+{
+  FAR struct mmcsd_state_s *priv = (FAR struct mmcsd_state_s *)dev;
+#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
+  size_t block;
+  size_t endblock;
+#endif
+  ssize_t ret;
+
+  ret = mmcsd_takesem(priv);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+#ifdef MMCSD_HAVE_RWBUFFER
+  /* Never write data buffered for a card that was removed in the meantime
+   * to the card now in the slot.  This runs with the write buffer locked,
+   * so the check cannot race with mmcsd_rwbcheck() discarding the buffer.
+   */
+
+  if (priv->rwbremoved != priv->rwbdiscarded)
+    {
+      mmcsd_givesem(priv);
+      return -ENODEV;
+    }
+#endif
+
+#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
+  /* Write each block using only the single block transfer method */
+
+  ret = nblocks;
+  endblock = startblock + nblocks - 1;
+  for (block = startblock; block <= endblock; block++)
+    {
+      /* Write this block from the user buffer */
+
+      ssize_t nwritten = mmcsd_writesingle(priv, buffer, block);
+      if (nwritten < 0)
+        {
+          ret = nwritten;
+          break;
+        }
+
+      /* Increment the buffer pointer by the block size */
+
+      buffer += priv->blocksize;
+    }
+
+#else
+  /* Use either the single- or multiple-block transfer method */
+
+  if (nblocks == 1)
+    {
+      ret = mmcsd_writesingle(priv, buffer, startblock);
+    }
+  else
+    {
+      ret = mmcsd_writemultiple(priv, buffer, startblock, nblocks);
+    }
+
+#endif
+  mmcsd_givesem(priv);
+
+  /* On success, return the number of blocks written */
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: mmcsd_rwbcheck
+ *
+ * Description:
+ *   Discard the contents of the read/write buffer if the card that they
+ *   belong to was removed.  mmcsd_removed() cannot do this itself because
+ *   it holds the slot lock, which must be taken after the buffer locks.
+ *   The removal count is read under the slot lock, and it is marked as
+ *   handled only after the buffers were discarded, so mmcsd_flush() keeps
+ *   refusing the stale data until then.
+ *
+ ****************************************************************************/
+
+#ifdef MMCSD_HAVE_RWBUFFER
+static int mmcsd_rwbcheck(FAR struct mmcsd_state_s *priv)
+{
+  uint8_t removed;
+  bool stale;
+  int ret;
+
+  ret = mmcsd_takesem(priv);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  removed = priv->rwbremoved;
+  stale   = removed != priv->rwbdiscarded;
+  mmcsd_givesem(priv);
+
+  if (!stale)
+    {
+      return OK;
+    }
+
+  ret = rwb_mediaremoved(&priv->rwbuffer);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = mmcsd_takesem(priv);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  priv->rwbdiscarded = removed;
+  mmcsd_givesem(priv);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: mmcsd_open
  *
@@ -2057,6 +2277,15 @@ static int mmcsd_close(FAR struct inode *inode)
   DEBUGASSERT(inode && inode->i_private);
   priv = (FAR struct mmcsd_state_s *)inode->i_private;
 
+#ifdef CONFIG_MMCSD_WRITEBUFFER
+  /* Do not leave buffered writes behind when the file is closed */
+
+  if (mmcsd_rwbcheck(priv) == OK)
+    {
+      rwb_flush(&priv->rwbuffer);
+    }
+#endif
+
   /* Decrement the reference count on the block driver */
 
   DEBUGASSERT(priv->crefs > 0);
@@ -2084,65 +2313,31 @@ static ssize_t mmcsd_read(FAR struct inode *inode, unsigned char *buffer,
                           blkcnt_t startsector, unsigned int nsectors)
 {
   FAR struct mmcsd_state_s *priv;
-#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
-  size_t sector;
-  size_t endsector;
+#ifdef MMCSD_HAVE_RWBUFFER
+  int ret;
 #endif
-  ssize_t ret = nsectors;
 
   DEBUGASSERT(inode && inode->i_private);
   priv = (FAR struct mmcsd_state_s *)inode->i_private;
   finfo("startsector: %" PRIuOFF " nsectors: %u sectorsize: %d\n",
         startsector, nsectors, priv->blocksize);
 
-  if (nsectors > 0)
+  if (nsectors == 0)
     {
-      ret = mmcsd_takesem(priv);
-      if (ret < 0)
-        {
-          return (ssize_t)ret;
-        }
-
-#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
-      /* Read each block using only the single block transfer method */
-
-      ret = nsectors;
-      endsector = startsector + nsectors - 1;
-      for (sector = startsector; sector <= endsector; sector++)
-        {
-          /* Read this sector into the user buffer */
-
-          ssize_t nread = mmcsd_readsingle(priv, buffer, sector);
-          if (nread < 0)
-            {
-              ret = nread;
-              break;
-            }
-
-          /* Increment the buffer pointer by the sector size */
+      return 0;
+    }
 
-          buffer += priv->blocksize;
-        }
+#ifdef MMCSD_HAVE_RWBUFFER
+  ret = mmcsd_rwbcheck(priv);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
+  return rwb_read(&priv->rwbuffer, startsector, nsectors, buffer);
 #else
-      /* Use either the single- or multiple-block transfer method */
-
-      if (nsectors == 1)
-        {
-          ret = mmcsd_readsingle(priv, buffer, startsector);
-        }
-      else
-        {
-          ret = mmcsd_readmultiple(priv, buffer, startsector, nsectors);
-        }
-
+  return mmcsd_reload(priv, buffer, startsector, nsectors);
 #endif
-      mmcsd_givesem(priv);
-    }
-
-  /* On success, return the number of blocks read */
-
-  return ret;
 }
 
 /****************************************************************************
@@ -2159,11 +2354,9 @@ static ssize_t mmcsd_write(FAR struct inode *inode,
                            blkcnt_t startsector, unsigned int nsectors)
 {
   FAR struct mmcsd_state_s *priv;
-#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
-  size_t sector;
-  size_t endsector;
+#ifdef MMCSD_HAVE_RWBUFFER
+  int ret;
 #endif
-  ssize_t ret = nsectors;
 
   DEBUGASSERT(inode && inode->i_private);
   priv = (FAR struct mmcsd_state_s *)inode->i_private;
@@ -2171,54 +2364,22 @@ static ssize_t mmcsd_write(FAR struct inode *inode,
   finfo("sector: %lu nsectors: %u sectorsize: %u\n",
         (unsigned long)startsector, nsectors, priv->blocksize);
 
-  if (nsectors > 0)
+  if (nsectors == 0)
     {
-      ret = mmcsd_takesem(priv);
-      if (ret < 0)
-        {
-          return (ssize_t)ret;
-        }
-
-#if defined(CONFIG_MMCSD_MULTIBLOCK_DISABLE)
-      /* Write each block using only the single block transfer method */
-
-      ret = nsectors;
-      endsector = startsector + nsectors - 1;
-      for (sector = startsector; sector <= endsector; sector++)
-        {
-          /* Write this block from the user buffer */
-
-          ssize_t nread = mmcsd_writesingle(priv, buffer, sector);
-          if (nread < 0)
-            {
-              ret = nread;
-              break;
-            }
-
-          /* Increment the buffer pointer by the block size */
+      return 0;
+    }
 
-          buffer += priv->blocksize;
-        }
+#ifdef MMCSD_HAVE_RWBUFFER
+  ret = mmcsd_rwbcheck(priv);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
+  return rwb_write(&priv->rwbuffer, startsector, nsectors, buffer);
 #else
-      /* Use either the single- or multiple-block transfer method */
-
-      if (nsectors == 1)
-        {
-          ret = mmcsd_writesingle(priv, buffer, startsector);
-        }
-      else
-        {
-          ret = mmcsd_writemultiple(priv, buffer, startsector, nsectors);
-        }
-
+  return mmcsd_flush(priv, buffer, startsector, nsectors);
 #endif
-      mmcsd_givesem(priv);
-    }
-
-  /* On success, return the number of blocks written */
-
-  return ret;
 }
 
 /****************************************************************************
@@ -2297,6 +2458,27 @@ static int mmcsd_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
   DEBUGASSERT(inode && inode->i_private);
   priv  = (FAR struct mmcsd_state_s *)inode->i_private;
 
+#ifdef CONFIG_MMCSD_WRITEBUFFER
+  /* The write buffer must be flushed before the slot is locked:  The flush
+   * callback locks the slot itself.  Flush it before probing the slot, too,
+   * since the probe forgets the card that the buffered data belongs to.
+   */
+
+  if (cmd == BIOC_FLUSH || cmd == BIOC_PROBE || cmd == BIOC_EJECT)
+    {
+      ret = mmcsd_rwbcheck(priv);
+      if (ret == OK)
+        {
+          ret = rwb_flush(&priv->rwbuffer);
+        }
+
+      if (ret < 0 || cmd == BIOC_FLUSH)
+        {
+          return ret;
+        }
+    }
+#endif
+
   /* Process the IOCTL by command */
 
   ret = mmcsd_takesem(priv);
@@ -2339,6 +2521,10 @@ static int mmcsd_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       }
       break;
 
+    case BIOC_FLUSH: /* Nothing is buffered */
+      ret = OK;
+      break;
+
     default:
       ret = -ENOTTY;
       break;
@@ -3340,6 +3526,12 @@ static int mmcsd_probe(FAR struct mmcsd_state_s *priv)
               finfo("Capacity: %lu Kbytes\n",
                     (unsigned long)(priv->capacity / 1024));
               priv->mediachanged = true;
+
+#ifdef MMCSD_HAVE_RWBUFFER
+              /* Read-ahead must not go beyond the end of this card */
+
+              priv->rwbuffer.nblocks = priv->nblocks;
+#endif
             }
 
           /* When the card is identified, we have probed this card */
@@ -3401,6 +3593,14 @@ static int mmcsd_removed(FAR struct mmcsd_state_s *priv)
   priv->rca          = 0;
   priv->selblocklen  = 0;
 
+#ifdef MMCSD_HAVE_RWBUFFER
+  /* Whatever is buffered belongs to the old card.  It is discarded before
+   * the next transfer.
+   */
+
+  priv->rwbremoved++;
+#endif
+
   /* Go back to the default 1-bit data bus. */
 
   SDIO_WIDEBUS(priv->dev, false);
@@ -3573,6 +3773,25 @@ int mmcsd_slotinitialize(int minor, FAR struct sdio_dev_s *dev)
 
   priv->dev = dev;
 
+#ifdef MMCSD_HAVE_RWBUFFER
+  /* Configure read-ahead/write buffering.  The driver always transfers
+   * 512 byte blocks.
+   */
+
+  priv->rwbuffer.blocksize   = 512;
+  priv->rwbuffer.dev         = (FAR void *)priv;
+  priv->rwbuffer.wrflush     = mmcsd_flush;
+  priv->rwbuffer.rhreload    = mmcsd_reload;
+
+#ifdef CONFIG_MMCSD_WRITEBUFFER
+  priv->rwbuffer.wrmaxblocks = CONFIG_MMCSD_WRBUFFER_BLOCKS;
+#endif
+
+#ifdef CONFIG_MMCSD_READAHEAD
+  priv->rwbuffer.rhmaxblocks = CONFIG_MMCSD_RHBUFFER_BLOCKS;
+#endif
+#endif
+
   /* Initialize the hardware associated with the slot */
 
   ret = mmcsd_hwinitialize(priv);
@@ -3606,6 +3825,24 @@ int mmcsd_slotinitialize(int minor, FAR struct sdio_dev_s *dev)
         }
     }
 
+#ifdef MMCSD_HAVE_RWBUFFER
+  /* The size of the card is updated each time that a card is probed, but
+   * the buffer wants a size now, even if the slot is empty.
+   */
+
+  if (priv->rwbuffer.nblocks == 0)
+    {
+      priv->rwbuffer.nblocks = 1;
+    }
+
+  ret = rwb_initialize(&priv->rwbuffer);
+  if (ret < 0)
+    {
+      ferr("ERROR: rwb_initialize failed: %d\n", ret);
+      goto errout_with_hwinit;
+    }
+#endif
+
   /* Create a MMCSD device name */
 
   snprintf(devname, 16, "/dev/mmcsd%d", minor);
@@ -3616,12 +3853,17 @@ int mmcsd_slotinitialize(int minor, FAR struct sdio_dev_s *dev)
   if (ret < 0)
     {
       ferr("ERROR: register_blockdriver failed: %d\n", ret);
-      goto errout_with_hwinit;
+      goto errout_with_rwb;
     }
 
   return OK;
 
+errout_with_rwb:
+#ifdef MMCSD_HAVE_RWBUFFER
+  rwb_uninitialize(&priv->rwbuffer);
+
 errout_with_hwinit:
+#endif
   mmcsd_hwuninitialize(priv);
 errout_with_alloc:
   nxsem_destroy(&priv->sem);
@@ -578,6 +578,9 @@ static int ftl_unlink(FAR struct inode *inode)
 
 int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd)
 {
+#ifdef CONFIG_FTL_LOG
+  return ftl_log_initialize_by_path(path, mtd);
+#else
   struct ftl_struct_s *dev;
   int ret = -ENOMEM;
 
@@ -659,6 +662,7 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd)
     }
 
   return ret;
+#endif
 }
 
 /****************************************************************************
@@ -0,0 +1,1390 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/* A log-structured flash translation layer.
+ *
+ * Sectors are never rewritten in place.  Each write is appended to the
+ * currently open erase block and a RAM table maps every logical sector to
+ * the physical page holding its newest copy.  Superseded pages are
+ * reclaimed by garbage collection, which copies the remaining valid pages
+ * out of a victim erase block so that the block can be erased and reused.
+ *
+ * On-flash layout of each erase block:
+ *
+ *   Page 0:    Block header (magic, sequence number, erase count, CRC)
+ *   Page 1...: Runs of data pages, each preceded by a run record that
+ *              holds the number of pages in the run, the logical sector
+ *              of every page and the CRC32 of their contents.
+ *
+ * When the table is rebuilt at mount time, the scan steps from one run
+ * record to the next by the page counts, so the contents of the data
+ * pages are never taken for metadata.  The data CRC is the commit:  A run
+ * whose pages were not written completely (power loss) is ignored.  When
+ * the same logical sector appears more than once, the copy in the block
+ * with the higher sequence number, or the later copy in the same block,
+ * wins.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <crc32.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/mtd/mtd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if defined(CONFIG_SCHED_LPWORK) && CONFIG_FTL_LOG_BGFREE > 0
+#  define FTL_LOG_HAVE_BGGC 1
+#endif
+
+#define FTL_LOG_HEADER_MAGIC  0x424c5446  /* "FTLB" */
+#define FTL_LOG_RUN_MAGIC     0x524c5446  /* "FTLR" */
+
+#define FTL_LOG_NOPAGE        UINT32_MAX
+#define FTL_LOG_NOBLOCK       UINT32_MAX
+
+/* Foreground garbage collection keeps this many erase blocks free before
+ * opening a block for new data.  A collection then always has a block to
+ * copy into, even if power was lost in the middle of the previous one.
+ */
+
+#define FTL_LOG_MINFREE       3
+
+/* Erase block states */
+
+#define FTL_LOG_FREE          0  /* No valid pages, erased before reuse */
+#define FTL_LOG_USED          1  /* Written, may hold valid pages */
+#define FTL_LOG_OPEN          2  /* The block currently being appended to */
+#define FTL_LOG_GC            3  /* Being collected */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Header in page 0 of every erase block */
+
+struct ftl_log_header_s
+{
+  uint32_t magic;                 /* FTL_LOG_HEADER_MAGIC */
+  uint32_t seq;                   /* Order in which the block was opened */
+  uint32_t erasecount;            /* Number of times the block was erased */
+  uint32_t crc;                   /* CRC32 of the fields above */
+};
+
+/* Run record preceding each run of data pages */
+
+struct ftl_log_run_s
+{
+  uint32_t magic;                 /* FTL_LOG_RUN_MAGIC */
+  uint32_t seq;                   /* Sequence number of the erase block */
+  uint16_t page;                  /* Index of this page in the erase block */
+  uint16_t count;                 /* Number of data pages in the run */
+  uint32_t dcrc;                  /* CRC32 of the data pages */
+  uint32_t crc;                   /* CRC32 of the record with crc = 0 */
+  uint32_t lsec[1];               /* Logical sector of each data page */
+};
+
+#define SIZEOF_FTL_LOG_RUN_S(n) \
+  (sizeof(struct ftl_log_run_s) + ((n) - 1) * sizeof(uint32_t))
+
+/* RAM state of each erase block */
+
+struct ftl_log_block_s
+{
+  uint32_t seq;                   /* Sequence number from the header */
+  uint32_t erasecount;            /* Erase count from the header */
+  uint16_t valid;                 /* Number of valid data pages */
+  uint8_t  state;                 /* See FTL_LOG_FREE etc. */
+};
+
+struct ftl_log_s
+{
+  FAR struct mtd_dev_s *mtd;      /* Contained MTD interface */
+  struct mtd_geometry_s geo;      /* Device geometry */
+  sem_t                 exclsem;  /* Serializes access to the tables */
+#ifdef FTL_LOG_HAVE_BGGC
+  struct work_s         work;     /* Background garbage collection */
+#endif
+  uint16_t              blkper;   /* R/W blocks per erase block */
+  uint16_t              maxrun;   /* Data pages described by one record */
+  uint16_t              dense;    /* Data pages in a fully packed block */
+  uint16_t              wp;       /* Next free page in the open block */
+  uint16_t              refs;     /* Number of references */
+  bool                  unlinked; /* The driver has been unlinked */
+  uint8_t               erased;   /* Value of an erased byte */
+  uint32_t              nsectors; /* Logical sectors exported */
+  uint32_t              npages;   /* Physical pages on the device */
+  uint32_t              seq;      /* Sequence number of the next block */
+  uint32_t              nfree;    /* Number of free erase blocks */
+  uint32_t              open;     /* Open erase block or FTL_LOG_NOBLOCK */
+  FAR uint32_t         *l2p;      /* Logical sector to physical page */
+  FAR uint32_t         *p2l;      /* Physical page to logical sector */
+
+  /* State of each erase block */
+
+  FAR struct ftl_log_block_s *blocks;
+
+  FAR uint32_t         *gclsecs;  /* Logical sectors being collected */
+  FAR uint8_t          *gcbuf;    /* One erase block of data */
+  FAR uint8_t          *page;     /* One page for headers and records */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     ftl_log_open(FAR struct inode *inode);
+static int     ftl_log_close(FAR struct inode *inode);
+static ssize_t ftl_log_read(FAR struct inode *inode,
+                 FAR unsigned char *buffer, blkcnt_t start_sector,
+                 unsigned int nsectors);
+static ssize_t ftl_log_write(FAR struct inode *inode,
+                 FAR const unsigned char *buffer, blkcnt_t start_sector,
+                 unsigned int nsectors);
+static int     ftl_log_geometry(FAR struct inode *inode,
+                 FAR struct geometry *geometry);
+static int     ftl_log_ioctl(FAR struct inode *inode, int cmd,
+                 unsigned long arg);
+#ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
+static int     ftl_log_unlink(FAR struct inode *inode);
+#endif
+
+static int     ftl_log_program(FAR struct ftl_log_s *dev, uint32_t lsec,
+                 FAR const uint32_t *lsecs, FAR const uint8_t *buffer,
+                 size_t npages, bool gc);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct block_operations g_ftl_log_bops =
+{
+  ftl_log_open,     /* open     */
+  ftl_log_close,    /* close    */
+  ftl_log_read,     /* read     */
+  ftl_log_write,    /* write    */
+  ftl_log_geometry, /* geometry */
+  ftl_log_ioctl     /* ioctl    */
+#ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
+  , ftl_log_unlink  /* unlink   */
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_isblank
+ *
+ * Description:
+ *   Return true if the page has never been programmed since its erase
+ *   block was erased.
+ *
+ ****************************************************************************/
+
+static bool ftl_log_isblank(FAR struct ftl_log_s *dev,
+                            FAR const uint8_t *page)
+{
+  uint32_t i;
+
+  for (i = 0; i < dev->geo.blocksize; i++)
+    {
+      if (page[i] != dev->erased)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: ftl_log_header
+ *
+ * Description:
+ *   Return the block header in 'page' if it is intact, NULL otherwise.
+ *
+ ****************************************************************************/
+
+static FAR const struct ftl_log_header_s *
+ftl_log_header(FAR const uint8_t *page)
+{
+  FAR const struct ftl_log_header_s *hdr =
+    (FAR const struct ftl_log_header_s *)page;
+
+  if (hdr->magic != FTL_LOG_HEADER_MAGIC ||
+      hdr->crc != crc32(page, offsetof(struct ftl_log_header_s, crc)))
+    {
+      return NULL;
+    }
+
+  return hdr;
+}
+
+/****************************************************************************
+ * Name: ftl_log_run
+ *
+ * Description:
+ *   Return the run record in 'page' if it is an intact record written at
+ *   index 'index' of the erase block with sequence number 'seq', NULL
+ *   otherwise.
+ *
+ ****************************************************************************/
+
+static FAR const struct ftl_log_run_s *
+ftl_log_run(FAR struct ftl_log_s *dev, FAR uint8_t *page,
+            uint16_t index, uint32_t seq)
+{
+  FAR struct ftl_log_run_s *run = (FAR struct ftl_log_run_s *)page;
+  uint32_t crc;
+  bool valid;
+
+  if (run->magic != FTL_LOG_RUN_MAGIC || run->seq != seq ||
+      run->page != index || run->count == 0 ||
+      run->count > dev->maxrun || run->count >= dev->blkper - index)
+    {
+      return NULL;
+    }
+
+  crc      = run->crc;
+  run->crc = 0;
+  valid    = crc == crc32(page, SIZEOF_FTL_LOG_RUN_S(run->count));
+  run->crc = crc;
+
+  return valid ? run : NULL;
+}
+
+/****************************************************************************
+ * Name: ftl_log_map
+ *
+ * Description:
+ *   Point logical sector 'lsec' at physical page 'ppage' and invalidate the
+ *   copy it replaces.  A written block that loses its last valid page is
+ *   free again.
+ *
+ ****************************************************************************/
+
+static void ftl_log_map(FAR struct ftl_log_s *dev, uint32_t lsec,
+                        uint32_t ppage)
+{
+  FAR struct ftl_log_block_s *blk;
+  uint32_t old = dev->l2p[lsec];
+
+  if (old != FTL_LOG_NOPAGE)
+    {
+      blk = &dev->blocks[old / dev->blkper];
+      dev->p2l[old] = FTL_LOG_NOPAGE;
+
+      DEBUGASSERT(blk->valid > 0);
+      if (--blk->valid == 0 && blk->state == FTL_LOG_USED)
+        {
+          blk->state = FTL_LOG_FREE;
+          dev->nfree++;
+        }
+    }
+
+  dev->l2p[lsec]  = ppage;
+  dev->p2l[ppage] = lsec;
+  dev->blocks[ppage / dev->blkper].valid++;
+}
+
+/****************************************************************************
+ * Name: ftl_log_openblock
+ *
+ * Description:
+ *   Erase the free block with the lowest erase count and make it the block
+ *   that new data is appended to.
+ *
+ ****************************************************************************/
+
+static int ftl_log_openblock(FAR struct ftl_log_s *dev)
+{
+  FAR struct ftl_log_header_s *hdr;
+  FAR struct ftl_log_block_s *blk;
+  uint32_t best = FTL_LOG_NOBLOCK;
+  uint32_t i;
+  ssize_t nxfrd;
+  int ret;
+
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      if (dev->blocks[i].state == FTL_LOG_FREE &&
+          (best == FTL_LOG_NOBLOCK ||
+           dev->blocks[i].erasecount < dev->blocks[best].erasecount))
+        {
+          best = i;
+        }
+    }
+
+  if (best == FTL_LOG_NOBLOCK)
+    {
+      ferr("ERROR: No free erase block\n");
+      return -ENOSPC;
+    }
+
+  blk = &dev->blocks[best];
+  ret = MTD_ERASE(dev->mtd, best, 1);
+  if (ret < 0)
+    {
+      ferr("ERROR: Erase block=%" PRIu32 " failed: %d\n", best, ret);
+      return ret;
+    }
+
+  blk->erasecount++;
+  blk->seq = dev->seq++;
+
+  memset(dev->page, dev->erased, dev->geo.blocksize);
+  hdr             = (FAR struct ftl_log_header_s *)dev->page;
+  hdr->magic      = FTL_LOG_HEADER_MAGIC;
+  hdr->seq        = blk->seq;
+  hdr->erasecount = blk->erasecount;
+  hdr->crc        = crc32(dev->page, offsetof(struct ftl_log_header_s, crc));
+
+  nxfrd = MTD_BWRITE(dev->mtd, best * dev->blkper, 1, dev->page);
+  if (nxfrd != 1)
+    {
+      ferr("ERROR: Write header of block=%" PRIu32 " failed: %zd\n",
+           best, nxfrd);
+      return nxfrd < 0 ? nxfrd : -EIO;
+    }
+
+  /* The previous open block is now an ordinary written block */
+
+  if (dev->open != FTL_LOG_NOBLOCK)
+    {
+      FAR struct ftl_log_block_s *prev = &dev->blocks[dev->open];
+
+      prev->state = FTL_LOG_USED;
+      if (prev->valid == 0)
+        {
+          prev->state = FTL_LOG_FREE;
+          dev->nfree++;
+        }
+    }
+
+  finfo("Open block=%" PRIu32 " seq=%" PRIu32 " erasecount=%" PRIu32 "\n",
+        best, blk->seq, blk->erasecount);
+
+  blk->state = FTL_LOG_OPEN;
+  dev->nfree--;
+  dev->open  = best;
+  dev->wp    = 1;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_victim
+ *
+ * Description:
+ *   Select the written block to garbage collect next.  Blocks that are
+ *   completely valid cannot gain anything and are never selected.
+ *
+ ****************************************************************************/
+
+static uint32_t ftl_log_victim(FAR struct ftl_log_s *dev)
+{
+  FAR struct ftl_log_block_s *blk;
+  uint32_t victim = FTL_LOG_NOBLOCK;
+  uint64_t best = 0;
+  uint64_t score;
+  uint32_t i;
+
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      blk = &dev->blocks[i];
+      if (blk->state != FTL_LOG_USED || blk->valid >= dev->dense)
+        {
+          continue;
+        }
+
+#ifdef CONFIG_FTL_LOG_GC_GREEDY
+      /* Greedy:  Fewest valid pages to copy */
+
+      score = dev->dense - blk->valid;
+#else
+      /* Cost-benefit:  Space gained times the age of the data, divided by
+       * the cost of reading and rewriting the valid pages.  Old, mostly
+       * stale blocks are preferred over recently written ones that may
+       * still become more stale by themselves.
+       */
+
+      score = (uint64_t)(dev->dense - blk->valid) *
+              (dev->seq - blk->seq) / (dev->dense + blk->valid);
+#endif
+
+      if (victim == FTL_LOG_NOBLOCK || score > best)
+        {
+          victim = i;
+          best   = score;
+        }
+    }
+
+  return victim;
+}
+
+/****************************************************************************
+ * Name: ftl_log_collect
+ *
+ * Description:
+ *   Copy valid pages to the open block, starting with those of 'victim' and
+ *   continuing with the next victims until the block is full.  Filling the
+ *   block with a single run keeps it packed as densely as possible; runs of
+ *   one victim each would waste the pages after the last run that fits.
+ *   A victim becomes free when its last valid page has been moved.
+ *
+ ****************************************************************************/
+
+static int ftl_log_collect(FAR struct ftl_log_s *dev, uint32_t victim)
+{
+  uint32_t base;
+  uint32_t lsec;
+  uint32_t i;
+  size_t npages = 0;
+  size_t room;
+  ssize_t nxfrd;
+  uint16_t p;
+  int ret;
+
+  if (dev->open == FTL_LOG_NOBLOCK || dev->blkper - dev->wp < 2)
+    {
+      ret = ftl_log_openblock(dev);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  room = dev->blkper - dev->wp - 1;
+  if (room > dev->maxrun)
+    {
+      room = dev->maxrun;
+    }
+
+  ret = OK;
+  while (victim != FTL_LOG_NOBLOCK && npages < room)
+    {
+      finfo("Collect block=%" PRIu32 " valid=%u\n",
+            victim, dev->blocks[victim].valid);
+
+      /* Keep the victim from being selected again */
+
+      dev->blocks[victim].state = FTL_LOG_GC;
+      base = victim * dev->blkper;
+
+      for (p = 1; p < dev->blkper && npages < room; p++)
+        {
+          lsec = dev->p2l[base + p];
+          if (lsec == FTL_LOG_NOPAGE)
+            {
+              continue;
+            }
+
+          nxfrd = MTD_BREAD(dev->mtd, base + p, 1,
+                            dev->gcbuf + npages * dev->geo.blocksize);
+          if (nxfrd != 1)
+            {
+              ferr("ERROR: Read page %" PRIu32 " failed: %zd\n",
+                   base + p, nxfrd);
+              ret = nxfrd < 0 ? nxfrd : -EIO;
+              goto errout;
+            }
+
+          dev->gclsecs[npages++] = lsec;
+        }
+
+      victim = ftl_log_victim(dev);
+    }
+
+errout:
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      if (dev->blocks[i].state == FTL_LOG_GC)
+        {
+          dev->blocks[i].state = FTL_LOG_USED;
+        }
+    }
+
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return ftl_log_program(dev, 0, dev->gclsecs, dev->gcbuf, npages, true);
+}
+
+/****************************************************************************
+ * Name: ftl_log_wearlevel
+ *
+ * Description:
+ *   Static wear leveling:  Data that is never rewritten pins its erase
+ *   block, so that block is never erased while the others wear out.  When
+ *   the spread of the erase counts gets too large, move the data out of the
+ *   least worn written block so that the block is reused for new data.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FTL_LOG_WLTHRESHOLD > 0
+static int ftl_log_wearlevel(FAR struct ftl_log_s *dev)
+{
+  FAR struct ftl_log_block_s *blk;
+  uint32_t cold = FTL_LOG_NOBLOCK;
+  uint32_t max = 0;
+  uint32_t i;
+
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      blk = &dev->blocks[i];
+      if (blk->erasecount > max)
+        {
+          max = blk->erasecount;
+        }
+
+      if (blk->state == FTL_LOG_USED &&
+          (cold == FTL_LOG_NOBLOCK ||
+           blk->erasecount < dev->blocks[cold].erasecount))
+        {
+          cold = i;
+        }
+    }
+
+  if (cold == FTL_LOG_NOBLOCK ||
+      max - dev->blocks[cold].erasecount <= CONFIG_FTL_LOG_WLTHRESHOLD)
+    {
+      return OK;
+    }
+
+  finfo("Wear level block=%" PRIu32 " erasecount=%" PRIu32 " max=%" PRIu32
+        "\n", cold, dev->blocks[cold].erasecount, max);
+
+  return ftl_log_collect(dev, cold);
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_makeroom
+ *
+ * Description:
+ *   Make sure that there is an open block with room for at least one run
+ *   record and a data page, garbage collecting in the foreground if too few
+ *   blocks are free.
+ *
+ ****************************************************************************/
+
+static int ftl_log_makeroom(FAR struct ftl_log_s *dev)
+{
+  uint32_t victim;
+  uint32_t i;
+  int ret;
+
+  for (i = 0; dev->nfree < FTL_LOG_MINFREE; i++)
+    {
+      victim = ftl_log_victim(dev);
+      if (victim == FTL_LOG_NOBLOCK ||
+          i >= dev->geo.neraseblocks * dev->blkper)
+        {
+          ferr("ERROR: Garbage collection made no progress\n");
+          return -ENOSPC;
+        }
+
+      ret = ftl_log_collect(dev, victim);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+#if CONFIG_FTL_LOG_WLTHRESHOLD > 0
+  ret = ftl_log_wearlevel(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
+  /* Collecting may have opened a block that still has room */
+
+  if (dev->open != FTL_LOG_NOBLOCK && dev->blkper - dev->wp >= 2)
+    {
+      return OK;
+    }
+
+  return ftl_log_openblock(dev);
+}
+
+/****************************************************************************
+ * Name: ftl_log_program
+ *
+ * Description:
+ *   Append 'npages' pages from 'buffer' to the log and map them.  The
+ *   logical sectors are taken from 'lsecs' if it is not NULL, otherwise
+ *   they are consecutive starting at 'lsec'.  Garbage collection ('gc')
+ *   must not recurse, so it only opens new blocks.
+ *
+ ****************************************************************************/
+
+static int ftl_log_program(FAR struct ftl_log_s *dev, uint32_t lsec,
+                           FAR const uint32_t *lsecs,
+                           FAR const uint8_t *buffer, size_t npages,
+                           bool gc)
+{
+  FAR struct ftl_log_run_s *run;
+  uint32_t first;
+  size_t count;
+  size_t i;
+  ssize_t nxfrd;
+  int ret;
+
+  while (npages > 0)
+    {
+      if (dev->open == FTL_LOG_NOBLOCK || dev->blkper - dev->wp < 2)
+        {
+          ret = gc ? ftl_log_openblock(dev) : ftl_log_makeroom(dev);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          continue;
+        }
+
+      /* Write as many data pages as fit after the run record */
+
+      count = dev->blkper - dev->wp - 1;
+      if (count > dev->maxrun)
+        {
+          count = dev->maxrun;
+        }
+
+      if (count > npages)
+        {
+          count = npages;
+        }
+
+      memset(dev->page, dev->erased, dev->geo.blocksize);
+      run        = (FAR struct ftl_log_run_s *)dev->page;
+      run->magic = FTL_LOG_RUN_MAGIC;
+      run->seq   = dev->blocks[dev->open].seq;
+      run->page  = dev->wp;
+      run->count = count;
+      run->dcrc  = crc32(buffer, count * dev->geo.blocksize);
+      run->crc   = 0;
+
+      for (i = 0; i < count; i++)
+        {
+          run->lsec[i] = lsecs != NULL ? lsecs[i] : lsec + i;
+        }
+
+      run->crc = crc32(dev->page, SIZEOF_FTL_LOG_RUN_S(count));
+
+      first = dev->open * dev->blkper + dev->wp;
+      nxfrd = MTD_BWRITE(dev->mtd, first, 1, dev->page);
+      if (nxfrd != 1)
+        {
+          /* The record may be partially programmed.  Nothing after it
+           * could be found again, so the block takes no more runs.
+           */
+
+          ferr("ERROR: Write run record at %" PRIu32 " failed: %zd\n",
+               first, nxfrd);
+          dev->wp = dev->blkper;
+          return nxfrd < 0 ? nxfrd : -EIO;
+        }
+
+      /* The pages of the run are used up even if they can't be written,
+       * the scan skips them by the count in the record.
+       */
+
+      dev->wp += count + 1;
+      first++;
+
+      nxfrd = MTD_BWRITE(dev->mtd, first, count, buffer);
+      if (nxfrd != count)
+        {
+          ferr("ERROR: Write %zu pages at %" PRIu32 " failed: %zd\n",
+               count, first, nxfrd);
+          return nxfrd < 0 ? nxfrd : -EIO;
+        }
+
+      for (i = 0; i < count; i++)
+        {
+          ftl_log_map(dev, lsecs != NULL ? lsecs[i] : lsec + i, first + i);
+        }
+
+      buffer += count * dev->geo.blocksize;
+      npages -= count;
+      lsec   += count;
+      if (lsecs != NULL)
+        {
+          lsecs += count;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_worker
+ *
+ * Description:
+ *   Collect garbage in the background while the number of free blocks is
+ *   below the watermark, so that writes rarely have to wait for it.
+ *
+ ****************************************************************************/
+
+#ifdef FTL_LOG_HAVE_BGGC
+static void ftl_log_worker(FAR void *arg)
+{
+  FAR struct ftl_log_s *dev = (FAR struct ftl_log_s *)arg;
+  uint32_t victim;
+  uint32_t i;
+
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      /* Give writers a chance between the collections */
+
+      if (nxsem_wait_uninterruptible(&dev->exclsem) < 0)
+        {
+          return;
+        }
+
+      victim = FTL_LOG_NOBLOCK;
+      if (dev->nfree < CONFIG_FTL_LOG_BGFREE)
+        {
+          victim = ftl_log_victim(dev);
+        }
+
+      if (victim == FTL_LOG_NOBLOCK || ftl_log_collect(dev, victim) < 0)
+        {
+          nxsem_post(&dev->exclsem);
+          break;
+        }
+
+      nxsem_post(&dev->exclsem);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_scan
+ *
+ * Description:
+ *   Rebuild the mapping tables from the headers and run records on flash.
+ *
+ ****************************************************************************/
+
+static int ftl_log_scan(FAR struct ftl_log_s *dev)
+{
+  FAR const struct ftl_log_header_s *hdr;
+  FAR const struct ftl_log_run_s *run;
+  FAR struct ftl_log_block_s *blk;
+  FAR uint8_t *page;
+  uint64_t total = 0;
+  uint32_t nknown = 0;
+  uint32_t maxseq = 0;
+  uint32_t base;
+  uint32_t ppage;
+  uint32_t lsec;
+  uint32_t old;
+  uint32_t i;
+  uint16_t wp = 0;
+  uint16_t p;
+  uint16_t n;
+  ssize_t nxfrd;
+
+  dev->open = FTL_LOG_NOBLOCK;
+
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      blk  = &dev->blocks[i];
+      base = i * dev->blkper;
+
+      nxfrd = MTD_BREAD(dev->mtd, base, dev->blkper, dev->gcbuf);
+      if (nxfrd != dev->blkper)
+        {
+          ferr("ERROR: Read block=%" PRIu32 " failed: %zd\n", i, nxfrd);
+          return nxfrd < 0 ? nxfrd : -EIO;
+        }
+
+      /* A block without an intact header holds no data.  Its erase count
+       * is unknown.
+       */
+
+      hdr = ftl_log_header(dev->gcbuf);
+      if (hdr == NULL)
+        {
+          blk->state      = FTL_LOG_FREE;
+          blk->erasecount = UINT32_MAX;
+          continue;
+        }
+
+      blk->state      = FTL_LOG_USED;
+      blk->seq        = hdr->seq;
+      blk->erasecount = hdr->erasecount;
+      total          += hdr->erasecount;
+      nknown++;
+
+      /* Replay the committed runs, stepping from one run record to the
+       * next.  The first blank record page ends the log of the block.  A
+       * record that is not intact ends it, too, since the runs after it
+       * can't be found anymore; the block then takes no more runs.
+       */
+
+      p = 1;
+      while (p < dev->blkper)
+        {
+          page = dev->gcbuf + p * dev->geo.blocksize;
+          if (ftl_log_isblank(dev, page))
+            {
+              break;
+            }
+
+          run = ftl_log_run(dev, page, p, blk->seq);
+          if (run == NULL)
+            {
+              p = dev->blkper;
+              break;
+            }
+
+          /* Skip a run whose pages were not all written */
+
+          if (run->dcrc != crc32(page + dev->geo.blocksize,
+                                 run->count * dev->geo.blocksize))
+            {
+              p += run->count + 1;
+              continue;
+            }
+
+          for (n = 0; n < run->count; n++)
+            {
+              lsec = run->lsec[n];
+              if (lsec >= dev->nsectors)
+                {
+                  continue;
+                }
+
+              /* Later pages of this block and pages of newer blocks
+               * replace older copies.
+               */
+
+              ppage = base + p + 1 + n;
+              old   = dev->l2p[lsec];
+              if (old != FTL_LOG_NOPAGE &&
+                  old / dev->blkper != i &&
+                  dev->blocks[old / dev->blkper].seq > blk->seq)
+                {
+                  continue;
+                }
+
+              if (old != FTL_LOG_NOPAGE)
+                {
+                  dev->p2l[old] = FTL_LOG_NOPAGE;
+                  dev->blocks[old / dev->blkper].valid--;
+                }
+
+              dev->l2p[lsec]  = ppage;
+              dev->p2l[ppage] = lsec;
+              blk->valid++;
+            }
+
+          p += run->count + 1;
+        }
+
+      /* The most recently opened block continues to be appended to */
+
+      if (dev->open == FTL_LOG_NOBLOCK || blk->seq > maxseq)
+        {
+          dev->open = i;
+          maxseq    = blk->seq;
+          wp        = p;
+        }
+    }
+
+  dev->seq = maxseq + 1;
+  if (dev->open != FTL_LOG_NOBLOCK)
+    {
+      if (dev->blkper - wp >= 2)
+        {
+          dev->blocks[dev->open].state = FTL_LOG_OPEN;
+          dev->wp = wp;
+        }
+      else
+        {
+          dev->open = FTL_LOG_NOBLOCK;
+        }
+    }
+
+  /* Written blocks without valid data are free.  Blocks that lost their
+   * erase count are assumed to be worn like the average.
+   */
+
+  dev->nfree = 0;
+  for (i = 0; i < dev->geo.neraseblocks; i++)
+    {
+      blk = &dev->blocks[i];
+      if (blk->state == FTL_LOG_USED && blk->valid == 0)
+        {
+          blk->state = FTL_LOG_FREE;
+        }
+
+      if (blk->state == FTL_LOG_FREE)
+        {
+          dev->nfree++;
+        }
+
+      if (blk->erasecount == UINT32_MAX)
+        {
+          blk->erasecount = nknown > 0 ? total / nknown : 0;
+        }
+    }
+
+  finfo("nfree=%" PRIu32 " open=%" PRIu32 " seq=%" PRIu32 "\n",
+        dev->nfree, dev->open, dev->seq);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_free
+ ****************************************************************************/
+
+static void ftl_log_free(FAR struct ftl_log_s *dev)
+{
+#ifdef FTL_LOG_HAVE_BGGC
+  work_cancel(LPWORK, &dev->work);
+#endif
+
+  kmm_free(dev->l2p);
+  kmm_free(dev->p2l);
+  kmm_free(dev->blocks);
+  kmm_free(dev->gclsecs);
+  kmm_free(dev->gcbuf);
+  kmm_free(dev->page);
+  nxsem_destroy(&dev->exclsem);
+  kmm_free(dev);
+}
+
+/****************************************************************************
+ * Name: ftl_log_open
+ *
+ * Description: Open the block device
+ *
+ ****************************************************************************/
+
+static int ftl_log_open(FAR struct inode *inode)
+{
+  FAR struct ftl_log_s *dev;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct ftl_log_s *)inode->i_private;
+
+  dev->refs++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_close
+ *
+ * Description: close the block device
+ *
+ ****************************************************************************/
+
+static int ftl_log_close(FAR struct inode *inode)
+{
+  FAR struct ftl_log_s *dev;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct ftl_log_s *)inode->i_private;
+
+  if (--dev->refs == 0 && dev->unlinked)
+    {
+      ftl_log_free(dev);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_read
+ *
+ * Description:  Read the specified number of sectors
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_log_read(FAR struct inode *inode,
+                            FAR unsigned char *buffer,
+                            blkcnt_t start_sector, unsigned int nsectors)
+{
+  FAR struct ftl_log_s *dev;
+  uint32_t ppage;
+  size_t nread = 0;
+  size_t n;
+  ssize_t nxfrd;
+  int ret;
+
+  finfo("sector: %" PRIuOFF " nsectors: %u\n", start_sector, nsectors);
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct ftl_log_s *)inode->i_private;
+
+  if (start_sector < 0 || start_sector + nsectors > dev->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  ret = nxsem_wait_uninterruptible(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  while (nread < nsectors)
+    {
+      /* Sectors that were never written read as erased flash */
+
+      ppage = dev->l2p[start_sector + nread];
+      if (ppage == FTL_LOG_NOPAGE)
+        {
+          memset(buffer, dev->erased, dev->geo.blocksize);
+          buffer += dev->geo.blocksize;
+          nread++;
+          continue;
+        }
+
+      /* Sectors written together are usually still adjacent on flash */
+
+      for (n = 1; nread + n < nsectors; n++)
+        {
+          if (dev->l2p[start_sector + nread + n] != ppage + n)
+            {
+              break;
+            }
+        }
+
+      nxfrd = MTD_BREAD(dev->mtd, ppage, n, buffer);
+      if (nxfrd != n)
+        {
+          ferr("ERROR: Read %zu pages at %" PRIu32 " failed: %zd\n",
+               n, ppage, nxfrd);
+          nxsem_post(&dev->exclsem);
+          return nxfrd < 0 ? nxfrd : -EIO;
+        }
+
+      buffer += n * dev->geo.blocksize;
+      nread  += n;
+    }
+
+  nxsem_post(&dev->exclsem);
+  return nread;
+}
+
+/****************************************************************************
+ * Name: ftl_log_write
+ *
+ * Description: Write the specified number of sectors
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_log_write(FAR struct inode *inode,
+                             FAR const unsigned char *buffer,
+                             blkcnt_t start_sector, unsigned int nsectors)
+{
+  FAR struct ftl_log_s *dev;
+  int ret;
+
+  finfo("sector: %" PRIuOFF " nsectors: %u\n", start_sector, nsectors);
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct ftl_log_s *)inode->i_private;
+
+  if (start_sector < 0 || start_sector + nsectors > dev->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  ret = nxsem_wait_uninterruptible(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = ftl_log_program(dev, start_sector, NULL, buffer, nsectors, false);
+
+#ifdef FTL_LOG_HAVE_BGGC
+  if (dev->nfree < CONFIG_FTL_LOG_BGFREE && work_available(&dev->work))
+    {
+      work_queue(LPWORK, &dev->work, ftl_log_worker, dev, 0);
+    }
+#endif
+
+  nxsem_post(&dev->exclsem);
+  return ret < 0 ? (ssize_t)ret : nsectors;
+}
+
+/****************************************************************************
+ * Name: ftl_log_geometry
+ *
+ * Description: Return device geometry
+ *
+ ****************************************************************************/
+
+static int ftl_log_geometry(FAR struct inode *inode,
+                            FAR struct geometry *geometry)
+{
+  FAR struct ftl_log_s *dev;
+
+  DEBUGASSERT(inode);
+  if (geometry)
+    {
+      dev = (FAR struct ftl_log_s *)inode->i_private;
+      geometry->geo_available     = true;
+      geometry->geo_mediachanged  = false;
+      geometry->geo_writeenabled  = true;
+      geometry->geo_nsectors      = dev->nsectors;
+      geometry->geo_sectorsize    = dev->geo.blocksize;
+
+      finfo("nsectors: %" PRIuOFF " sectorsize: %u\n",
+            geometry->geo_nsectors, geometry->geo_sectorsize);
+
+      return OK;
+    }
+
+  return -EINVAL;
+}
+
+/****************************************************************************
+ * Name: ftl_log_ioctl
+ *
+ * Description: Handle block driver ioctl commands
+ *
+ ****************************************************************************/
+
+static int ftl_log_ioctl(FAR struct inode *inode, int cmd,
+                         unsigned long arg)
+{
+  FAR struct ftl_log_s *dev;
+  int ret;
+
+  finfo("Entry\n");
+  DEBUGASSERT(inode && inode->i_private);
+
+  dev = (FAR struct ftl_log_s *)inode->i_private;
+
+  /* The sectors are not at linear addresses on the FLASH, so they can't be
+   * executed in place, and erasing the MTD device would pull the FLASH out
+   * from under the mapping tables.
+   */
+
+  if (cmd == BIOC_XIPBASE || cmd == MTDIOC_BULKERASE)
+    {
+      return -ENOTTY;
+    }
+
+  /* Every write is committed before it returns, so there is nothing to
+   * flush here.  Other commands are passed through to the MTD driver.
+   */
+
+  ret = MTD_IOCTL(dev->mtd, cmd, arg);
+  if (ret < 0 && ret != -ENOTTY)
+    {
+      ferr("ERROR: MTD ioctl(%04x) failed: %d\n", cmd, ret);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_unlink
+ *
+ * Description: Unlink the device
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
+static int ftl_log_unlink(FAR struct inode *inode)
+{
+  FAR struct ftl_log_s *dev;
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct ftl_log_s *)inode->i_private;
+
+  dev->unlinked = true;
+  if (dev->refs == 0)
+    {
+      ftl_log_free(dev);
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize_by_path
+ *
+ * Description:
+ *   Initialize a log-structured block driver wrapper around an MTD
+ *   interface.  The mapping is rebuilt from the contents of the FLASH;
+ *   FLASH that does not hold an FTL log is used as if blank.
+ *
+ * Input Parameters:
+ *   path - The block device path.
+ *   mtd  - The MTD device that supports the FLASH interface.
+ *
+ ****************************************************************************/
+
+int ftl_log_initialize_by_path(FAR const char *path,
+                               FAR struct mtd_dev_s *mtd)
+{
+  FAR struct ftl_log_s *dev;
+  uint32_t usable;
+  uint32_t i;
+  int ret;
+
+  /* Sanity check */
+
+  if (path == NULL || mtd == NULL)
+    {
+      return -EINVAL;
+    }
+
+  finfo("path=\"%s\"\n", path);
+
+  dev = (FAR struct ftl_log_s *)kmm_zalloc(sizeof(struct ftl_log_s));
+  if (dev == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  dev->mtd = mtd;
+  nxsem_init(&dev->exclsem, 0, 1);
+
+  ret = MTD_IOCTL(mtd, MTDIOC_GEOMETRY,
+                  (unsigned long)((uintptr_t)&dev->geo));
+  if (ret < 0)
+    {
+      ferr("ERROR: MTD ioctl(MTDIOC_GEOMETRY) failed: %d\n", ret);
+      goto errout;
+    }
+
+  if (MTD_IOCTL(mtd, MTDIOC_ERASESTATE,
+                (unsigned long)((uintptr_t)&dev->erased)) < 0)
+    {
+      dev->erased = 0xff;
+    }
+
+  /* Each erase block needs room for the header, a run record and a data
+   * page.  Runs are as long as one record page can describe.
+   */
+
+  dev->blkper = dev->geo.erasesize / dev->geo.blocksize;
+  DEBUGASSERT(dev->blkper * dev->geo.blocksize == dev->geo.erasesize);
+
+  if (dev->blkper < 3 ||
+      dev->geo.blocksize < SIZEOF_FTL_LOG_RUN_S(1) ||
+      dev->geo.neraseblocks <= CONFIG_FTL_LOG_SPAREBLOCKS ||
+      CONFIG_FTL_LOG_SPAREBLOCKS <= FTL_LOG_MINFREE)
+    {
+      ferr("ERROR: Unsupported geometry\n");
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  dev->maxrun   = (dev->geo.blocksize - SIZEOF_FTL_LOG_RUN_S(0)) /
+                  sizeof(uint32_t);
+  usable        = dev->blkper - 1;
+  dev->dense    = usable - (usable + dev->maxrun) / (dev->maxrun + 1);
+  dev->npages   = dev->geo.neraseblocks * dev->blkper;
+
+  /* The spare blocks guarantee that garbage collection always finds
+   * stale pages to reclaim, even when the logical device is full.
+   */
+
+  dev->nsectors = (dev->geo.neraseblocks - CONFIG_FTL_LOG_SPAREBLOCKS) *
+                  dev->dense;
+
+  dev->l2p      = kmm_malloc(dev->nsectors * sizeof(uint32_t));
+  dev->p2l      = kmm_malloc(dev->npages * sizeof(uint32_t));
+  dev->blocks   = kmm_zalloc(dev->geo.neraseblocks *
+                             sizeof(struct ftl_log_block_s));
+  dev->gclsecs  = kmm_malloc(dev->blkper * sizeof(uint32_t));
+  dev->gcbuf    = kmm_malloc(dev->geo.erasesize);
+  dev->page     = kmm_malloc(dev->geo.blocksize);
+
+  if (dev->l2p == NULL || dev->p2l == NULL || dev->blocks == NULL ||
+      dev->gclsecs == NULL || dev->gcbuf == NULL || dev->page == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  for (i = 0; i < dev->nsectors; i++)
+    {
+      dev->l2p[i] = FTL_LOG_NOPAGE;
+    }
+
+  for (i = 0; i < dev->npages; i++)
+    {
+      dev->p2l[i] = FTL_LOG_NOPAGE;
+    }
+
+  ret = ftl_log_scan(dev);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  /* Inode private data is a reference to the FTL device structure */
+
+  ret = register_blockdriver(path, &g_ftl_log_bops, 0, dev);
+  if (ret < 0)
+    {
+      ferr("ERROR: register_blockdriver failed: %d\n", -ret);
+      goto errout;
+    }
+
+  return OK;
+
+errout:
+  ftl_log_free(dev);
+  return ret;
+}
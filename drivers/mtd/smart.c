@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <strings.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -43,7 +44,11 @@
 #include <crc32.h>
 #include <debug.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/signal.h>
+#include <nuttx/wqueue.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mtd/mtd.h>
@@ -143,6 +148,15 @@
 #define SMART_WEARFLAGS_FORCE_REORG         0x01
 #define SMART_WEARFLAGS_WRITE_NEEDED        0x02
 
+/* Background garbage collection starts when fewer free sectors than this
+ * remain.  Foreground collection starts at one erase block plus 4.
+ */
+
+#ifdef CONFIG_MTD_SMART_BGGC
+#  define SMART_BGGC_WATERMARK(d) \
+     (CONFIG_MTD_SMART_BGGC_FREEBLOCKS * (d)->sectorsperblk)
+#endif
+
 #define SET_BITMAP(m, n) do { (m)[(n) / 8] |= 1 << ((n) % 8); } while (0)
 #define CLR_BITMAP(m, n) do { (m)[(n) / 8] &= ~(1 << ((n) % 8)); } while (0)
 #define ISSET_BITMAP(m, n) ((m)[(n) / 8] & (1 << ((n) % 8)))
@@ -223,9 +237,23 @@ struct smart_struct_s
   FAR struct mtd_dev_s *mtd;              /* Contained MTD interface */
   struct mtd_geometry_s geo;              /* Device geometry */
 
+  sem_t                 exclsem;          /* Serializes access to the device */
+#ifdef CONFIG_MTD_SMART_BGGC
+  struct work_s         gcwork;           /* Background garbage collection */
+  bool                  gcbusy;           /* gcwork is queued or running */
+  bool                  gcstop;           /* No more background collection */
+#endif
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
   uint32_t              unusedsectors;    /* Count of unused sectors (i.e. free when erased) */
   uint32_t              blockerases;      /* Count of unused sectors (i.e. free when erased) */
+  uint32_t              fgcollections;    /* Blocks collected during writes */
+#ifdef CONFIG_MTD_SMART_BGGC
+  uint32_t              bgcollections;    /* Blocks collected in the background */
+#endif
+  uint32_t              writes;           /* Number of sector writes */
+  uint32_t              writemax;         /* Longest sector write (usec) */
+  uint64_t              writetotal;       /* Sum of all sector writes (usec) */
+  uint32_t              writehist[SMART_WRITE_HIST_NBUCKETS];
 #endif
   uint16_t              neraseblocks;     /* Number of erase blocks or sub-sectors */
   uint16_t              lastallocblock;   /* Last  block we allocated a sector from */
@@ -238,6 +266,9 @@ struct smart_struct_s
   uint32_t              erasesize;        /* Size of an erase block */
   FAR uint8_t          *releasecount;     /* Count of released sectors per erase block */
   FAR uint8_t          *freecount;        /* Count of free sectors per erase block */
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  FAR uint8_t          *freemap;          /* Bit set for each erased, unallocated sector */
+#endif
   FAR char             *rwbuffer;         /* Our sector read/write buffer */
   char                  partname[SMART_PARTNAME_SIZE];
   uint8_t               formatversion;    /* Format version on the device */
@@ -422,6 +453,16 @@ static int     smart_relocate_static_data(FAR struct smart_struct_s *dev,
                  uint16_t block);
 #endif
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+static void    smart_freemap_setblock(FAR struct smart_struct_s *dev,
+                 uint16_t block);
+static void    smart_freemap_clear(FAR struct smart_struct_s *dev,
+                 uint32_t sector, uint32_t nsectors);
+#endif
+#ifdef CONFIG_MTD_SMART_BGGC
+static void    smart_bggc_worker(FAR void *arg);
+#endif
+
 static int     smart_relocate_sector(FAR struct smart_struct_s *dev,
                  uint16_t oldsector, uint16_t newsector);
 
@@ -879,6 +920,7 @@ static ssize_t smart_read(FAR struct inode *inode, unsigned char *buffer,
                           blkcnt_t start_sector, unsigned int nsectors)
 {
   FAR struct smart_struct_s *dev;
+  ssize_t ret;
 
   finfo("SMART: sector: %" PRIuOFF " nsectors: %u\n",
         start_sector, nsectors);
@@ -889,7 +931,16 @@ static ssize_t smart_read(FAR struct inode *inode, unsigned char *buffer,
 #else
   dev = (struct smart_struct_s *)inode->i_private;
 #endif
-  return smart_reload(dev, buffer, start_sector, nsectors);
+
+  ret = nxsem_wait_uninterruptible(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = smart_reload(dev, buffer, start_sector, nsectors);
+  nxsem_post(&dev->exclsem);
+  return ret;
 }
 
 /****************************************************************************
@@ -926,7 +977,11 @@ static ssize_t smart_write(FAR struct inode *inode,
   dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
-  /* I think maybe we need to lock on a mutex here */
+  ret = nxsem_wait_uninterruptible(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
   /* Get the aligned block.  Here is is assumed: (1) The number of R/W blocks
    * per erase block is a power of 2, and (2) the erase begins with that same
@@ -968,10 +1023,13 @@ static ssize_t smart_write(FAR struct inode *inode,
               ferr("ERROR: Erase block=%" PRIdOFF " failed: %d\n",
                    eraseblock, ret);
 
-              /* Unlock the mutex if we add one */
-
+              nxsem_post(&dev->exclsem);
               return ret;
             }
+
+#ifdef CONFIG_MTD_SMART_FREEMAP
+          smart_freemap_setblock(dev, eraseblock);
+#endif
         }
 
       /* Calculate the number of blocks to write. */
@@ -999,11 +1057,18 @@ static ssize_t smart_write(FAR struct inode *inode,
           ferr("ERROR: Write block %" PRIdOFF " failed: %zd.\n",
                nextblock, nxfrd);
 
-          /* Unlock the mutex if we add one */
-
+          nxsem_post(&dev->exclsem);
           return -EIO;
         }
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+      /* The written sectors are no longer erased */
+
+      smart_freemap_clear(dev, nextblock / dev->mtdblkspersector,
+                          (blkstowrite + dev->mtdblkspersector - 1) /
+                          dev->mtdblkspersector);
+#endif
+
       /* Then update for amount written */
 
       nextblock += blkstowrite;
@@ -1012,6 +1077,7 @@ static ssize_t smart_write(FAR struct inode *inode,
       alignedblock += mtdblkspererase;
     }
 
+  nxsem_post(&dev->exclsem);
   return nsectors;
 }
 
@@ -1164,6 +1230,14 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
     }
 #endif
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  if (dev->freemap != NULL)
+    {
+      smart_free(dev, dev->freemap);
+      dev->freemap = NULL;
+    }
+#endif
+
   /* Allocate a virtual to physical sector map buffer.  Also allocate
    * the storage space for releasecount and freecounts.
    */
@@ -1305,6 +1379,18 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
   dev->uneven_wearcount = 0;
 #endif
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  /* Allocate the free sector map.  It is filled in by the scan. */
+
+  dev->freemap = (FAR uint8_t *)
+    smart_zalloc(dev, (totalsectors + 7) >> 3, "Free map");
+  if (!dev->freemap)
+    {
+      ferr("ERROR: Error allocating free sector map\n");
+      goto errexit;
+    }
+#endif
+
   /* Allocate a read/write buffer */
 
   dev->rwbuffer = (FAR char *) smart_malloc(dev, size, "RW Buffer");
@@ -1359,6 +1445,14 @@ errexit:
     }
 #endif
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  if (dev->freemap)
+    {
+      smart_free(dev, dev->freemap);
+      dev->freemap = NULL;
+    }
+#endif
+
   return -ENOMEM;
 }
 
@@ -1904,6 +1998,76 @@ static int smart_set_wear_level(FAR struct smart_struct_s *dev,
 }
 #endif
 
+/****************************************************************************
+ * Name: smart_isfreeheader
+ *
+ * Description: Tests if a sector header is still in the erased state, i.e.
+ *              the sector can be allocated.
+ *
+ ****************************************************************************/
+
+static bool smart_isfreeheader(FAR struct smart_sect_header_s *header)
+{
+  return (*((FAR uint16_t *) header->logicalsector) == 0xffff) &&
+#if SMART_STATUS_VERSION == 1
+         (*((FAR uint16_t *) &header->seq) == 0xffff) &&
+#else
+         (header->seq == CONFIG_SMARTFS_ERASEDSTATE) &&
+#endif
+         ((header->status & SMART_STATUS_COMMITTED) ==
+          (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED));
+}
+
+/****************************************************************************
+ * Name: smart_freemap_setblock
+ *
+ * Description: Marks all sectors of an erase block that was just erased as
+ *              free in the free sector map.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_FREEMAP
+static void smart_freemap_setblock(FAR struct smart_struct_s *dev,
+                                   uint16_t block)
+{
+  uint32_t sector = (uint32_t)block * dev->sectorsperblk;
+  uint32_t end = sector + dev->availsectperblk;
+
+  if (end > dev->totalsectors)
+    {
+      end = dev->totalsectors;
+    }
+
+  for (; sector < end; sector++)
+    {
+      SET_BITMAP(dev->freemap, sector);
+    }
+}
+
+/****************************************************************************
+ * Name: smart_freemap_clear
+ *
+ * Description: Marks a range of sectors as no longer free.
+ *
+ ****************************************************************************/
+
+static void smart_freemap_clear(FAR struct smart_struct_s *dev,
+                                uint32_t sector, uint32_t nsectors)
+{
+  uint32_t end = sector + nsectors;
+
+  if (end > dev->totalsectors)
+    {
+      end = dev->totalsectors;
+    }
+
+  for (; sector < end; sector++)
+    {
+      CLR_BITMAP(dev->freemap, sector);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: smart_scan
  *
@@ -2050,6 +2214,12 @@ static int smart_scan(FAR struct smart_struct_s *dev)
   memset(dev->sbitmap, 0, (dev->totalsectors + 7) >> 3);
 #endif
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  /* Sectors with an erased header are marked free as they are scanned */
+
+  memset(dev->freemap, 0, (dev->totalsectors + 7) >> 3);
+#endif
+
   /* Now scan the MTD device */
 
   /* At first, set the loser sector as the invalid value */
@@ -2076,6 +2246,13 @@ static int smart_scan(FAR struct smart_struct_s *dev)
           goto err_out;
         }
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+      if (smart_isfreeheader(&header))
+        {
+          SET_BITMAP(dev->freemap, sector);
+        }
+#endif
+
       /* Get the logical sector number for this physical sector */
 
       logicalsector = *((FAR uint16_t *) header.logicalsector);
@@ -2696,6 +2873,9 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev,
       dev->blockerases++;
 #endif
       MTD_ERASE(dev->mtd, block, 1);
+#ifdef CONFIG_MTD_SMART_FREEMAP
+      smart_freemap_setblock(dev, block);
+#endif
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
       if (dev->erasecounts)
@@ -3271,6 +3451,17 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev,
   dev->freecount[0]--;
 #endif
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  /* Everything but the format sector is erased */
+
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+      smart_freemap_setblock(dev, x);
+    }
+
+  smart_freemap_clear(dev, 0, 1);
+#endif
+
   /* Now initialize the logical to physical sector map */
 
 #ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
@@ -3613,6 +3804,9 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev,
   /* Now erase the erase block */
 
   MTD_ERASE(dev->mtd, block, 1);
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  smart_freemap_setblock(dev, block);
+#endif
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
   dev->unusedsectors += freecount;
   dev->blockerases++;
@@ -3884,6 +4078,28 @@ retry:
    * allocate.
    */
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  /* The free sector map tells which sectors are erased without reading
+   * their headers from the media.
+   */
+
+  for (i = allocblock * dev->sectorsperblk;
+       i < allocblock * dev->sectorsperblk + dev->availsectperblk &&
+       i < dev->totalsectors; i++)
+    {
+      if (ISSET_BITMAP(dev->freemap, i))
+        {
+          physicalsector = i;
+          dev->lastallocblock = allocblock;
+          goto found;
+        }
+    }
+
+  /* Not expected, but fall back to the headers on the media */
+
+  fwarn("WARNING: No free sector in the map of block %d\n", allocblock);
+#endif
+
   for (i = allocblock * dev->sectorsperblk;
        i < allocblock * dev->sectorsperblk + dev->availsectperblk; i++)
     {
@@ -3927,14 +4143,7 @@ retry:
           return -1;
         }
 
-      if ((*((FAR uint16_t *) header.logicalsector) == 0xffff) &&
-#if SMART_STATUS_VERSION == 1
-          (*((FAR uint16_t *) &header.seq) == 0xffff) &&
-#else
-          (header.seq == CONFIG_SMARTFS_ERASEDSTATE) &&
-#endif
-          ((header.status & SMART_STATUS_COMMITTED) ==
-           (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED)))
+      if (smart_isfreeheader(&header))
         {
           physicalsector = i;
           dev->lastallocblock = allocblock;
@@ -3958,6 +4167,14 @@ retry:
         }
     }
 
+#ifdef CONFIG_MTD_SMART_FREEMAP
+found:
+  if (physicalsector < dev->totalsectors)
+    {
+      CLR_BITMAP(dev->freemap, physicalsector);
+    }
+#endif
+
   if (physicalsector == 0xffff)
     {
       ferr("ERROR: Program bug!  Expected a free sector\n");
@@ -4082,6 +4299,9 @@ static int smart_garbagecollect(FAR struct smart_struct_s *dev)
           /* Relocate the active data in the collection block */
 
           ret = smart_relocate_block(dev, collectblock);
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+          dev->fgcollections++;
+#endif
 
 #ifdef CONFIG_SMART_LOCAL_CHECKFREE
           if (smart_checkfree(dev, __LINE__) != OK)
@@ -4103,6 +4323,146 @@ errout:
   return ret;
 }
 
+/****************************************************************************
+ * Name: smart_bggc_victim
+ *
+ * Description:  Selects the erase block to collect in the background:  The
+ *               block with the most released sectors, if at least a
+ *               quarter of it is released and its live sectors fit in the
+ *               free sectors of the other blocks.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BGGC
+static int smart_bggc_victim(FAR struct smart_struct_s *dev)
+{
+  uint16_t  releasecount;
+  uint16_t  freecount;
+  uint16_t  releasemax = 0;
+  int       collectblock = -1;
+  int       x;
+
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+      /* Don't collect blocks that have been worn completely */
+
+      if (smart_get_wear_level(dev, x) >= SMART_WEAR_REORG_THRESHOLD)
+        {
+          continue;
+        }
+#endif
+
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+      releasecount = smart_get_count(dev, dev->releasecount, x);
+      freecount    = smart_get_count(dev, dev->freecount, x);
+#else
+      releasecount = dev->releasecount[x];
+      freecount    = dev->freecount[x];
+#endif
+
+      if (releasecount > releasemax &&
+          releasecount * 4 >= dev->availsectperblk &&
+          dev->availsectperblk - freecount - releasecount <
+          dev->freesectors - freecount)
+        {
+          releasemax   = releasecount;
+          collectblock = x;
+        }
+    }
+
+  return collectblock;
+}
+
+/****************************************************************************
+ * Name: smart_bggc_worker
+ *
+ * Description:  Collects garbage on the low priority work queue while the
+ *               free sectors are below the watermark, so that the erase
+ *               blocks are erased before a write has to wait for them.
+ *               The device is unlocked between blocks so that the file
+ *               system is not held off for long.
+ *
+ ****************************************************************************/
+
+static void smart_bggc_worker(FAR void *arg)
+{
+  FAR struct smart_struct_s *dev = (FAR struct smart_struct_s *)arg;
+  int block;
+  int ret;
+
+  for (; ; )
+    {
+      ret = nxsem_wait_uninterruptible(&dev->exclsem);
+      if (ret < 0)
+        {
+          dev->gcbusy = false;
+          return;
+        }
+
+      block = -1;
+      if (!dev->gcstop && dev->freesectors < SMART_BGGC_WATERMARK(dev))
+        {
+          block = smart_bggc_victim(dev);
+        }
+
+      /* The device may be freed as soon as gcbusy is cleared, so it is
+       * not touched after the lock is released.
+       */
+
+      if (block < 0)
+        {
+          dev->gcbusy = false;
+          nxsem_post(&dev->exclsem);
+          return;
+        }
+
+      finfo("Background collecting block %d, free=%d released=%d\n",
+            block, dev->freesectors, dev->releasesectors);
+
+      ret = smart_relocate_block(dev, block);
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+      if (ret == OK)
+        {
+          dev->bgcollections++;
+        }
+#endif
+
+      if (ret < 0)
+        {
+          dev->gcbusy = false;
+        }
+
+      nxsem_post(&dev->exclsem);
+      if (ret < 0)
+        {
+          ferr("ERROR: Background collection of block %d failed: %d\n",
+               block, ret);
+          return;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: smart_bggc_schedule
+ *
+ * Description:  Starts background garbage collection if the free sectors
+ *               fell below the watermark.  Called with the device locked.
+ *
+ ****************************************************************************/
+
+static void smart_bggc_schedule(FAR struct smart_struct_s *dev)
+{
+  if (dev->formatstatus == SMART_FMT_STAT_FORMATTED &&
+      dev->freesectors < SMART_BGGC_WATERMARK(dev) &&
+      !dev->gcbusy && !dev->gcstop)
+    {
+      dev->gcbusy = true;
+      work_queue(LPWORK, &dev->gcwork, smart_bggc_worker, dev, 0);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: smart_write_wearstatus
  *
@@ -5450,6 +5810,10 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
   FAR struct mtd_smart_procfs_data_s *procfs_data;
   FAR struct mtd_smart_debug_data_s *debug_data;
+  struct timespec start;
+  struct timespec end;
+  uint32_t elapsed;
+  int bucket;
 #endif
 
   finfo("Entry\n");
@@ -5461,6 +5825,12 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
   dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
+  ret = nxsem_wait_uninterruptible(&dev->exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
   /* Process the ioctl's we care about first, pass any we don't respond
    * to directly to the underlying MTD device.
    */
@@ -5513,12 +5883,19 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       /* Free the specified logical sector */
 
       ret = smart_freesector(dev, arg);
+#ifdef CONFIG_MTD_SMART_BGGC
+      smart_bggc_schedule(dev);
+#endif
       goto ok_out;
 
     case BIOC_WRITESECT:
 
       /* Write to the sector */
 
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+      clock_systime_timespec(&start);
+#endif
+
       ret = smart_writesector(dev, arg);
 
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
@@ -5530,6 +5907,33 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
         }
 #endif
 
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+      /* Account the write latency, including any garbage collection that
+       * the write had to wait for, in a log2 histogram in microseconds.
+       */
+
+      clock_systime_timespec(&end);
+      elapsed = (end.tv_sec - start.tv_sec) * USEC_PER_SEC +
+                (end.tv_nsec - start.tv_nsec) / NSEC_PER_USEC;
+
+      bucket = elapsed < 256 ? 0 : flsl(elapsed) - 8;
+      if (bucket >= SMART_WRITE_HIST_NBUCKETS)
+        {
+          bucket = SMART_WRITE_HIST_NBUCKETS - 1;
+        }
+
+      dev->writes++;
+      dev->writetotal += elapsed;
+      dev->writehist[bucket]++;
+      if (elapsed > dev->writemax)
+        {
+          dev->writemax = elapsed;
+        }
+#endif
+
+#ifdef CONFIG_MTD_SMART_BGGC
+      smart_bggc_schedule(dev);
+#endif
       goto ok_out;
 
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
@@ -5567,6 +5971,15 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
       procfs_data->uneven_wearcount = dev->uneven_wearcount;
 #endif
+      procfs_data->fgcollections  = dev->fgcollections;
+#ifdef CONFIG_MTD_SMART_BGGC
+      procfs_data->bgcollections  = dev->bgcollections;
+#endif
+      procfs_data->writes         = dev->writes;
+      procfs_data->writemax       = dev->writemax;
+      procfs_data->writetotal     = dev->writetotal;
+      memcpy(procfs_data->writehist, dev->writehist,
+             sizeof(procfs_data->writehist));
       ret = OK;
       goto ok_out;
 #endif
@@ -5600,6 +6013,7 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
     }
 
 ok_out:
+  nxsem_post(&dev->exclsem);
   return ret;
 }
 
@@ -6141,6 +6555,7 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd,
       /* Initialize the SMART device structure */
 
       dev->mtd = mtd;
+      nxsem_init(&dev->exclsem, 0, 1);
 
       /* Get the device geometry. (casting to uintptr_t first eliminates
        * complaints on some architectures where the sizeof long is different
@@ -6285,6 +6700,9 @@ errout:
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
   smart_free(dev, dev->erasecounts);
 #endif
+#ifdef CONFIG_MTD_SMART_FREEMAP
+  smart_free(dev, dev->freemap);
+#endif
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   if (rootdirdev)
     {
@@ -6292,6 +6710,7 @@ errout:
     }
 #endif
 
+  nxsem_destroy(&dev->exclsem);
   kmm_free(dev);
   return ret;
 }
@@ -6406,11 +6825,35 @@ static int smart_loteardown(FAR const char *devname)
 
   close_blockdriver(inode);
 
+#ifdef CONFIG_MTD_SMART_BGGC
+  /* Stop the background collection.  work_cancel() only removes the work
+   * if it has not started yet, so wait for a running collection to see
+   * gcstop and return.
+   */
+
+  nxsem_wait_uninterruptible(&dev->exclsem);
+  dev->gcstop = true;
+  if (work_cancel(LPWORK, &dev->gcwork) == OK)
+    {
+      dev->gcbusy = false;
+    }
+
+  while (dev->gcbusy)
+    {
+      nxsem_post(&dev->exclsem);
+      nxsig_usleep(USEC_PER_TICK);
+      nxsem_wait_uninterruptible(&dev->exclsem);
+    }
+
+  nxsem_post(&dev->exclsem);
+#endif
+
   /* Now teardown the filemtd */
 
   filemtd_teardown(dev->mtd);
   unregister_blockdriver(devname);
 
+  nxsem_destroy(&dev->exclsem);
   kmm_free(dev);
 
   return OK;
@@ -0,0 +1,514 @@
+/****************************************************************************
+ * drivers/note/notectf_driver.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <time.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/kthread.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/signal.h>
+#include <nuttx/sched_note.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/note/notectf_driver.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_DRIVER_NOTECTF_PACKETSIZE
+#  define CONFIG_DRIVER_NOTECTF_PACKETSIZE 4096
+#endif
+
+#ifndef CONFIG_DRIVER_NOTECTF_INTERVAL
+#  define CONFIG_DRIVER_NOTECTF_INTERVAL 100
+#endif
+
+#ifndef CONFIG_DRIVER_NOTECTF_PRIORITY
+#  define CONFIG_DRIVER_NOTECTF_PRIORITY 50
+#endif
+
+#ifndef CONFIG_DRIVER_NOTECTF_STACKSIZE
+#  define CONFIG_DRIVER_NOTECTF_STACKSIZE 2048
+#endif
+
+#if CONFIG_DRIVER_NOTECTF_PACKETSIZE < NOTECTF_HDRSIZE + 256
+#  error CONFIG_DRIVER_NOTECTF_PACKETSIZE cannot hold the largest note
+#endif
+
+/* The time stamp of the notes as seen by the viewer */
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+#  define NOTECTF_CLOCKFREQ  1000000000ul
+#  define NOTECTF_CLOCKSIZE  64
+#else
+#  define NOTECTF_CLOCKFREQ  ((unsigned long)CLOCKS_PER_SEC)
+#  define NOTECTF_CLOCKSIZE  32
+#endif
+
+#define NOTECTF_LINESIZE     128
+#define NOTECTF_NEVENTS      (sizeof(g_notectf_events) / \
+                              sizeof(g_notectf_events[0]))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Describes one type of note to the viewer */
+
+struct notectf_event_s
+{
+  uint8_t id;                  /* Value of enum note_type_e */
+  FAR const char *name;        /* Event name */
+  FAR const char *fields;      /* TSDL fields following the common header */
+};
+
+/* The state of the exporter */
+
+struct notectf_s
+{
+  struct file note;            /* /dev/note */
+  struct file stream;          /* The trace stream file */
+  FAR uint8_t *packet;         /* Packet being assembled */
+  pid_t pid;                   /* The exporter thread, 0 if not running */
+  volatile bool stop;          /* True: Write the remaining notes and exit */
+  sem_t exitsem;               /* Posted when the thread exits */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The note types and their payload.  Types that are not configured are
+ * described anyway, they just never show up in the stream.
+ */
+
+static const struct notectf_event_s g_notectf_events[] =
+{
+#if CONFIG_TASK_NAME_SIZE > 0
+  { 0,  "sched_start",      "string name;" },
+#else
+  { 0,  "sched_start",      NULL },
+#endif
+  { 1,  "sched_stop",       NULL },
+  { 2,  "sched_suspend",    "uint8_t state;" },
+  { 3,  "sched_resume",     NULL },
+  { 4,  "cpu_start",        "uint8_t target;" },
+  { 5,  "cpu_started",      NULL },
+  { 6,  "cpu_pause",        "uint8_t target;" },
+  { 7,  "cpu_paused",       NULL },
+  { 8,  "cpu_resume",       "uint8_t target;" },
+  { 9,  "cpu_resumed",      NULL },
+  { 10, "preempt_lock",     "uint16_t count;" },
+  { 11, "preempt_unlock",   "uint16_t count;" },
+#ifdef CONFIG_SMP
+  { 12, "csection_enter",   "uint16_t count;" },
+  { 13, "csection_leave",   "uint16_t count;" },
+#else
+  { 12, "csection_enter",   NULL },
+  { 13, "csection_leave",   NULL },
+#endif
+  { 14, "spinlock_lock",    "uintptr_t spinlock; uint8_t value;" },
+  { 15, "spinlock_locked",  "uintptr_t spinlock; uint8_t value;" },
+  { 16, "spinlock_unlock",  "uintptr_t spinlock; uint8_t value;" },
+  { 17, "spinlock_abort",   "uintptr_t spinlock; uint8_t value;" },
+  { 18, "syscall_enter",
+        "uint8_t nr; uint8_t argc; uintptr_t args[argc];" },
+  { 19, "syscall_leave",    "uint8_t nr; uintptr_t result;" },
+  { 20, "irq_enter",        "uint8_t irq;" },
+  { 21, "irq_leave",        "uint8_t irq;" },
+};
+
+static struct notectf_s g_notectf;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: notectf_printf
+ ****************************************************************************/
+
+static int notectf_printf(FAR struct file *filep, FAR const char *fmt, ...)
+{
+  char line[NOTECTF_LINESIZE];
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  len = vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+
+  DEBUGASSERT(len < sizeof(line));
+  return file_write(filep, line, len);
+}
+
+/****************************************************************************
+ * Name: notectf_metadata
+ *
+ * Description:
+ *   Write the TSDL description of the notes of this configuration.
+ *
+ ****************************************************************************/
+
+static int notectf_metadata(FAR const char *dirpath)
+{
+  char path[PATH_MAX];
+  struct file meta;
+  int ret;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/metadata", dirpath);
+  ret = file_open(&meta, path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  notectf_printf(&meta, "/* CTF 1.8 */\n\n");
+  for (i = 8; i <= 64; i <<= 1)
+    {
+      notectf_printf(&meta,
+                     "typealias integer { size = %d; align = 8; "
+                     "signed = false; } := uint%d_t;\n", i, i);
+    }
+
+  notectf_printf(&meta,
+                 "typealias integer { size = %d; align = 8; "
+                 "signed = false; base = hex; } := uintptr_t;\n\n",
+                 (int)(8 * sizeof(uintptr_t)));
+
+  notectf_printf(&meta, "trace {\n  major = 1;\n  minor = 8;\n"
+                 "  byte_order = le;\n");
+  notectf_printf(&meta, "  packet.header := struct {\n"
+                 "    uint32_t magic;\n    uint32_t stream_id;\n"
+                 "  };\n};\n\n");
+
+  notectf_printf(&meta, "clock {\n  name = monotonic;\n  freq = %lu;\n"
+                 "};\n\n", NOTECTF_CLOCKFREQ);
+  notectf_printf(&meta,
+                 "typealias integer { size = %d; align = 8; "
+                 "signed = false;\n  map = clock.monotonic.value; } "
+                 ":= clock_t;\n\n", NOTECTF_CLOCKSIZE);
+
+  notectf_printf(&meta, "stream {\n  id = 0;\n");
+  notectf_printf(&meta, "  packet.context := struct {\n"
+                 "    uint32_t content_size;\n    uint32_t packet_size;\n"
+                 "  };\n");
+  notectf_printf(&meta, "  event.header := struct {\n"
+                 "    uint8_t length;\n    uint8_t id;\n"
+                 "    uint8_t priority;\n");
+#ifdef CONFIG_SMP
+  notectf_printf(&meta, "    uint8_t cpu;\n");
+#endif
+  notectf_printf(&meta, "    uint16_t pid;\n    clock_t timestamp;\n"
+                 "  };\n};\n\n");
+
+  for (i = 0; i < NOTECTF_NEVENTS; i++)
+    {
+      FAR const struct notectf_event_s *event = &g_notectf_events[i];
+
+      notectf_printf(&meta, "event {\n  id = %d;\n  name = \"%s\";\n"
+                     "  stream_id = 0;\n", event->id, event->name);
+      if (event->fields != NULL)
+        {
+          notectf_printf(&meta, "  fields := struct { %s };\n",
+                         event->fields);
+        }
+
+      ret = notectf_printf(&meta, "};\n\n");
+    }
+
+  file_close(&meta);
+  return ret < 0 ? ret : OK;
+}
+
+/****************************************************************************
+ * Name: notectf_putle32
+ ****************************************************************************/
+
+static void notectf_putle32(FAR uint8_t *dest, uint32_t value)
+{
+  dest[0] = value & 0xff;
+  dest[1] = (value >> 8) & 0xff;
+  dest[2] = (value >> 16) & 0xff;
+  dest[3] = (value >> 24) & 0xff;
+}
+
+/****************************************************************************
+ * Name: notectf_systime
+ *
+ * Description:
+ *   Replace the seconds and nanoseconds of the time stamps of the notes in
+ *   the buffer with one 64-bit count of nanoseconds that the viewers can
+ *   use as a clock.  Both take eight bytes.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+static void notectf_systime(FAR uint8_t *buffer, size_t buflen)
+{
+  FAR struct note_common_s *note;
+  uint64_t systime;
+  uint32_t nsec;
+  uint32_t sec;
+  size_t offset;
+
+  for (offset = 0; offset < buflen; offset += note->nc_length)
+    {
+      note = (FAR struct note_common_s *)&buffer[offset];
+      if (note->nc_length < sizeof(struct note_common_s))
+        {
+          break;
+        }
+
+      sec  = note->nc_systime_sec[0] |
+             (uint32_t)note->nc_systime_sec[1] << 8 |
+             (uint32_t)note->nc_systime_sec[2] << 16 |
+             (uint32_t)note->nc_systime_sec[3] << 24;
+      nsec = note->nc_systime_nsec[0] |
+             (uint32_t)note->nc_systime_nsec[1] << 8 |
+             (uint32_t)note->nc_systime_nsec[2] << 16 |
+             (uint32_t)note->nc_systime_nsec[3] << 24;
+
+      systime = (uint64_t)sec * 1000000000 + nsec;
+      notectf_putle32(note->nc_systime_sec, (uint32_t)systime);
+      notectf_putle32(note->nc_systime_nsec, (uint32_t)(systime >> 32));
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: notectf_packet
+ *
+ * Description:
+ *   Move as many notes as fit into one packet from /dev/note to the
+ *   stream.
+ *
+ * Returned Value:
+ *   The number of bytes of notes written, zero if there were no notes, or
+ *   a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static ssize_t notectf_packet(void)
+{
+  FAR uint8_t *packet = g_notectf.packet;
+  ssize_t nread;
+  ssize_t ret;
+  size_t size;
+
+  /* /dev/note only ever returns whole notes */
+
+  nread = file_read(&g_notectf.note, &packet[NOTECTF_HDRSIZE],
+                    CONFIG_DRIVER_NOTECTF_PACKETSIZE - NOTECTF_HDRSIZE);
+  if (nread <= 0)
+    {
+      return nread;
+    }
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+  notectf_systime(&packet[NOTECTF_HDRSIZE], nread);
+#endif
+
+  size = NOTECTF_HDRSIZE + nread;
+  notectf_putle32(&packet[0], NOTECTF_MAGIC);
+  notectf_putle32(&packet[4], 0);
+  notectf_putle32(&packet[8], 8 * size);
+  notectf_putle32(&packet[12], 8 * size);
+
+  ret = file_write(&g_notectf.stream, packet, size);
+  return ret < 0 ? ret : nread;
+}
+
+/****************************************************************************
+ * Name: notectf_thread
+ ****************************************************************************/
+
+static int notectf_thread(int argc, FAR char *argv[])
+{
+  ssize_t ret;
+
+  for (; ; )
+    {
+      ret = notectf_packet();
+      if (ret < 0)
+        {
+          serr("ERROR: Failed to export notes: %zd\n", ret);
+          break;
+        }
+      else if (ret == 0)
+        {
+          /* Drained.  Stop now or wait for more notes. */
+
+          if (g_notectf.stop)
+            {
+              break;
+            }
+
+          nxsig_usleep(CONFIG_DRIVER_NOTECTF_INTERVAL * 1000);
+        }
+    }
+
+  file_close(&g_notectf.stream);
+  file_close(&g_notectf.note);
+  kmm_free(g_notectf.packet);
+  g_notectf.packet = NULL;
+
+  nxsem_post(&g_notectf.exitsem);
+  return ret < 0 ? (int)ret : OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: notectf_start
+ *
+ * Description:
+ *   Start streaming the notes of /dev/note to a CTF trace in the directory
+ *   'dirpath', which must exist.  This may be a local file system, a hostfs
+ *   mount or an rpmsgfs mount.  The notes are written by a kernel thread
+ *   until notectf_stop() is called.
+ *
+ * Input Parameters:
+ *   dirpath - The directory to hold the trace files.
+ *
+ * Returned Value:
+ *   Zero on success. A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+int notectf_start(FAR const char *dirpath)
+{
+  char path[PATH_MAX];
+  int ret;
+
+  DEBUGASSERT(dirpath != NULL);
+
+  if (g_notectf.pid > 0)
+    {
+      return -EBUSY;
+    }
+
+  ret = notectf_metadata(dirpath);
+  if (ret < 0)
+    {
+      serr("ERROR: Failed to write the metadata: %d\n", ret);
+      return ret;
+    }
+
+  snprintf(path, sizeof(path), "%s/stream", dirpath);
+  ret = file_open(&g_notectf.stream, path, O_WRONLY | O_CREAT | O_TRUNC,
+                  0666);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = file_open(&g_notectf.note, "/dev/note", O_RDONLY);
+  if (ret < 0)
+    {
+      goto errout_with_stream;
+    }
+
+  g_notectf.packet = kmm_malloc(CONFIG_DRIVER_NOTECTF_PACKETSIZE);
+  if (g_notectf.packet == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout_with_note;
+    }
+
+  g_notectf.stop = false;
+  nxsem_init(&g_notectf.exitsem, 0, 0);
+  nxsem_set_protocol(&g_notectf.exitsem, SEM_PRIO_NONE);
+
+  ret = kthread_create("notectf", CONFIG_DRIVER_NOTECTF_PRIORITY,
+                       CONFIG_DRIVER_NOTECTF_STACKSIZE, notectf_thread,
+                       NULL);
+  if (ret < 0)
+    {
+      nxsem_destroy(&g_notectf.exitsem);
+      goto errout_with_packet;
+    }
+
+  g_notectf.pid = ret;
+  return OK;
+
+errout_with_packet:
+  kmm_free(g_notectf.packet);
+  g_notectf.packet = NULL;
+
+errout_with_note:
+  file_close(&g_notectf.note);
+
+errout_with_stream:
+  file_close(&g_notectf.stream);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: notectf_stop
+ *
+ * Description:
+ *   Write the remaining notes and stop streaming.
+ *
+ * Returned Value:
+ *   Zero on success. A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+int notectf_stop(void)
+{
+  int ret;
+
+  if (g_notectf.pid <= 0)
+    {
+      return -ESRCH;
+    }
+
+  g_notectf.stop = true;
+  ret = nxsem_wait_uninterruptible(&g_notectf.exitsem);
+  if (ret >= 0)
+    {
+      nxsem_destroy(&g_notectf.exitsem);
+      g_notectf.pid = 0;
+    }
+
+  return ret;
+}
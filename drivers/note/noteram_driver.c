@@ -31,12 +31,29 @@
 #include <errno.h>
 #include <string.h>
 
+#include <nuttx/arch.h>
 #include <nuttx/spinlock.h>
 #include <nuttx/sched.h>
 #include <nuttx/sched_note.h>
 #include <nuttx/note/noteram_driver.h>
 #include <nuttx/fs/fs.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* There is one circular buffer per CPU.  Only that CPU adds notes to it so
+ * that recording never waits for another CPU.
+ */
+
+#ifdef CONFIG_SMP
+#  define NOTERAM_NCPUS       CONFIG_SMP_NCPUS
+#  define NOTERAM_THIS_CPU()  up_cpu_index()
+#else
+#  define NOTERAM_NCPUS       1
+#  define NOTERAM_THIS_CPU()  0
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -46,7 +63,12 @@ struct noteram_info_s
   volatile unsigned int ni_head;
   volatile unsigned int ni_tail;
   volatile unsigned int ni_read;
-  unsigned int ni_overwrite;
+  unsigned int ni_dropped;      /* Notes not recorded (buffer full) */
+  unsigned int ni_overwritten;  /* Notes overwritten before being read */
+  bool ni_overflow;             /* Full in no-overwrite mode, stopped */
+#ifdef CONFIG_SMP
+  spinlock_t ni_lock;           /* Taken by the reader and this CPU only */
+#endif
   uint8_t ni_buffer[CONFIG_DRIVER_NOTERAM_BUFSIZE];
 };
 
@@ -92,22 +114,25 @@ static const struct file_operations g_noteram_fops =
 #endif
 };
 
-static struct noteram_info_s g_noteram_info =
-{
+static struct noteram_info_s g_noteram_info[NOTERAM_NCPUS];
+
 #ifdef CONFIG_DRIVER_NOTERAM_DEFAULT_NOOVERWRITE
-  .ni_overwrite = NOTERAM_MODE_OVERWRITE_DISABLE
+static volatile unsigned int g_noteram_overwrite =
+  NOTERAM_MODE_OVERWRITE_DISABLE;
 #else
-  .ni_overwrite = NOTERAM_MODE_OVERWRITE_ENABLE
+static volatile unsigned int g_noteram_overwrite =
+  NOTERAM_MODE_OVERWRITE_ENABLE;
 #endif
-};
 
 #if CONFIG_DRIVER_NOTERAM_TASKNAME_BUFSIZE > 0
 static struct noteram_taskname_s g_noteram_taskname;
-#endif
 
 #ifdef CONFIG_SMP
+/* Protects the task names which are shared by all CPUs */
+
 static volatile spinlock_t g_noteram_lock;
 #endif
+#endif
 
 /****************************************************************************
  * Private Functions
@@ -255,7 +280,10 @@ static const char *noteram_get_taskname(pid_t pid)
   FAR struct noteram_taskname_info_s *ti;
   FAR struct tcb_s *tcb;
 
-  irq_mask = enter_critical_section();
+  irq_mask = up_irq_save();
+#ifdef CONFIG_SMP
+  spin_lock_wo_note(&g_noteram_lock);
+#endif
 
   ti = noteram_find_taskname(pid);
   if (ti != NULL)
@@ -272,16 +300,52 @@ static const char *noteram_get_taskname(pid_t pid)
         }
     }
 
-  leave_critical_section(irq_mask);
+#ifdef CONFIG_SMP
+  spin_unlock_wo_note(&g_noteram_lock);
+#endif
+  up_irq_restore(irq_mask);
   return ret;
 }
 #endif
 
+/****************************************************************************
+ * Name: noteram_lock
+ *
+ * Description:
+ *   Get exclusive access to the circular buffer of one CPU.  Interrupts
+ *   are disabled so that the CPU owning the buffer cannot try to add a
+ *   note from an interrupt handler while the lock is held on that CPU.
+ *   The lock is never contended by another CPU adding notes.
+ *
+ ****************************************************************************/
+
+static inline irqstate_t noteram_lock(FAR struct noteram_info_s *ni)
+{
+  irqstate_t flags = up_irq_save();
+#ifdef CONFIG_SMP
+  spin_lock_wo_note(&ni->ni_lock);
+#endif
+  return flags;
+}
+
+/****************************************************************************
+ * Name: noteram_unlock
+ ****************************************************************************/
+
+static inline void noteram_unlock(FAR struct noteram_info_s *ni,
+                                  irqstate_t flags)
+{
+#ifdef CONFIG_SMP
+  spin_unlock_wo_note(&ni->ni_lock);
+#endif
+  up_irq_restore(flags);
+}
+
 /****************************************************************************
  * Name: noteram_buffer_clear
  *
  * Description:
- *   Clear all contents of the circular buffer.
+ *   Clear all contents of the circular buffers.
  *
  * Input Parameters:
  *   None.
@@ -293,23 +357,96 @@ static const char *noteram_get_taskname(pid_t pid)
 
 static void noteram_buffer_clear(void)
 {
+  FAR struct noteram_info_s *ni;
   irqstate_t flags;
+  int cpu;
 
-  flags = enter_critical_section();
+  for (cpu = 0; cpu < NOTERAM_NCPUS; cpu++)
+    {
+      ni    = &g_noteram_info[cpu];
+      flags = noteram_lock(ni);
 
-  g_noteram_info.ni_tail = g_noteram_info.ni_head;
-  g_noteram_info.ni_read = g_noteram_info.ni_head;
+      ni->ni_tail        = ni->ni_head;
+      ni->ni_read        = ni->ni_head;
+      ni->ni_dropped     = 0;
+      ni->ni_overwritten = 0;
+      ni->ni_overflow    = false;
 
-  if (g_noteram_info.ni_overwrite == NOTERAM_MODE_OVERWRITE_OVERFLOW)
-    {
-      g_noteram_info.ni_overwrite = NOTERAM_MODE_OVERWRITE_DISABLE;
+      noteram_unlock(ni, flags);
     }
 
 #if CONFIG_DRIVER_NOTERAM_TASKNAME_BUFSIZE > 0
+  flags = up_irq_save();
+#ifdef CONFIG_SMP
+  spin_lock_wo_note(&g_noteram_lock);
+#endif
+
   g_noteram_taskname.buffer_used = 0;
+
+#ifdef CONFIG_SMP
+  spin_unlock_wo_note(&g_noteram_lock);
 #endif
+  up_irq_restore(flags);
+#endif
+}
 
-  leave_critical_section(flags);
+/****************************************************************************
+ * Name: noteram_getmode
+ *
+ * Description:
+ *   Return the overwrite mode.  NOTERAM_MODE_OVERWRITE_OVERFLOW is reported
+ *   if the buffer of any CPU filled up and stopped recording.
+ *
+ ****************************************************************************/
+
+static unsigned int noteram_getmode(void)
+{
+  int cpu;
+
+  if (g_noteram_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE)
+    {
+      for (cpu = 0; cpu < NOTERAM_NCPUS; cpu++)
+        {
+          if (g_noteram_info[cpu].ni_overflow)
+            {
+              return NOTERAM_MODE_OVERWRITE_OVERFLOW;
+            }
+        }
+    }
+
+  return g_noteram_overwrite;
+}
+
+/****************************************************************************
+ * Name: noteram_setmode
+ *
+ * Description:
+ *   Set the overwrite mode.  Each CPU stops recording on its own when its
+ *   buffer fills up in no-overwrite mode, so that one busy CPU does not end
+ *   the recording of the others.  Setting a mode resumes the recording on
+ *   all CPUs; setting NOTERAM_MODE_OVERWRITE_OVERFLOW stops it on all CPUs.
+ *
+ ****************************************************************************/
+
+static void noteram_setmode(unsigned int mode)
+{
+  FAR struct noteram_info_s *ni;
+  irqstate_t flags;
+  int cpu;
+
+  for (cpu = 0; cpu < NOTERAM_NCPUS; cpu++)
+    {
+      ni    = &g_noteram_info[cpu];
+      flags = noteram_lock(ni);
+
+      ni->ni_overflow = mode == NOTERAM_MODE_OVERWRITE_OVERFLOW;
+
+      noteram_unlock(ni, flags);
+    }
+
+  g_noteram_overwrite = mode == NOTERAM_MODE_OVERWRITE_ENABLE ?
+                        NOTERAM_MODE_OVERWRITE_ENABLE :
+                        NOTERAM_MODE_OVERWRITE_DISABLE;
 }
 
 /****************************************************************************
@@ -346,17 +483,17 @@ static inline unsigned int noteram_next(unsigned int ndx,
  *   Length of data currently in circular buffer.
  *
  * Input Parameters:
- *   None
+ *   ni - The circular buffer
  *
  * Returned Value:
  *   Length of data currently in circular buffer.
  *
  ****************************************************************************/
 
-static unsigned int noteram_length(void)
+static unsigned int noteram_length(FAR struct noteram_info_s *ni)
 {
-  unsigned int head = g_noteram_info.ni_head;
-  unsigned int tail = g_noteram_info.ni_tail;
+  unsigned int head = ni->ni_head;
+  unsigned int tail = ni->ni_tail;
 
   if (tail > head)
     {
@@ -373,17 +510,17 @@ static unsigned int noteram_length(void)
  *   Length of unread data currently in circular buffer.
  *
  * Input Parameters:
- *   None
+ *   ni - The circular buffer
  *
  * Returned Value:
  *   Length of unread data currently in circular buffer.
  *
  ****************************************************************************/
 
-static unsigned int noteram_unread_length(void)
+static unsigned int noteram_unread_length(FAR struct noteram_info_s *ni)
 {
-  unsigned int head = g_noteram_info.ni_head;
-  unsigned int read = g_noteram_info.ni_read;
+  unsigned int head = ni->ni_head;
+  unsigned int read = ni->ni_read;
 
   if (read > head)
     {
@@ -393,6 +530,85 @@ static unsigned int noteram_unread_length(void)
   return head - read;
 }
 
+/****************************************************************************
+ * Name: noteram_copyin
+ *
+ * Description:
+ *   Copy data into the circular buffer at the specified index.  The copy
+ *   is done with at most two memcpy() calls instead of byte by byte.
+ *
+ ****************************************************************************/
+
+static void noteram_copyin(FAR struct noteram_info_s *ni, unsigned int ndx,
+                           FAR const void *src, size_t len)
+{
+  size_t first = CONFIG_DRIVER_NOTERAM_BUFSIZE - ndx;
+
+  if (len <= first)
+    {
+      memcpy(&ni->ni_buffer[ndx], src, len);
+    }
+  else
+    {
+      memcpy(&ni->ni_buffer[ndx], src, first);
+      memcpy(ni->ni_buffer, (FAR const uint8_t *)src + first, len - first);
+    }
+}
+
+/****************************************************************************
+ * Name: noteram_copyout
+ *
+ * Description:
+ *   Copy data out of the circular buffer from the specified index.
+ *
+ ****************************************************************************/
+
+static void noteram_copyout(FAR struct noteram_info_s *ni, unsigned int ndx,
+                            FAR void *dest, size_t len)
+{
+  size_t first = CONFIG_DRIVER_NOTERAM_BUFSIZE - ndx;
+
+  if (len <= first)
+    {
+      memcpy(dest, &ni->ni_buffer[ndx], len);
+    }
+  else
+    {
+      memcpy(dest, &ni->ni_buffer[ndx], first);
+      memcpy((FAR uint8_t *)dest + first, ni->ni_buffer, len - first);
+    }
+}
+
+/****************************************************************************
+ * Name: noteram_timestamp
+ *
+ * Description:
+ *   Return the time when the note was buffered in a form that can be
+ *   compared with the time of other notes.
+ *
+ ****************************************************************************/
+
+static uint64_t noteram_timestamp(FAR const struct note_common_s *note)
+{
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+  uint32_t sec  = note->nc_systime_sec[0] |
+                  (uint32_t)note->nc_systime_sec[1] << 8 |
+                  (uint32_t)note->nc_systime_sec[2] << 16 |
+                  (uint32_t)note->nc_systime_sec[3] << 24;
+  uint32_t nsec = note->nc_systime_nsec[0] |
+                  (uint32_t)note->nc_systime_nsec[1] << 8 |
+                  (uint32_t)note->nc_systime_nsec[2] << 16 |
+                  (uint32_t)note->nc_systime_nsec[3] << 24;
+
+  return (uint64_t)sec << 32 | nsec;
+#else
+  return note->nc_systime[0] |
+         (uint32_t)note->nc_systime[1] << 8 |
+         (uint32_t)note->nc_systime[2] << 16 |
+         (uint32_t)note->nc_systime[3] << 24;
+#endif
+}
+
 /****************************************************************************
  * Name: noteram_remove
  *
@@ -400,41 +616,47 @@ static unsigned int noteram_unread_length(void)
  *   Remove the variable length note from the tail of the circular buffer
  *
  * Input Parameters:
- *   None
+ *   ni - The circular buffer
  *
  * Returned Value:
  *   None
  *
  * Assumptions:
- *   We are within a critical section.
+ *   The caller holds the lock of the circular buffer.
  *
  ****************************************************************************/
 
-static void noteram_remove(void)
+static void noteram_remove(FAR struct noteram_info_s *ni)
 {
-  FAR struct note_common_s *note;
+  struct note_common_s note;
   unsigned int tail;
   unsigned int length;
 
   /* Get the tail index of the circular buffer */
 
-  tail = g_noteram_info.ni_tail;
+  tail = ni->ni_tail;
   DEBUGASSERT(tail < CONFIG_DRIVER_NOTERAM_BUFSIZE);
 
   /* Get the length of the note at the tail index */
 
-  note   = (FAR struct note_common_s *)&g_noteram_info.ni_buffer[tail];
-  length = note->nc_length;
-  DEBUGASSERT(length <= noteram_length());
+  noteram_copyout(ni, tail, &note, sizeof(struct note_common_s));
+  length = note.nc_length;
+  DEBUGASSERT(length <= noteram_length(ni));
 
 #if CONFIG_DRIVER_NOTERAM_TASKNAME_BUFSIZE > 0
-  if (note->nc_type == NOTE_STOP)
+  if (note.nc_type == NOTE_STOP)
     {
       /* The name of the task is no longer needed because the task is deleted
        * and the corresponding notes are lost.
        */
 
-      noteram_remove_taskname(note->nc_pid[0] + (note->nc_pid[1] << 8));
+#ifdef CONFIG_SMP
+      spin_lock_wo_note(&g_noteram_lock);
+#endif
+      noteram_remove_taskname(note.nc_pid[0] + (note.nc_pid[1] << 8));
+#ifdef CONFIG_SMP
+      spin_unlock_wo_note(&g_noteram_lock);
+#endif
     }
 #endif
 
@@ -442,21 +664,73 @@ static void noteram_remove(void)
    * buffer.
    */
 
-  if (g_noteram_info.ni_read == g_noteram_info.ni_tail)
+  if (ni->ni_read == ni->ni_tail)
+    {
+      /* The read index also needs increment.  The note was never read. */
+
+      ni->ni_read = noteram_next(tail, length);
+      ni->ni_overwritten++;
+    }
+
+  ni->ni_tail = noteram_next(tail, length);
+}
+
+/****************************************************************************
+ * Name: noteram_oldest
+ *
+ * Description:
+ *   Find the circular buffer holding the oldest unread note.  The buffers
+ *   of all CPUs are merged in time order this way.
+ *
+ * Input Parameters:
+ *   read - Location to return the read index of the oldest note
+ *
+ * Returned Value:
+ *   The circular buffer holding the oldest unread note or NULL if all
+ *   buffers are empty.
+ *
+ ****************************************************************************/
+
+static FAR struct noteram_info_s *noteram_oldest(FAR unsigned int *read)
+{
+  FAR struct noteram_info_s *oldest = NULL;
+  FAR struct noteram_info_s *ni;
+  struct note_common_s note;
+  uint64_t oldtime = 0;
+  uint64_t systime;
+  irqstate_t flags;
+  int cpu;
+
+  for (cpu = 0; cpu < NOTERAM_NCPUS; cpu++)
     {
-      /* The read index also needs increment. */
+      ni    = &g_noteram_info[cpu];
+      flags = noteram_lock(ni);
+
+      if (noteram_unread_length(ni) > 0)
+        {
+          noteram_copyout(ni, ni->ni_read, &note,
+                          sizeof(struct note_common_s));
+          systime = noteram_timestamp(&note);
+
+          if (oldest == NULL || systime < oldtime)
+            {
+              oldest  = ni;
+              oldtime = systime;
+              *read   = ni->ni_read;
+            }
+        }
 
-      g_noteram_info.ni_read = noteram_next(tail, length);
+      noteram_unlock(ni, flags);
     }
 
-  g_noteram_info.ni_tail = noteram_next(tail, length);
+  return oldest;
 }
 
 /****************************************************************************
  * Name: noteram_get
  *
  * Description:
- *   Get the next note from the read index of the circular buffer.
+ *   Get the oldest unread note from the circular buffers.
  *
  * Input Parameters:
  *   buffer - Location to return the next note
@@ -464,42 +738,44 @@ static void noteram_remove(void)
  *
  * Returned Value:
  *   On success, the positive, non-zero length of the return note is
- *   provided.  Zero is returned only if the circular buffer is empty.  A
+ *   provided.  Zero is returned only if the circular buffers are empty.  A
  *   negated errno value is returned in the event of any failure.
  *
  ****************************************************************************/
 
 static ssize_t noteram_get(FAR uint8_t *buffer, size_t buflen)
 {
-  FAR struct note_common_s *note;
+  FAR struct noteram_info_s *ni;
   irqstate_t flags;
-  unsigned int remaining;
   unsigned int read;
   ssize_t notelen;
-  size_t circlen;
 
   DEBUGASSERT(buffer != NULL);
-  flags = enter_critical_section();
 
-  /* Verify that the circular buffer is not empty */
-
-  circlen = noteram_unread_length();
-  if (circlen <= 0)
+  for (; ; )
     {
-      notelen = 0;
-      goto errout_with_csection;
-    }
+      ni = noteram_oldest(&read);
+      if (ni == NULL)
+        {
+          return 0;
+        }
 
-  /* Get the read index of the circular buffer */
+      /* The note may have been overwritten since it was found */
 
-  read    = g_noteram_info.ni_read;
-  DEBUGASSERT(read < CONFIG_DRIVER_NOTERAM_BUFSIZE);
+      flags = noteram_lock(ni);
+      if (ni->ni_read == read)
+        {
+          break;
+        }
+
+      noteram_unlock(ni, flags);
+    }
 
   /* Get the length of the note at the read index */
 
-  note    = (FAR struct note_common_s *)&g_noteram_info.ni_buffer[read];
-  notelen = note->nc_length;
-  DEBUGASSERT(notelen <= circlen);
+  DEBUGASSERT(read < CONFIG_DRIVER_NOTERAM_BUFSIZE);
+  notelen = ni->ni_buffer[read];
+  DEBUGASSERT(notelen <= noteram_unread_length(ni));
 
   /* Is the user buffer large enough to hold the note? */
 
@@ -507,33 +783,19 @@ static ssize_t noteram_get(FAR uint8_t *buffer, size_t buflen)
     {
       /* Skip the large note so that we do not get constipated. */
 
-      g_noteram_info.ni_read = noteram_next(read, notelen);
+      ni->ni_read = noteram_next(read, notelen);
 
       /* and return an error */
 
       notelen = -EFBIG;
-      goto errout_with_csection;
     }
-
-  /* Loop until the note has been transferred to the user buffer */
-
-  remaining = (unsigned int)notelen;
-  while (remaining > 0)
+  else
     {
-      /* Copy the next byte at the read index */
-
-      *buffer++ = g_noteram_info.ni_buffer[read];
-
-      /* Adjust indices and counts */
-
-      read = noteram_next(read, 1);
-      remaining--;
+      noteram_copyout(ni, read, buffer, notelen);
+      ni->ni_read = noteram_next(read, notelen);
     }
 
-  g_noteram_info.ni_read = read;
-
-errout_with_csection:
-  leave_critical_section(flags);
+  noteram_unlock(ni, flags);
   return notelen;
 }
 
@@ -541,51 +803,31 @@ errout_with_csection:
  * Name: noteram_size
  *
  * Description:
- *   Return the size of the next note at the read index of the circular
- *   buffer.
+ *   Return the size of the oldest unread note in the circular buffers.
  *
  * Input Parameters:
  *   None.
  *
  * Returned Value:
- *   Zero is returned if the circular buffer is empty.  Otherwise, the size
- *   of the next note is returned.
+ *   Zero is returned if the circular buffers are empty.  Otherwise, the
+ *   size of the next note is returned.
  *
  ****************************************************************************/
 
 static ssize_t noteram_size(void)
 {
-  FAR struct note_common_s *note;
-  irqstate_t flags;
+  FAR struct noteram_info_s *ni;
   unsigned int read;
-  ssize_t notelen;
-  size_t circlen;
-
-  flags = enter_critical_section();
-
-  /* Verify that the circular buffer is not empty */
 
-  circlen = noteram_unread_length();
-  if (circlen <= 0)
+  ni = noteram_oldest(&read);
+  if (ni == NULL)
     {
-      notelen = 0;
-      goto errout_with_csection;
+      return 0;
     }
 
-  /* Get the read index of the circular buffer */
+  /* This is only a hint, the note may be overwritten at any time */
 
-  read = g_noteram_info.ni_read;
-  DEBUGASSERT(read < CONFIG_DRIVER_NOTERAM_BUFSIZE);
-
-  /* Get the length of the note at the read index */
-
-  note    = (FAR struct note_common_s *)&g_noteram_info.ni_buffer[read];
-  notelen = note->nc_length;
-  DEBUGASSERT(notelen <= circlen);
-
-errout_with_csection:
-  leave_critical_section(flags);
-  return notelen;
+  return ni->ni_buffer[read];
 }
 
 /****************************************************************************
@@ -594,9 +836,19 @@ errout_with_csection:
 
 static int noteram_open(FAR struct file *filep)
 {
-  /* Reset the read index of the circular buffer */
+  FAR struct noteram_info_s *ni;
+  irqstate_t flags;
+  int cpu;
 
-  g_noteram_info.ni_read = g_noteram_info.ni_tail;
+  /* Reset the read index of the circular buffers */
+
+  for (cpu = 0; cpu < NOTERAM_NCPUS; cpu++)
+    {
+      ni    = &g_noteram_info[cpu];
+      flags = noteram_lock(ni);
+      ni->ni_read = ni->ni_tail;
+      noteram_unlock(ni, flags);
+    }
 
   return OK;
 }
@@ -695,7 +947,7 @@ static int noteram_ioctl(struct file *filep, int cmd, unsigned long arg)
           }
         else
           {
-            *(unsigned int *)arg = g_noteram_info.ni_overwrite;
+            *(unsigned int *)arg = noteram_getmode();
             ret = OK;
           }
         break;
@@ -712,7 +964,7 @@ static int noteram_ioctl(struct file *filep, int cmd, unsigned long arg)
           }
         else
           {
-            g_noteram_info.ni_overwrite = *(unsigned int *)arg;
+            noteram_setmode(*(unsigned int *)arg);
             ret = OK;
           }
         break;
@@ -753,6 +1005,35 @@ static int noteram_ioctl(struct file *filep, int cmd, unsigned long arg)
         break;
 #endif
 
+      /* NOTERAM_GETLOST
+       *      - Get the number of notes lost since the last clear
+       *        Argument: A writable pointer to struct noteram_lost_s
+       */
+
+      case NOTERAM_GETLOST:
+        if (arg == 0)
+          {
+            ret = -EINVAL;
+          }
+        else
+          {
+            FAR struct noteram_lost_s *lost =
+              (FAR struct noteram_lost_s *)arg;
+            int cpu;
+
+            lost->dropped     = 0;
+            lost->overwritten = 0;
+
+            for (cpu = 0; cpu < NOTERAM_NCPUS; cpu++)
+              {
+                lost->dropped     += g_noteram_info[cpu].ni_dropped;
+                lost->overwritten += g_noteram_info[cpu].ni_overwritten;
+              }
+
+            ret = OK;
+          }
+        break;
+
       default:
           break;
     }
@@ -784,23 +1065,23 @@ static int noteram_ioctl(struct file *filep, int cmd, unsigned long arg)
 
 void sched_note_add(FAR const void *note, size_t notelen)
 {
-  FAR const char *buf = note;
-  unsigned int head;
-  unsigned int next;
+  FAR struct noteram_info_s *ni;
   irqstate_t flags;
 
+  /* The note goes into the buffer of this CPU.  Only the reader ever
+   * competes for its lock.
+   */
+
   flags = up_irq_save();
+  ni    = &g_noteram_info[NOTERAM_THIS_CPU()];
 #ifdef CONFIG_SMP
-  spin_lock_wo_note(&g_noteram_lock);
+  spin_lock_wo_note(&ni->ni_lock);
 #endif
 
-  if (g_noteram_info.ni_overwrite == NOTERAM_MODE_OVERWRITE_OVERFLOW)
+  if (ni->ni_overflow)
     {
-#ifdef CONFIG_SMP
-      spin_unlock_wo_note(&g_noteram_lock);
-#endif
-      up_irq_restore(flags);
-      return;
+      ni->ni_dropped++;
+      goto out;
     }
 
 #if CONFIG_DRIVER_NOTERAM_TASKNAME_BUFSIZE > 0
@@ -812,59 +1093,49 @@ void sched_note_add(FAR const void *note, size_t notelen)
       note_st = (FAR struct note_start_s *)note;
       if (note_st->nst_cmn.nc_type == NOTE_START)
         {
+#ifdef CONFIG_SMP
+          spin_lock_wo_note(&g_noteram_lock);
+#endif
           noteram_record_taskname(note_st->nst_cmn.nc_pid[0] +
                                   (note_st->nst_cmn.nc_pid[1] << 8),
                                   note_st->nst_name);
+#ifdef CONFIG_SMP
+          spin_unlock_wo_note(&g_noteram_lock);
+#endif
         }
     }
 #endif
 
-  /* Get the index to the head of the circular buffer */
-
   DEBUGASSERT(note != NULL && notelen < CONFIG_DRIVER_NOTERAM_BUFSIZE);
-  head = g_noteram_info.ni_head;
 
-  /* Loop until all bytes have been transferred to the circular buffer */
+  /* Make room for the whole note.  The head index may never reach the
+   * tail index.
+   */
 
-  while (notelen > 0)
+  while (noteram_length(ni) + notelen >= CONFIG_DRIVER_NOTERAM_BUFSIZE)
     {
-      /* Get the next head index.  Would it collide with the current tail
-       * index?
-       */
-
-      next = noteram_next(head, 1);
-      if (next == g_noteram_info.ni_tail)
+      if (g_noteram_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE)
         {
-          if (g_noteram_info.ni_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE)
-            {
-              /* Stop recording if not in overwrite mode */
-
-              g_noteram_info.ni_overwrite = NOTERAM_MODE_OVERWRITE_OVERFLOW;
-
-#ifdef CONFIG_SMP
-              spin_unlock_wo_note(&g_noteram_lock);
-#endif
-              up_irq_restore(flags);
-              return;
-            }
-
-          /* Yes, then remove the note at the tail index */
+          /* Stop recording on this CPU if not in overwrite mode */
 
-          noteram_remove();
+          ni->ni_overflow = true;
+          ni->ni_dropped++;
+          goto out;
         }
 
-      /* Save the next byte at the head index */
+      /* Remove the note at the tail index */
 
-      g_noteram_info.ni_buffer[head] = *buf++;
-
-      head = next;
-      notelen--;
+      noteram_remove(ni);
     }
 
-  g_noteram_info.ni_head = head;
+  /* Copy the note and then publish it by moving the head index */
+
+  noteram_copyin(ni, ni->ni_head, note, notelen);
+  ni->ni_head = noteram_next(ni->ni_head, notelen);
 
+out:
 #ifdef CONFIG_SMP
-  spin_unlock_wo_note(&g_noteram_lock);
+  spin_unlock_wo_note(&ni->ni_lock);
 #endif
   up_irq_restore(flags);
 }
@@ -37,11 +37,11 @@
 #include <assert.h>
 #include <debug.h>
 
-#ifdef CONFIG_DEBUG_FEATURES
-#  include <nuttx/arch.h>
-#endif
+#include <nuttx/arch.h>
+#include <nuttx/irq.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 
@@ -63,6 +63,10 @@
 #  define pipe_dumpbuffer(m,a,n)
 #endif
 
+#ifndef SP_DMB
+#  define SP_DMB()
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -114,6 +118,586 @@ static void pipecommon_pollnotify(FAR struct pipe_dev_s *dev,
     }
 }
 
+/****************************************************************************
+ * Name: pipecommon_lock
+ *
+ * Description:
+ *   Serialize the access to the buffer and the indices, unless the pipe is
+ *   in single reader/writer mode.  A transfer without d_bfsem is counted in
+ *   d_nxfers so that PIPEIOC_SPSC cannot change the mode before the
+ *   matching pipecommon_unlock().
+ *
+ ****************************************************************************/
+
+static int pipecommon_lock(FAR struct pipe_dev_s *dev)
+{
+  irqstate_t flags;
+  int ret;
+
+  flags = enter_critical_section();
+  if (PIPE_IS_SPSC(dev->d_flags))
+    {
+      dev->d_nxfers++;
+      leave_critical_section(flags);
+      return OK;
+    }
+
+  leave_critical_section(flags);
+
+  ret = nxsem_wait(&dev->d_bfsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* The mode may have been changed while waiting for d_bfsem */
+
+  flags = enter_critical_section();
+  if (PIPE_IS_SPSC(dev->d_flags))
+    {
+      dev->d_nxfers++;
+      nxsem_post(&dev->d_bfsem);
+    }
+
+  leave_critical_section(flags);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: pipecommon_unlock
+ ****************************************************************************/
+
+static void pipecommon_unlock(FAR struct pipe_dev_s *dev)
+{
+  irqstate_t flags;
+
+  flags = enter_critical_section();
+  if (PIPE_IS_SPSC(dev->d_flags))
+    {
+      DEBUGASSERT(dev->d_nxfers > 0);
+      dev->d_nxfers--;
+      leave_critical_section(flags);
+    }
+  else
+    {
+      leave_critical_section(flags);
+      nxsem_post(&dev->d_bfsem);
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_nbytes
+ *
+ * Description:
+ *   Return the number of bytes in the buffer.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_nbytes(FAR struct pipe_dev_s *dev)
+{
+  pipe_ndx_t wrndx = dev->d_wrndx;
+  pipe_ndx_t rdndx = dev->d_rdndx;
+
+  if (wrndx >= rdndx)
+    {
+      return wrndx - rdndx;
+    }
+  else
+    {
+      return dev->d_bufsize + wrndx - rdndx;
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_rdready
+ *
+ * Description:
+ *   Return true if a reader need not wait:  There is data to read or there
+ *   will never be any more.
+ *
+ ****************************************************************************/
+
+static bool pipecommon_rdready(FAR struct pipe_dev_s *dev)
+{
+  return dev->d_wrndx != dev->d_rdndx || dev->d_nwriters <= 0;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wrready
+ *
+ * Description:
+ *   Return true if a writer need not wait:  There is space for at least
+ *   one byte or nobody will ever read it.
+ *
+ ****************************************************************************/
+
+static bool pipecommon_wrready(FAR struct pipe_dev_s *dev)
+{
+  return pipecommon_nbytes(dev) < dev->d_bufsize - 1 ||
+         dev->d_nreaders <= 0;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wait
+ *
+ * Description:
+ *   Wait on 'sem' until the peer makes the pipe ready.  The condition is
+ *   re-checked within the critical section that the peer also holds when
+ *   it wakes up the waiters so that no wake up can be lost, even when the
+ *   peer does not take d_bfsem.  d_bfsem is released while waiting.
+ *
+ * Returned Value:
+ *   Zero on success, with d_bfsem held again.  A negated errno value if
+ *   the wait was interrupted, with d_bfsem released.
+ *
+ ****************************************************************************/
+
+static int pipecommon_wait(FAR struct pipe_dev_s *dev, FAR sem_t *sem,
+                           CODE bool (*ready)(FAR struct pipe_dev_s *dev))
+{
+  irqstate_t flags;
+  int ret = OK;
+
+  sched_lock();
+  flags = enter_critical_section();
+  pipecommon_unlock(dev);
+
+  if (!ready(dev))
+    {
+      ret = nxsem_wait(sem);
+    }
+
+  leave_critical_section(flags);
+  sched_unlock();
+
+  if (ret >= 0)
+    {
+      ret = pipecommon_lock(dev);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wakeup
+ *
+ * Description:
+ *   Notify the poll waiters of 'eventset' and wake up all threads waiting
+ *   on 'sem'.
+ *
+ ****************************************************************************/
+
+static void pipecommon_wakeup(FAR struct pipe_dev_s *dev, FAR sem_t *sem,
+                              pollevent_t eventset)
+{
+  irqstate_t flags;
+  int sval;
+
+  flags = enter_critical_section();
+  pipecommon_pollnotify(dev, eventset);
+
+  while (nxsem_get_value(sem, &sval) == 0 && sval < 0)
+    {
+      nxsem_post(sem);
+    }
+
+  leave_critical_section(flags);
+}
+
+/****************************************************************************
+ * Name: pipecommon_rdspace
+ *
+ * Description:
+ *   Return the number of contiguous bytes that can be read at d_rdndx.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_rdspace(FAR struct pipe_dev_s *dev)
+{
+  pipe_ndx_t wrndx = dev->d_wrndx;
+  pipe_ndx_t rdndx = dev->d_rdndx;
+
+  return (wrndx >= rdndx ? wrndx : dev->d_bufsize) - rdndx;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wrspace
+ *
+ * Description:
+ *   Return the number of contiguous bytes that can be written at d_wrndx.
+ *   One byte always stays free to tell a full buffer from an empty one.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_wrspace(FAR struct pipe_dev_s *dev)
+{
+  pipe_ndx_t wrndx = dev->d_wrndx;
+  pipe_ndx_t rdndx = dev->d_rdndx;
+
+  if (wrndx < rdndx)
+    {
+      return rdndx - wrndx - 1;
+    }
+  else if (rdndx == 0)
+    {
+      return dev->d_bufsize - wrndx - 1;
+    }
+  else
+    {
+      return dev->d_bufsize - wrndx;
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_rdadvance
+ *
+ * Description:
+ *   Release 'nbytes' read bytes to the writer.
+ *
+ ****************************************************************************/
+
+static void pipecommon_rdadvance(FAR struct pipe_dev_s *dev, size_t nbytes)
+{
+  size_t rdndx = dev->d_rdndx + nbytes;
+
+  if (rdndx >= dev->d_bufsize)
+    {
+      rdndx -= dev->d_bufsize;
+    }
+
+  /* The data must be copied out before the writer may overwrite it */
+
+  SP_DMB();
+  dev->d_rdndx = rdndx;
+}
+
+/****************************************************************************
+ * Name: pipecommon_wradvance
+ *
+ * Description:
+ *   Publish 'nbytes' written bytes to the reader.
+ *
+ ****************************************************************************/
+
+static void pipecommon_wradvance(FAR struct pipe_dev_s *dev, size_t nbytes)
+{
+  size_t wrndx = dev->d_wrndx + nbytes;
+
+  if (wrndx >= dev->d_bufsize)
+    {
+      wrndx -= dev->d_bufsize;
+    }
+
+  /* The data must be visible before the reader may see the new index */
+
+  SP_DMB();
+  dev->d_wrndx = wrndx;
+}
+
+/****************************************************************************
+ * Name: pipecommon_copyout
+ *
+ * Description:
+ *   Copy up to 'len' bytes out of the buffer in at most two segments.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_copyout(FAR struct pipe_dev_s *dev,
+                                 FAR char *buffer, size_t len)
+{
+  size_t nread = 0;
+  size_t nbytes;
+
+  while (nread < len && (nbytes = pipecommon_rdspace(dev)) > 0)
+    {
+      if (nbytes > len - nread)
+        {
+          nbytes = len - nread;
+        }
+
+      memcpy(&buffer[nread], &dev->d_buffer[dev->d_rdndx], nbytes);
+      pipecommon_rdadvance(dev, nbytes);
+      nread += nbytes;
+    }
+
+  return nread;
+}
+
+/****************************************************************************
+ * Name: pipecommon_copyin
+ *
+ * Description:
+ *   Copy up to 'len' bytes into the buffer in at most two segments.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_copyin(FAR struct pipe_dev_s *dev,
+                                FAR const char *buffer, size_t len)
+{
+  size_t nwritten = 0;
+  size_t nbytes;
+
+  while (nwritten < len && (nbytes = pipecommon_wrspace(dev)) > 0)
+    {
+      if (nbytes > len - nwritten)
+        {
+          nbytes = len - nwritten;
+        }
+
+      memcpy(&dev->d_buffer[dev->d_wrndx], &buffer[nwritten], nbytes);
+      pipecommon_wradvance(dev, nbytes);
+      nwritten += nbytes;
+    }
+
+  return nwritten;
+}
+
+/****************************************************************************
+ * Name: pipecommon_resize
+ *
+ * Description:
+ *   Change the size of the buffer, keeping the buffered data.
+ *
+ * Assumptions:
+ *   The caller holds d_bfsem.
+ *
+ ****************************************************************************/
+
+static int pipecommon_resize(FAR struct pipe_dev_s *dev, size_t bufsize)
+{
+  FAR uint8_t *buffer;
+  size_t nbytes;
+
+  /* The lock-free reader and writer cannot follow a moving buffer */
+
+  if (PIPE_IS_SPSC(dev->d_flags))
+    {
+      return -EBUSY;
+    }
+
+  if (bufsize < 2 || bufsize > CONFIG_DEV_PIPE_MAXSIZE)
+    {
+      return -EINVAL;
+    }
+
+  if (dev->d_buffer != NULL)
+    {
+      nbytes = pipecommon_nbytes(dev);
+      if (nbytes >= bufsize)
+        {
+          return -EBUSY;
+        }
+
+      buffer = (FAR uint8_t *)kmm_malloc(bufsize);
+      if (buffer == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      pipecommon_copyout(dev, (FAR char *)buffer, nbytes);
+      kmm_free(dev->d_buffer);
+
+      dev->d_buffer = buffer;
+      dev->d_rdndx  = 0;
+      dev->d_wrndx  = nbytes;
+    }
+
+  dev->d_bufsize = bufsize;
+
+  /* There may be more space now */
+
+  pipecommon_wakeup(dev, &dev->d_wrsem, POLLOUT);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: pipecommon_ispipe
+ ****************************************************************************/
+
+static bool pipecommon_ispipe(FAR struct file *filep)
+{
+  FAR struct inode *inode = filep->f_inode;
+
+  return inode != NULL && INODE_IS_DRIVER(inode) &&
+         inode->u.i_ops->read == pipecommon_read;
+}
+
+/****************************************************************************
+ * Name: pipecommon_spliceout
+ *
+ * Description:
+ *   Write the data of the pipe 'filep' to 'outfile' directly from the
+ *   pipe buffer.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_spliceout(FAR struct file *filep,
+                                    FAR struct file *outfile, size_t count)
+{
+  FAR struct pipe_dev_s *dev = filep->f_inode->i_private;
+  ssize_t total = 0;
+  ssize_t nwritten;
+  size_t nbytes;
+  int ret;
+
+  ret = pipecommon_lock(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Wait for data as pipecommon_read() does */
+
+  while (dev->d_wrndx == dev->d_rdndx)
+    {
+      if (dev->d_nwriters <= 0 || (filep->f_oflags & O_NONBLOCK) != 0)
+        {
+          pipecommon_unlock(dev);
+          return dev->d_nwriters <= 0 ? 0 : -EAGAIN;
+        }
+
+      ret = pipecommon_wait(dev, &dev->d_rdsem, pipecommon_rdready);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  /* The output may block.  Holding d_bfsem meanwhile keeps other readers
+   * from consuming the data being written.
+   */
+
+  while ((size_t)total < count && (nbytes = pipecommon_rdspace(dev)) > 0)
+    {
+      if (nbytes > count - total)
+        {
+          nbytes = count - total;
+        }
+
+      nwritten = file_write(outfile, &dev->d_buffer[dev->d_rdndx], nbytes);
+      if (nwritten <= 0)
+        {
+          if (total == 0)
+            {
+              total = nwritten;
+            }
+
+          break;
+        }
+
+      pipecommon_rdadvance(dev, nwritten);
+      total += nwritten;
+
+      if ((size_t)nwritten < nbytes)
+        {
+          break;
+        }
+    }
+
+  if (total > 0)
+    {
+      pipecommon_wakeup(dev, &dev->d_wrsem, POLLOUT);
+    }
+
+  pipecommon_unlock(dev);
+  return total;
+}
+
+/****************************************************************************
+ * Name: pipecommon_splicein
+ *
+ * Description:
+ *   Read data from 'infile' directly into the buffer of the pipe 'filep'.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_splicein(FAR struct file *filep,
+                                   FAR struct file *infile, size_t count)
+{
+  FAR struct pipe_dev_s *dev = filep->f_inode->i_private;
+  ssize_t total = 0;
+  ssize_t nread;
+  size_t nbytes;
+  int ret;
+
+  if (dev->d_nreaders <= 0)
+    {
+      return -EPIPE;
+    }
+
+  ret = pipecommon_lock(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  while ((size_t)total < count)
+    {
+      nbytes = pipecommon_wrspace(dev);
+      if (nbytes == 0)
+        {
+          /* The pipe is full.  Return what was moved so far or wait for
+           * space as pipecommon_write() does.
+           */
+
+          if (total > 0)
+            {
+              break;
+            }
+
+          if ((filep->f_oflags & O_NONBLOCK) != 0)
+            {
+              total = -EAGAIN;
+              break;
+            }
+
+          ret = pipecommon_wait(dev, &dev->d_wrsem, pipecommon_wrready);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          if (dev->d_nreaders <= 0)
+            {
+              total = -EPIPE;
+              break;
+            }
+
+          continue;
+        }
+
+      if (nbytes > count - total)
+        {
+          nbytes = count - total;
+        }
+
+      nread = file_read(infile, &dev->d_buffer[dev->d_wrndx], nbytes);
+      if (nread <= 0)
+        {
+          if (total == 0)
+            {
+              total = nread;
+            }
+
+          break;
+        }
+
+      pipecommon_wradvance(dev, nread);
+      pipecommon_wakeup(dev, &dev->d_rdsem, POLLIN);
+      total += nread;
+
+      /* Don't block on the input once some data has been moved */
+
+      if ((size_t)nread < nbytes)
+        {
+          break;
+        }
+    }
+
+  pipecommon_unlock(dev);
+  return total;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -209,6 +793,18 @@ int pipecommon_open(FAR struct file *filep)
    * instance.
    */
 
+  /* Only one reader and one writer may use a pipe in single reader/writer
+   * mode.
+   */
+
+  if (PIPE_IS_SPSC(dev->d_flags) &&
+      (((filep->f_oflags & O_WROK) != 0 && dev->d_nwriters > 0) ||
+       ((filep->f_oflags & O_RDOK) != 0 && dev->d_nreaders > 0)))
+    {
+      nxsem_post(&dev->d_bfsem);
+      return -EBUSY;
+    }
+
   if ((filep->f_oflags & O_WROK) != 0)
     {
       dev->d_nwriters++;
@@ -284,7 +880,6 @@ int pipecommon_close(FAR struct file *filep)
 {
   FAR struct inode      *inode = filep->f_inode;
   FAR struct pipe_dev_s *dev   = inode->i_private;
-  int                    sval;
   int                    ret;
 
   DEBUGASSERT(dev && filep->f_inode->i_crefs > 0);
@@ -324,12 +919,7 @@ int pipecommon_close(FAR struct file *filep)
             {
               /* Inform poll readers that other end closed. */
 
-              pipecommon_pollnotify(dev, POLLHUP);
-
-              while (nxsem_get_value(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  nxsem_post(&dev->d_rdsem);
-                }
+              pipecommon_wakeup(dev, &dev->d_rdsem, POLLHUP);
             }
         }
 
@@ -345,12 +935,7 @@ int pipecommon_close(FAR struct file *filep)
                 {
                   /* Inform poll writers that other end closed. */
 
-                  pipecommon_pollnotify(dev, POLLERR);
-                  while (nxsem_get_value(&dev->d_wrsem, &sval) == 0
-                         && sval < 0)
-                    {
-                      nxsem_post(&dev->d_wrsem);
-                    }
+                  pipecommon_wakeup(dev, &dev->d_wrsem, POLLERR);
                 }
             }
         }
@@ -401,11 +986,7 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
 {
   FAR struct inode      *inode  = filep->f_inode;
   FAR struct pipe_dev_s *dev    = inode->i_private;
-#ifdef CONFIG_DEV_PIPEDUMP
-  FAR uint8_t           *start  = (FAR uint8_t *)buffer;
-#endif
-  ssize_t                nread  = 0;
-  int                    sval;
+  ssize_t                nread;
   int                    ret;
 
   DEBUGASSERT(dev);
@@ -417,7 +998,7 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
   /* Make sure that we have exclusive access to the device structure */
 
-  ret = nxsem_wait(&dev->d_bfsem);
+  ret = pipecommon_lock(dev);
   if (ret < 0)
     {
       /* May fail because a signal was received or if the task was
@@ -435,7 +1016,7 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
       if (dev->d_nwriters <= 0)
         {
-          nxsem_post(&dev->d_bfsem);
+          pipecommon_unlock(dev);
           return 0;
         }
 
@@ -443,18 +1024,14 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
       if (filep->f_oflags & O_NONBLOCK)
         {
-          nxsem_post(&dev->d_bfsem);
+          pipecommon_unlock(dev);
           return -EAGAIN;
         }
 
       /* Otherwise, wait for something to be written to the pipe */
 
-      sched_lock();
-      nxsem_post(&dev->d_bfsem);
-      ret = nxsem_wait(&dev->d_rdsem);
-      sched_unlock();
-
-      if (ret < 0 || (ret = nxsem_wait(&dev->d_bfsem)) < 0)
+      ret = pipecommon_wait(dev, &dev->d_rdsem, pipecommon_rdready);
+      if (ret < 0)
         {
           /* May fail because a signal was received or if the task was
            * canceled.
@@ -468,33 +1045,16 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
    * byte).
    */
 
-  nread = 0;
-  while ((size_t)nread < len && dev->d_wrndx != dev->d_rdndx)
-    {
-      *buffer++ = dev->d_buffer[dev->d_rdndx];
-      if (++dev->d_rdndx >= dev->d_bufsize)
-        {
-          dev->d_rdndx = 0;
-        }
-
-      nread++;
-    }
-
-  /* Notify all poll/select waiters that they can write to the FIFO */
-
-  pipecommon_pollnotify(dev, POLLOUT);
+  nread = pipecommon_copyout(dev, buffer, len);
 
-  /* Notify all waiting writers that bytes have been removed from the
-   * buffer.
+  /* Notify all poll/select waiters that they can write to the FIFO and
+   * all waiting writers that bytes have been removed from the buffer.
    */
 
-  while (nxsem_get_value(&dev->d_wrsem, &sval) == 0 && sval < 0)
-    {
-      nxsem_post(&dev->d_wrsem);
-    }
+  pipecommon_wakeup(dev, &dev->d_wrsem, POLLOUT);
 
-  nxsem_post(&dev->d_bfsem);
-  pipe_dumpbuffer("From PIPE:", start, nread);
+  pipecommon_unlock(dev);
+  pipe_dumpbuffer("From PIPE:", (FAR uint8_t *)buffer, nread);
   return nread;
 }
 
@@ -508,9 +1068,7 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
   FAR struct inode      *inode    = filep->f_inode;
   FAR struct pipe_dev_s *dev      = inode->i_private;
   ssize_t                nwritten = 0;
-  ssize_t                last;
-  int                    nxtwrndx;
-  int                    sval;
+  size_t                 nbytes;
   int                    ret;
 
   DEBUGASSERT(dev);
@@ -551,7 +1109,7 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
 
   /* Make sure that we have exclusive access to the device structure */
 
-  ret = nxsem_wait(&dev->d_bfsem);
+  ret = pipecommon_lock(dev);
   if (ret < 0)
     {
       /* May fail because a signal was received or if the task was
@@ -563,117 +1121,69 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
 
   /* Loop until all of the bytes have been written */
 
-  last = 0;
   for (; ; )
     {
-      /* Calculate the write index AFTER the next byte is written */
+      /* Copy as much as fits into the free space of the buffer */
 
-      nxtwrndx = dev->d_wrndx + 1;
-      if (nxtwrndx >= dev->d_bufsize)
+      nbytes = pipecommon_copyin(dev, &buffer[nwritten], len - nwritten);
+      if (nbytes > 0)
         {
-          nxtwrndx = 0;
+          /* Notify all poll/select waiters that they can read from the
+           * FIFO and all waiting readers that more data is available.
+           */
+
+          nwritten += nbytes;
+          pipecommon_wakeup(dev, &dev->d_rdsem, POLLIN);
         }
 
-      /* Would the next write overflow the circular buffer? */
+      /* Is the write complete? */
 
-      if (nxtwrndx != dev->d_rdndx)
+      if ((size_t)nwritten >= len)
         {
-          /* No... copy the byte */
-
-          dev->d_buffer[dev->d_wrndx] = *buffer++;
-          dev->d_wrndx = nxtwrndx;
-
-          /* Is the write complete? */
-
-          nwritten++;
-          if ((size_t)nwritten >= len)
-            {
-              /* Notify all poll/select waiters that they can read from the
-               * FIFO.
-               */
-
-              pipecommon_pollnotify(dev, POLLIN);
-
-              /* Yes.. Notify all of the waiting readers that more data is
-               * available.
-               */
-
-              while (nxsem_get_value(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  nxsem_post(&dev->d_rdsem);
-                }
+          break;
+        }
 
-              /* Return the number of bytes written */
+      /* If O_NONBLOCK was set, then return partial bytes written or
+       * EGAIN.
+       */
 
-              nxsem_post(&dev->d_bfsem);
-              return len;
-            }
-        }
-      else
+      if (filep->f_oflags & O_NONBLOCK)
         {
-          /* There is not enough room for the next byte.  Was anything
-           * written in this pass?
-           */
-
-          if (last < nwritten)
+          if (nwritten == 0)
             {
-              /* Notify all poll/select waiters that they can read from the
-               * FIFO.
-               */
-
-              pipecommon_pollnotify(dev, POLLIN);
-
-              /* Yes.. Notify all of the waiting readers that more data is
-               * available.
-               */
-
-              while (nxsem_get_value(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  nxsem_post(&dev->d_rdsem);
-                }
+              nwritten = -EAGAIN;
             }
 
-          last = nwritten;
-
-          /* If O_NONBLOCK was set, then return partial bytes written or
-           * EGAIN.
-           */
-
-          if (filep->f_oflags & O_NONBLOCK)
-            {
-              if (nwritten == 0)
-                {
-                  nwritten = -EAGAIN;
-                }
+          break;
+        }
 
-              nxsem_post(&dev->d_bfsem);
-              return nwritten;
-            }
+      /* There is more to be written.. wait for data to be removed from
+       * the pipe
+       */
 
-          /* There is more to be written.. wait for data to be removed from
-           * the pipe
+      ret = pipecommon_wait(dev, &dev->d_wrsem, pipecommon_wrready);
+      if (ret < 0)
+        {
+          /* Either call nxsem_wait may fail because a signal was
+           * received or if the task was canceled.
            */
 
-          sched_lock();
-          nxsem_post(&dev->d_bfsem);
-          ret = nxsem_wait(&dev->d_wrsem);
-          sched_unlock();
+          return nwritten == 0 ? (ssize_t)ret : nwritten;
+        }
 
-          if (dev->d_nreaders <= 0)
+      if (dev->d_nreaders <= 0)
+        {
+          if (nwritten == 0)
             {
-              ret = -EPIPE;
+              nwritten = -EPIPE;
             }
 
-          if (ret < 0 || (ret = nxsem_wait(&dev->d_bfsem)) < 0)
-            {
-              /* Either call nxsem_wait may fail because a signal was
-               * received or if the task was canceled.
-               */
-
-              return nwritten == 0 ? (ssize_t)ret : nwritten;
-            }
+          break;
         }
     }
+
+  pipecommon_unlock(dev);
+  return nwritten;
 }
 
 /****************************************************************************
@@ -686,7 +1196,8 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
   FAR struct inode      *inode    = filep->f_inode;
   FAR struct pipe_dev_s *dev      = inode->i_private;
   pollevent_t            eventset;
-  pipe_ndx_t             nbytes;
+  irqstate_t             flags;
+  size_t                 nbytes;
   int                    ret;
   int                    i;
 
@@ -706,6 +1217,11 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
        * slot for the poll structure reference
        */
 
+      /* The slots are also used by readers and writers in single
+       * reader/writer mode, within a critical section.
+       */
+
+      flags = enter_critical_section();
       for (i = 0; i < CONFIG_DEV_PIPE_NPOLLWAITERS; i++)
         {
           /* Find an available slot */
@@ -720,6 +1236,8 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
             }
         }
 
+      leave_critical_section(flags);
+
       if (i >= CONFIG_DEV_PIPE_NPOLLWAITERS)
         {
           fds->priv   = NULL;
@@ -731,14 +1249,7 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
        * First, determine how many bytes are in the buffer
        */
 
-      if (dev->d_wrndx >= dev->d_rdndx)
-        {
-          nbytes = dev->d_wrndx - dev->d_rdndx;
-        }
-      else
-        {
-          nbytes = dev->d_bufsize + dev->d_wrndx - dev->d_rdndx;
-        }
+      nbytes = pipecommon_nbytes(dev);
 
       /* Notify the POLLOUT event if the pipe is not full, but only if
        * there is readers.
@@ -775,7 +1286,9 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
 
       if (eventset)
         {
+          flags = enter_critical_section();
           pipecommon_pollnotify(dev, eventset);
+          leave_critical_section(flags);
         }
     }
   else
@@ -794,8 +1307,10 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
 
       /* Remove all memory of the poll setup */
 
+      flags                = enter_critical_section();
       *slot                = NULL;
       fds->priv            = NULL;
+      leave_critical_section(flags);
     }
 
 errout:
@@ -845,29 +1360,65 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
         }
         break;
 
-      case FIONWRITE:  /* Number of bytes waiting in send queue */
-      case FIONREAD:   /* Number of bytes available for reading */
+      case PIPEIOC_SETSIZE:
         {
-          int count;
+          ret = pipecommon_resize(dev, arg);
+        }
+        break;
 
-          /* Determine the number of bytes written to the buffer.  This is,
-           * of course, also the number of bytes that may be read from the
-           * buffer.
-           *
-           *   d_rdndx - index to remove next byte from the buffer
-           *   d_wrndx - Index to next location to add a byte to the buffer.
+      case PIPEIOC_GETSIZE:
+        {
+          *(FAR int *)((uintptr_t)arg) = dev->d_bufsize;
+          ret = OK;
+        }
+        break;
+
+      case PIPEIOC_SPSC:
+        {
+          irqstate_t flags;
+          int sval;
+
+          /* The mode may only be changed while there are no transfers in
+           * progress:  Holding d_bfsem excludes the serialized ones, but
+           * not those without d_bfsem or waiting for the peer.  Entering
+           * the mode also requires a single reader and a single writer.
            */
 
-          if (dev->d_wrndx < dev->d_rdndx)
+          flags = enter_critical_section();
+          if (dev->d_nxfers > 0 ||
+              (nxsem_get_value(&dev->d_rdsem, &sval) == 0 && sval < 0) ||
+              (nxsem_get_value(&dev->d_wrsem, &sval) == 0 && sval < 0) ||
+              (arg != 0 && (dev->d_nreaders > 1 || dev->d_nwriters > 1)))
             {
-              count = (dev->d_bufsize - dev->d_rdndx) + dev->d_wrndx;
+              ret = -EBUSY;
             }
           else
             {
-              count = dev->d_wrndx - dev->d_rdndx;
+              if (arg != 0)
+                {
+                  PIPE_SPSC_1(dev->d_flags);
+                }
+              else
+                {
+                  PIPE_SPSC_0(dev->d_flags);
+                }
+
+              ret = OK;
             }
 
-          *(FAR int *)((uintptr_t)arg) = count;
+          leave_critical_section(flags);
+        }
+        break;
+
+      case FIONWRITE:  /* Number of bytes waiting in send queue */
+      case FIONREAD:   /* Number of bytes available for reading */
+        {
+          /* Determine the number of bytes written to the buffer.  This is,
+           * of course, also the number of bytes that may be read from the
+           * buffer.
+           */
+
+          *(FAR int *)((uintptr_t)arg) = pipecommon_nbytes(dev);
           ret = 0;
         }
         break;
@@ -876,24 +1427,12 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case FIONSPACE:
         {
-          int count;
-
-          /* Determine the number of bytes free in the buffer.
-           *
-           *   d_rdndx - index to remove next byte from the buffer
-           *   d_wrndx - Index to next location to add a byte to the buffer.
+          /* Determine the number of bytes free in the buffer.  One byte
+           * always stays free to tell a full buffer from an empty one.
            */
 
-          if (dev->d_wrndx < dev->d_rdndx)
-            {
-              count = (dev->d_rdndx - dev->d_wrndx) - 1;
-            }
-          else
-            {
-              count = ((dev->d_bufsize - dev->d_wrndx) + dev->d_rdndx) - 1;
-            }
-
-          *(FAR int *)((uintptr_t)arg) = count;
+          *(FAR int *)((uintptr_t)arg) =
+            dev->d_bufsize - pipecommon_nbytes(dev) - 1;
           ret = 0;
         }
         break;
@@ -907,6 +1446,43 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
   return ret;
 }
 
+/****************************************************************************
+ * Name: pipe_splice
+ *
+ * Description:
+ *   Move up to 'count' bytes between a pipe and another file without an
+ *   intermediate buffer.  See include/nuttx/fs/fs.h.
+ *
+ ****************************************************************************/
+
+ssize_t pipe_splice(FAR struct file *outfile, FAR struct file *infile,
+                    size_t count)
+{
+  if (count == 0)
+    {
+      return 0;
+    }
+
+  if (pipecommon_ispipe(infile) && (infile->f_oflags & O_RDOK) != 0)
+    {
+      /* Writing to the same pipe would deadlock on d_bfsem */
+
+      if (outfile->f_inode == infile->f_inode)
+        {
+          return -EINVAL;
+        }
+
+      return pipecommon_spliceout(infile, outfile, count);
+    }
+
+  if (pipecommon_ispipe(outfile) && (outfile->f_oflags & O_WROK) != 0)
+    {
+      return pipecommon_splicein(outfile, infile, count);
+    }
+
+  return -ENOSYS;
+}
+
 /****************************************************************************
  * Name: pipecommon_unlink
  ****************************************************************************/
@@ -83,6 +83,7 @@
 
 #define PIPE_FLAG_POLICY    (1 << 0) /* Bit 0: Policy=Free buffer when empty */
 #define PIPE_FLAG_UNLINKED  (1 << 1) /* Bit 1: The driver has been unlinked */
+#define PIPE_FLAG_SPSC      (1 << 2) /* Bit 2: Single reader/writer mode */
 
 #define PIPE_POLICY_0(f)    do { (f) &= ~PIPE_FLAG_POLICY; } while (0)
 #define PIPE_POLICY_1(f)    do { (f) |= PIPE_FLAG_POLICY; } while (0)
@@ -92,6 +93,10 @@
 #define PIPE_UNLINK(f)      do { (f) |= PIPE_FLAG_UNLINKED; } while (0)
 #define PIPE_IS_UNLINKED(f) (((f) & PIPE_FLAG_UNLINKED) != 0)
 
+#define PIPE_SPSC_0(f)      do { (f) &= ~PIPE_FLAG_SPSC; } while (0)
+#define PIPE_SPSC_1(f)      do { (f) |= PIPE_FLAG_SPSC; } while (0)
+#define PIPE_IS_SPSC(f)     (((f) & PIPE_FLAG_SPSC) != 0)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -109,6 +114,13 @@ typedef uint8_t pipe_ndx_t;   /*  8-bit index */
 /* This structure represents the state of one pipe.  A reference to this
  * structure is retained in the i_private field of the inode whenthe
  * pipe/fifo device is registered.
+ *
+ * d_wrndx is only changed by the writer and d_rdndx only by the reader.
+ * In single reader/writer mode (PIPE_FLAG_SPSC), this allows both sides to
+ * move data without d_bfsem.  The wait and wake up of the peer are then
+ * serialized by a critical section.  d_nxfers counts the transfers that
+ * are in progress without d_bfsem so that the mode is not changed under
+ * them.
  */
 
 struct pipe_dev_s
@@ -116,13 +128,21 @@ struct pipe_dev_s
   sem_t      d_bfsem;       /* Used to serialize access to d_buffer and indices */
   sem_t      d_rdsem;       /* Empty buffer - Reader waits for data write */
   sem_t      d_wrsem;       /* Full buffer - Writer waits for data read */
-  pipe_ndx_t d_wrndx;       /* Index in d_buffer to save next byte written */
-  pipe_ndx_t d_rdndx;       /* Index in d_buffer to return the next byte read */
+
+  /* Index in d_buffer to save next byte written */
+
+  volatile pipe_ndx_t d_wrndx;
+
+  /* Index in d_buffer to return the next byte read */
+
+  volatile pipe_ndx_t d_rdndx;
+
   pipe_ndx_t d_bufsize;     /* allocated size of d_buffer in bytes */
   uint8_t    d_nwriters;    /* Number of reference counts for write access */
   uint8_t    d_nreaders;    /* Number of reference counts for read access */
   uint8_t    d_pipeno;      /* Pipe minor number */
   uint8_t    d_flags;       /* See PIPE_FLAG_* definitions */
+  uint8_t    d_nxfers;      /* Transfers in progress in PIPE_FLAG_SPSC mode */
   uint8_t   *d_buffer;      /* Buffer allocated when device opened */
 
   /* The following is a list if poll structures of threads waiting for
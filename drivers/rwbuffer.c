@@ -958,6 +958,26 @@ static ssize_t rwb_read_(FAR struct rwbuffer_s *rwb, off_t startblock,
                 }
             }
 
+          /* Reading ahead does not help requests that are at least as
+           * large as the buffer:  Transfer those directly into the user
+           * buffer in one go rather than in buffer sized pieces.
+           */
+
+          if (remaining >= rwb->rhmaxblocks)
+            {
+              ret = rwb->rhreload(rwb->dev, rdbuffer, startblock, remaining);
+              if (ret != remaining)
+                {
+                  ferr("ERROR: Failed to read %zu blocks: %d\n",
+                       remaining, ret);
+
+                  rwb_semgive(&rwb->rhsem);
+                  return ret < 0 ? ret : -EIO;
+                }
+
+              break;
+            }
+
           /* If we did not get all of the data from the buffer, then we have
            * to refill the buffer and try again.
            */
@@ -1194,6 +1214,8 @@ ssize_t rwb_readbytes(FAR struct rwbuffer_s *dev, off_t offset,
 #ifdef CONFIG_DRVR_REMOVABLE
 int rwb_mediaremoved(FAR struct rwbuffer_s *rwb)
 {
+  int ret;
+
 #ifdef CONFIG_DRVR_WRITEBUFFER
   if (rwb->wrmaxblocks > 0)
     {
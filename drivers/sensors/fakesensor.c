@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/kthread.h>
@@ -39,6 +40,18 @@
 #include <nuttx/signal.h>
 #include <debug.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The events generated without a csv file are pushed this many at a time */
+
+#define FAKESENSOR_CHUNK    16
+
+/* The default interval of the generated events, in us */
+
+#define FAKESENSOR_INTERVAL 1000
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -50,6 +63,7 @@ struct fakesensor_s
   unsigned int interval;
   unsigned int batch;
   int raw_start;
+  uint64_t next;
   FAR const char *file_path;
   sem_t wakeup;
   volatile bool running;
@@ -213,6 +227,45 @@ static inline void fakesensor_read_gps(FAR struct fakesensor_s *sensor)
                            sizeof(struct sensor_event_gps));
 }
 
+static void fakesensor_generate(FAR struct fakesensor_s *sensor)
+{
+  struct sensor_event_accel events[FAKESENSOR_CHUNK];
+  uint64_t now = sensor_get_timestamp();
+  float phase;
+  int n = 0;
+
+  /* Generate an event for every interval that passed since the last
+   * wakeup, so that the rate is exact even if the interval is shorter than
+   * the system tick.  Accelerometer, gyroscope and magnetic field events
+   * share the same layout.
+   */
+
+  while (sensor->next <= now)
+    {
+      phase = 2 * M_PI * (sensor->next % USEC_PER_SEC) / USEC_PER_SEC;
+
+      events[n].timestamp   = sensor->next;
+      events[n].x           = sinf(phase);
+      events[n].y           = cosf(phase);
+      events[n].z           = 9.8f;
+      events[n].temperature = NAN;
+
+      sensor->next += sensor->interval;
+      if (++n == FAKESENSOR_CHUNK)
+        {
+          sensor->lower.push_event(sensor->lower.priv, events,
+                                   sizeof(events));
+          n = 0;
+        }
+    }
+
+  if (n > 0)
+    {
+      sensor->lower.push_event(sensor->lower.priv, events,
+                               n * sizeof(struct sensor_event_accel));
+    }
+}
+
 static int fakesensor_activate(FAR struct sensor_lowerhalf_s *lower, bool sw)
 {
   FAR struct fakesensor_s *sensor = container_of(lower,
@@ -238,6 +291,12 @@ static int fakesensor_set_interval(FAR struct sensor_lowerhalf_s *lower,
 {
   FAR struct fakesensor_s *sensor = container_of(lower,
                                                  struct fakesensor_s, lower);
+
+  if (sensor->file_path == NULL && *period_us == 0)
+    {
+      return -EINVAL;
+    }
+
   sensor->interval = *period_us;
   return OK;
 }
@@ -301,6 +360,20 @@ static int fakesensor_thread(int argc, char** argv)
 
       nxsem_wait_uninterruptible(&sensor->wakeup);
 
+      if (sensor->file_path == NULL)
+        {
+          /* Generate the events without a csv file */
+
+          sensor->next = sensor_get_timestamp() + sensor->interval;
+          while (sensor->running)
+            {
+              nxsig_usleep(sensor->batch ? sensor->batch : sensor->interval);
+              fakesensor_generate(sensor);
+            }
+
+          continue;
+        }
+
       /* Open csv file and init file handle */
 
       ret = file_open(&sensor->data, sensor->file_path, O_RDONLY);
@@ -369,6 +442,12 @@ static int fakesensor_thread(int argc, char** argv)
  *                    x,y,z
  *                    2.1234,3.23443,2.23456
  *                    ...
+ *                 If NULL, an accelerometer, gyroscope or magnetic field
+ *                 sensor generates a sine wave at the interval set by
+ *                 SNIOC_SET_INTERVAL (1 ms by default).  Intervals shorter
+ *                 than the system tick are generated in bursts with exact
+ *                 timestamps, which makes this a high rate sensor to
+ *                 benchmark the readers with.
  *   devno       - The user specifies which device of this type, from 0.
  *   batch_number- The maximum number of batch
  ****************************************************************************/
@@ -395,6 +474,19 @@ int fakesensor_init(int type, FAR const char *file_name,
   sensor->lower.buffer_number = batch_number;
   sensor->file_path = file_name;
 
+  if (file_name == NULL)
+    {
+      if (type != SENSOR_TYPE_ACCELEROMETER &&
+          type != SENSOR_TYPE_GYROSCOPE &&
+          type != SENSOR_TYPE_MAGNETIC_FIELD)
+        {
+          kmm_free(sensor);
+          return -EINVAL;
+        }
+
+      sensor->interval = FAKESENSOR_INTERVAL;
+    }
+
   nxsem_init(&sensor->wakeup, 0, 0);
   nxsem_set_protocol(&sensor->wakeup, SEM_PRIO_NONE);
 
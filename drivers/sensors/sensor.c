@@ -34,7 +34,9 @@
 
 #include <poll.h>
 #include <fcntl.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
 #include <nuttx/mm/circbuf.h>
 #include <nuttx/sensors/sensor.h>
 
@@ -49,6 +51,10 @@
 #define DEVNAME_MAX        64
 #define DEVNAME_UNCAL      "_uncal"
 
+#ifndef SP_DMB
+#  define SP_DMB()
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -77,6 +83,10 @@ struct sensor_upperhalf_s
   bool               enabled;            /* The status of sensor enable or disable */
   unsigned int       interval;           /* The sample interval for sensor, in us */
   unsigned int       latency;            /* The batch latency for sensor, in us */
+  unsigned int       watermark;          /* Events buffered before waking up readers */
+#ifdef CONFIG_SENSORS_MMAP
+  FAR struct sensor_ring_s *ring;        /* The ring shared with readers by mmap() */
+#endif
 };
 
 /****************************************************************************
@@ -173,6 +183,171 @@ static void sensor_pollnotify(FAR struct sensor_upperhalf_s *upper,
     }
 }
 
+static uint32_t sensor_navail(FAR struct sensor_upperhalf_s *upper)
+{
+#ifdef CONFIG_SENSORS_MMAP
+  if (upper->ring != NULL)
+    {
+      return upper->ring->head - upper->ring->tail;
+    }
+#endif
+
+  return circbuf_used(&upper->buffer) / upper->esize;
+}
+
+static bool sensor_is_ready(FAR struct sensor_upperhalf_s *upper)
+{
+  uint32_t watermark = upper->watermark;
+  uint32_t depth;
+
+  /* A watermark deeper than the buffer could never be reached */
+
+#ifdef CONFIG_SENSORS_MMAP
+  if (upper->ring != NULL)
+    {
+      depth = upper->ring->nevents;
+    }
+  else
+#endif
+    {
+      depth = circbuf_size(&upper->buffer) / upper->esize;
+    }
+
+  if (watermark > depth)
+    {
+      watermark = depth;
+    }
+
+  return sensor_navail(upper) >= (watermark > 0 ? watermark : 1);
+}
+
+static void sensor_wakeup(FAR struct sensor_upperhalf_s *upper)
+{
+  int semcount;
+
+  sensor_pollnotify(upper, POLLIN);
+  nxsem_get_value(&upper->buffersem, &semcount);
+  if (semcount < 1)
+    {
+      nxsem_post(&upper->buffersem);
+    }
+}
+
+#ifdef CONFIG_SENSORS_MMAP
+static FAR uint8_t *sensor_ring_slot(FAR struct sensor_ring_s *ring,
+                                     uint32_t n)
+{
+  return (FAR uint8_t *)ring + ring->offset +
+         (n & (ring->nevents - 1)) * ring->esize;
+}
+
+static void sensor_ring_write(FAR struct sensor_ring_s *ring,
+                              FAR const void *data, size_t bytes)
+{
+  FAR const uint8_t *src = data;
+  uint32_t head = ring->head;
+
+  for (; bytes >= ring->esize; bytes -= ring->esize, src += ring->esize)
+    {
+      /* The reader owns the tail, so a full ring can't be overwritten */
+
+      if (head - ring->tail >= ring->nevents)
+        {
+          ring->dropped++;
+          continue;
+        }
+
+      memcpy(sensor_ring_slot(ring, head), src, ring->esize);
+      head++;
+    }
+
+  /* Publish the events after their data */
+
+  SP_DMB();
+  ring->head = head;
+}
+
+static ssize_t sensor_ring_read(FAR struct sensor_ring_s *ring,
+                                FAR char *buffer, size_t len)
+{
+  uint32_t tail = ring->tail;
+  uint32_t nevents = ring->head - tail;
+  uint32_t nfirst;
+
+  SP_DMB();
+
+  if (nevents > len / ring->esize)
+    {
+      nevents = len / ring->esize;
+    }
+
+  /* Copy up to the end of the ring, then from its start */
+
+  nfirst = ring->nevents - (tail & (ring->nevents - 1));
+  if (nfirst > nevents)
+    {
+      nfirst = nevents;
+    }
+
+  memcpy(buffer, sensor_ring_slot(ring, tail), nfirst * ring->esize);
+  memcpy(buffer + nfirst * ring->esize, sensor_ring_slot(ring, 0),
+         (nevents - nfirst) * ring->esize);
+
+  SP_DMB();
+  ring->tail = tail + nevents;
+  return nevents * ring->esize;
+}
+
+static int sensor_mmap(FAR struct sensor_upperhalf_s *upper,
+                       FAR void **addr)
+{
+  FAR struct sensor_ring_s *ring = upper->ring;
+  uint32_t nevents = 1;
+  size_t offset;
+
+  if (addr == NULL)
+    {
+      return -EINVAL;
+    }
+
+  if (ring == NULL)
+    {
+      /* Size the ring like the buffer, rounded up to a power of two */
+
+      while (nevents < circbuf_size(&upper->buffer) / upper->esize)
+        {
+          nevents <<= 1;
+        }
+
+      offset = ROUNDUP(sizeof(struct sensor_ring_s), sizeof(uint64_t));
+      ring = kumm_zalloc(offset + nevents * upper->esize);
+      if (ring == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      ring->esize   = upper->esize;
+      ring->nevents = nevents;
+      ring->offset  = offset;
+
+      /* Move the events already buffered to the ring */
+
+      while (ring->head < nevents &&
+             circbuf_read(&upper->buffer, sensor_ring_slot(ring, ring->head),
+                          upper->esize) == upper->esize)
+        {
+          ring->head++;
+        }
+
+      circbuf_reset(&upper->buffer);
+      upper->ring = ring;
+    }
+
+  *addr = ring;
+  return OK;
+}
+#endif
+
 static int sensor_open(FAR struct file *filep)
 {
   FAR struct inode *inode = filep->f_inode;
@@ -290,13 +465,19 @@ static ssize_t sensor_read(FAR struct file *filep, FAR char *buffer,
       /* We must make sure that when the semaphore is equal to 1, there must
        * be events available in the buffer, so we use a while statement to
        * synchronize this case that other read operations consume events
-       * that have just entered the buffer.
+       * that have just entered the buffer.  A blocking read waits for the
+       * watermark, a non-blocking read returns what is there.
        */
 
-      while (circbuf_is_empty(&upper->buffer))
+      while (!sensor_is_ready(upper))
         {
           if (filep->f_oflags & O_NONBLOCK)
             {
+              if (sensor_navail(upper) > 0)
+                {
+                  break;
+                }
+
               ret = -EAGAIN;
               goto out;
             }
@@ -317,6 +498,15 @@ static ssize_t sensor_read(FAR struct file *filep, FAR char *buffer,
             }
         }
 
+#ifdef CONFIG_SENSORS_MMAP
+      if (upper->ring != NULL)
+        {
+          ret = len < upper->esize ? -EINVAL :
+                sensor_ring_read(upper->ring, buffer, len);
+          goto out;
+        }
+#endif
+
       ret = circbuf_read(&upper->buffer, buffer, len);
 
       /* Release some buffer space when current mode isn't batch mode
@@ -374,6 +564,18 @@ static int sensor_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case SNIOC_SET_INTERVAL:
         {
+#ifdef CONFIG_SENSORS_MMAP
+          /* The ring was sized for the current interval and batch latency
+           * and may be mapped, so it can't be resized anymore.
+           */
+
+          if (upper->ring != NULL)
+            {
+              ret = -EBUSY;
+              break;
+            }
+#endif
+
           if (lower->ops->set_interval == NULL)
             {
               ret = -ENOTSUP;
@@ -395,6 +597,14 @@ static int sensor_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case SNIOC_BATCH:
         {
+#ifdef CONFIG_SENSORS_MMAP
+          if (upper->ring != NULL)
+            {
+              ret = -EBUSY;
+              break;
+            }
+#endif
+
           if (lower->ops->batch == NULL)
             {
               ret = -ENOTSUP;
@@ -451,6 +661,14 @@ static int sensor_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case SNIOC_SET_BUFFER_NUMBER:
         {
+#ifdef CONFIG_SENSORS_MMAP
+          if (upper->ring != NULL)
+            {
+              ret = -EBUSY;
+              break;
+            }
+#endif
+
           if (arg != 0)
             {
               lower->buffer_number = arg;
@@ -459,6 +677,39 @@ static int sensor_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
         }
         break;
 
+      case SNIOC_SET_WATERMARK:
+        {
+          if (lower->ops->fetch)
+            {
+              ret = -ENOTSUP;
+              break;
+            }
+
+          if (arg == 0)
+            {
+              ret = -EINVAL;
+              break;
+            }
+
+          /* A lower watermark may already be reached */
+
+          upper->watermark = arg;
+          if (sensor_is_ready(upper))
+            {
+              sensor_wakeup(upper);
+            }
+        }
+        break;
+
+#ifdef CONFIG_SENSORS_MMAP
+      case FIOC_MMAP:
+        {
+          ret = lower->ops->fetch ? -ENOTSUP :
+                sensor_mmap(upper, (FAR void **)(uintptr_t)arg);
+        }
+        break;
+#endif
+
       default:
 
         /* Lowerhalf driver process other cmd. */
@@ -533,7 +784,7 @@ static int sensor_poll(FAR struct file *filep,
                 }
             }
         }
-      else if (!circbuf_is_empty(&upper->buffer))
+      else if (sensor_is_ready(upper))
         {
           eventset |= (fds->events & POLLIN);
         }
@@ -565,19 +816,28 @@ static void sensor_push_event(FAR void *priv, FAR const void *data,
                               size_t bytes)
 {
   FAR struct sensor_upperhalf_s *upper = priv;
-  int semcount;
 
   if (!bytes || nxsem_wait(&upper->exclsem) < 0)
     {
       return;
     }
 
-  circbuf_overwrite(&upper->buffer, data, bytes);
-  sensor_pollnotify(upper, POLLIN);
-  nxsem_get_value(&upper->buffersem, &semcount);
-  if (semcount < 1)
+#ifdef CONFIG_SENSORS_MMAP
+  if (upper->ring != NULL)
     {
-      nxsem_post(&upper->buffersem);
+      sensor_ring_write(upper->ring, data, bytes);
+    }
+  else
+#endif
+    {
+      circbuf_overwrite(&upper->buffer, data, bytes);
+    }
+
+  /* Wake up the readers once a batch of events is buffered */
+
+  if (sensor_is_ready(upper))
+    {
+      sensor_wakeup(upper);
     }
 
   nxsem_post(&upper->exclsem);
@@ -586,20 +846,13 @@ static void sensor_push_event(FAR void *priv, FAR const void *data,
 static void sensor_notify_event(FAR void *priv)
 {
   FAR struct sensor_upperhalf_s *upper = priv;
-  int semcount;
 
   if (nxsem_wait(&upper->exclsem) < 0)
     {
       return;
     }
 
-  sensor_pollnotify(upper, POLLIN);
-  nxsem_get_value(&upper->buffersem, &semcount);
-  if (semcount < 1)
-    {
-      nxsem_post(&upper->buffersem);
-    }
-
+  sensor_wakeup(upper);
   nxsem_post(&upper->exclsem);
 }
 
@@ -695,8 +948,9 @@ int sensor_custom_register(FAR struct sensor_lowerhalf_s *lower,
 
   /* Initialize the upper-half data structure */
 
-  upper->lower = lower;
-  upper->esize = esize;
+  upper->lower     = lower;
+  upper->esize     = esize;
+  upper->watermark = 1;
 
   nxsem_init(&upper->exclsem, 0, 1);
   nxsem_init(&upper->buffersem, 0, 0);
@@ -795,5 +1049,14 @@ void sensor_custom_unregister(FAR struct sensor_lowerhalf_s *lower,
   nxsem_destroy(&upper->exclsem);
   nxsem_destroy(&upper->buffersem);
 
+#ifdef CONFIG_SENSORS_MMAP
+  /* The ring outlives the last close() because it may still be mapped */
+
+  if (upper->ring != NULL)
+    {
+      kumm_free(upper->ring);
+    }
+#endif
+
   kmm_free(upper);
 }
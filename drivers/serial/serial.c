@@ -88,6 +88,10 @@ static inline ssize_t uart_irqwrite(FAR uart_dev_t *dev,
                                     FAR const char *buffer,
                                     size_t buflen);
 static int     uart_tcdrain(FAR uart_dev_t *dev, clock_t timeout);
+#ifdef CONFIG_SERIAL_TXDMA_ZEROCOPY
+static ssize_t uart_dmawrite(FAR uart_dev_t *dev, FAR const char *buffer,
+                             size_t buflen);
+#endif
 
 /* Character driver methods */
 
@@ -387,6 +391,115 @@ static inline ssize_t uart_irqwrite(FAR uart_dev_t *dev,
   return ret;
 }
 
+/****************************************************************************
+ * Name: uart_dmawrite
+ *
+ * Description:
+ *   Send the caller's buffer with TX DMA without copying it to the TX
+ *   circular buffer.  Any data already in the TX buffer is sent first.
+ *   This blocks until the whole buffer has been sent.
+ *
+ * Returned Value:
+ *   The number of bytes sent, -EAGAIN if the buffer needs output
+ *   post-processing and must go through the TX buffer, or a negated errno
+ *   value if nothing was sent.
+ *
+ * Assumptions:
+ *   The caller holds the xmit.sem and TX interrupts are disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SERIAL_TXDMA_ZEROCOPY
+static ssize_t uart_dmawrite(FAR uart_dev_t *dev, FAR const char *buffer,
+                             size_t buflen)
+{
+  FAR struct uart_dmaxfer_s *xfer = &dev->dmatx;
+  irqstate_t flags;
+  ssize_t nsent;
+  int ret;
+
+  if (dev->ops->dmasend == NULL)
+    {
+      return -EAGAIN;
+    }
+
+  /* The data must go out exactly as it is in the caller's buffer */
+
+#ifdef CONFIG_SERIAL_TERMIOS
+  if ((dev->tc_oflag & OPOST) != 0 &&
+      (((dev->tc_oflag & (ONLCR | ONLRET)) != 0 &&
+        memchr(buffer, '\n', buflen) != NULL) ||
+       ((dev->tc_oflag & OCRNL) != 0 &&
+        memchr(buffer, '\r', buflen) != NULL)))
+    {
+      return -EAGAIN;
+    }
+#else
+  if (dev->isconsole && memchr(buffer, '\n', buflen) != NULL)
+    {
+      return -EAGAIN;
+    }
+#endif
+
+  flags = enter_critical_section();
+
+  /* Wait for the data already in the TX buffer to be sent so that the
+   * output stays in order.
+   */
+
+  ret = OK;
+  while (ret >= 0 && dev->xmit.head != dev->xmit.tail)
+    {
+      dev->xmitwaiting = true;
+      uart_dmatxavail(dev);
+      uart_enabletxint(dev);
+      ret = uart_takesem(&dev->xmitsem, true);
+      uart_disabletxint(dev);
+
+#ifdef CONFIG_SERIAL_REMOVABLE
+      if (dev->disconnected)
+        {
+          ret = -ENOTCONN;
+        }
+#endif
+    }
+
+  if (ret < 0)
+    {
+      leave_critical_section(flags);
+      return ret;
+    }
+
+  /* Start the transfer.  From here on we are committed and signals are
+   * ignored.  uart_xmitchars_done() restarts the DMA until the whole
+   * buffer has been sent, or the lower half reports that nothing more
+   * could be sent.
+   */
+
+  xfer->buffer     = (FAR char *)buffer;
+  xfer->length     = buflen;
+  xfer->nbuffer    = NULL;
+  xfer->nlength    = 0;
+  xfer->nbytes     = 0;
+  dev->dmatxdirect = buflen;
+
+  uart_dmasend(dev);
+
+  while (dev->dmatxdirect > 0)
+    {
+      dev->xmitwaiting = true;
+      uart_takesem(&dev->xmitsem, false);
+    }
+
+  nsent        = xfer->buffer - buffer;
+  xfer->buffer = NULL;
+  xfer->length = 0;
+
+  leave_critical_section(flags);
+  return nsent > 0 ? nsent : -EIO;
+}
+#endif
+
 /****************************************************************************
  * Name: uart_tcdrain
  *
@@ -1124,6 +1237,26 @@ static ssize_t uart_write(FAR struct file *filep, FAR const char *buffer,
 
   oktoblock = ((filep->f_oflags & O_NONBLOCK) == 0);
 
+#ifdef CONFIG_SERIAL_TXDMA_ZEROCOPY
+  /* Large blocking writes are sent straight from the caller's buffer */
+
+  if (oktoblock && buflen >= CONFIG_SERIAL_TXDMA_ZEROCOPY_THRESHOLD)
+    {
+      uart_disabletxint(dev);
+      ret = uart_dmawrite(dev, buffer, buflen);
+      if (ret != -EAGAIN)
+        {
+          if (dev->xmit.head != dev->xmit.tail)
+            {
+              uart_enabletxint(dev);
+            }
+
+          uart_givesem(&dev->xmit.sem);
+          return ret;
+        }
+    }
+#endif
+
   /* Loop while we still have data to copy to the transmit buffer.
    * we add data to the head of the buffer; uart_xmitchars takes the
    * data from the end of the buffer.
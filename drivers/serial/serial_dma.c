@@ -95,8 +95,8 @@ static int uart_check_signo(int pid, const char *buf, size_t size)
  * Name: uart_recvchars_signo
  *
  * Description:
- *   Check if the SIGINT character is anywhere in the newly received DMA
- *   buffer.
+ *   Check if the SIGINT character is anywhere in the 'nbytes' bytes of the
+ *   RX DMA transfer that were received after the first 'offset' bytes.
  *
  *   REVISIT:  We must also remove the SIGINT/SIGTSTP character from the Rx
  *   buffer.  It should not be read as normal data by the caller.
@@ -106,30 +106,93 @@ static int uart_check_signo(int pid, const char *buf, size_t size)
 #if defined(CONFIG_SERIAL_RXDMA) && \
    (defined(CONFIG_TTY_SIGINT) || defined(CONFIG_TTY_SIGTSTP) || \
     defined(CONFIG_TTY_FORCE_PANIC))
-static int uart_recvchars_signo(FAR uart_dev_t *dev)
+static int uart_recvchars_signo(FAR uart_dev_t *dev, size_t offset,
+                                size_t nbytes)
 {
   FAR struct uart_dmaxfer_s *xfer = &dev->dmarx;
+  size_t nfirst;
   int signo;
 
-  /* Check if the valid DMAed data is in one or two contiguous regions */
+  /* Check if the new data is in one or two contiguous regions */
+
+  if (offset >= xfer->length)
+    {
+      return uart_check_signo(dev->pid, xfer->nbuffer + offset -
+                              xfer->length, nbytes);
+    }
 
-  if (xfer->nbytes <= xfer->length)
+  nfirst = xfer->length - offset;
+  if (nbytes <= nfirst)
     {
-      return uart_check_signo(dev->pid, xfer->buffer, xfer->nbytes);
+      return uart_check_signo(dev->pid, xfer->buffer + offset, nbytes);
     }
   else
     {
       /* REVISIT:  Additional signals could be in the second region. */
 
-      signo = uart_check_signo(dev->pid, xfer->buffer, xfer->length);
+      signo = uart_check_signo(dev->pid, xfer->buffer + offset, nfirst);
       if (signo != 0)
         {
           return signo;
         }
 
-      return uart_check_signo(dev->pid, xfer->nbuffer,
-                              xfer->nbytes - xfer->length);
+      return uart_check_signo(dev->pid, xfer->nbuffer, nbytes - nfirst);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: uart_recvchars_commit
+ *
+ * Description:
+ *   Move the bytes that the RX DMA has received since the last commit into
+ *   the RX circular buffer and wake up any waiting readers.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SERIAL_RXDMA
+static void uart_recvchars_commit(FAR uart_dev_t *dev)
+{
+  FAR struct uart_dmaxfer_s *xfer = &dev->dmarx;
+  FAR struct uart_buffer_s *rxbuf = &dev->recv;
+  size_t nbytes = xfer->nbytes - xfer->ndone;
+#if defined(CONFIG_TTY_SIGINT) || defined(CONFIG_TTY_SIGTSTP) || \
+    defined(CONFIG_TTY_FORCE_PANIC)
+  int signo = 0;
+
+  /* Check if the SIGINT character is anywhere in the newly received DMA
+   * data.
+   */
+
+  if (nbytes > 0 && (dev->tc_lflag & ISIG))
+    {
+      signo = uart_recvchars_signo(dev, xfer->ndone, nbytes);
     }
+#endif
+
+  /* Move head for nbytes. */
+
+  rxbuf->head  = (rxbuf->head + nbytes) % rxbuf->size;
+  xfer->ndone  = xfer->nbytes;
+
+  /* If any bytes were added to the buffer, inform any waiters there is new
+   * incoming data available.
+   */
+
+  if (nbytes)
+    {
+      uart_datareceived(dev);
+    }
+
+#if defined(CONFIG_TTY_SIGINT) || defined(CONFIG_TTY_SIGTSTP)
+  /* Send the signal if necessary */
+
+  if (signo != 0)
+    {
+      nxsig_kill(dev->pid, signo);
+      uart_reset_sem(dev);
+    }
+#endif
 }
 #endif
 
@@ -194,6 +257,34 @@ void uart_xmitchars_done(FAR uart_dev_t *dev)
   size_t nbytes = xfer->nbytes;
   struct uart_buffer_s *txbuf = &dev->xmit;
 
+#ifdef CONFIG_SERIAL_TXDMA_ZEROCOPY
+  /* Is this a transfer straight from the buffer of uart_write()? */
+
+  if (dev->dmatxdirect > 0)
+    {
+      xfer->buffer      += nbytes;
+      dev->dmatxdirect  -= nbytes;
+      xfer->nbytes       = 0;
+
+      if (nbytes > 0 && dev->dmatxdirect > 0)
+        {
+          /* Send the remainder.  xfer->buffer is left pointing after the
+           * last byte sent so that uart_write() knows how much was sent if
+           * the transfer stops early.
+           */
+
+          xfer->length = dev->dmatxdirect;
+          uart_dmasend(dev);
+          return;
+        }
+
+      dev->dmatxdirect = 0;
+      xfer->length     = 0;
+      uart_datasent(dev);
+      return;
+    }
+#endif
+
   /* Skip the update if the tail position change which mean
    * someone reset (e.g. TCOFLUSH) the xmit buffer during DMA.
    */
@@ -366,46 +457,38 @@ void uart_recvchars_dma(FAR uart_dev_t *dev)
 void uart_recvchars_done(FAR uart_dev_t *dev)
 {
   FAR struct uart_dmaxfer_s *xfer = &dev->dmarx;
-  FAR struct uart_buffer_s *rxbuf = &dev->recv;
-  size_t nbytes = xfer->nbytes;
-#if defined(CONFIG_TTY_SIGINT) || defined(CONFIG_TTY_SIGTSTP) || \
-    defined(CONFIG_TTY_FORCE_PANIC)
-  int signo = 0;
-
-  /* Check if the SIGINT character is anywhere in the newly received DMA
-   * buffer.
-   */
 
-  if ((dev->tc_lflag & ISIG))
-    {
-      signo = uart_recvchars_signo(dev);
-    }
-#endif
+  uart_recvchars_commit(dev);
 
-  /* Move head for nbytes. */
+  /* The transfer is finished, reset the RX DMA descriptor. */
 
-  rxbuf->head  = (rxbuf->head + nbytes) % rxbuf->size;
   xfer->nbytes = 0;
+  xfer->ndone  = 0;
   xfer->length = xfer->nlength = 0;
+}
+#endif
 
-  /* If any bytes were added to the buffer, inform any waiters there is new
-   * incoming data available.
-   */
-
-  if (nbytes)
-    {
-      uart_datareceived(dev);
-    }
-
-#if defined(CONFIG_TTY_SIGINT) || defined(CONFIG_TTY_SIGTSTP)
-  /* Send the signal if necessary */
+/****************************************************************************
+ * Name: uart_recvchars_update
+ *
+ * Description:
+ *   Make the data received so far by a still running RX DMA transfer
+ *   available to readers.  The lower half calls this on a half transfer
+ *   interrupt, on the switch between the two regions of a double-buffered
+ *   transfer, or when the line goes idle, after updating dmarx.nbytes with
+ *   the total count of bytes received into the transfer.  Unlike
+ *   uart_recvchars_done(), the transfer stays armed and the lower half
+ *   must not restart it.
+ *
+ ****************************************************************************/
 
-  if (signo != 0)
+#ifdef CONFIG_SERIAL_RXDMA
+void uart_recvchars_update(FAR uart_dev_t *dev)
+{
+  if (dev->dmarx.nbytes > dev->dmarx.ndone)
     {
-      nxsig_kill(dev->pid, signo);
-      uart_reset_sem(dev);
+      uart_recvchars_commit(dev);
     }
-#endif
 }
 #endif
 
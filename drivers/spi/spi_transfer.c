@@ -25,10 +25,18 @@
 #include <nuttx/config.h>
 
 #include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/irq.h>
+#include <nuttx/clock.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/kthread.h>
+#include <nuttx/semaphore.h>
 #include <nuttx/signal.h>
 #include <nuttx/spi/spi.h>
 #include <nuttx/spi/spi_transfer.h>
@@ -36,54 +44,63 @@
 #ifdef CONFIG_SPI_EXCHANGE
 
 /****************************************************************************
- * Public Functions
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_SPI_QUEUE
+struct spi_queue_s
+{
+  FAR struct spi_dev_s *spi;      /* The SPI bus */
+  sq_queue_t pending;             /* Requests waiting to be performed */
+  sem_t wakeup;                   /* Wakes up the queue thread */
+  sem_t exited;                   /* Posted when the queue thread exits */
+  volatile bool stop;             /* Asks the queue thread to exit */
+  struct spi_queue_stats_s stats; /* Statistics of the queue */
+  uint64_t reset;                 /* Time of the last statistics reset */
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
  ****************************************************************************/
 
 /****************************************************************************
- * Name: spi_transfer
+ * Name: spi_sequence
  *
  * Description:
- *   This is a helper function that can be used to encapsulate and manage
- *   a sequence of SPI transfers.  The SPI bus will be locked and the
- *   SPI device selected for the duration of the transfers.
- *
- * Input Parameters:
- *   spi - An instance of the SPI device to use for the transfer
- *   seq - Describes the sequence of transfers.
- *
- * Returned Value:
- *   Zero (OK) on success; a negated errno value on failure.
+ *   Perform a sequence of transfers on an SPI bus that the caller has
+ *   locked.  The fixed attributes of the sequence are only established if
+ *   'configure' is true.
  *
  ****************************************************************************/
 
-int spi_transfer(FAR struct spi_dev_s *spi, FAR struct spi_sequence_s *seq)
+static int spi_sequence(FAR struct spi_dev_s *spi,
+                        FAR struct spi_sequence_s *seq, bool configure)
 {
   FAR struct spi_trans_s *trans;
   int ret = OK;
   int i;
 
-  DEBUGASSERT(spi != NULL && seq != NULL && seq->trans != NULL);
-
-  /* Get exclusive access to the SPI bus */
-
-  SPI_LOCK(spi, true);
-
-  /* Establish the fixed SPI attributes for all transfers in the sequence */
+  if (configure)
+    {
+      /* Establish the fixed SPI attributes for all transfers in the
+       * sequence
+       */
 
-  SPI_SETFREQUENCY(spi, seq->frequency);
+      SPI_SETFREQUENCY(spi, seq->frequency);
 
 #ifdef CONFIG_SPI_DELAY_CONTROL
-  ret = SPI_SETDELAY(spi, seq->a, seq->b, seq->c, seq->i);
-  if (ret < 0)
-    {
-      spierr("ERROR: SPI_SETDELAY failed: %d\n", ret);
-      SPI_LOCK(spi, false);
-      return ret;
-    }
+      ret = SPI_SETDELAY(spi, seq->a, seq->b, seq->c, seq->i);
+      if (ret < 0)
+        {
+          spierr("ERROR: SPI_SETDELAY failed: %d\n", ret);
+          return ret;
+        }
 #endif
 
-  SPI_SETMODE(spi, seq->mode);
-  SPI_SETBITS(spi, seq->nbits);
+      SPI_SETMODE(spi, seq->mode);
+      SPI_SETBITS(spi, seq->nbits);
+    }
 
   /* Select the SPI device in preparation for the transfer.
    * REVISIT: This is redundant.
@@ -139,8 +156,386 @@ int spi_transfer(FAR struct spi_dev_s *spi, FAR struct spi_sequence_s *seq)
     }
 
   SPI_SELECT(spi, seq->dev, false);
+  return ret;
+}
+
+#ifdef CONFIG_SPI_QUEUE
+/****************************************************************************
+ * Name: spi_queue_now
+ *
+ * Description:
+ *   Return the system time in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t spi_queue_now(void)
+{
+  struct timespec ts;
+
+  clock_systime_timespec(&ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/****************************************************************************
+ * Name: spi_queue_sameconfig
+ *
+ * Description:
+ *   Return true if two sequences share the fixed SPI attributes.
+ *
+ ****************************************************************************/
+
+static bool spi_queue_sameconfig(FAR const struct spi_sequence_s *seq1,
+                                 FAR const struct spi_sequence_s *seq2)
+{
+  return seq1->frequency == seq2->frequency &&
+#ifdef CONFIG_SPI_DELAY_CONTROL
+         seq1->a == seq2->a && seq1->b == seq2->b &&
+         seq1->c == seq2->c && seq1->i == seq2->i &&
+#endif
+         seq1->mode == seq2->mode && seq1->nbits == seq2->nbits;
+}
+
+/****************************************************************************
+ * Name: spi_queue_batch
+ *
+ * Description:
+ *   Lock the bus once and perform the requests that are queued, up to
+ *   CONFIG_SPI_QUEUE_MAXBATCH of them.  The callbacks are called after the
+ *   bus has been unlocked so that they may use the bus or submit new
+ *   requests.
+ *
+ ****************************************************************************/
+
+static void spi_queue_batch(FAR struct spi_queue_s *queue)
+{
+  FAR struct spi_sequence_s *prev = NULL;
+  FAR struct spi_request_s *req;
+  uint32_t maxlatency = 0;
+  uint64_t latency = 0;
+  uint64_t start;
+  uint64_t now;
+  sq_queue_t done;
+  irqstate_t flags;
+  uint32_t n;
+
+  sq_init(&done);
+
+  SPI_LOCK(queue->spi, true);
+  start = spi_queue_now();
+  now   = start;
+
+  for (n = 0; n < CONFIG_SPI_QUEUE_MAXBATCH; n++)
+    {
+      flags = enter_critical_section();
+      req = (FAR struct spi_request_s *)sq_remfirst(&queue->pending);
+      leave_critical_section(flags);
+
+      if (req == NULL)
+        {
+          break;
+        }
+
+      if (now - req->submitted > maxlatency)
+        {
+          maxlatency = now - req->submitted;
+        }
+
+      latency += now - req->submitted;
+
+      /* Back-to-back sequences with the same attributes skip the
+       * reconfiguration of the bus.
+       */
+
+      req->result = spi_sequence(queue->spi, req->seq, prev == NULL ||
+                                 !spi_queue_sameconfig(prev, req->seq));
+      prev = req->result < 0 ? NULL : req->seq;
+
+      sq_addlast(&req->node, &done);
+      now = spi_queue_now();
+    }
+
+  SPI_LOCK(queue->spi, false);
+
+  flags = enter_critical_section();
+  queue->stats.nrequests += n;
+  queue->stats.nbatches++;
+  queue->stats.latency += latency;
+  queue->stats.busy += now - start;
+
+  if (n > queue->stats.maxbatch)
+    {
+      queue->stats.maxbatch = n;
+    }
+
+  if (maxlatency > queue->stats.maxlatency)
+    {
+      queue->stats.maxlatency = maxlatency;
+    }
+
+  leave_critical_section(flags);
+
+  while ((req = (FAR struct spi_request_s *)sq_remfirst(&done)) != NULL)
+    {
+      req->callback(req, req->result);
+    }
+}
+
+/****************************************************************************
+ * Name: spi_queue_thread
+ *
+ * Description:
+ *   The thread that performs the requests of a queue.
+ *
+ ****************************************************************************/
+
+static int spi_queue_thread(int argc, FAR char *argv[])
+{
+  FAR struct spi_queue_s *queue;
+  FAR struct spi_request_s *req;
+  irqstate_t flags;
+
+  queue = (FAR struct spi_queue_s *)((uintptr_t)strtoul(argv[1], NULL, 0));
+
+  while (!queue->stop)
+    {
+      nxsem_wait_uninterruptible(&queue->wakeup);
+
+      while (!queue->stop && !sq_empty(&queue->pending))
+        {
+          spi_queue_batch(queue);
+        }
+    }
+
+  /* Cancel the requests that are left */
+
+  do
+    {
+      flags = enter_critical_section();
+      req = (FAR struct spi_request_s *)sq_remfirst(&queue->pending);
+      leave_critical_section(flags);
+
+      if (req != NULL)
+        {
+          req->callback(req, -ECANCELED);
+        }
+    }
+  while (req != NULL);
+
+  nxsem_post(&queue->exited);
+  return OK;
+}
+#endif /* CONFIG_SPI_QUEUE */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spi_transfer
+ *
+ * Description:
+ *   This is a helper function that can be used to encapsulate and manage
+ *   a sequence of SPI transfers.  The SPI bus will be locked and the
+ *   SPI device selected for the duration of the transfers.
+ *
+ * Input Parameters:
+ *   spi - An instance of the SPI device to use for the transfer
+ *   seq - Describes the sequence of transfers.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int spi_transfer(FAR struct spi_dev_s *spi, FAR struct spi_sequence_s *seq)
+{
+  int ret;
+
+  DEBUGASSERT(spi != NULL && seq != NULL && seq->trans != NULL);
+
+  /* Get exclusive access to the SPI bus */
+
+  SPI_LOCK(spi, true);
+  ret = spi_sequence(spi, seq, true);
   SPI_LOCK(spi, false);
   return ret;
 }
 
+#ifdef CONFIG_SPI_QUEUE
+/****************************************************************************
+ * Name: spi_queue_create
+ *
+ * Description:
+ *   Create a queue of asynchronous requests for an SPI bus.
+ *
+ * Input Parameters:
+ *   spi - An instance of the SPI device to use for the transfers
+ *
+ * Returned Value:
+ *   The new queue on success; NULL on failure.
+ *
+ ****************************************************************************/
+
+FAR struct spi_queue_s *spi_queue_create(FAR struct spi_dev_s *spi)
+{
+  FAR struct spi_queue_s *queue;
+  FAR char *argv[2];
+  char arg1[32];
+  int ret;
+
+  DEBUGASSERT(spi != NULL);
+
+  queue = kmm_zalloc(sizeof(struct spi_queue_s));
+  if (queue == NULL)
+    {
+      return NULL;
+    }
+
+  queue->spi   = spi;
+  queue->reset = spi_queue_now();
+  sq_init(&queue->pending);
+
+  nxsem_init(&queue->wakeup, 0, 0);
+  nxsem_init(&queue->exited, 0, 0);
+  nxsem_set_protocol(&queue->wakeup, SEM_PRIO_NONE);
+  nxsem_set_protocol(&queue->exited, SEM_PRIO_NONE);
+
+  snprintf(arg1, sizeof(arg1), "%p", queue);
+  argv[0] = arg1;
+  argv[1] = NULL;
+
+  ret = kthread_create("spiq", CONFIG_SPI_QUEUE_PRIORITY,
+                       CONFIG_SPI_QUEUE_STACKSIZE, spi_queue_thread, argv);
+  if (ret < 0)
+    {
+      spierr("ERROR: Failed to start the queue thread: %d\n", ret);
+      nxsem_destroy(&queue->wakeup);
+      nxsem_destroy(&queue->exited);
+      kmm_free(queue);
+      return NULL;
+    }
+
+  return queue;
+}
+
+/****************************************************************************
+ * Name: spi_queue_destroy
+ *
+ * Description:
+ *   Stop the queue thread and free the queue.  This must not be called from
+ *   a request callback.
+ *
+ ****************************************************************************/
+
+void spi_queue_destroy(FAR struct spi_queue_s *queue)
+{
+  DEBUGASSERT(queue != NULL);
+
+  queue->stop = true;
+  nxsem_post(&queue->wakeup);
+  nxsem_wait_uninterruptible(&queue->exited);
+
+  nxsem_destroy(&queue->wakeup);
+  nxsem_destroy(&queue->exited);
+  kmm_free(queue);
+}
+
+/****************************************************************************
+ * Name: spi_queue_submit
+ *
+ * Description:
+ *   Add a request to the end of the queue.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int spi_queue_submit(FAR struct spi_queue_s *queue,
+                     FAR struct spi_request_s *req)
+{
+  irqstate_t flags;
+
+  DEBUGASSERT(queue != NULL && req != NULL && req->seq != NULL &&
+              req->seq->trans != NULL && req->callback != NULL);
+
+  if (queue->stop)
+    {
+      return -ESHUTDOWN;
+    }
+
+  req->submitted = spi_queue_now();
+
+  flags = enter_critical_section();
+  sq_addlast(&req->node, &queue->pending);
+  leave_critical_section(flags);
+
+  return nxsem_post(&queue->wakeup);
+}
+
+/****************************************************************************
+ * Name: spi_queue_cancel
+ *
+ * Description:
+ *   Remove a request that has not been started from the queue.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOENT if the request is not queued.
+ *
+ ****************************************************************************/
+
+int spi_queue_cancel(FAR struct spi_queue_s *queue,
+                     FAR struct spi_request_s *req)
+{
+  FAR sq_entry_t *node;
+  irqstate_t flags;
+  int ret = -ENOENT;
+
+  DEBUGASSERT(queue != NULL && req != NULL);
+
+  flags = enter_critical_section();
+  for (node = sq_peek(&queue->pending); node != NULL; node = sq_next(node))
+    {
+      if (node == &req->node)
+        {
+          sq_rem(node, &queue->pending);
+          ret = OK;
+          break;
+        }
+    }
+
+  leave_critical_section(flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: spi_queue_stats
+ *
+ * Description:
+ *   Return the statistics of the queue and optionally reset them.
+ *
+ ****************************************************************************/
+
+void spi_queue_stats(FAR struct spi_queue_s *queue,
+                     FAR struct spi_queue_stats_s *stats, bool reset)
+{
+  uint64_t now = spi_queue_now();
+  irqstate_t flags;
+
+  DEBUGASSERT(queue != NULL && stats != NULL);
+
+  flags = enter_critical_section();
+  *stats = queue->stats;
+  stats->elapsed = now - queue->reset;
+
+  if (reset)
+    {
+      memset(&queue->stats, 0, sizeof(queue->stats));
+      queue->reset = now;
+    }
+
+  leave_critical_section(flags);
+}
+#endif /* CONFIG_SPI_QUEUE */
+
 #endif /* CONFIG_SPI_EXCHANGE */
@@ -49,6 +49,8 @@
 
 #include <nuttx/irq.h>
 
+#include "syslog.h"
+
 #ifdef CONFIG_RAMLOG
 
 /****************************************************************************
@@ -347,6 +349,94 @@ again:
   return OK;
 }
 
+/****************************************************************************
+ * Name: ramlog_copybuf
+ *
+ * Description:
+ *   Add a buffer to the circular buffer with at most two memcpy() calls
+ *   in one critical section, instead of one critical section per byte.
+ *   Not usable with CONFIG_RAMLOG_CRLF which must inspect each byte.
+ *
+ * Returned Value:
+ *   The number of bytes added.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_RAMLOG_CRLF
+static size_t ramlog_copybuf(FAR struct ramlog_dev_s *priv,
+                             FAR const char *buffer, size_t len)
+{
+  irqstate_t flags;
+  size_t nwritten = 0;
+  size_t head;
+  size_t tail;
+  size_t n;
+
+#ifdef CONFIG_RAMLOG_SYSLOG
+  if (priv == &g_sysdev)
+    {
+      ramlog_initbuf();
+    }
+#endif
+
+  flags = enter_critical_section();
+
+  while (nwritten < len)
+    {
+      head = priv->rl_head;
+      tail = priv->rl_tail;
+
+      /* Determine the contiguous free space at the head.  One byte always
+       * stays free to tell a full buffer from an empty one.
+       */
+
+      if (head >= tail)
+        {
+          n = priv->rl_bufsize - head - (tail == 0 ? 1 : 0);
+        }
+      else
+        {
+          n = tail - head - 1;
+        }
+
+      if (n == 0)
+        {
+#ifdef CONFIG_RAMLOG_OVERWRITE
+          /* Discard the oldest bytes to make room for the latest log */
+
+          n = tail > head ? priv->rl_bufsize - tail : head - tail;
+          if (n > len - nwritten)
+            {
+              n = len - nwritten;
+            }
+
+          memset(&priv->rl_buffer[tail], 0, n);
+          tail += n;
+          priv->rl_tail = tail >= priv->rl_bufsize ? 0 : tail;
+          continue;
+#else
+          /* The buffer is full.  The rest is dropped on the floor. */
+
+          break;
+#endif
+        }
+
+      if (n > len - nwritten)
+        {
+          n = len - nwritten;
+        }
+
+      memcpy(&priv->rl_buffer[head], &buffer[nwritten], n);
+      head += n;
+      priv->rl_head = head >= priv->rl_bufsize ? 0 : head;
+      nwritten += n;
+    }
+
+  leave_critical_section(flags);
+  return nwritten;
+}
+#endif
+
 /****************************************************************************
  * Name: ramlog_addbuf
  ****************************************************************************/
@@ -356,7 +446,9 @@ static ssize_t ramlog_addbuf(FAR struct ramlog_dev_s *priv,
 {
   int readers_waken;
   ssize_t nwritten;
+#ifdef CONFIG_RAMLOG_CRLF
   char ch;
+#endif
   int ret;
 
   ret = nxsem_wait(&priv->rl_exclsem);
@@ -365,6 +457,7 @@ static ssize_t ramlog_addbuf(FAR struct ramlog_dev_s *priv,
       return ret;
     }
 
+#ifdef CONFIG_RAMLOG_CRLF
   for (nwritten = 0; (size_t)nwritten < len; nwritten++)
     {
       /* Get the next character to output */
@@ -383,6 +476,9 @@ static ssize_t ramlog_addbuf(FAR struct ramlog_dev_s *priv,
           break;
         }
     }
+#else
+  nwritten = ramlog_copybuf(priv, buffer, len);
+#endif
 
   /* Was anything written? */
 
@@ -448,6 +544,12 @@ static ssize_t ramlog_file_read(FAR struct file *filep, FAR char *buffer,
 
   DEBUGASSERT(!up_interrupt_context());
 
+#ifdef CONFIG_SYSLOG_BINARY
+  /* Format the deferred SYSLOG messages so that the reader gets them */
+
+  syslog_binary_flush(false);
+#endif
+
   /* Get exclusive access to the rl_tail index */
 
   ret = nxsem_wait(&priv->rl_exclsem);
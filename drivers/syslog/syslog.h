@@ -27,7 +27,10 @@
 
 #include <nuttx/config.h>
 
+#include <sys/types.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <time.h>
 
 /****************************************************************************
  * Public Data
@@ -51,6 +54,12 @@ struct syslog_channel_s; /* Forward reference */
 EXTERN FAR struct syslog_channel_s *g_syslog_channel
                                                 [CONFIG_SYSLOG_MAX_CHANNELS];
 
+/* This is set by syslog_flush() when the crash-handling logic runs.  The
+ * channels must then write the remaining output without taking any locks.
+ */
+
+EXTERN volatile bool g_syslog_panic;
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -102,6 +111,23 @@ FAR struct syslog_channel_s *syslog_dev_initialize(FAR const char *devpath,
 
 void syslog_dev_uninitialize(FAR struct syslog_channel_s *channel);
 
+/****************************************************************************
+ * Name: syslog_dev_rotate
+ *
+ * Description:
+ *   Rotate the log file 'log_file' if it is larger than
+ *   CONFIG_SYSLOG_FILE_SIZE_LIMIT:  The file becomes 'log_file'.0, the
+ *   older backups are renamed accordingly and the oldest one is lost.
+ *
+ * Input Parameters:
+ *   log_file - The full path to the log file.  It must not be open.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_SYSLOG_FILE) && CONFIG_SYSLOG_FILE_ROTATIONS > 0
+void syslog_dev_rotate(FAR const char *log_file);
+#endif
+
 /****************************************************************************
  * Name: syslog_dev_channel
  *
@@ -278,6 +304,122 @@ ssize_t syslog_write(FAR const char *buffer, size_t buflen);
 
 int syslog_force(int ch);
 
+/****************************************************************************
+ * Name: syslog_gettime
+ *
+ * Description:
+ *   Get the time stamp of a new SYSLOG message.  Zero is returned early in
+ *   the start-up sequence when the hardware timer may not yet be available.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+void syslog_gettime(FAR struct timespec *ts);
+#endif
+
+/****************************************************************************
+ * Name: syslog_header
+ *
+ * Description:
+ *   Output the configured prefix of a SYSLOG message:  The time stamp, the
+ *   CPU, the process ID, the priority and the process name.
+ *
+ * Input Parameters:
+ *   stream   - The stream to receive the prefix
+ *   priority - The priority of the message
+ *   ts       - The time stamp from syslog_gettime()
+ *   pid      - The process that generated the message
+ *   cpu      - The CPU that generated the message
+ *
+ * Returned Value:
+ *   The number of characters output.
+ *
+ ****************************************************************************/
+
+struct lib_outstream_s; /* Forward reference */
+int syslog_header(FAR struct lib_outstream_s *stream, int priority,
+                  FAR const struct timespec *ts, pid_t pid, int cpu);
+
+/****************************************************************************
+ * Name: syslog_trailer
+ *
+ * Description:
+ *   Output the configured suffix of a SYSLOG message.
+ *
+ * Returned Value:
+ *   The number of characters output.
+ *
+ ****************************************************************************/
+
+int syslog_trailer(FAR struct lib_outstream_s *stream);
+
+/****************************************************************************
+ * Name: syslog_binary_add
+ *
+ * Description:
+ *   Record a SYSLOG message in the ring of the current CPU for deferred
+ *   formatting.  Only the format pointer and the arguments are saved.  The
+ *   message is dropped, not waited for, if the ring is full.
+ *
+ * Input Parameters:
+ *   priority - The priority of the message
+ *   fmt      - The format string.  It must remain valid until the message
+ *              has been formatted.  Formats in a heap or on the stack of
+ *              the caller are not recorded.
+ *   ap       - The arguments of the format
+ *
+ * Returned Value:
+ *   The size of the record if the message was recorded, -ENOSPC if it was
+ *   dropped and -ENOTSUP if it must be formatted by the caller (i.e., the
+ *   format uses conversions that cannot be deferred or the record would be
+ *   too big).  'ap' is only left untouched for -ENOTSUP.
+ *
+ * Assumptions:
+ *   May be called from any context, including interrupt handlers.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_BINARY
+int syslog_binary_add(int priority, FAR const IPTR char *fmt,
+                      FAR va_list *ap);
+#endif
+
+/****************************************************************************
+ * Name: syslog_binary_flush
+ *
+ * Description:
+ *   Format all recorded messages to the SYSLOG channels, oldest first.
+ *
+ * Input Parameters:
+ *   force - Called from crash-handling logic with interrupts disabled.  The
+ *           messages are formatted without waiting for the consumer lock.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success.  A negated errno value is returned
+ *   on any failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_BINARY
+int syslog_binary_flush(bool force);
+#endif
+
+/****************************************************************************
+ * Name: syslog_binary_initialize
+ *
+ * Description:
+ *   Start the thread that periodically formats the recorded messages.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success.  A negated errno value is returned
+ *   on any failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSLOG_BINARY
+int syslog_binary_initialize(void);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -0,0 +1,966 @@
+/****************************************************************************
+ * drivers/syslog/syslog_binary.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/irq.h>
+#include <nuttx/clock.h>
+#include <nuttx/kthread.h>
+#include <nuttx/sched.h>
+#include <nuttx/mm/mm.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/streams.h>
+
+#include "syslog.h"
+
+#ifdef CONFIG_SYSLOG_BINARY
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+#  define SYSLOG_BINARY_NCPUS   CONFIG_SMP_NCPUS
+#else
+#  define SYSLOG_BINARY_NCPUS   1
+#endif
+
+#define SYSLOG_BINARY_MASK      (CONFIG_SYSLOG_BINARY_BUFSIZE - 1)
+
+#if (CONFIG_SYSLOG_BINARY_BUFSIZE & SYSLOG_BINARY_MASK) != 0
+#  error CONFIG_SYSLOG_BINARY_BUFSIZE must be a power of two
+#endif
+
+#if CONFIG_SYSLOG_BINARY_RECSIZE > CONFIG_SYSLOG_BINARY_BUFSIZE / 2
+#  error CONFIG_SYSLOG_BINARY_RECSIZE is too big for the ring
+#endif
+
+/* Records are aligned so that their header can be accessed in place */
+
+#define SYSLOG_BINARY_ALIGN(n) \
+  (((n) + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1))
+
+/* The longest conversion specification that is deferred and the size of
+ * the buffer to rebuild it with the '*' fields expanded.
+ */
+
+#define SYSLOG_BINARY_MAXSPEC   16
+#define SYSLOG_BINARY_SPECBUF   (SYSLOG_BINARY_MAXSPEC + 24)
+
+#ifndef SP_DMB
+#  define SP_DMB()
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The type of the argument of one conversion */
+
+enum syslog_bintype_e
+{
+  SYSLOG_BIN_NONE = 0,        /* No argument, i.e. "%%" */
+  SYSLOG_BIN_INT,             /* int and all smaller types */
+  SYSLOG_BIN_LONG,            /* long */
+  SYSLOG_BIN_LLONG,           /* long long */
+  SYSLOG_BIN_DOUBLE,          /* double */
+  SYSLOG_BIN_PTR,             /* void * */
+  SYSLOG_BIN_STR,             /* String, copied into the record */
+  SYSLOG_BIN_UNSUPP           /* Cannot be deferred */
+};
+
+/* The header of one recorded message.  It is followed by the arguments:
+ * The values of the '*' fields and of each conversion in the order of the
+ * format, unaligned.  Strings are copied with their NUL terminator.
+ */
+
+struct syslog_binrec_s
+{
+  FAR const IPTR char *fmt;   /* The format or NULL for padding */
+  struct timespec ts;         /* Time stamp of the message */
+  uint32_t size;              /* Size of the record, aligned */
+  pid_t pid;                  /* The process that generated the message */
+  uint8_t priority;           /* The priority of the message */
+  uint8_t cpu;                /* The CPU that generated the message */
+};
+
+/* The ring of one CPU.  The producers of a CPU are serialized by disabling
+ * the local interrupts, so each ring has a single producer and a single
+ * consumer and needs no lock.  'head' and 'tail' run freely and are masked
+ * to index the buffer.
+ */
+
+struct syslog_binring_s
+{
+  volatile uint32_t head;     /* Written by the producers */
+  volatile uint32_t tail;     /* Written by the consumer */
+  volatile uint32_t dropped;  /* Messages dropped by the producers */
+  uint32_t reported;          /* Drops reported by the consumer */
+  uintptr_t buffer[CONFIG_SYSLOG_BINARY_BUFSIZE / sizeof(uintptr_t)];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct syslog_binring_s g_syslog_binring[SYSLOG_BINARY_NCPUS];
+
+/* Serializes the consumers */
+
+static sem_t g_syslog_binlock = SEM_INITIALIZER(1);
+
+/* Wakes up the consumer thread when a ring is half full */
+
+static sem_t g_syslog_binwait = SEM_INITIALIZER(0);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_binary_spec
+ *
+ * Description:
+ *   Parse one conversion specification.  'pfmt' points just after the '%'
+ *   and is advanced past the conversion character.  The producer and the
+ *   consumer must walk the format identically, so both use this function.
+ *
+ * Returned Value:
+ *   The type of the argument.  'nstars' receives the number of '*' fields
+ *   which each take one additional int argument.
+ *
+ ****************************************************************************/
+
+static enum syslog_bintype_e syslog_binary_spec(FAR const char **pfmt,
+                                                FAR int *nstars)
+{
+  FAR const char *fmt = *pfmt;
+  enum syslog_bintype_e type;
+  enum syslog_bintype_e intype = SYSLOG_BIN_INT;
+  int ch;
+
+  *nstars = 0;
+
+  /* Flags */
+
+  while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' ||
+         *fmt == '0' || *fmt == '\'')
+    {
+      fmt++;
+    }
+
+  /* Width */
+
+  if (*fmt == '*')
+    {
+      (*nstars)++;
+      fmt++;
+    }
+  else
+    {
+      while (*fmt >= '0' && *fmt <= '9')
+        {
+          fmt++;
+        }
+
+      /* Numbered arguments need the whole va_list */
+
+      if (*fmt == '$')
+        {
+          return SYSLOG_BIN_UNSUPP;
+        }
+    }
+
+  /* Precision */
+
+  if (*fmt == '.')
+    {
+      fmt++;
+      if (*fmt == '*')
+        {
+          (*nstars)++;
+          fmt++;
+        }
+      else
+        {
+          while (*fmt >= '0' && *fmt <= '9')
+            {
+              fmt++;
+            }
+        }
+    }
+
+  /* Length modifiers.  Short types are promoted to int.  The other types
+   * are saved as the standard type of the same size.
+   */
+
+  for (; ; fmt++)
+    {
+      if (*fmt == 'h')
+        {
+          intype = SYSLOG_BIN_INT;
+        }
+      else if (*fmt == 'l')
+        {
+          intype = intype == SYSLOG_BIN_LONG ?
+                   SYSLOG_BIN_LLONG : SYSLOG_BIN_LONG;
+        }
+      else if (*fmt == 'j')
+        {
+          intype = sizeof(intmax_t) == sizeof(long) ?
+                   SYSLOG_BIN_LONG : SYSLOG_BIN_LLONG;
+        }
+      else if (*fmt == 'z' || *fmt == 't')
+        {
+          intype = sizeof(size_t) == sizeof(int) ? SYSLOG_BIN_INT :
+                   sizeof(size_t) == sizeof(long) ?
+                   SYSLOG_BIN_LONG : SYSLOG_BIN_LLONG;
+        }
+      else
+        {
+          break;
+        }
+    }
+
+  ch = *fmt;
+  if (ch == '\0' || fmt - *pfmt >= SYSLOG_BINARY_MAXSPEC)
+    {
+      return SYSLOG_BIN_UNSUPP;
+    }
+
+  fmt++;
+
+  switch (ch)
+    {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        type = intype;
+        break;
+
+      case 'c':
+        type = SYSLOG_BIN_INT;
+        break;
+
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+        type = SYSLOG_BIN_DOUBLE;
+        break;
+
+      case 'p':
+
+        /* %pV formats a nested va_list */
+
+        type = *fmt == 'V' ? SYSLOG_BIN_UNSUPP : SYSLOG_BIN_PTR;
+        break;
+
+      case 's':
+        type = SYSLOG_BIN_STR;
+        break;
+
+      case '%':
+        type = SYSLOG_BIN_NONE;
+        break;
+
+      default:
+        type = SYSLOG_BIN_UNSUPP;
+        break;
+    }
+
+  *pfmt = fmt;
+  return type;
+}
+
+/****************************************************************************
+ * Name: syslog_binary_transient
+ *
+ * Description:
+ *   Return true if 'addr' is in a heap or on the stack of the caller, where
+ *   a format string may be gone by the time the message is formatted.
+ *   Anything else is assumed to be a string literal or other static data.
+ *
+ ****************************************************************************/
+
+static bool syslog_binary_transient(FAR const void *addr)
+{
+  FAR struct tcb_s *rtcb = nxsched_self();
+  uintptr_t start;
+  uintptr_t end;
+
+  if (umm_heapmember((FAR void *)addr))
+    {
+      return true;
+    }
+
+#ifdef CONFIG_MM_KERNEL_HEAP
+  if (kmm_heapmember((FAR void *)addr))
+    {
+      return true;
+    }
+#endif
+
+  /* In an interrupt handler this is the stack of the interrupted thread */
+
+  if (rtcb != NULL && rtcb->stack_alloc_ptr != NULL)
+    {
+      start = (uintptr_t)rtcb->stack_alloc_ptr;
+      end   = (uintptr_t)rtcb->stack_base_ptr + rtcb->adj_stack_size;
+      if ((uintptr_t)addr >= start && (uintptr_t)addr < end)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: syslog_binary_argsize
+ ****************************************************************************/
+
+static size_t syslog_binary_argsize(enum syslog_bintype_e type)
+{
+  switch (type)
+    {
+      case SYSLOG_BIN_INT:
+        return sizeof(int);
+
+      case SYSLOG_BIN_LONG:
+        return sizeof(long);
+
+      case SYSLOG_BIN_LLONG:
+        return sizeof(long long);
+
+      case SYSLOG_BIN_DOUBLE:
+        return sizeof(double);
+
+      case SYSLOG_BIN_PTR:
+        return sizeof(FAR void *);
+
+      case SYSLOG_BIN_STR:
+        return 1;
+
+      default:
+        return 0;
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_binary_peek
+ *
+ * Description:
+ *   Return the oldest record of the ring, skipping any padding, or NULL if
+ *   the ring is empty.
+ *
+ ****************************************************************************/
+
+static FAR struct syslog_binrec_s *
+syslog_binary_peek(FAR struct syslog_binring_s *ring)
+{
+  FAR struct syslog_binrec_s *rec;
+  uint32_t offset;
+  uint32_t tail;
+
+  for (; ; )
+    {
+      tail = ring->tail;
+      if (ring->head == tail)
+        {
+          return NULL;
+        }
+
+      /* The record must be read after its publication */
+
+      SP_DMB();
+
+      offset = tail & SYSLOG_BINARY_MASK;
+      if (CONFIG_SYSLOG_BINARY_BUFSIZE - offset <
+          sizeof(struct syslog_binrec_s))
+        {
+          ring->tail = tail + CONFIG_SYSLOG_BINARY_BUFSIZE - offset;
+          continue;
+        }
+
+      rec = (FAR struct syslog_binrec_s *)
+              ((FAR uint8_t *)ring->buffer + offset);
+      if (rec->fmt == NULL)
+        {
+          ring->tail = tail + rec->size;
+          continue;
+        }
+
+      return rec;
+    }
+}
+
+/****************************************************************************
+ * Name: syslog_binary_format
+ *
+ * Description:
+ *   Format one record as nx_vsyslog() would have done.
+ *
+ ****************************************************************************/
+
+static void syslog_binary_format(FAR struct lib_outstream_s *stream,
+                                 FAR struct syslog_binrec_s *rec)
+{
+  FAR const uint8_t *arg = (FAR const uint8_t *)(rec + 1);
+  FAR const char *fmt = rec->fmt;
+  FAR const char *spec;
+  enum syslog_bintype_e type;
+  char buf[SYSLOG_BINARY_SPECBUF];
+  size_t len;
+  int nstars;
+  int value;
+
+  syslog_header(stream, rec->priority, &rec->ts, rec->pid, rec->cpu);
+
+  while (*fmt != '\0')
+    {
+      if (*fmt != '%')
+        {
+          stream->put(stream, *fmt++);
+          continue;
+        }
+
+      spec = fmt++;
+      type = syslog_binary_spec(&fmt, &nstars);
+
+      /* Rebuild the conversion with the '*' fields replaced by their
+       * recorded values.
+       */
+
+      for (len = 0; spec < fmt; spec++)
+        {
+          if (*spec != '*')
+            {
+              buf[len++] = *spec;
+              continue;
+            }
+
+          memcpy(&value, arg, sizeof(int));
+          arg += sizeof(int);
+
+          if (value < 0 && *(spec - 1) == '.')
+            {
+              /* A negative precision is taken as if it were omitted */
+
+              len--;
+            }
+          else
+            {
+              len += snprintf(&buf[len], sizeof(buf) - len, "%d", value);
+            }
+        }
+
+      buf[len] = '\0';
+
+      switch (type)
+        {
+          case SYSLOG_BIN_INT:
+            {
+              int val;
+
+              memcpy(&val, arg, sizeof(val));
+              lib_sprintf(stream, buf, val);
+            }
+            break;
+
+          case SYSLOG_BIN_LONG:
+            {
+              long val;
+
+              memcpy(&val, arg, sizeof(val));
+              lib_sprintf(stream, buf, val);
+            }
+            break;
+
+          case SYSLOG_BIN_LLONG:
+            {
+              long long val;
+
+              memcpy(&val, arg, sizeof(val));
+              lib_sprintf(stream, buf, val);
+            }
+            break;
+
+          case SYSLOG_BIN_DOUBLE:
+            {
+              double val;
+
+              memcpy(&val, arg, sizeof(val));
+              lib_sprintf(stream, buf, val);
+            }
+            break;
+
+          case SYSLOG_BIN_PTR:
+            {
+              FAR void *val;
+
+              memcpy(&val, arg, sizeof(val));
+              lib_sprintf(stream, buf, val);
+            }
+            break;
+
+          case SYSLOG_BIN_STR:
+            lib_sprintf(stream, buf, (FAR const char *)arg);
+            arg += strlen((FAR const char *)arg);
+            break;
+
+          default:
+            lib_sprintf(stream, buf);
+            break;
+        }
+
+      arg += syslog_binary_argsize(type);
+    }
+
+  syslog_trailer(stream);
+}
+
+/****************************************************************************
+ * Name: syslog_binary_thread
+ *
+ * Description:
+ *   Periodically format the recorded messages.
+ *
+ ****************************************************************************/
+
+static int syslog_binary_thread(int argc, FAR char *argv[])
+{
+  for (; ; )
+    {
+      nxsem_tickwait(&g_syslog_binwait, clock_systime_ticks(),
+                     MSEC2TICK(CONFIG_SYSLOG_BINARY_INTERVAL));
+      syslog_binary_flush(false);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: syslog_binary_add
+ *
+ * Description:
+ *   Record a SYSLOG message in the ring of the current CPU for deferred
+ *   formatting.  Only the format pointer and the arguments are saved.  The
+ *   message is dropped, not waited for, if the ring is full.
+ *
+ * Input Parameters:
+ *   priority - The priority of the message
+ *   fmt      - The format string.  It must remain valid until the message
+ *              has been formatted.
+ *   ap       - The arguments of the format
+ *
+ * Returned Value:
+ *   The size of the record if the message was recorded, -ENOSPC if it was
+ *   dropped and -ENOTSUP if it must be formatted by the caller (i.e., the
+ *   format uses conversions that cannot be deferred or the record would be
+ *   too big).  'ap' is only left untouched for -ENOTSUP.
+ *
+ * Assumptions:
+ *   May be called from any context, including interrupt handlers.
+ *
+ ****************************************************************************/
+
+int syslog_binary_add(int priority, FAR const IPTR char *fmt,
+                      FAR va_list *ap)
+{
+  union
+  {
+    struct syslog_binrec_s hdr;
+    uint8_t data[CONFIG_SYSLOG_BINARY_RECSIZE];
+  } rec;
+
+  FAR struct syslog_binring_s *ring;
+  FAR const char *ptr;
+  enum syslog_bintype_e type;
+  irqstate_t flags;
+  uint32_t offset;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t pad;
+  size_t reserve;
+  size_t off;
+  size_t len;
+  bool wake;
+  int nstars;
+  int cpu = 0;
+
+  /* First check that the message can be deferred.  This must not touch
+   * the arguments:  The caller formats them itself if it cannot.  Only the
+   * format is kept by reference; string arguments are copied.
+   */
+
+  if (syslog_binary_transient(fmt))
+    {
+      return -ENOTSUP;
+    }
+
+  reserve = sizeof(struct syslog_binrec_s);
+  for (ptr = fmt; *ptr != '\0'; )
+    {
+      if (*ptr++ == '%')
+        {
+          type = syslog_binary_spec(&ptr, &nstars);
+          if (type == SYSLOG_BIN_UNSUPP)
+            {
+              return -ENOTSUP;
+            }
+
+          reserve += nstars * sizeof(int) + syslog_binary_argsize(type);
+        }
+    }
+
+  if (reserve > sizeof(rec))
+    {
+      return -ENOTSUP;
+    }
+
+  /* Then save the arguments.  Strings get whatever space is left after
+   * the other arguments and are truncated if necessary.
+   */
+
+  reserve -= sizeof(struct syslog_binrec_s);
+  off      = sizeof(struct syslog_binrec_s);
+
+  for (ptr = fmt; *ptr != '\0'; )
+    {
+      if (*ptr++ != '%')
+        {
+          continue;
+        }
+
+      type = syslog_binary_spec(&ptr, &nstars);
+      for (; nstars > 0; nstars--)
+        {
+          int val = va_arg(*ap, int);
+
+          memcpy(&rec.data[off], &val, sizeof(val));
+          off     += sizeof(val);
+          reserve -= sizeof(val);
+        }
+
+      reserve -= syslog_binary_argsize(type);
+
+      switch (type)
+        {
+          case SYSLOG_BIN_INT:
+            {
+              int val = va_arg(*ap, int);
+
+              memcpy(&rec.data[off], &val, sizeof(val));
+              off += sizeof(val);
+            }
+            break;
+
+          case SYSLOG_BIN_LONG:
+            {
+              long val = va_arg(*ap, long);
+
+              memcpy(&rec.data[off], &val, sizeof(val));
+              off += sizeof(val);
+            }
+            break;
+
+          case SYSLOG_BIN_LLONG:
+            {
+              long long val = va_arg(*ap, long long);
+
+              memcpy(&rec.data[off], &val, sizeof(val));
+              off += sizeof(val);
+            }
+            break;
+
+          case SYSLOG_BIN_DOUBLE:
+            {
+              double val = va_arg(*ap, double);
+
+              memcpy(&rec.data[off], &val, sizeof(val));
+              off += sizeof(val);
+            }
+            break;
+
+          case SYSLOG_BIN_PTR:
+            {
+              FAR void *val = va_arg(*ap, FAR void *);
+
+              memcpy(&rec.data[off], &val, sizeof(val));
+              off += sizeof(val);
+            }
+            break;
+
+          case SYSLOG_BIN_STR:
+            {
+              FAR const char *str = va_arg(*ap, FAR const char *);
+
+              if (str == NULL)
+                {
+                  str = "(null)";
+                }
+
+              len = strnlen(str, sizeof(rec) - off - reserve - 1);
+              memcpy(&rec.data[off], str, len);
+              rec.data[off + len] = '\0';
+              off += len + 1;
+            }
+            break;
+
+          default:
+            break;
+        }
+    }
+
+  rec.hdr.fmt      = fmt;
+  rec.hdr.size     = SYSLOG_BINARY_ALIGN(off);
+  rec.hdr.pid      = getpid();
+  rec.hdr.priority = priority;
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  syslog_gettime(&rec.hdr.ts);
+#else
+  rec.hdr.ts.tv_sec  = 0;
+  rec.hdr.ts.tv_nsec = 0;
+#endif
+
+  /* Only the local interrupts are disabled while the record is copied.
+   * This keeps the thread on this CPU and serializes it with the interrupt
+   * handlers of the CPU, the only other producers of this ring.
+   */
+
+  flags = up_irq_save();
+
+#ifdef CONFIG_SMP
+  cpu = up_cpu_index();
+#endif
+
+  ring = &g_syslog_binring[cpu];
+  rec.hdr.cpu = cpu;
+
+  head = ring->head;
+  tail = ring->tail;
+
+  /* The consumer must be done with the space before it is reused */
+
+  SP_DMB();
+
+  /* A record never wraps.  Pad up to the end of the buffer if it does not
+   * fit there.
+   */
+
+  offset = head & SYSLOG_BINARY_MASK;
+  pad    = CONFIG_SYSLOG_BINARY_BUFSIZE - offset;
+  if (pad >= rec.hdr.size)
+    {
+      pad = 0;
+    }
+
+  if (CONFIG_SYSLOG_BINARY_BUFSIZE - (head - tail) < pad + rec.hdr.size)
+    {
+      ring->dropped++;
+      up_irq_restore(flags);
+      return -ENOSPC;
+    }
+
+  if (pad > 0)
+    {
+      if (pad >= sizeof(struct syslog_binrec_s))
+        {
+          FAR struct syslog_binrec_s *padrec =
+            (FAR struct syslog_binrec_s *)
+              ((FAR uint8_t *)ring->buffer + offset);
+
+          padrec->fmt  = NULL;
+          padrec->size = pad;
+        }
+
+      offset = 0;
+    }
+
+  memcpy((FAR uint8_t *)ring->buffer + offset, rec.data, off);
+
+  /* The record must be complete before it is published */
+
+  SP_DMB();
+  ring->head = head + pad + rec.hdr.size;
+
+  wake = head - tail <= CONFIG_SYSLOG_BINARY_BUFSIZE / 2 &&
+         ring->head - tail > CONFIG_SYSLOG_BINARY_BUFSIZE / 2;
+
+  up_irq_restore(flags);
+
+  if (wake)
+    {
+      nxsem_post(&g_syslog_binwait);
+    }
+
+  return rec.hdr.size;
+}
+
+/****************************************************************************
+ * Name: syslog_binary_flush
+ *
+ * Description:
+ *   Format all recorded messages to the SYSLOG channels, oldest first.
+ *
+ * Input Parameters:
+ *   force - Called from crash-handling logic with interrupts disabled.  The
+ *           messages are formatted without waiting for the consumer lock.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success.  A negated errno value is returned
+ *   on any failure.
+ *
+ ****************************************************************************/
+
+int syslog_binary_flush(bool force)
+{
+  struct lib_syslogstream_s stream;
+  FAR struct syslog_binring_s *ring;
+  FAR struct syslog_binrec_s *oldest;
+  FAR struct syslog_binrec_s *rec;
+  uint32_t dropped;
+  int ret;
+  int i;
+
+  if (!force)
+    {
+      ret = nxsem_wait(&g_syslog_binlock);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  /* Merge the messages of all CPUs in time stamp order */
+
+  for (; ; )
+    {
+      oldest = NULL;
+      ring   = NULL;
+
+      for (i = 0; i < SYSLOG_BINARY_NCPUS; i++)
+        {
+          rec = syslog_binary_peek(&g_syslog_binring[i]);
+          if (rec != NULL &&
+              (oldest == NULL || rec->ts.tv_sec < oldest->ts.tv_sec ||
+               (rec->ts.tv_sec == oldest->ts.tv_sec &&
+                rec->ts.tv_nsec < oldest->ts.tv_nsec)))
+            {
+              oldest = rec;
+              ring   = &g_syslog_binring[i];
+            }
+        }
+
+      if (oldest == NULL)
+        {
+          break;
+        }
+
+      syslogstream_create(&stream);
+      syslog_binary_format(&stream.public, oldest);
+      syslogstream_destroy(&stream);
+
+      /* The record must be read before its space is released */
+
+      SP_DMB();
+      ring->tail += oldest->size;
+    }
+
+  /* Then report the messages that were lost after these */
+
+  for (i = 0; i < SYSLOG_BINARY_NCPUS; i++)
+    {
+      ring    = &g_syslog_binring[i];
+      dropped = ring->dropped;
+      if (dropped != ring->reported)
+        {
+          syslogstream_create(&stream);
+          lib_sprintf(&stream.public, "[CPU%d] %" PRIu32
+                      " syslog messages dropped\n",
+                      i, dropped - ring->reported);
+          syslogstream_destroy(&stream);
+          ring->reported = dropped;
+        }
+    }
+
+  if (!force)
+    {
+      nxsem_post(&g_syslog_binlock);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: syslog_binary_initialize
+ *
+ * Description:
+ *   Start the thread that periodically formats the recorded messages.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success.  A negated errno value is returned
+ *   on any failure.
+ *
+ ****************************************************************************/
+
+int syslog_binary_initialize(void)
+{
+  int pid;
+
+  /* The wait semaphore is used for signaling and, hence, should not have
+   * priority inheritance enabled.
+   */
+
+  nxsem_set_protocol(&g_syslog_binwait, SEM_PRIO_NONE);
+
+  pid = kthread_create("syslog", CONFIG_SYSLOG_BINARY_PRIORITY,
+                       CONFIG_SYSLOG_BINARY_STACKSIZE,
+                       syslog_binary_thread, NULL);
+  return pid < 0 ? pid : OK;
+}
+
+#endif /* CONFIG_SYSLOG_BINARY */
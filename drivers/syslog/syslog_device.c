@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 
 #include <stdint.h>
 #include <stdio.h>
@@ -40,6 +41,7 @@
 #include <nuttx/fs/fs.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/syslog/syslog.h>
+#include <nuttx/wqueue.h>
 #include <nuttx/compiler.h>
 
 #include "syslog.h"
@@ -59,6 +61,25 @@
 
 #define NO_HOLDER     ((pid_t)-1)
 
+/* Output is combined in a buffer and written when the buffer is full,
+ * after CONFIG_SYSLOG_DEV_FLUSHDELAY milliseconds or on syslog_flush().
+ */
+
+#ifndef CONFIG_SYSLOG_DEV_BUFSIZE
+#  define CONFIG_SYSLOG_DEV_BUFSIZE 0
+#endif
+
+#if CONFIG_SYSLOG_DEV_BUFSIZE > 0 && defined(CONFIG_SCHED_WORKQUEUE) && \
+    CONFIG_SYSLOG_DEV_FLUSHDELAY > 0
+#  define HAVE_SYSLOG_DEV_WORK
+#endif
+
+/* Log files are rotated when they reach the size limit */
+
+#if defined(CONFIG_SYSLOG_FILE) && CONFIG_SYSLOG_FILE_ROTATIONS > 0
+#  define HAVE_SYSLOG_DEV_ROTATE
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -87,6 +108,16 @@ struct syslog_dev_s
   pid_t        sl_holder;   /* PID of the thread that holds the semaphore */
   struct file  sl_file;     /* The syslog file structure */
   FAR char    *sl_devpath;  /* Full path to the character device */
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+  off_t        sl_size;     /* Size of the log file or -1 if not a file */
+#endif
+#if CONFIG_SYSLOG_DEV_BUFSIZE > 0
+#ifdef HAVE_SYSLOG_DEV_WORK
+  struct work_s sl_work;    /* Flushes the buffer after a delay */
+#endif
+  size_t       sl_buflen;   /* Number of bytes in sl_buffer */
+  char         sl_buffer[CONFIG_SYSLOG_DEV_BUFSIZE];
+#endif
 };
 
 /****************************************************************************
@@ -180,6 +211,273 @@ static inline void syslog_dev_givesem(FAR struct syslog_dev_s *syslog_dev)
   nxsem_post(&syslog_dev->sl_sem);
 }
 
+/****************************************************************************
+ * Name: syslog_dev_panic
+ *
+ * Description:
+ *   Return true if the caller must not wait for sl_sem and must not touch
+ *   the file system beyond writing:  In the crash-handling logic, which
+ *   may run in an interrupt handler, in the IDLE thread or in the task
+ *   that crashed.
+ *
+ ****************************************************************************/
+
+static inline bool syslog_dev_panic(void)
+{
+  return g_syslog_panic || up_interrupt_context() || getpid() == 0;
+}
+
+/****************************************************************************
+ * Name: syslog_dev_filewrite
+ *
+ * Description:
+ *   Write all of the buffer to the device or file.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+static int syslog_dev_filewrite(FAR struct syslog_dev_s *syslog_dev,
+                                FAR const void *buffer, size_t buflen)
+{
+  FAR const uint8_t *ptr = buffer;
+  ssize_t nwritten;
+
+  while (buflen > 0)
+    {
+      nwritten = file_write(&syslog_dev->sl_file, ptr, buflen);
+      if (nwritten <= 0)
+        {
+          return nwritten < 0 ? (int)nwritten : -EIO;
+        }
+
+      ptr    += nwritten;
+      buflen -= nwritten;
+
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+      if (syslog_dev->sl_size >= 0)
+        {
+          syslog_dev->sl_size += nwritten;
+        }
+#endif
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: syslog_dev_checkrotate
+ *
+ * Description:
+ *   Rotate the log file if it has reached CONFIG_SYSLOG_FILE_SIZE_LIMIT
+ *   and start a new, empty one.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success.  A negated errno value is returned if
+ *   the new log file could not be opened; the device is marked as failed
+ *   then and syslog_dev_outputready() keeps trying to open it.
+ *
+ * Assumptions:
+ *   The caller holds sl_sem and the buffer is empty.
+ *
+ ****************************************************************************/
+
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+static int syslog_dev_checkrotate(FAR struct syslog_dev_s *syslog_dev)
+{
+  int ret;
+
+  /* Don't rename files in the crash-handling logic */
+
+  if (syslog_dev->sl_size < CONFIG_SYSLOG_FILE_SIZE_LIMIT ||
+      syslog_dev_panic())
+    {
+      return OK;
+    }
+
+  /* syslog_dev_rotate() must not rename the file while it is open.  Not
+   * every file system can rename an open file, so close it first.
+   */
+
+  file_close(&syslog_dev->sl_file);
+  syslog_dev_rotate(syslog_dev->sl_devpath);
+
+  syslog_dev->sl_size = 0;
+  ret = file_open(&syslog_dev->sl_file, syslog_dev->sl_devpath,
+                  syslog_dev->sl_oflags, syslog_dev->sl_mode);
+  if (ret < 0)
+    {
+      syslog_dev->sl_state = SYSLOG_FAILURE;
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: syslog_dev_drain
+ *
+ * Description:
+ *   Write the content of the write buffer to the device or file.
+ *
+ * Assumptions:
+ *   The caller holds sl_sem.
+ *
+ ****************************************************************************/
+
+static int syslog_dev_drain(FAR struct syslog_dev_s *syslog_dev)
+{
+  int ret = OK;
+
+#if CONFIG_SYSLOG_DEV_BUFSIZE > 0
+  if (syslog_dev->sl_buflen > 0)
+    {
+      ret = syslog_dev_filewrite(syslog_dev, syslog_dev->sl_buffer,
+                                 syslog_dev->sl_buflen);
+      syslog_dev->sl_buflen = 0;
+    }
+#endif
+
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+  if (ret >= 0)
+    {
+      ret = syslog_dev_checkrotate(syslog_dev);
+    }
+#endif
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: syslog_dev_sync
+ *
+ * Description:
+ *   Write the content of the write buffer and flush the data buffered in
+ *   the file system to the media.
+ *
+ ****************************************************************************/
+
+static int syslog_dev_sync(FAR struct syslog_dev_s *syslog_dev)
+{
+  int ret;
+
+  ret = syslog_dev_drain(syslog_dev);
+
+#if defined(CONFIG_SYSLOG_FILE) && !defined(CONFIG_DISABLE_MOUNTPOINT)
+  /* Ignore return value of the fsync.  file_fsync() could fail because
+   * the file is not open, the inode is not a mountpoint, or the
+   * mountpoint does not support the sync() method.
+   */
+
+  file_fsync(&syslog_dev->sl_file);
+#endif
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: syslog_dev_worker
+ *
+ * Description:
+ *   Write out the buffered output some time after it was generated.
+ *
+ ****************************************************************************/
+
+#ifdef HAVE_SYSLOG_DEV_WORK
+static void syslog_dev_worker(FAR void *arg)
+{
+  FAR struct syslog_dev_s *syslog_dev = arg;
+
+  if (syslog_dev->sl_state == SYSLOG_OPENED &&
+      syslog_dev_takesem(syslog_dev) >= 0)
+    {
+      if (syslog_dev_sync(syslog_dev) < 0)
+        {
+          syslog_dev->sl_state = SYSLOG_FAILURE;
+        }
+
+      syslog_dev_givesem(syslog_dev);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: syslog_dev_output
+ *
+ * Description:
+ *   Output data to the device or file through the write buffer.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ * Assumptions:
+ *   The caller holds sl_sem.
+ *
+ ****************************************************************************/
+
+static int syslog_dev_output(FAR struct syslog_dev_s *syslog_dev,
+                             FAR const void *buffer, size_t buflen)
+{
+#if CONFIG_SYSLOG_DEV_BUFSIZE > 0
+  FAR const char *ptr = buffer;
+  size_t nbytes;
+  int ret;
+
+  while (buflen > 0)
+    {
+      /* Only write when the buffer is full */
+
+      if (syslog_dev->sl_buflen >= CONFIG_SYSLOG_DEV_BUFSIZE)
+        {
+          ret = syslog_dev_drain(syslog_dev);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+#ifdef HAVE_SYSLOG_DEV_WORK
+      /* Start the timer on the first byte buffered */
+
+      if (syslog_dev->sl_buflen == 0 && work_available(&syslog_dev->sl_work))
+        {
+          work_queue(LPWORK, &syslog_dev->sl_work, syslog_dev_worker,
+                     syslog_dev, MSEC2TICK(CONFIG_SYSLOG_DEV_FLUSHDELAY));
+        }
+#endif
+
+      nbytes = CONFIG_SYSLOG_DEV_BUFSIZE - syslog_dev->sl_buflen;
+      if (nbytes > buflen)
+        {
+          nbytes = buflen;
+        }
+
+      memcpy(&syslog_dev->sl_buffer[syslog_dev->sl_buflen], ptr, nbytes);
+      syslog_dev->sl_buflen += nbytes;
+      ptr                   += nbytes;
+      buflen                -= nbytes;
+    }
+
+  return OK;
+#else
+  int ret;
+
+  ret = syslog_dev_filewrite(syslog_dev, buffer, buflen);
+
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+  if (ret >= 0)
+    {
+      ret = syslog_dev_checkrotate(syslog_dev);
+    }
+#endif
+
+  return ret;
+#endif
+}
+
 /****************************************************************************
  * Name: syslog_dev_open
  *
@@ -270,6 +568,16 @@ static int syslog_dev_open(FAR struct syslog_dev_s *syslog_dev,
       return ret;
     }
 
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+  /* Only log files in a mounted file system are rotated */
+
+  syslog_dev->sl_size = -1;
+  if (INODE_IS_MOUNTPT(syslog_dev->sl_file.f_inode))
+    {
+      syslog_dev->sl_size = file_seek(&syslog_dev->sl_file, 0, SEEK_END);
+    }
+#endif
+
   /* The SYSLOG device is open and ready for writing. */
 
   nxsem_init(&syslog_dev->sl_sem, 0, 1);
@@ -414,7 +722,6 @@ static ssize_t syslog_dev_write(FAR struct syslog_channel_s *channel,
 {
   FAR struct syslog_dev_s *syslog_dev = (FAR struct syslog_dev_s *)channel;
   FAR const char *endptr;
-  ssize_t nwritten;
   size_t writelen;
   size_t remaining;
   int ret;
@@ -474,11 +781,9 @@ static ssize_t syslog_dev_write(FAR struct syslog_channel_s *channel,
               writelen = (size_t)((uintptr_t)endptr - (uintptr_t)buffer);
               if (writelen > 0)
                 {
-                  nwritten = file_write(&syslog_dev->sl_file,
-                                        buffer, writelen);
-                  if (nwritten < 0)
+                  ret = syslog_dev_output(syslog_dev, buffer, writelen);
+                  if (ret < 0)
                     {
-                      ret = (int)nwritten;
                       goto errout_with_sem;
                     }
                 }
@@ -489,11 +794,9 @@ static ssize_t syslog_dev_write(FAR struct syslog_channel_s *channel,
 
               if (*endptr == '\n')
                 {
-                  nwritten = file_write(&syslog_dev->sl_file,
-                                        g_syscrlf, 2);
-                  if (nwritten < 0)
+                  ret = syslog_dev_output(syslog_dev, g_syscrlf, 2);
+                  if (ret < 0)
                     {
-                      ret = (int)nwritten;
                       goto errout_with_sem;
                     }
                 }
@@ -515,10 +818,9 @@ static ssize_t syslog_dev_write(FAR struct syslog_channel_s *channel,
   writelen = (size_t)((uintptr_t)endptr - (uintptr_t)buffer);
   if (writelen > 0)
     {
-      nwritten = file_write(&syslog_dev->sl_file, buffer, writelen);
-      if (nwritten < 0)
+      ret = syslog_dev_output(syslog_dev, buffer, writelen);
+      if (ret < 0)
         {
-          ret = (int)nwritten;
           goto errout_with_sem;
         }
     }
@@ -552,7 +854,6 @@ errout_with_sem:
 static int syslog_dev_putc(FAR struct syslog_channel_s *channel, int ch)
 {
   FAR struct syslog_dev_s *syslog_dev = (FAR struct syslog_dev_s *)channel;
-  ssize_t nbytes;
   uint8_t uch;
   int ret;
 
@@ -593,16 +894,16 @@ static int syslog_dev_putc(FAR struct syslog_channel_s *channel, int ch)
     {
       /* Write the CR-LF sequence */
 
-      nbytes = file_write(&syslog_dev->sl_file, g_syscrlf, 2);
+      ret = syslog_dev_output(syslog_dev, g_syscrlf, 2);
 
-      /* Synchronize the file when each CR-LF is encountered (i.e.,
-       * implements line buffering always).
+#if CONFIG_SYSLOG_DEV_BUFSIZE == 0 && !defined(CONFIG_DISABLE_MOUNTPOINT)
+      /* Without a write buffer, synchronize the file when each CR-LF is
+       * encountered (i.e., implements line buffering always).
        */
 
-#ifndef CONFIG_DISABLE_MOUNTPOINT
-      if (nbytes > 0)
+      if (ret >= 0)
         {
-          syslog_dev_flush(channel);
+          syslog_dev_sync(syslog_dev);
         }
 #endif
     }
@@ -611,19 +912,19 @@ static int syslog_dev_putc(FAR struct syslog_channel_s *channel, int ch)
       /* Write the non-newline character (and don't flush) */
 
       uch = (uint8_t)ch;
-      nbytes = file_write(&syslog_dev->sl_file, &uch, 1);
+      ret = syslog_dev_output(syslog_dev, &uch, 1);
     }
 
   syslog_dev_givesem(syslog_dev);
 
-  /* Check if the write was successful.  If not, nbytes will be
-   * a negated errno value.
+  /* Check if the write was successful.  If not, ret will be a negated
+   * errno value.
    */
 
-  if (nbytes < 0)
+  if (ret < 0)
     {
       syslog_dev->sl_state = SYSLOG_FAILURE;
-      return (int)nbytes;
+      return ret;
     }
 
   return ch;
@@ -654,7 +955,8 @@ static int syslog_dev_force(FAR struct syslog_channel_s *channel, int ch)
  * Name: syslog_dev_flush
  *
  * Description:
- *   Flush any buffer data in the file system to media.
+ *   Write the buffered output and flush any buffer data in the file system
+ *   to media.
  *
  * Input Parameters:
  *   channel    - Handle to syslog channel to be used.
@@ -666,18 +968,35 @@ static int syslog_dev_force(FAR struct syslog_channel_s *channel, int ch)
 
 static int syslog_dev_flush(FAR struct syslog_channel_s *channel)
 {
-#if defined(CONFIG_SYSLOG_FILE) && !defined(CONFIG_DISABLE_MOUNTPOINT)
   FAR struct syslog_dev_s *syslog_dev = (FAR struct syslog_dev_s *)channel;
+  int ret;
 
-  /* Ignore return value, always return success.  file_fsync() could fail
-   * because the file is not open, the inode is not a mountpoint, or the
-   * mountpoint does not support the sync() method.
+  if (syslog_dev->sl_state != SYSLOG_OPENED)
+    {
+      return OK;
+    }
+
+  /* The crash-handling logic calls this with interrupts disabled, from an
+   * interrupt handler or from the task that crashed, which may even hold
+   * the semaphore.  Then nobody can release the semaphore anymore and the
+   * last output must be written regardless.
    */
 
-  file_fsync(&syslog_dev->sl_file);
-#endif
+  if (syslog_dev_panic() || syslog_dev->sl_holder == getpid())
+    {
+      syslog_dev_sync(syslog_dev);
+      return OK;
+    }
 
-  return OK;
+  ret = syslog_dev_takesem(syslog_dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = syslog_dev_sync(syslog_dev);
+  syslog_dev_givesem(syslog_dev);
+  return ret;
 }
 
 /****************************************************************************
@@ -775,6 +1094,10 @@ void syslog_dev_uninitialize(FAR struct syslog_channel_s *channel)
   sched_lock();
   syslog_dev_flush(channel);
 
+#ifdef HAVE_SYSLOG_DEV_WORK
+  work_cancel(LPWORK, &syslog_dev->sl_work);
+#endif
+
   /* Close the detached file instance, and destroy the semaphore. These are
    * both only created when the device is in SYSLOG_OPENED or SYSLOG_FAILURE
    * state.
@@ -803,3 +1126,73 @@ void syslog_dev_uninitialize(FAR struct syslog_channel_s *channel)
   kmm_free(syslog_dev);
   sched_unlock();
 }
+
+/****************************************************************************
+ * Name: syslog_dev_rotate
+ *
+ * Description:
+ *   Rotate the log file 'log_file' if it is larger than
+ *   CONFIG_SYSLOG_FILE_SIZE_LIMIT:  The file becomes 'log_file'.0, the
+ *   older backups are renamed accordingly and the oldest one is lost.
+ *
+ * Input Parameters:
+ *   log_file - The full path to the log file.  It must not be open.
+ *
+ ****************************************************************************/
+
+#ifdef HAVE_SYSLOG_DEV_ROTATE
+void syslog_dev_rotate(FAR const char *log_file)
+{
+  int i;
+  off_t size;
+  struct stat f_stat;
+  size_t name_size;
+  FAR char *rotate_to;
+  FAR char *rotate_from;
+
+  /* Get the size of the current log file. */
+
+  if (stat(log_file, &f_stat) < 0)
+    {
+      return;
+    }
+
+  size = f_stat.st_size;
+
+  /* If it does not exceed the limit we are OK. */
+
+  if (size < CONFIG_SYSLOG_FILE_SIZE_LIMIT)
+    {
+      return;
+    }
+
+  /* Rotated file names. */
+
+  name_size = strlen(log_file) + 8;
+  rotate_to = kmm_malloc(name_size);
+  rotate_from = kmm_malloc(name_size);
+  if ((rotate_to == NULL) || (rotate_from == NULL))
+    {
+      goto end;
+    }
+
+  /* Rotate the logs. */
+
+  for (i = (CONFIG_SYSLOG_FILE_ROTATIONS - 1); i > 0; i--)
+    {
+      snprintf(rotate_to, name_size, "%s.%d", log_file, i);
+      snprintf(rotate_from, name_size, "%s.%d", log_file, i - 1);
+
+      rename(rotate_from, rotate_to);
+    }
+
+  snprintf(rotate_to, name_size, "%s.0", log_file);
+
+  rename(log_file, rotate_to);
+
+end:
+
+  kmm_free(rotate_to);
+  kmm_free(rotate_from);
+}
+#endif
@@ -77,63 +77,6 @@ static void log_separate(FAR const char *log_file)
 }
 #endif
 
-#if CONFIG_SYSLOG_FILE_ROTATIONS > 0
-static void log_rotate(FAR const char *log_file)
-{
-  int i;
-  off_t size;
-  struct stat f_stat;
-  size_t name_size;
-  FAR char *rotate_to;
-  FAR char *rotate_from;
-
-  /* Get the size of the current log file. */
-
-  if (stat(log_file, &f_stat) < 0)
-    {
-      return;
-    }
-
-  size = f_stat.st_size;
-
-  /* If it does not exceed the limit we are OK. */
-
-  if (size < CONFIG_SYSLOG_FILE_SIZE_LIMIT)
-    {
-      return;
-    }
-
-  /* Rotated file names. */
-
-  name_size = strlen(log_file) + 8;
-  rotate_to = kmm_malloc(name_size);
-  rotate_from = kmm_malloc(name_size);
-  if ((rotate_to == NULL) || (rotate_from == NULL))
-    {
-      goto end;
-    }
-
-  /* Rotate the logs. */
-
-  for (i = (CONFIG_SYSLOG_FILE_ROTATIONS - 1); i > 0; i--)
-    {
-      snprintf(rotate_to, name_size, "%s.%d", log_file, i);
-      snprintf(rotate_from, name_size, "%s.%d", log_file, i - 1);
-
-      rename(rotate_from, rotate_to);
-    }
-
-  snprintf(rotate_to, name_size, "%s.0", log_file);
-
-  rename(log_file, rotate_to);
-
-end:
-
-  kmm_free(rotate_to);
-  kmm_free(rotate_from);
-}
-#endif
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -195,7 +138,7 @@ FAR struct syslog_channel_s *syslog_file_channel(FAR const char *devpath)
   /* Rotate the log file, if needed. */
 
 #if CONFIG_SYSLOG_FILE_ROTATIONS > 0
-  log_rotate(devpath);
+  syslog_dev_rotate(devpath);
 #endif
 
   /* Separate the old log entries. */
@@ -31,6 +31,12 @@
 
 #include "syslog.h"
 
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+volatile bool g_syslog_panic;
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -66,6 +72,18 @@ int syslog_flush(void)
 {
   int i;
 
+  /* The system is going down.  The channels must not wait for a lock that
+   * might be held by the thread that crashed.
+   */
+
+  g_syslog_panic = true;
+
+#ifdef CONFIG_SYSLOG_BINARY
+  /* Format the messages that are still recorded */
+
+  syslog_binary_flush(true);
+#endif
+
 #ifdef CONFIG_SYSLOG_INTBUFFER
   /* Flush any characters that may have been added to the interrupt
    * buffer.
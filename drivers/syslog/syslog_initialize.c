@@ -91,6 +91,12 @@ int syslog_initialize(void)
   syslog_rpmsg_init();
 #endif
 
+#ifdef CONFIG_SYSLOG_BINARY
+  /* Start formatting the deferred messages */
+
+  ret = syslog_binary_initialize();
+#endif
+
   return ret;
 }
 
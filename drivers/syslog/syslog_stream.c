@@ -26,6 +26,7 @@
 
 #include <stdio.h>
 #include <unistd.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -174,6 +175,58 @@ static void syslogstream_putc(FAR struct lib_outstream_s *this, int ch)
     }
 }
 
+/****************************************************************************
+ * Name: syslogstream_puts
+ ****************************************************************************/
+
+static void syslogstream_puts(FAR struct lib_outstream_s *this,
+                              FAR const void *buf, int len)
+{
+  FAR const char *ptr = buf;
+#ifdef CONFIG_SYSLOG_BUFFER
+  FAR struct lib_syslogstream_s *stream =
+    (FAR struct lib_syslogstream_s *)this;
+  FAR struct iob_s *iob = stream->iob;
+  int ncopy;
+#endif
+
+  while (len > 0)
+    {
+#ifdef CONFIG_SYSLOG_BUFFER
+      /* Copy a run of characters that need no CR/LF handling straight into
+       * the IO buffer.
+       */
+
+      if (iob != NULL)
+        {
+          for (ncopy = 0;
+               ncopy < len && ncopy < CONFIG_IOB_BUFSIZE - iob->io_len &&
+               ptr[ncopy] != '\r' && ptr[ncopy] != '\n';
+               ncopy++);
+
+          if (ncopy > 0)
+            {
+              memcpy(&iob->io_data[iob->io_len], ptr, ncopy);
+              iob->io_len  += ncopy;
+              this->nput   += ncopy;
+              ptr          += ncopy;
+              len          -= ncopy;
+
+              if (iob->io_len >= CONFIG_IOB_BUFSIZE)
+                {
+                  syslogstream_flush(stream);
+                }
+
+              continue;
+            }
+        }
+#endif
+
+      syslogstream_putc(this, *ptr++);
+      len--;
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -205,6 +258,7 @@ void syslogstream_create(FAR struct lib_syslogstream_s *stream)
   /* Initialize the common fields */
 
   stream->public.put   = syslogstream_putc;
+  stream->public.puts  = syslogstream_puts;
   stream->public.flush = lib_noflush;
   stream->public.nput  = 0;
 
@@ -25,16 +25,22 @@
 #include <nuttx/config.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <syslog.h>
+#include <time.h>
+#include <unistd.h>
 #include <errno.h>
 
 #include <nuttx/arch.h>
 #include <nuttx/init.h>
 #include <nuttx/arch.h>
 #include <nuttx/clock.h>
+#include <nuttx/sched.h>
 #include <nuttx/streams.h>
 #include <nuttx/syslog/syslog.h>
 
+#include "syslog.h"
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -52,46 +58,19 @@ static FAR const char * g_priority_str[] =
  ****************************************************************************/
 
 /****************************************************************************
- * Name: nx_vsyslog
+ * Name: syslog_gettime
  *
  * Description:
- *   nx_vsyslog() handles the system logging system calls. It is functionally
- *   equivalent to vsyslog() except that (1) the per-process priority
- *   filtering has already been performed and the va_list parameter is
- *   passed by reference.  That is because the va_list is a structure in
- *   some compilers and passing of structures in the NuttX sycalls does
- *   not work.
+ *   Get the time stamp of a new SYSLOG message.  Zero is returned early in
+ *   the start-up sequence when the hardware timer may not yet be available.
  *
  ****************************************************************************/
 
-int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
-{
-  struct lib_syslogstream_s stream;
-  int ret = 0;
-#if CONFIG_TASK_NAME_SIZE > 0 && defined(CONFIG_SYSLOG_PROCESS_NAME)
-  struct tcb_s *tcb;
-#endif
 #ifdef CONFIG_SYSLOG_TIMESTAMP
-  struct timespec ts;
-#if defined(CONFIG_SYSLOG_TIMESTAMP_FORMATTED)
-  struct tm tm;
-  char date_buf[CONFIG_SYSLOG_TIMESTAMP_BUFFER];
-#endif
-#endif
-
-  /* Wrap the low-level output in a stream object and let lib_vsprintf
-   * do the work.
-   */
-
-  syslogstream_create(&stream);
-
-#ifdef CONFIG_SYSLOG_TIMESTAMP
-  ts.tv_sec = 0;
-  ts.tv_nsec = 0;
-
-#if defined(CONFIG_SYSLOG_TIMESTAMP_FORMATTED)
-  memset(&tm, 0, sizeof(tm));
-#endif
+void syslog_gettime(FAR struct timespec *ts)
+{
+  ts->tv_sec = 0;
+  ts->tv_nsec = 0;
 
   /* Get the current time.  Since debug output may be generated very early
    * in the start-up sequence, hardware timer support may not yet be
@@ -103,54 +82,96 @@ int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
 #if defined(CONFIG_SYSLOG_TIMESTAMP_REALTIME)
       /* Use CLOCK_REALTIME if so configured */
 
-      clock_gettime(CLOCK_REALTIME, &ts);
+      clock_gettime(CLOCK_REALTIME, ts);
 
 #elif defined(CONFIG_CLOCK_MONOTONIC)
       /* Prefer monotonic when enabled, as it can be synchronized to
        * RTC with clock_resynchronize.
        */
 
-      clock_gettime(CLOCK_MONOTONIC, &ts);
+      clock_gettime(CLOCK_MONOTONIC, ts);
 
 #else
       /* Otherwise, fall back to the system timer */
 
-      clock_systime_timespec(&ts);
+      clock_systime_timespec(ts);
+#endif
+    }
+}
 #endif
 
-      /* Prepend the message with the current time, if available */
+/****************************************************************************
+ * Name: syslog_header
+ *
+ * Description:
+ *   Output the configured prefix of a SYSLOG message:  The time stamp, the
+ *   CPU, the process ID, the priority and the process name.
+ *
+ * Input Parameters:
+ *   stream   - The stream to receive the prefix
+ *   priority - The priority of the message
+ *   ts       - The time stamp from syslog_gettime()
+ *   pid      - The process that generated the message
+ *   cpu      - The CPU that generated the message
+ *
+ * Returned Value:
+ *   The number of characters output.
+ *
+ ****************************************************************************/
+
+int syslog_header(FAR struct lib_outstream_s *stream, int priority,
+                  FAR const struct timespec *ts, pid_t pid, int cpu)
+{
+  int ret = 0;
+#if CONFIG_TASK_NAME_SIZE > 0 && defined(CONFIG_SYSLOG_PROCESS_NAME)
+  FAR struct tcb_s *tcb;
+#endif
+#if defined(CONFIG_SYSLOG_TIMESTAMP_FORMATTED)
+  struct tm tm;
+  char date_buf[CONFIG_SYSLOG_TIMESTAMP_BUFFER];
+#endif
+
+  UNUSED(priority);
+  UNUSED(ts);
+  UNUSED(pid);
+  UNUSED(cpu);
+
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  /* Prepend the message with the time, if available */
 
 #if defined(CONFIG_SYSLOG_TIMESTAMP_FORMATTED)
+  memset(&tm, 0, sizeof(tm));
+
+  if (ts->tv_sec != 0 || ts->tv_nsec != 0)
+    {
 #if defined(CONFIG_SYSLOG_TIMESTAMP_LOCALTIME)
-      localtime_r(&ts.tv_sec, &tm);
+      localtime_r(&ts->tv_sec, &tm);
 #else
-      gmtime_r(&ts.tv_sec, &tm);
-#endif
+      gmtime_r(&ts->tv_sec, &tm);
 #endif
     }
 
-#if defined(CONFIG_SYSLOG_TIMESTAMP_FORMATTED)
   ret = strftime(date_buf, CONFIG_SYSLOG_TIMESTAMP_BUFFER,
                  CONFIG_SYSLOG_TIMESTAMP_FORMAT, &tm);
 
   if (ret > 0)
     {
-      ret = lib_sprintf(&stream.public, "[%s] ", date_buf);
+      ret = lib_sprintf(stream, "[%s] ", date_buf);
     }
 #else
-  ret = lib_sprintf(&stream.public, "[%5jd.%06ld] ",
-                    (uintmax_t)ts.tv_sec, ts.tv_nsec / 1000);
+  ret = lib_sprintf(stream, "[%5jd.%06ld] ",
+                    (uintmax_t)ts->tv_sec, ts->tv_nsec / 1000);
 #endif
 #endif
 
 #if defined(CONFIG_SMP)
-  ret += lib_sprintf(&stream.public, "[CPU%d] ", up_cpu_index());
+  ret += lib_sprintf(stream, "[CPU%d] ", cpu);
 #endif
 
 #if defined(CONFIG_SYSLOG_PROCESSID)
   /* Prepend the Process ID */
 
-  ret += lib_sprintf(&stream.public, "[%2d] ", (int)getpid());
+  ret += lib_sprintf(stream, "[%2d] ", (int)pid);
 #endif
 
 #if defined(CONFIG_SYSLOG_COLOR_OUTPUT)
@@ -159,34 +180,34 @@ int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
   switch (priority)
     {
       case LOG_EMERG:   /* Red, Bold, Blinking */
-        ret += lib_sprintf(&stream.public, "\e[31;1;5m");
+        ret += lib_sprintf(stream, "\e[31;1;5m");
         break;
 
       case LOG_ALERT:   /* Red, Bold */
-        ret += lib_sprintf(&stream.public, "\e[31;1m");
+        ret += lib_sprintf(stream, "\e[31;1m");
         break;
 
       case LOG_CRIT:    /* Red, Bold */
-        ret += lib_sprintf(&stream.public, "\e[31;1m");
+        ret += lib_sprintf(stream, "\e[31;1m");
         break;
 
       case LOG_ERR:     /* Red */
-        ret += lib_sprintf(&stream.public, "\e[31m");
+        ret += lib_sprintf(stream, "\e[31m");
         break;
 
       case LOG_WARNING: /* Yellow */
-        ret += lib_sprintf(&stream.public, "\e[33m");
+        ret += lib_sprintf(stream, "\e[33m");
         break;
 
       case LOG_NOTICE:  /* Bold */
-        ret += lib_sprintf(&stream.public, "\e[1m");
+        ret += lib_sprintf(stream, "\e[1m");
         break;
 
       case LOG_INFO:    /* Normal */
         break;
 
       case LOG_DEBUG:   /* Dim */
-        ret += lib_sprintf(&stream.public, "\e[2m");
+        ret += lib_sprintf(stream, "\e[2m");
         break;
     }
 #endif
@@ -194,33 +215,110 @@ int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
 #if defined(CONFIG_SYSLOG_PRIORITY)
   /* Prepend the message priority. */
 
-  ret += lib_sprintf(&stream.public, "[%6s] ", g_priority_str[priority]);
+  ret += lib_sprintf(stream, "[%6s] ", g_priority_str[priority]);
 #endif
 
 #if defined(CONFIG_SYSLOG_PREFIX)
   /* Prepend the prefix, if available */
 
-  ret += lib_sprintf(&stream.public, "%s", CONFIG_SYSLOG_PREFIX_STRING);
+  ret += lib_sprintf(stream, "%s", CONFIG_SYSLOG_PREFIX_STRING);
 #endif
 
 #if CONFIG_TASK_NAME_SIZE > 0 && defined(CONFIG_SYSLOG_PROCESS_NAME)
   /* Prepend the process name */
 
-  tcb = nxsched_get_tcb(getpid());
-  ret += lib_sprintf(&stream.public, "%s: ",
-                     (tcb != NULL) ? tcb->name : "(null)");
+  tcb = nxsched_get_tcb(pid);
+  ret += lib_sprintf(stream, "%s: ", (tcb != NULL) ? tcb->name : "(null)");
 #endif
 
-  /* Generate the output */
+  return ret;
+}
 
-  ret += lib_vsprintf(&stream.public, fmt, *ap);
+/****************************************************************************
+ * Name: syslog_trailer
+ *
+ * Description:
+ *   Output the configured suffix of a SYSLOG message.
+ *
+ * Returned Value:
+ *   The number of characters output.
+ *
+ ****************************************************************************/
 
+int syslog_trailer(FAR struct lib_outstream_s *stream)
+{
 #if defined(CONFIG_SYSLOG_COLOR_OUTPUT)
   /* Reset the terminal style back to normal. */
 
-  ret += lib_sprintf(&stream.public, "\e[0m");
+  return lib_sprintf(stream, "\e[0m");
+#else
+  UNUSED(stream);
+  return 0;
+#endif
+}
+
+/****************************************************************************
+ * Name: nx_vsyslog
+ *
+ * Description:
+ *   nx_vsyslog() handles the system logging system calls. It is functionally
+ *   equivalent to vsyslog() except that (1) the per-process priority
+ *   filtering has already been performed and the va_list parameter is
+ *   passed by reference.  That is because the va_list is a structure in
+ *   some compilers and passing of structures in the NuttX sycalls does
+ *   not work.
+ *
+ *   Returns the number of characters output.  With CONFIG_SYSLOG_BINARY,
+ *   a message recorded for deferred formatting is not measured; the size
+ *   of the record, or zero if the message was dropped, is returned.
+ *
+ ****************************************************************************/
+
+int nx_vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
+{
+  struct lib_syslogstream_s stream;
+  struct timespec ts;
+  int cpu = 0;
+  int ret;
+
+#ifdef CONFIG_SYSLOG_BINARY
+  /* Record the message for deferred formatting.  Only the messages that
+   * cannot be recorded are formatted here.  A recorded message is not
+   * measured:  The size of the record, or zero if the message was dropped,
+   * is returned instead of the length of the formatted message.
+   */
+
+  ret = syslog_binary_add(priority, fmt, ap);
+  if (ret != -ENOTSUP)
+    {
+      return ret < 0 ? 0 : ret;
+    }
 #endif
 
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  syslog_gettime(&ts);
+#else
+  ts.tv_sec  = 0;
+  ts.tv_nsec = 0;
+#endif
+
+#ifdef CONFIG_SMP
+  cpu = up_cpu_index();
+#endif
+
+  /* Wrap the low-level output in a stream object and let lib_vsprintf
+   * do the work.
+   */
+
+  syslogstream_create(&stream);
+
+  ret  = syslog_header(&stream.public, priority, &ts, getpid(), cpu);
+
+  /* Generate the output */
+
+  ret += lib_vsprintf(&stream.public, fmt, *ap);
+  ret += syslog_trailer(&stream.public);
+
 #ifdef CONFIG_SYSLOG_BUFFER
   /* Flush and destroy the syslog stream buffer */
 
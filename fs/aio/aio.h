@@ -49,6 +49,35 @@
 #  define CONFIG_FS_NAIOC 8
 #endif
 
+#ifdef CONFIG_FS_AIO_WORKERS
+#  ifndef CONFIG_FS_AIO_NTHREADS
+#    define CONFIG_FS_AIO_NTHREADS 2
+#  endif
+
+#  ifndef CONFIG_FS_AIO_PRIORITY
+#    define CONFIG_FS_AIO_PRIORITY 50
+#  endif
+
+#  ifndef CONFIG_FS_AIO_STACKSIZE
+#    define CONFIG_FS_AIO_STACKSIZE 2048
+#  endif
+
+#  ifndef CONFIG_FS_AIO_MAXMERGE
+#    define CONFIG_FS_AIO_MAXMERGE 1
+#  endif
+#endif
+
+/* When the I/O runs on the low priority work queue, the worker thread
+ * priority was boosted by aio_queue() and must be restored when the I/O
+ * completes.  The dedicated AIO worker threads manage their own priority.
+ */
+
+#if defined(CONFIG_PRIORITY_INHERITANCE) && !defined(CONFIG_FS_AIO_WORKERS)
+#  define aio_restorepriority(prio) lpwork_restorepriority(prio)
+#else
+#  define aio_restorepriority(prio) UNUSED(prio)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -64,8 +93,14 @@ struct aio_container_s
   dq_entry_t aioc_link;            /* Supports a doubly linked list */
   FAR struct aiocb *aioc_aiocbp;   /* The contained AIO control block */
   FAR struct file *aioc_filep;     /* File structure to use with the I/O */
+#ifdef CONFIG_FS_AIO_WORKERS
+  worker_t aioc_worker;            /* I/O worker, NULL until queued or once
+                                    * claimed by an AIO worker thread */
+#else
   struct work_s aioc_work;         /* Used to defer I/O to the work thread */
+#endif
   pid_t aioc_pid;                  /* ID of the waiting task */
+  uint8_t aioc_opcode;             /* LIO_READ, LIO_WRITE or LIO_NOP */
 #ifdef CONFIG_PRIORITY_INHERITANCE
   uint8_t aioc_prio;               /* Priority of the waiting task */
 #endif
@@ -207,7 +242,8 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
  * Name: aio_queue
  *
  * Description:
- *   Schedule the asynchronous I/O on the low priority work queue
+ *   Schedule the asynchronous I/O on the low priority work queue or, if
+ *   CONFIG_FS_AIO_WORKERS is selected, on the dedicated AIO worker threads.
  *
  * Input Parameters:
  *   arg - Worker argument.  In this case, a pointer to an instance of
@@ -221,6 +257,24 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
 
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker);
 
+/****************************************************************************
+ * Name: aio_dequeue
+ *
+ * Description:
+ *   Remove a queued asynchronous I/O that has not yet been started.  The
+ *   caller must hold the lock on the pending asynchronous I/O list.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container to be dequeued
+ *
+ * Returned Value:
+ *   Zero (OK) if the I/O was dequeued.  -ENOENT if the I/O has already
+ *   been started and can no longer be canceled.
+ *
+ ****************************************************************************/
+
+int aio_dequeue(FAR struct aio_container_s *aioc);
+
 /****************************************************************************
  * Name: aio_signal
  *
@@ -240,6 +294,28 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker);
 
 int aio_signal(pid_t pid, FAR struct aiocb *aiocbp);
 
+/****************************************************************************
+ * Name: aio_evclose
+ *
+ * Description:
+ *   Release the duplicate of the SIGEV_EVENTFD eventfd that aio_contain()
+ *   took for the I/O.  aio_signal() does this after the notification; it
+ *   must also be done if the I/O is abandoned without being signalled.
+ *
+ * Input Parameters:
+ *   aiocbp - Pointer to the asynchronous I/O state structure
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIO_EVENTFD
+void aio_evclose(FAR struct aiocb *aiocbp);
+#else
+#  define aio_evclose(aiocbp)
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
@@ -99,7 +99,7 @@ static void aio_fsync_worker(FAR void *arg)
 #ifdef CONFIG_PRIORITY_INHERITANCE
   /* Restore the low priority worker thread default priority */
 
-  lpwork_restorepriority(prio);
+  aio_restorepriority(prio);
 #endif
 }
 
@@ -215,12 +215,15 @@ int aio_fsync(int op, FAR struct aiocb *aiocbp)
 
   /* Defer the work to the worker thread */
 
+  aioc->aioc_opcode = LIO_NOP;
+
   ret = aio_queue(aioc, aio_fsync_worker);
   if (ret < 0)
     {
       /* The result and the errno have already been set */
 
       aioc_decant(aioc);
+      aio_evclose(aiocbp);
       return ERROR;
     }
 
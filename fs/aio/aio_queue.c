@@ -34,10 +34,10 @@
 
 #include "aio/aio.h"
 
-#ifdef CONFIG_FS_AIO
+#if defined(CONFIG_FS_AIO) && !defined(CONFIG_FS_AIO_WORKERS)
 
 /****************************************************************************
- * Private Functions
+ * Public Functions
  ****************************************************************************/
 
 /****************************************************************************
@@ -96,4 +96,29 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
   return ret;
 }
 
-#endif /* CONFIG_FS_AIO */
+/****************************************************************************
+ * Name: aio_dequeue
+ *
+ * Description:
+ *   Remove a queued asynchronous I/O that has not yet been started.  The
+ *   caller must hold the lock on the pending asynchronous I/O list.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container to be dequeued
+ *
+ * Returned Value:
+ *   Zero (OK) if the I/O was dequeued.  -ENOENT if the I/O has already
+ *   been started and can no longer be canceled.
+ *
+ ****************************************************************************/
+
+int aio_dequeue(FAR struct aio_container_s *aioc)
+{
+  /* work_cancel() will return -ENOENT if the work has already been started
+   * and is no longer queued.
+   */
+
+  return work_cancel(LPWORK, &aioc->aioc_work);
+}
+
+#endif /* CONFIG_FS_AIO && !CONFIG_FS_AIO_WORKERS */
@@ -109,7 +109,7 @@ static void aio_read_worker(FAR void *arg)
 #ifdef CONFIG_PRIORITY_INHERITANCE
   /* Restore the low priority worker thread default priority */
 
-  lpwork_restorepriority(prio);
+  aio_restorepriority(prio);
 #endif
 }
 
@@ -241,12 +241,15 @@ int aio_read(FAR struct aiocb *aiocbp)
 
   /* Defer the work to the worker thread */
 
+  aioc->aioc_opcode = LIO_READ;
+
   ret = aio_queue(aioc, aio_read_worker);
   if (ret < 0)
     {
       /* The result and the errno have already been set */
 
       aioc_decant(aioc);
+      aio_evclose(aiocbp);
       return ERROR;
     }
 
@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/eventfd.h>
 #include <sched.h>
 #include <signal.h>
 #include <aio.h>
@@ -32,6 +33,8 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
 #include <nuttx/signal.h>
 
 #include "aio/aio.h"
@@ -72,13 +75,34 @@ int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
 
   ret = OK; /* Assume success */
 
-  /* Signal the client */
+#ifdef CONFIG_FS_AIO_EVENTFD
+  if (aiocbp->aio_sigevent.sigev_notify == SIGEV_EVENTFD)
+    {
+      eventfd_t count = 1;
+      ssize_t nwritten;
 
-  ret = nxsig_notification(pid, &aiocbp->aio_sigevent,
-                           SI_ASYNCIO, &aiocbp->aio_sigwork);
-  if (ret < 0)
+      /* Increment the eventfd counter */
+
+      nwritten = file_write(aiocbp->aio_evfilep, &count, sizeof(count));
+      if (nwritten < 0)
+        {
+          ferr("ERROR: eventfd write failed: %zd\n", nwritten);
+          ret = nwritten;
+        }
+
+      aio_evclose(aiocbp);
+    }
+  else
+#endif
     {
-      ferr("ERROR: nxsig_notification failed: %d\n", ret);
+      /* Signal the client */
+
+      ret = nxsig_notification(pid, &aiocbp->aio_sigevent,
+                               SI_ASYNCIO, &aiocbp->aio_sigwork);
+      if (ret < 0)
+        {
+          ferr("ERROR: nxsig_notification failed: %d\n", ret);
+        }
     }
 
   /* Send the poll signal in any event in case the caller is waiting
@@ -107,4 +131,32 @@ int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
   return OK;
 }
 
+/****************************************************************************
+ * Name: aio_evclose
+ *
+ * Description:
+ *   Release the duplicate of the SIGEV_EVENTFD eventfd that aio_contain()
+ *   took for the I/O.
+ *
+ * Input Parameters:
+ *   aiocbp - Pointer to the asynchronous I/O state structure
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIO_EVENTFD
+void aio_evclose(FAR struct aiocb *aiocbp)
+{
+  if (aiocbp->aio_sigevent.sigev_notify == SIGEV_EVENTFD &&
+      aiocbp->aio_evfilep != NULL)
+    {
+      file_close(aiocbp->aio_evfilep);
+      kmm_free(aiocbp->aio_evfilep);
+      aiocbp->aio_evfilep = NULL;
+    }
+}
+#endif
+
 #endif /* CONFIG_FS_AIO */
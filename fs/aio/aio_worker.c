@@ -0,0 +1,507 @@
+/****************************************************************************
+ * fs/aio/aio_worker.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/kthread.h>
+#include <nuttx/sched.h>
+#include <nuttx/semaphore.h>
+
+#include "aio/aio.h"
+
+#ifdef CONFIG_FS_AIO_WORKERS
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Counts the I/O queued for the AIO worker threads.  A worker that is
+ * awakened may find nothing that it can start (because the file is busy on
+ * another worker); the worker that owns the file will pick the I/O up when
+ * it finishes.
+ */
+
+static sem_t g_aio_qsem;
+
+/* The file that each worker thread is currently performing I/O on.  I/O on
+ * the same file is never performed concurrently so that the requests on
+ * each file complete in the order that they were queued.  Protected by
+ * aio_lock().
+ */
+
+static FAR struct file *g_aio_busy[CONFIG_FS_AIO_NTHREADS];
+
+/* True once the worker threads have been started */
+
+static bool g_aio_started;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aio_isbusy
+ *
+ * Description:
+ *   Return true if I/O on 'filep' is in progress on a worker thread.  The
+ *   caller must hold aio_lock().
+ *
+ ****************************************************************************/
+
+static bool aio_isbusy(FAR struct file *filep)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_FS_AIO_NTHREADS; i++)
+    {
+      if (g_aio_busy[i] == filep)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: aio_mergeable
+ *
+ * Description:
+ *   Return true if 'next' continues 'aioc' both in the file and in memory
+ *   so that the two may be performed with a single transfer.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FS_AIO_MAXMERGE > 1
+static bool aio_mergeable(FAR struct aio_container_s *aioc,
+                          FAR struct aio_container_s *next, off_t offset,
+                          FAR volatile uint8_t *buffer)
+{
+  FAR struct aiocb *aiocbp = next->aioc_aiocbp;
+
+  if (next->aioc_opcode != aioc->aioc_opcode)
+    {
+      return false;
+    }
+
+  /* Appends are written at the current file position and cannot be
+   * combined.
+   */
+
+  if (aioc->aioc_opcode == LIO_WRITE &&
+      (aioc->aioc_filep->f_oflags & O_APPEND) != 0)
+    {
+      return false;
+    }
+
+  return aiocbp->aio_offset == offset &&
+         (FAR volatile uint8_t *)aiocbp->aio_buf == buffer;
+}
+#endif
+
+/****************************************************************************
+ * Name: aio_claim
+ *
+ * Description:
+ *   Claim the oldest queued I/O on a file that is not busy on another
+ *   worker.  Immediately following I/O of the same type that is contiguous
+ *   with it, both in the file and in memory, is claimed too so that all of
+ *   it can be done in a single transfer.
+ *
+ * Input Parameters:
+ *   wndx   - The index of the calling worker thread
+ *   chain  - The array in which to return the claimed containers
+ *   worker - The location to return the worker of the first container
+ *
+ * Returned Value:
+ *   The number of containers claimed; zero if there is nothing to do.
+ *
+ ****************************************************************************/
+
+static int aio_claim(int wndx, FAR struct aio_container_s **chain,
+                     FAR worker_t *worker)
+{
+  FAR struct aio_container_s *aioc;
+#if CONFIG_FS_AIO_MAXMERGE > 1
+  FAR struct aio_container_s *next;
+  FAR volatile uint8_t *buffer;
+  off_t offset;
+#endif
+  int nclaimed = 0;
+
+  if (aio_lock() < 0)
+    {
+      return 0;
+    }
+
+  for (aioc = (FAR struct aio_container_s *)g_aio_pending.head;
+       aioc != NULL;
+       aioc = (FAR struct aio_container_s *)aioc->aioc_link.flink)
+    {
+      if (aioc->aioc_worker != NULL && !aio_isbusy(aioc->aioc_filep))
+        {
+          break;
+        }
+    }
+
+  if (aioc != NULL)
+    {
+      *worker            = aioc->aioc_worker;
+      aioc->aioc_worker  = NULL;
+      chain[nclaimed++]  = aioc;
+      g_aio_busy[wndx]   = aioc->aioc_filep;
+
+#if CONFIG_FS_AIO_MAXMERGE > 1
+      if (aioc->aioc_opcode != LIO_NOP)
+        {
+          offset = aioc->aioc_aiocbp->aio_offset +
+                   aioc->aioc_aiocbp->aio_nbytes;
+          buffer = (FAR volatile uint8_t *)aioc->aioc_aiocbp->aio_buf +
+                   aioc->aioc_aiocbp->aio_nbytes;
+
+          for (next = (FAR struct aio_container_s *)aioc->aioc_link.flink;
+               next != NULL && nclaimed < CONFIG_FS_AIO_MAXMERGE;
+               next = (FAR struct aio_container_s *)next->aioc_link.flink)
+            {
+              if (next->aioc_filep != aioc->aioc_filep)
+                {
+                  continue;
+                }
+
+              /* Stop at the first I/O on this file that cannot be merged
+               * so that the file's I/O still completes in order.
+               */
+
+              if (next->aioc_worker == NULL ||
+                  !aio_mergeable(aioc, next, offset, buffer))
+                {
+                  break;
+                }
+
+              next->aioc_worker = NULL;
+              chain[nclaimed++] = next;
+
+              offset += next->aioc_aiocbp->aio_nbytes;
+              buffer += next->aioc_aiocbp->aio_nbytes;
+            }
+        }
+#endif
+    }
+
+  aio_unlock();
+  return nclaimed;
+}
+
+/****************************************************************************
+ * Name: aio_merged
+ *
+ * Description:
+ *   Perform a chain of contiguous reads or writes with one transfer and
+ *   complete each of them.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FS_AIO_MAXMERGE > 1
+static void aio_merged(FAR struct aio_container_s **chain, int nchain)
+{
+  FAR struct aiocb *aiocbs[CONFIG_FS_AIO_MAXMERGE];
+  pid_t pids[CONFIG_FS_AIO_MAXMERGE];
+  FAR struct file *filep;
+  FAR void *buffer;
+  uint8_t opcode;
+  size_t nbytes = 0;
+  off_t offset;
+  ssize_t ret;
+  int i;
+
+  /* Decant the AIO control blocks first, as the single I/O workers do, so
+   * that the containers are available to other submitters during the I/O.
+   */
+
+  filep  = chain[0]->aioc_filep;
+  opcode = chain[0]->aioc_opcode;
+
+  for (i = 0; i < nchain; i++)
+    {
+      pids[i]   = chain[i]->aioc_pid;
+      aiocbs[i] = aioc_decant(chain[i]);
+      nbytes   += aiocbs[i]->aio_nbytes;
+    }
+
+  buffer = (FAR void *)aiocbs[0]->aio_buf;
+  offset = aiocbs[0]->aio_offset;
+
+  finfo("%s %d requests, %zu bytes at %jd\n",
+        opcode == LIO_READ ? "Read" : "Write", nchain, nbytes,
+        (intmax_t)offset);
+
+  if (opcode == LIO_READ)
+    {
+      ret = file_pread(filep, buffer, nbytes, offset);
+    }
+  else
+    {
+      ret = file_pwrite(filep, buffer, nbytes, offset);
+    }
+
+  if (ret < 0)
+    {
+      ferr("ERROR: merged I/O failed: %zd\n", ret);
+    }
+
+  /* Distribute the result.  A short transfer completes the leading
+   * requests and leaves the remaining ones short or empty, exactly as if
+   * they had been performed one at a time.
+   */
+
+  for (i = 0; i < nchain; i++)
+    {
+      if (ret < 0)
+        {
+          aiocbs[i]->aio_result = ret;
+        }
+      else if ((size_t)ret >= aiocbs[i]->aio_nbytes)
+        {
+          aiocbs[i]->aio_result = aiocbs[i]->aio_nbytes;
+          ret -= aiocbs[i]->aio_nbytes;
+        }
+      else
+        {
+          aiocbs[i]->aio_result = ret;
+          ret = 0;
+        }
+
+      aio_signal(pids[i], aiocbs[i]);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: aio_worker_thread
+ *
+ * Description:
+ *   The body of each AIO worker thread.
+ *
+ ****************************************************************************/
+
+static int aio_worker_thread(int argc, FAR char *argv[])
+{
+  FAR struct aio_container_s *chain[CONFIG_FS_AIO_MAXMERGE];
+#ifdef CONFIG_PRIORITY_INHERITANCE
+  struct sched_param param;
+  int prio;
+  int i;
+#endif
+  worker_t worker;
+  int nchain;
+  int wndx;
+
+  wndx = atoi(argv[1]);
+  DEBUGASSERT(wndx >= 0 && wndx < CONFIG_FS_AIO_NTHREADS);
+
+  for (; ; )
+    {
+      nxsem_wait_uninterruptible(&g_aio_qsem);
+
+      /* Keep going until there is nothing that this thread can start */
+
+      while ((nchain = aio_claim(wndx, chain, &worker)) > 0)
+        {
+#ifdef CONFIG_PRIORITY_INHERITANCE
+          /* Run at the priority of the highest priority waiting client */
+
+          prio = CONFIG_FS_AIO_PRIORITY;
+          for (i = 0; i < nchain; i++)
+            {
+              if (chain[i]->aioc_prio > prio)
+                {
+                  prio = chain[i]->aioc_prio;
+                }
+            }
+
+          if (prio != CONFIG_FS_AIO_PRIORITY)
+            {
+              param.sched_priority = prio;
+              nxsched_set_param(0, &param);
+            }
+#endif
+
+#if CONFIG_FS_AIO_MAXMERGE > 1
+          if (nchain > 1)
+            {
+              aio_merged(chain, nchain);
+            }
+          else
+#endif
+            {
+              worker(chain[0]);
+            }
+
+#ifdef CONFIG_PRIORITY_INHERITANCE
+          if (prio != CONFIG_FS_AIO_PRIORITY)
+            {
+              param.sched_priority = CONFIG_FS_AIO_PRIORITY;
+              nxsched_set_param(0, &param);
+            }
+#endif
+
+          /* The file is no longer busy */
+
+          aio_lock();
+          g_aio_busy[wndx] = NULL;
+          aio_unlock();
+        }
+    }
+
+  return OK; /* To keep some compilers happy */
+}
+
+/****************************************************************************
+ * Name: aio_worker_start
+ *
+ * Description:
+ *   Start the AIO worker threads.  This is deferred until the first I/O is
+ *   queued because aio_initialize() runs before threads can be created.
+ *   The caller must hold aio_lock().
+ *
+ ****************************************************************************/
+
+static int aio_worker_start(void)
+{
+  FAR char *argv[2];
+  char arg[8];
+  int wndx;
+  int pid;
+
+  nxsem_init(&g_aio_qsem, 0, 0);
+  nxsem_set_protocol(&g_aio_qsem, SEM_PRIO_NONE);
+
+  for (wndx = 0; wndx < CONFIG_FS_AIO_NTHREADS; wndx++)
+    {
+      snprintf(arg, sizeof(arg), "%d", wndx);
+      argv[0] = arg;
+      argv[1] = NULL;
+
+      pid = kthread_create("aio", CONFIG_FS_AIO_PRIORITY,
+                           CONFIG_FS_AIO_STACKSIZE,
+                           (main_t)aio_worker_thread, argv);
+      if (pid < 0)
+        {
+          ferr("ERROR: kthread_create %d failed: %d\n", wndx, pid);
+
+          /* The threads already started will do all of the work */
+
+          return wndx > 0 ? OK : pid;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aio_queue
+ *
+ * Description:
+ *   Schedule the asynchronous I/O on the dedicated AIO worker threads.
+ *
+ * Input Parameters:
+ *   aioc   - The AIO container, already on the pending I/O list
+ *   worker - The function that performs the I/O
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  Otherwise, -1 is returned and the errno is set
+ *   appropriately.
+ *
+ ****************************************************************************/
+
+int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
+{
+  int ret;
+
+  ret = aio_lock();
+  if (ret >= 0)
+    {
+      if (!g_aio_started)
+        {
+          ret = aio_worker_start();
+          g_aio_started = ret >= 0;
+        }
+
+      if (ret >= 0)
+        {
+          aioc->aioc_worker = worker;
+        }
+
+      aio_unlock();
+    }
+
+  if (ret < 0)
+    {
+      aioc->aioc_aiocbp->aio_result = ret;
+      set_errno(-ret);
+      return ERROR;
+    }
+
+  nxsem_post(&g_aio_qsem);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: aio_dequeue
+ *
+ * Description:
+ *   Remove a queued asynchronous I/O that has not yet been started.  The
+ *   caller must hold the lock on the pending asynchronous I/O list.
+ *
+ ****************************************************************************/
+
+int aio_dequeue(FAR struct aio_container_s *aioc)
+{
+  /* A worker thread clears aioc_worker when it claims the I/O */
+
+  if (aioc->aioc_worker == NULL)
+    {
+      return -ENOENT;
+    }
+
+  aioc->aioc_worker = NULL;
+  return OK;
+}
+
+#endif /* CONFIG_FS_AIO_WORKERS */
@@ -136,7 +136,7 @@ errout:
 #ifdef CONFIG_PRIORITY_INHERITANCE
   /* Restore the low priority worker thread default priority */
 
-  lpwork_restorepriority(prio);
+  aio_restorepriority(prio);
 #endif
 }
 
@@ -270,12 +270,15 @@ int aio_write(FAR struct aiocb *aiocbp)
 
   /* Defer the work to the worker thread */
 
+  aioc->aioc_opcode = LIO_WRITE;
+
   ret = aio_queue(aioc, aio_write_worker);
   if (ret < 0)
     {
       /* The result and the errno have already been set */
 
       aioc_decant(aioc);
+      aio_evclose(aiocbp);
       return ERROR;
     }
 
@@ -29,6 +29,7 @@
 #include <errno.h>
 
 #include <nuttx/sched.h>
+#include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/net/net.h>
 
@@ -77,6 +78,41 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
 
   DEBUGASSERT(filep != NULL);
 
+#ifdef CONFIG_FS_AIO_EVENTFD
+  /* The eventfd descriptor is only meaningful in the context of the caller
+   * so it must be translated to a file structure now.  The caller may
+   * close the descriptor before the I/O completes, so keep a duplicate
+   * open until aio_evclose() releases it.
+   */
+
+  if (aiocbp->aio_sigevent.sigev_notify == SIGEV_EVENTFD)
+    {
+      FAR struct file *evfilep;
+
+      ret = fs_getfilep(aiocbp->aio_sigevent.sigev_value.sival_int,
+                        &evfilep);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      aiocbp->aio_evfilep = kmm_zalloc(sizeof(struct file));
+      if (aiocbp->aio_evfilep == NULL)
+        {
+          ret = -ENOMEM;
+          goto errout;
+        }
+
+      ret = file_dup2(evfilep, aiocbp->aio_evfilep);
+      if (ret < 0)
+        {
+          kmm_free(aiocbp->aio_evfilep);
+          aiocbp->aio_evfilep = NULL;
+          goto errout;
+        }
+    }
+#endif
+
   /* Allocate the AIO control block container, waiting for one to become
    * available if necessary.  This should not fail except for in the case
    * where the calling thread is canceled.
@@ -103,15 +139,22 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
       if (ret < 0)
         {
           aioc_free(aioc);
-          goto errout;
+          goto errout_with_evfile;
         }
 
       dq_addlast(&aioc->aioc_link, &g_aio_pending);
       aio_unlock();
     }
+  else
+    {
+      aio_evclose(aiocbp);
+    }
 
   return aioc;
 
+errout_with_evfile:
+  aio_evclose(aiocbp);
+
 errout:
   set_errno(-ret);
   return NULL;
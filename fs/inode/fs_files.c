@@ -25,7 +25,9 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <string.h>
+#include <strings.h>
 #include <assert.h>
 #include <sched.h>
 #include <errno.h>
@@ -35,9 +37,34 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/cancelpt.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
 
 #include "inode/inode.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* fs_getfilep() reads fl_rows and fl_files without holding fl_sem.  These
+ * accessors keep the compiler from reordering those accesses.
+ */
+
+#define FILES_ROWS(l)   (*(FAR volatile uint8_t *)&(l)->fl_rows)
+#define FILES_ARRAY(l)  (*(FAR struct file **volatile *)&(l)->fl_files)
+
+/* Only SMP needs a memory barrier between those accesses */
+
+#ifndef SP_DMB
+#  define SP_DMB()
+#endif
+
+/* The bitmap of file descriptors in use */
+
+#define FILES_NWORDS(r) \
+  (((r) * CONFIG_NFILE_DESCRIPTORS_PER_BLOCK + 31) / 32)
+#define FILES_SETFD(l,fd) ((l)->fl_bitmap[(fd) / 32] |= 1u << ((fd) % 32))
+#define FILES_CLRFD(l,fd) ((l)->fl_bitmap[(fd) / 32] &= ~(1u << ((fd) % 32)))
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -64,6 +91,8 @@ static int _files_semtake(FAR struct filelist *list)
 static int files_extend(FAR struct filelist *list, size_t row)
 {
   FAR struct file **tmp;
+  FAR uint32_t *bitmap;
+  size_t nwords;
   int i;
 
   if (row <= list->fl_rows)
@@ -71,13 +100,46 @@ static int files_extend(FAR struct filelist *list, size_t row)
       return 0;
     }
 
-  tmp = kmm_realloc(list->fl_files, sizeof(FAR struct file *) * row);
+  /* The bitmap is only accessed with fl_sem held and may simply move */
+
+  nwords = FILES_NWORDS(list->fl_rows);
+  bitmap = kmm_realloc(list->fl_bitmap,
+                       sizeof(uint32_t) * FILES_NWORDS(row));
+  if (bitmap == NULL)
+    {
+      return -ENFILE;
+    }
+
+  memset(&bitmap[nwords], 0,
+         sizeof(uint32_t) * (FILES_NWORDS(row) - nwords));
+  list->fl_bitmap = bitmap;
+
+  /* The array of rows may be in use by fs_getfilep() on another thread,
+   * so it cannot be reallocated.  Build a larger copy instead.  The slot
+   * in front of the rows links to the previous copy, which is freed with
+   * the list.
+   */
+
+  tmp = kmm_malloc(sizeof(FAR struct file *) * (row + 1));
   DEBUGASSERT(tmp);
   if (tmp == NULL)
     {
       return -ENFILE;
     }
 
+  if (list->fl_files != NULL)
+    {
+      tmp[0] = (FAR struct file *)(list->fl_files - 1);
+      memcpy(&tmp[1], list->fl_files,
+             sizeof(FAR struct file *) * list->fl_rows);
+    }
+  else
+    {
+      tmp[0] = NULL;
+    }
+
+  tmp++;
+
   i = list->fl_rows;
   do
     {
@@ -90,17 +152,69 @@ static int files_extend(FAR struct filelist *list, size_t row)
               kmm_free(tmp[i]);
             }
 
-          kmm_free(tmp);
+          kmm_free(tmp - 1);
           return -ENFILE;
         }
     }
   while (++i < row);
 
-  list->fl_files = tmp;
-  list->fl_rows = row;
+  /* Publish the new rows before the new row count */
+
+  FILES_ARRAY(list) = tmp;
+  SP_DMB();
+  FILES_ROWS(list) = row;
   return 0;
 }
 
+/****************************************************************************
+ * Name: files_findfree
+ *
+ * Description:
+ *   Return the lowest file descriptor at or above minfd that is not in
+ *   use.  That may be beyond the end of the list.
+ *
+ ****************************************************************************/
+
+static int files_findfree(FAR struct filelist *list, int minfd)
+{
+  int nfds = list->fl_rows * CONFIG_NFILE_DESCRIPTORS_PER_BLOCK;
+  uint32_t avail;
+  int word;
+  int fd;
+
+  for (word = minfd / 32; word * 32 < nfds; word++)
+    {
+      avail = ~list->fl_bitmap[word];
+      if (word == minfd / 32)
+        {
+          avail &= ~((1u << (minfd % 32)) - 1);
+        }
+
+      while (avail != 0)
+        {
+          fd = word * 32 + ffs((int)avail) - 1;
+          if (fd >= nfds)
+            {
+              return nfds;
+            }
+
+          if (list->fl_files[fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
+                            [fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK].f_inode
+              == NULL)
+            {
+              return fd;
+            }
+
+          /* Filled without going through this file, e.g. by file_dup2() */
+
+          FILES_SETFD(list, fd);
+          avail &= avail - 1;
+        }
+    }
+
+  return minfd > nfds ? minfd : nfds;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -131,6 +245,7 @@ void files_initlist(FAR struct filelist *list)
 
 void files_releaselist(FAR struct filelist *list)
 {
+  FAR struct file **files;
   int i;
   int j;
 
@@ -151,7 +266,20 @@ void files_releaselist(FAR struct filelist *list)
       kmm_free(list->fl_files[i]);
     }
 
-  kmm_free(list->fl_files);
+  /* Free the array of rows and all of its previous copies */
+
+  if (list->fl_files != NULL)
+    {
+      for (files = list->fl_files - 1; files != NULL; )
+        {
+          FAR struct file **prev = (FAR struct file **)files[0];
+
+          kmm_free(files);
+          files = prev;
+        }
+    }
+
+  kmm_free(list->fl_bitmap);
 
   /* Destroy the semaphore */
 
@@ -171,9 +299,9 @@ int files_allocate(FAR struct inode *inode, int oflags, off_t pos,
                    FAR void *priv, int minfd)
 {
   FAR struct filelist *list;
+  FAR struct file *filep;
   int ret;
-  int i;
-  int j;
+  int fd;
 
   /* Get the file descriptor list.  It should not be NULL in this context. */
 
@@ -188,54 +316,22 @@ int files_allocate(FAR struct inode *inode, int oflags, off_t pos,
       return ret;
     }
 
-  /* Calcuate minfd whether is in list->fl_files.
-   * if not, allocate a new filechunk.
+  /* Find a free file in the bitmap.  If there is none at or above minfd,
+   * allocate new filechunks.
    */
 
-  i = minfd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK;
-  if (i >= list->fl_rows)
-    {
-      ret = files_extend(list, i + 1);
-      if (ret < 0)
-        {
-          _files_semgive(list);
-          return ret;
-        }
-    }
-
-  /* Find free file */
-
-  j = minfd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK;
-  do
-    {
-      do
-        {
-          if (!list->fl_files[i][j].f_inode)
-            {
-              list->fl_files[i][j].f_oflags = oflags;
-              list->fl_files[i][j].f_pos    = pos;
-              list->fl_files[i][j].f_inode  = inode;
-              list->fl_files[i][j].f_priv   = priv;
-              _files_semgive(list);
-              return i * CONFIG_NFILE_DESCRIPTORS_PER_BLOCK + j;
-            }
-        }
-      while (++j < CONFIG_NFILE_DESCRIPTORS_PER_BLOCK);
-
-      j = 0;
-    }
-  while (++i < list->fl_rows);
-
-  /* The space of file array isn't enough, allocate a new filechunk */
-
-  ret = files_extend(list, i + 1);
+  fd = files_findfree(list, minfd);
+  ret = files_extend(list, fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK + 1);
   if (ret >= 0)
     {
-      list->fl_files[i][0].f_oflags = oflags;
-      list->fl_files[i][0].f_pos    = pos;
-      list->fl_files[i][0].f_inode  = inode;
-      list->fl_files[i][0].f_priv   = priv;
-      ret = i * CONFIG_NFILE_DESCRIPTORS_PER_BLOCK;
+      filep = &list->fl_files[fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
+                             [fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK];
+      filep->f_oflags = oflags;
+      filep->f_pos    = pos;
+      filep->f_inode  = inode;
+      filep->f_priv   = priv;
+      FILES_SETFD(list, fd);
+      ret = fd;
     }
 
   _files_semgive(list);
@@ -303,6 +399,8 @@ int files_duplist(FAR struct filelist *plist, FAR struct filelist *clist)
             {
               goto out;
             }
+
+          FILES_SETFD(clist, i * CONFIG_NFILE_DESCRIPTORS_PER_BLOCK + j);
         }
     }
 
@@ -331,7 +429,7 @@ out:
 int fs_getfilep(int fd, FAR struct file **filep)
 {
   FAR struct filelist *list;
-  int ret;
+  uint8_t rows;
 
   DEBUGASSERT(filep != NULL);
   *filep = (FAR struct file *)NULL;
@@ -350,26 +448,24 @@ int fs_getfilep(int fd, FAR struct file **filep)
       return -EAGAIN;
     }
 
-  if ((unsigned int)fd >= CONFIG_NFILE_DESCRIPTORS_PER_BLOCK * list->fl_rows)
-    {
-      return -EBADF;
-    }
-
-  /* The descriptor is in a valid range to file descriptor... Get the
-   * thread-specific file list.
+  /* No semaphore is needed:  Rows are never freed while the list exists
+   * and files_extend() publishes the array of rows before the row count.
+   * So any row count read here is covered by the array read after it.
    */
 
-  /* And return the file pointer from the list */
+  rows = FILES_ROWS(list);
+  SP_DMB();
 
-  ret = _files_semtake(list);
-  if (ret >= 0)
+  if ((unsigned int)fd >= CONFIG_NFILE_DESCRIPTORS_PER_BLOCK * rows)
     {
-      *filep = &list->fl_files[fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
-                              [fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK];
-      _files_semgive(list);
+      return -EBADF;
     }
 
-  return ret;
+  /* And return the file pointer from the list */
+
+  *filep = &FILES_ARRAY(list)[fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
+                             [fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK];
+  return OK;
 }
 
 /****************************************************************************
@@ -393,6 +489,7 @@ int fs_getfilep(int fd, FAR struct file **filep)
 int nx_dup2(int fd1, int fd2)
 {
   FAR struct filelist *list;
+  FAR struct file *filep2;
   int ret;
 
   /* Get the file descriptor list.  It should not be NULL in this context. */
@@ -426,10 +523,23 @@ int nx_dup2(int fd1, int fd2)
 
   /* Perform the dup2 operation */
 
+  filep2 = &list->fl_files[fd2 / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
+                          [fd2 % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK];
   ret = file_dup2(&list->fl_files[fd1 / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
                                  [fd1 % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK],
-                  &list->fl_files[fd2 / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]
-                                 [fd2 % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK]);
+                  filep2);
+
+  /* fd2 was closed first and may be left closed on failure */
+
+  if (filep2->f_inode != NULL)
+    {
+      FILES_SETFD(list, fd2);
+    }
+  else
+    {
+      FILES_CLRFD(list, fd2);
+    }
+
   _files_semgive(list);
 
   return ret < 0 ? ret : fd2;
@@ -516,6 +626,7 @@ int nx_close(int fd)
                          [fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK];
   memcpy(&file, filep, sizeof(struct file));
   memset(filep, 0,     sizeof(struct file));
+  FILES_CLRFD(list, fd);
 
   _files_semgive(list);
 
@@ -28,6 +28,7 @@
 #include <assert.h>
 #include <errno.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/semaphore.h>
 
@@ -56,6 +57,11 @@ struct inode_sem_s
   sem_t   sem;     /* The semaphore */
   pid_t   holder;  /* The current holder of the semaphore */
   int16_t count;   /* Number of counts held */
+#ifdef CONFIG_FS_INODE_RWLOCK
+  int16_t readers; /* Number of readers in the tree */
+  bool    waiting; /* True: The holder waits for the readers to leave */
+  sem_t   rdsem;   /* Wakes up the holder when the last reader leaves */
+#endif
 };
 
 /****************************************************************************
@@ -87,6 +93,15 @@ void inode_initialize(void)
   g_inode_sem.holder = NO_HOLDER;
   g_inode_sem.count  = 0;
 
+#ifdef CONFIG_FS_INODE_RWLOCK
+  /* rdsem is used for signaling and, hence, should not have priority
+   * inheritance enabled.
+   */
+
+  nxsem_init(&g_inode_sem.rdsem, 0, 0);
+  nxsem_set_protocol(&g_inode_sem.rdsem, SEM_PRIO_NONE);
+#endif
+
   /* Reserve the root node */
 
   inode_root_reserve();
@@ -123,6 +138,23 @@ int inode_semtake(void)
       ret = nxsem_wait_uninterruptible(&g_inode_sem.sem);
       if (ret >= 0)
         {
+#ifdef CONFIG_FS_INODE_RWLOCK
+          irqstate_t flags;
+
+          /* No new readers can enter now.  Wait for those still searching
+           * the tree to leave.
+           */
+
+          flags = enter_critical_section();
+          while (g_inode_sem.readers > 0)
+            {
+              g_inode_sem.waiting = true;
+              nxsem_wait_uninterruptible(&g_inode_sem.rdsem);
+            }
+
+          leave_critical_section(flags);
+#endif
+
           /* No we hold the semaphore */
 
           g_inode_sem.holder = me;
@@ -163,3 +195,86 @@ void inode_semgive(void)
       nxsem_post(&g_inode_sem.sem);
     }
 }
+
+#ifdef CONFIG_FS_INODE_RWLOCK
+/****************************************************************************
+ * Name: inode_rdtake
+ *
+ * Description:
+ *   Get shared, read-only access to the in-memory inode tree.  Any number
+ *   of readers may search the tree concurrently, but the tree must not be
+ *   modified and inode_semtake() must not be called while the read access
+ *   is held.  If the caller already holds exclusive access, this simply
+ *   nests.
+ *
+ ****************************************************************************/
+
+int inode_rdtake(void)
+{
+  irqstate_t flags;
+  int ret;
+
+  /* Do we already hold the semaphore exclusively? */
+
+  if (getpid() == g_inode_sem.holder)
+    {
+      /* Yes... just increment the count */
+
+      g_inode_sem.count++;
+      DEBUGASSERT(g_inode_sem.count > 0);
+      return OK;
+    }
+
+  /* Wait until no one holds the tree exclusively, then register as a
+   * reader.  The semaphore is held only long enough to do that.
+   */
+
+  ret = nxsem_wait_uninterruptible(&g_inode_sem.sem);
+  if (ret >= 0)
+    {
+      flags = enter_critical_section();
+      g_inode_sem.readers++;
+      DEBUGASSERT(g_inode_sem.readers > 0);
+      leave_critical_section(flags);
+
+      nxsem_post(&g_inode_sem.sem);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: inode_rdgive
+ *
+ * Description:
+ *   Relinquish read-only access to the in-memory inode tree.
+ *
+ ****************************************************************************/
+
+void inode_rdgive(void)
+{
+  irqstate_t flags;
+
+  /* Nested in exclusive access? */
+
+  if (getpid() == g_inode_sem.holder)
+    {
+      inode_semgive();
+      return;
+    }
+
+  /* Wake up the task waiting for exclusive access if this is the last
+   * reader.
+   */
+
+  flags = enter_critical_section();
+  DEBUGASSERT(g_inode_sem.readers > 0);
+  if (--g_inode_sem.readers == 0 && g_inode_sem.waiting)
+    {
+      g_inode_sem.waiting = false;
+      nxsem_post(&g_inode_sem.rdsem);
+    }
+
+  leave_critical_section(flags);
+}
+#endif /* CONFIG_FS_INODE_RWLOCK */
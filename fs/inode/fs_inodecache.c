@@ -0,0 +1,211 @@
+/****************************************************************************
+ * fs/inode/fs_inodecache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/fs/fs.h>
+
+#include "inode/inode.h"
+
+#ifdef CONFIG_FS_INODE_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define INODE_CACHE_MASK (CONFIG_FS_INODE_CACHE_NENTRIES - 1)
+
+#if (CONFIG_FS_INODE_CACHE_NENTRIES & INODE_CACHE_MASK) != 0
+#  error CONFIG_FS_INODE_CACHE_NENTRIES must be a power of two
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One cached path segment lookup.  This remembers the result of searching
+ * the children of 'parent' for 'name':  The matching inode (NULL for a
+ * negative entry) and the inode to its "left" in the ordered list of
+ * peers.
+ */
+
+struct inode_cache_s
+{
+  FAR struct inode *parent;    /* The directory that was searched */
+  FAR struct inode *node;      /* The inode found or NULL */
+  FAR struct inode *peer;      /* Node to the "left" of the name */
+  uint32_t gen;                /* Tree generation of the entry */
+  uint8_t len;                 /* Length of the name */
+  char name[CONFIG_FS_INODE_CACHE_NAMELEN];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct inode_cache_s g_inode_cache[CONFIG_FS_INODE_CACHE_NENTRIES];
+
+/* Every change to the shape of the inode tree starts a new generation.
+ * Entries of older generations are stale.  Zero is never used so that the
+ * zeroed table is empty.
+ */
+
+static uint32_t g_inode_gen = 1;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_hash
+ *
+ * Description:
+ *   Return the length of the path segment 'name' and its hash slot in
+ *   the directory 'parent'.
+ *
+ ****************************************************************************/
+
+static FAR struct inode_cache_s *
+inode_cache_hash(FAR struct inode *parent, FAR const char *name,
+                 FAR size_t *len)
+{
+  uint32_t hash = 2166136261u ^ (uint32_t)(uintptr_t)parent;
+  size_t i;
+
+  for (i = 0; name[i] != '\0' && name[i] != '/'; i++)
+    {
+      hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+
+  *len = i;
+  return &g_inode_cache[(hash ^ (hash >> 16)) & INODE_CACHE_MASK];
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_lookup
+ *
+ * Description:
+ *   Look up the path segment 'name' below 'parent' in the cache.
+ *
+ * Returned Value:
+ *   true if the lookup was cached.  In that case 'node' holds the inode
+ *   found (NULL if the name is known not to exist) and 'peer' holds the
+ *   inode to the "left" of the name.
+ *
+ ****************************************************************************/
+
+bool inode_cache_lookup(FAR struct inode *parent, FAR const char *name,
+                        FAR struct inode **node, FAR struct inode **peer)
+{
+  FAR struct inode_cache_s *entry;
+  irqstate_t flags;
+  bool hit = false;
+  size_t len;
+
+  entry = inode_cache_hash(parent, name, &len);
+
+  /* Concurrent readers of the tree may update the same entry */
+
+  flags = enter_critical_section();
+  if (entry->gen == g_inode_gen && entry->parent == parent &&
+      entry->len == len && memcmp(entry->name, name, len) == 0)
+    {
+      *node = entry->node;
+      *peer = entry->peer;
+      hit   = true;
+    }
+
+  leave_critical_section(flags);
+  return hit;
+}
+
+/****************************************************************************
+ * Name: inode_cache_add
+ *
+ * Description:
+ *   Remember the result of searching for the path segment 'name' below
+ *   'parent'.  Segments longer than CONFIG_FS_INODE_CACHE_NAMELEN are not
+ *   cached.
+ *
+ ****************************************************************************/
+
+void inode_cache_add(FAR struct inode *parent, FAR const char *name,
+                     FAR struct inode *node, FAR struct inode *peer)
+{
+  FAR struct inode_cache_s *entry;
+  irqstate_t flags;
+  size_t len;
+
+  entry = inode_cache_hash(parent, name, &len);
+  if (len > CONFIG_FS_INODE_CACHE_NAMELEN)
+    {
+      return;
+    }
+
+  flags = enter_critical_section();
+  entry->parent = parent;
+  entry->node   = node;
+  entry->peer   = peer;
+  entry->gen    = g_inode_gen;
+  entry->len    = len;
+  memcpy(entry->name, name, len);
+  leave_critical_section(flags);
+}
+
+/****************************************************************************
+ * Name: inode_cache_invalidate
+ *
+ * Description:
+ *   Discard all cached lookups.  This must be called whenever an inode is
+ *   inserted into or removed from the tree.
+ *
+ * Assumptions:
+ *   The caller holds the g_inode_sem semaphore exclusively
+ *
+ ****************************************************************************/
+
+void inode_cache_invalidate(void)
+{
+  irqstate_t flags;
+
+  flags = enter_critical_section();
+  if (++g_inode_gen == 0)
+    {
+      memset(g_inode_cache, 0, sizeof(g_inode_cache));
+      g_inode_gen = 1;
+    }
+
+  leave_critical_section(flags);
+}
+
+#endif /* CONFIG_FS_INODE_CACHE */
@@ -27,6 +27,7 @@
 #include <assert.h>
 #include <errno.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/fs/fs.h>
 
 #include "inode/inode.h"
@@ -55,7 +56,7 @@ int inode_find(FAR struct inode_search_s *desc)
    * references on the node.
    */
 
-  ret = inode_semtake();
+  ret = inode_rdtake();
   if (ret < 0)
     {
       return ret;
@@ -67,13 +68,25 @@ int inode_find(FAR struct inode_search_s *desc)
       /* Found it */
 
       FAR struct inode *node = desc->node;
+#ifdef CONFIG_FS_INODE_RWLOCK
+      irqstate_t flags;
+#endif
+
       DEBUGASSERT(node != NULL);
 
-      /* Increment the reference count on the inode */
+      /* Increment the reference count on the inode.  Other readers may be
+       * doing the same.
+       */
 
+#ifdef CONFIG_FS_INODE_RWLOCK
+      flags = enter_critical_section();
+      node->i_crefs++;
+      leave_critical_section(flags);
+#else
       node->i_crefs++;
+#endif
     }
 
-  inode_semgive();
+  inode_rdgive();
   return ret;
 }
@@ -223,6 +223,9 @@ static int _inode_search(FAR struct inode_search_s *desc)
   FAR struct inode *left    = NULL;
   FAR struct inode *above   = NULL;
   FAR const char   *relpath = NULL;
+#ifdef CONFIG_FS_INODE_CACHE
+  bool scanned = false;
+#endif
   int ret = -ENOENT;
 
   /* Get the search path, skipping over the leading '/'.  The leading '/' is
@@ -275,6 +278,16 @@ static int _inode_search(FAR struct inode_search_s *desc)
 
       else
         {
+#ifdef CONFIG_FS_INODE_CACHE
+          /* Remember where the name was found in the list of peers */
+
+          if (scanned)
+            {
+              inode_cache_add(above, name, node, left);
+              scanned = false;
+            }
+#endif
+
           /* Now there are three remaining possibilities:
            *   (1) This is the node that we are looking for.
            *   (2) The node we are looking for is "below" this one.
@@ -387,10 +400,33 @@ static int _inode_search(FAR struct inode_search_s *desc)
               above = node;
               left  = NULL;
               node  = node->i_child;
+
+#ifdef CONFIG_FS_INODE_CACHE
+              /* Has this name been looked up in this directory before?
+               * If so, go straight to the node (or to the failure) instead
+               * of walking the list of peers.
+               */
+
+              if (!inode_cache_lookup(above, name, &node, &left))
+                {
+                  scanned = true;
+                }
+#endif
             }
         }
     }
 
+#ifdef CONFIG_FS_INODE_CACHE
+  /* Remember that the name does not exist in the directory, and where it
+   * would be inserted.
+   */
+
+  if (node == NULL && scanned)
+    {
+      inode_cache_add(above, name, NULL, left);
+    }
+#endif
+
   /* The node may or may not be null as per one of the following four cases:
    *
    * With node = NULL
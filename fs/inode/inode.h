@@ -166,6 +166,83 @@ int inode_semtake(void);
 
 void inode_semgive(void);
 
+/****************************************************************************
+ * Name: inode_rdtake
+ *
+ * Description:
+ *   Get shared, read-only access to the in-memory inode tree.  Any number
+ *   of readers may search the tree concurrently, but the tree must not be
+ *   modified and inode_semtake() must not be called while the read access
+ *   is held.  If the caller already holds exclusive access, this simply
+ *   nests.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_RWLOCK
+int inode_rdtake(void);
+#else
+#  define inode_rdtake() inode_semtake()
+#endif
+
+/****************************************************************************
+ * Name: inode_rdgive
+ *
+ * Description:
+ *   Relinquish read-only access to the in-memory inode tree.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_RWLOCK
+void inode_rdgive(void);
+#else
+#  define inode_rdgive() inode_semgive()
+#endif
+
+/****************************************************************************
+ * Name: inode_cache_lookup
+ *
+ * Description:
+ *   Look up the path segment 'name' below 'parent' in the cache.
+ *
+ * Returned Value:
+ *   true if the lookup was cached.  In that case 'node' holds the inode
+ *   found (NULL if the name is known not to exist) and 'peer' holds the
+ *   inode to the "left" of the name.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_CACHE
+bool inode_cache_lookup(FAR struct inode *parent, FAR const char *name,
+                        FAR struct inode **node, FAR struct inode **peer);
+
+/****************************************************************************
+ * Name: inode_cache_add
+ *
+ * Description:
+ *   Remember the result of searching for the path segment 'name' below
+ *   'parent'.
+ *
+ ****************************************************************************/
+
+void inode_cache_add(FAR struct inode *parent, FAR const char *name,
+                     FAR struct inode *node, FAR struct inode *peer);
+#endif
+
+/****************************************************************************
+ * Name: inode_cache_invalidate
+ *
+ * Description:
+ *   Discard all cached lookups.  This must be called whenever an inode is
+ *   inserted into or removed from the tree.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_CACHE
+void inode_cache_invalidate(void);
+#else
+#  define inode_cache_invalidate()
+#endif
+
 /****************************************************************************
  * Name: inode_checkflags
  *
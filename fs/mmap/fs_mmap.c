@@ -131,7 +131,7 @@ static int file_mmap_(FAR struct file *filep, FAR void *start,
        * do much better in the KERNEL build using the MMU.
        */
 
-      return rammap(filep, length, offset, kernel, mapped);
+      return rammap(filep, length, offset, prot, flags, kernel, mapped);
 #endif
     }
 
@@ -153,7 +153,7 @@ static int file_mmap_(FAR struct file *filep, FAR void *start,
        * do much better in the KERNEL build using the MMU.
        */
 
-      return rammap(filep, length, offset, kernel, mapped);
+      return rammap(filep, length, offset, prot, flags, kernel, mapped);
 #else
       ferr("ERROR: file_ioctl(FIOC_MMAP) failed: %d\n", ret);
       return ret;
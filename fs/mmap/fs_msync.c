@@ -0,0 +1,147 @@
+/****************************************************************************
+ * fs/mmap/fs_msync.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/cancelpt.h>
+#include <nuttx/fs/fs.h>
+
+#include "inode/inode.h"
+#include "fs_rammap.h"
+
+#ifdef CONFIG_FS_RAMMAP
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: file_msync
+ *
+ * Description:
+ *   Equivalent to the standard msync() function except it does not set
+ *   the errno variable.
+ *
+ ****************************************************************************/
+
+int file_msync(FAR void *start, size_t length, int flags)
+{
+  FAR struct fs_rammap_s *map;
+  int ret;
+
+  if ((flags & (MS_ASYNC | MS_SYNC)) == (MS_ASYNC | MS_SYNC))
+    {
+      return -EINVAL;
+    }
+
+  ret = nxsem_wait(&g_rammaps.exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  map = rammap_find(start, NULL);
+  if (map == NULL)
+    {
+      ferr("ERROR: Region not found\n");
+      ret = -ENOMEM;
+    }
+  else
+    {
+      /* There is no asynchronous write-back; MS_ASYNC is handled like
+       * MS_SYNC.  MS_INVALIDATE is a no-op because every mapping of a file
+       * shares the same region.
+       */
+
+      ret = rammap_writeback(map, start, length);
+#ifndef CONFIG_DISABLE_MOUNTPOINT
+      if (ret >= 0 && (map->flags & RAMMAP_WRITEBACK) != 0)
+        {
+          ret = file_fsync(&map->file);
+          if (ret == -EINVAL)
+            {
+              /* Not a mountpoint or no sync method; nothing more to do */
+
+              ret = OK;
+            }
+        }
+#endif
+    }
+
+  nxsem_post(&g_rammaps.exclsem);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: msync
+ *
+ * Description:
+ *   msync() flushes changes made to a MAP_SHARED file mapping back to the
+ *   file.  Mappings are simulated by copying the file into RAM (see
+ *   fs_rammap.c) and there is no way to tell which bytes were modified, so
+ *   the whole range [start, start + length) that lies within the file is
+ *   written back.  Mappings that are not writable MAP_SHARED mappings are
+ *   not affected.
+ *
+ * Input Parameters:
+ *   start   An address within a region returned by mmap()
+ *   length  The number of bytes to flush
+ *   flags   MS_ASYNC, MS_SYNC and/or MS_INVALIDATE
+ *
+ * Returned Value:
+ *   On success, msync() returns 0, on failure -1, and errno is set:
+ *
+ *     EINVAL
+ *       Both MS_ASYNC and MS_SYNC were specified.
+ *     ENOMEM
+ *       The address does not lie within a mapped region.
+ *
+ ****************************************************************************/
+
+int msync(FAR void *start, size_t length, int flags)
+{
+  int ret;
+
+  /* msync() is a cancellation point */
+
+  enter_cancellation_point();
+
+  ret = file_msync(start, length, flags);
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      ret = ERROR;
+    }
+
+  leave_cancellation_point();
+  return ret;
+}
+
+#endif /* CONFIG_FS_RAMMAP */
@@ -60,27 +60,44 @@ static int file_munmap_(FAR void *start, size_t length, bool kernel)
 
   /* Search the list of regions */
 
-  for (prev = NULL, curr = g_rammaps.head; curr;
-       prev = curr, curr = curr->flink)
-    {
-      /* Does this region include any part of the specified range? */
-
-      if ((uintptr_t)start < (uintptr_t)curr->addr + curr->length &&
-          (uintptr_t)start + length >= (uintptr_t)curr->addr)
-        {
-          break;
-        }
-    }
+  curr = rammap_find(start, &prev);
 
   /* Did we find the region */
 
-  if (!curr)
+  if (!curr || ((curr->flags & RAMMAP_KERNEL) != 0) != kernel)
     {
       ferr("ERROR: Region not found\n");
       ret = -EINVAL;
       goto errout_with_semaphore;
     }
 
+  /* Is the region shared with other mappings of the same file?  Every
+   * mapping of a shared region covers the whole region, so it can only be
+   * unmapped whole.  Only a mapping that the caller actually holds is
+   * dropped, so unmapping the same mapping twice cannot release a region
+   * that is still in use by another mapping.
+   */
+
+  if (curr->crefs > 1)
+    {
+      if (start != curr->addr || length < curr->length)
+        {
+          ferr("ERROR: Cannot partially unmap a shared region\n");
+          ret = -ENOSYS;
+          goto errout_with_semaphore;
+        }
+
+      ret = rammap_unshare(curr);
+      if (ret < 0)
+        {
+          ferr("ERROR: Region not mapped by the caller\n");
+          goto errout_with_semaphore;
+        }
+
+      ret = rammap_writeback(curr, start, curr->length);
+      goto errout_with_semaphore;
+    }
+
   /* Get the offset from the beginning of the region and the actual number
    * of bytes to "unmap".  All mappings must extend to the end of the region.
    * There is no support for free a block of memory but leaving a block of
@@ -106,7 +123,16 @@ static int file_munmap_(FAR void *start, size_t length, bool kernel)
 
   if (length >= curr->length)
     {
-      /* Yes.. remove the mapping from the list */
+      /* Yes.. the last mapping must belong to the caller too */
+
+      ret = rammap_unshare(curr);
+      if (ret < 0)
+        {
+          ferr("ERROR: Region not mapped by the caller\n");
+          goto errout_with_semaphore;
+        }
+
+      /* Remove the mapping from the list */
 
       if (prev)
         {
@@ -117,16 +143,9 @@ static int file_munmap_(FAR void *start, size_t length, bool kernel)
           g_rammaps.head = curr->flink;
         }
 
-      /* Then free the region */
+      /* Then write back and free the region */
 
-      if (kernel)
-        {
-          kmm_free(curr);
-        }
-      else
-        {
-          kumm_free(curr);
-        }
+      ret = rammap_release(curr);
     }
 
   /* No.. We have been asked to "unmap' only a portion of the memory
@@ -135,24 +154,30 @@ static int file_munmap_(FAR void *start, size_t length, bool kernel)
 
   else
     {
-      if (kernel)
+      /* Write back the part being unmapped before it is lost */
+
+      ret = rammap_writeback(curr, start, length);
+
+      if ((curr->flags & RAMMAP_KERNEL) != 0)
         {
-          newaddr = kmm_realloc(curr->addr,
-                               sizeof(struct fs_rammap_s) + length);
+          newaddr = kmm_realloc(curr,
+                                sizeof(struct fs_rammap_s) + offset);
         }
       else
         {
-          newaddr = kumm_realloc(curr->addr,
-                                sizeof(struct fs_rammap_s) + length);
+          newaddr = kumm_realloc(curr,
+                                 sizeof(struct fs_rammap_s) + offset);
         }
 
-      DEBUGASSERT(newaddr == (FAR void *)(curr->addr));
+      DEBUGASSERT(newaddr == (FAR void *)curr);
       UNUSED(newaddr); /* May not be used */
-      curr->length = length;
-    }
+      curr->length = offset;
 
-  nxsem_post(&g_rammaps.exclsem);
-  return OK;
+      if (curr->valid > offset)
+        {
+          curr->valid = offset;
+        }
+    }
 
 errout_with_semaphore:
   nxsem_post(&g_rammaps.exclsem);
@@ -215,7 +240,8 @@ int file_munmap(FAR void *start, size_t length)
  *   2. If CONFIG_FS_RAMMAP is defined in the configuration, then mmap() will
  *      support simulation of memory mapped files by copying files whole
  *      into RAM.  munmap() is required in this case to free the allocated
- *      memory holding the shared copy of the file.
+ *      memory holding the shared copy of the file.  Writable MAP_SHARED
+ *      mappings are written back to the file when they are unmapped.
  *
  * Input Parameters:
  *   start   The start address of the mapping to delete.  For this
@@ -28,12 +28,14 @@
 #include <sys/mman.h>
 
 #include <string.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <debug.h>
 
 #include <nuttx/fs/fs.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/sched.h>
 
 #include "inode/inode.h"
 #include "fs_rammap.h"
@@ -51,6 +53,178 @@ struct fs_allmaps_s g_rammaps =
   SEM_INITIALIZER(1)
 };
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: rammap_share
+ *
+ * Description:
+ *   Look for an existing MAP_SHARED region of the same file with exactly
+ *   the requested range.  Only exact matches are shared so that every
+ *   mapping of a region can be unmapped in the same way as the mapping
+ *   that created it.  Kernel and user regions are never shared with each
+ *   other because they live in different heaps.  The caller must hold
+ *   g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+static FAR struct fs_rammap_s *rammap_share(FAR struct file *filep,
+                                            size_t length, off_t offset,
+                                            bool kernel)
+{
+  FAR struct fs_rammap_s *map;
+  uint8_t kflag = kernel ? RAMMAP_KERNEL : 0;
+
+  for (map = g_rammaps.head; map; map = map->flink)
+    {
+      if (map->inode == filep->f_inode &&
+          (map->flags & (RAMMAP_SHARED | RAMMAP_KERNEL)) ==
+          (RAMMAP_SHARED | kflag) &&
+          map->crefs < UINT16_MAX &&
+          offset == map->offset && length == map->length)
+        {
+          return map;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: rammap_ownerid
+ *
+ * Description:
+ *   Return the ID of the task group of the caller.  Mappings belong to the
+ *   task group so that any thread of the group may unmap them.
+ *
+ ****************************************************************************/
+
+static pid_t rammap_ownerid(void)
+{
+  FAR struct tcb_s *rtcb = nxsched_self();
+
+  return rtcb->group != NULL ? rtcb->group->tg_pid : rtcb->pid;
+}
+
+/****************************************************************************
+ * Name: rammap_addshare
+ *
+ * Description:
+ *   Record a new mapping of a region by the calling task group.  The caller
+ *   must hold g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+static int rammap_addshare(FAR struct fs_rammap_s *map)
+{
+  FAR struct rammap_user_s *user;
+
+  user = kmm_malloc(sizeof(struct rammap_user_s));
+  if (user == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  user->pid   = rammap_ownerid();
+  user->flink = map->users;
+  map->users  = user;
+  map->crefs++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: rammap_load
+ *
+ * Description:
+ *   Read the mapped range of the file into the region.  Returns the number
+ *   of bytes read from the file.  Memory beyond the end of file is zeroed.
+ *
+ ****************************************************************************/
+
+static ssize_t rammap_load(FAR struct file *filep,
+                           FAR struct fs_rammap_s *map)
+{
+  FAR uint8_t *rdbuffer;
+  size_t length;
+  ssize_t nread;
+  off_t fpos;
+
+  /* Seek to the specified file offset */
+
+  fpos = file_seek(filep, map->offset, SEEK_SET);
+  if (fpos < 0)
+    {
+      /* Seek failed... errno has already been set, but EINVAL is probably
+       * the correct response.
+       */
+
+      ferr("ERROR: Seek to position %d failed\n", (int)map->offset);
+      return fpos;
+    }
+
+  /* Read the file data into the memory region */
+
+  rdbuffer = map->addr;
+  length   = map->length;
+
+  while (length > 0)
+    {
+      nread = file_read(filep, rdbuffer, length);
+      if (nread < 0)
+        {
+          /* Handle the special case where the read was interrupted by a
+           * signal.
+           */
+
+          if (nread != -EINTR)
+            {
+              /* All other read errors are bad. */
+
+              ferr("ERROR: Read failed: offset=%d ret=%d\n",
+                   (int)map->offset, (int)nread);
+              return nread;
+            }
+
+          continue;
+        }
+
+      /* Check for end of file. */
+
+      if (nread == 0)
+        {
+          break;
+        }
+
+      /* Increment number of bytes read */
+
+      rdbuffer += nread;
+      length   -= nread;
+    }
+
+  /* Zero any memory beyond the amount read from the file */
+
+  memset(rdbuffer, 0, length);
+  return map->length - length;
+}
+
+/****************************************************************************
+ * Name: rammap_free
+ ****************************************************************************/
+
+static void rammap_free(FAR struct fs_rammap_s *map)
+{
+  if ((map->flags & RAMMAP_KERNEL) != 0)
+    {
+      kmm_free(map);
+    }
+  else
+    {
+      kumm_free(map);
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -60,12 +234,17 @@ struct fs_allmaps_s g_rammaps =
  *
  * Description:
  *   Support simulation of memory mapped files by copying files into RAM.
+ *   A MAP_SHARED request for exactly the same range of the same file as an
+ *   existing MAP_SHARED region returns that region instead of making a new
+ *   copy.
  *
  * Input Parameters:
  *   filep   file descriptor of the backing file -- required.
  *   length  The length of the mapping.  For exception #1 above, this length
  *           ignored:  The entire underlying media is always accessible.
  *   offset  The offset into the file to map
+ *   prot    The PROT_* protections requested for the mapping
+ *   flags   The MAP_* flags requested for the mapping
  *   kernel  kmm_zalloc or kumm_zalloc
  *   mapped  The pointer to the mapped area
  *
@@ -81,29 +260,69 @@ struct fs_allmaps_s g_rammaps =
  *
  ****************************************************************************/
 
-int rammap(FAR struct file *filep, size_t length,
-           off_t offset, bool kernel, FAR void **mapped)
+int rammap(FAR struct file *filep, size_t length, off_t offset,
+           int prot, int flags, bool kernel, FAR void **mapped)
 {
   FAR struct fs_rammap_s *map;
   FAR uint8_t *alloc;
-  FAR uint8_t *rdbuffer;
+  bool shared;
+  bool writeback;
   ssize_t nread;
-  off_t fpos;
   int ret;
 
-  /* There is a major design flaw that I have not yet thought of fix for:
-   * The goal is to have a single region of memory that represents a single
-   * file and can be shared by many threads.  That is, given a filename a
-   * thread should be able to open the file, get a file descriptor, and
-   * call mmap() to get a memory region.  Different file descriptors opened
-   * with the same file path should get the same memory region when mapped.
-   *
-   * The design flaw is that I don't have sufficient knowledge to know that
-   * these different file descriptors map to the same file.  So, for the time
-   * being, a new memory region is created each time that rammap() is called.
-   * Not very useful!
+  /* Only MAP_SHARED mappings may share a region.  Modifications to a
+   * writable MAP_SHARED mapping are also written back to the file if the
+   * file was opened for writing.
+   */
+
+  shared    = (flags & MAP_SHARED) != 0 && (flags & MAP_PRIVATE) == 0;
+  writeback = shared && (prot & PROT_WRITE) != 0 &&
+              (filep->f_oflags & O_WROK) != 0;
+
+  /* Hold the list locked while the region is looked up and loaded so that
+   * concurrent mappings of the same file cannot create duplicate copies.
    */
 
+  ret = nxsem_wait(&g_rammaps.exclsem);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (shared)
+    {
+      map = rammap_share(filep, length, offset, kernel);
+      if (map != NULL)
+        {
+          /* Upgrade a read-only region if this mapping needs write-back */
+
+          if (writeback && (map->flags & RAMMAP_WRITEBACK) == 0)
+            {
+              ret = file_dup2(filep, &map->file);
+              if (ret < 0)
+                {
+                  goto errout_with_semaphore;
+                }
+
+              map->flags |= RAMMAP_WRITEBACK;
+            }
+
+          ret = rammap_addshare(map);
+          if (ret < 0)
+            {
+              goto errout_with_semaphore;
+            }
+
+          nxsem_post(&g_rammaps.exclsem);
+
+          finfo("Sharing region %p offset=%d crefs=%d\n",
+                map->addr, (int)map->offset, map->crefs);
+
+          *mapped = map->addr;
+          return OK;
+        }
+    }
+
   /* Allocate a region of memory of the specified size */
 
   alloc = kernel ?
@@ -112,7 +331,8 @@ int rammap(FAR struct file *filep, size_t length,
   if (!alloc)
     {
       ferr("ERROR: Region allocation failed, length: %d\n", (int)length);
-      return -ENOMEM;
+      ret = -ENOMEM;
+      goto errout_with_semaphore;
     }
 
   /* Initialize the region */
@@ -122,87 +342,240 @@ int rammap(FAR struct file *filep, size_t length,
   map->addr   = alloc + sizeof(struct fs_rammap_s);
   map->length = length;
   map->offset = offset;
+  map->flags  = kernel ? RAMMAP_KERNEL : 0;
 
-  /* Seek to the specified file offset */
+  /* Read the mapped range of the file into memory */
 
-  fpos = file_seek(filep, offset, SEEK_SET);
-  if (fpos < 0)
+  nread = rammap_load(filep, map);
+  if (nread < 0)
     {
-      /* Seek failed... errno has already been set, but EINVAL is probably
-       * the correct response.
-       */
+      ret = nread;
+      goto errout_with_region;
+    }
+
+  map->valid = nread;
+
+  /* Hold a reference to the inode so that it cannot be freed (and its
+   * address re-used for a different file) while the region exists.
+   */
 
-      ferr("ERROR: Seek to position %d failed\n", (int)offset);
-      ret = fpos;
+  ret = inode_addref(filep->f_inode);
+  if (ret < 0)
+    {
       goto errout_with_region;
     }
 
-  /* Read the file data into the memory region */
+  map->inode = filep->f_inode;
 
-  rdbuffer = map->addr;
-  while (length > 0)
+  if (writeback)
     {
-      nread = file_read(filep, rdbuffer, length);
-      if (nread < 0)
+      ret = file_dup2(filep, &map->file);
+      if (ret < 0)
         {
-          /* Handle the special case where the read was interrupted by a
-           * signal.
-           */
-
-          if (nread != -EINTR)
-            {
-              /* All other read errors are bad. */
+          goto errout_with_inode;
+        }
 
-              ferr("ERROR: Read failed: offset=%d ret=%d\n",
-                   (int)offset, (int)nread);
+      map->flags |= RAMMAP_WRITEBACK;
+    }
 
-              ret = nread;
-              goto errout_with_region;
-            }
+  ret = rammap_addshare(map);
+  if (ret < 0)
+    {
+      if (writeback)
+        {
+          file_close(&map->file);
         }
 
-      /* Check for end of file. */
+      goto errout_with_inode;
+    }
 
-      if (nread == 0)
+  if (shared)
+    {
+      map->flags |= RAMMAP_SHARED;
+    }
+
+  /* Add the buffer to the list of regions */
+
+  map->flink = g_rammaps.head;
+  g_rammaps.head = map;
+
+  nxsem_post(&g_rammaps.exclsem);
+  *mapped = map->addr;
+  return OK;
+
+errout_with_inode:
+  inode_release(map->inode);
+
+errout_with_region:
+  rammap_free(map);
+
+errout_with_semaphore:
+  nxsem_post(&g_rammaps.exclsem);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: rammap_find
+ *
+ * Description:
+ *   Find the region that contains the address 'start'.  The caller must
+ *   hold g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+FAR struct fs_rammap_s *rammap_find(FAR const void *start,
+                                    FAR struct fs_rammap_s **prev)
+{
+  FAR struct fs_rammap_s *before;
+  FAR struct fs_rammap_s *curr;
+
+  for (before = NULL, curr = g_rammaps.head; curr;
+       before = curr, curr = curr->flink)
+    {
+      if ((uintptr_t)start >= (uintptr_t)curr->addr &&
+          (uintptr_t)start <  (uintptr_t)curr->addr + curr->length)
         {
           break;
         }
+    }
 
-      /* Increment number of bytes read */
+  if (prev != NULL)
+    {
+      *prev = before;
+    }
 
-      rdbuffer += nread;
-      length   -= nread;
+  return curr;
+}
+
+/****************************************************************************
+ * Name: rammap_unshare
+ *
+ * Description:
+ *   Remove one mapping owned by the calling task group from a region.  The
+ *   caller must hold g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+int rammap_unshare(FAR struct fs_rammap_s *map)
+{
+  FAR struct rammap_user_s **pprev;
+  FAR struct rammap_user_s *user;
+  pid_t pid = rammap_ownerid();
+
+  for (pprev = &map->users; (user = *pprev) != NULL; pprev = &user->flink)
+    {
+      if (user->pid == pid)
+        {
+          *pprev = user->flink;
+          kmm_free(user);
+          map->crefs--;
+          return OK;
+        }
     }
 
-  /* Zero any memory beyond the amount read from the file */
+  return -EINVAL;
+}
 
-  memset(rdbuffer, 0, length);
+/****************************************************************************
+ * Name: rammap_writeback
+ *
+ * Description:
+ *   Write the modified contents of a region back to the backing file.  The
+ *   caller must hold g_rammaps.exclsem.
+ *
+ ****************************************************************************/
 
-  /* Add the buffer to the list of regions */
+int rammap_writeback(FAR struct fs_rammap_s *map, FAR const void *start,
+                     size_t length)
+{
+  FAR const uint8_t *wrbuffer;
+  size_t offset;
+  ssize_t nwritten;
 
-  ret = nxsem_wait(&g_rammaps.exclsem);
-  if (ret < 0)
+  if ((map->flags & RAMMAP_WRITEBACK) == 0)
     {
-      goto errout_with_region;
+      return OK;
     }
 
-  map->flink = g_rammaps.head;
-  g_rammaps.head = map;
+  /* Clip the range to the part of the region that is backed by the file.
+   * Like a real mapping, stores beyond the end of file are not written.
+   */
+
+  offset = (FAR const uint8_t *)start - (FAR const uint8_t *)map->addr;
+  if (offset >= map->valid)
+    {
+      return OK;
+    }
+
+  if (length > map->valid - offset)
+    {
+      length = map->valid - offset;
+    }
+
+  wrbuffer = (FAR const uint8_t *)start;
+  while (length > 0)
+    {
+      nwritten = file_pwrite(&map->file, wrbuffer, length,
+                             map->offset + offset);
+      if (nwritten < 0)
+        {
+          if (nwritten != -EINTR)
+            {
+              ferr("ERROR: Write-back failed: offset=%d ret=%d\n",
+                   (int)(map->offset + offset), (int)nwritten);
+              return nwritten;
+            }
+
+          continue;
+        }
+
+      /* A zero length write would never finish; the media is full */
+
+      if (nwritten == 0)
+        {
+          ferr("ERROR: Write-back made no progress: offset=%d\n",
+               (int)(map->offset + offset));
+          return -ENOSPC;
+        }
+
+      wrbuffer += nwritten;
+      offset   += nwritten;
+      length   -= nwritten;
+    }
 
-  nxsem_post(&g_rammaps.exclsem);
-  *mapped = map->addr;
   return OK;
+}
 
-errout_with_region:
-  if (kernel)
+/****************************************************************************
+ * Name: rammap_release
+ *
+ * Description:
+ *   Write back (if needed) and free a region that has been removed from the
+ *   list of regions.
+ *
+ ****************************************************************************/
+
+int rammap_release(FAR struct fs_rammap_s *map)
+{
+  int ret;
+
+  ret = rammap_writeback(map, map->addr, map->length);
+
+  if ((map->flags & RAMMAP_WRITEBACK) != 0)
     {
-      kmm_free(alloc);
+      file_close(&map->file);
     }
-  else
+
+  while (map->users != NULL)
     {
-      kumm_free(alloc);
+      FAR struct rammap_user_s *user = map->users;
+
+      map->users = user->flink;
+      kmm_free(user);
     }
 
+  inode_release(map->inode);
+  rammap_free(map);
   return ret;
 }
 
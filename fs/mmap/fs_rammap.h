@@ -28,28 +28,58 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
+
+#include <nuttx/fs/fs.h>
 #include <nuttx/semaphore.h>
 
 #ifdef CONFIG_FS_RAMMAP
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Values for the fs_rammap_s flags field */
+
+#define RAMMAP_KERNEL     (1 << 0) /* Region allocated from the kernel heap */
+#define RAMMAP_SHARED     (1 << 1) /* MAP_SHARED region, may be re-used */
+#define RAMMAP_WRITEBACK  (1 << 2) /* Modifications are written to the file */
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* Each mmap() call that returns a region is recorded by one of these, so
+ * that munmap() can drop only a reference that the caller actually holds.
+ * Mappings are owned by the task group that created them.
+ */
+
+struct rammap_user_s
+{
+  FAR struct rammap_user_s *flink; /* Next mapping of the same region */
+  pid_t                     pid;   /* Task group that owns the mapping */
+};
+
 /* This structure describes one file that has been copied to memory and
  * managed as a share-able "memory mapped" file.  This functionality is
  * intended to provide a substitute for memory mapped files for architectures
  * that do not have MMUs and, hence, cannot support on demand paging of
  * blocks of a file.
  *
+ * Regions are keyed by the inode of the backing file so that MAP_SHARED
+ * mappings of exactly the same file range share a single copy in memory.
+ * Each mapping of a region is recorded and the region is freed when the
+ * last mapping is unmapped.
+ *
  * This copied file has many of the properties of a standard memory mapped
  * file except:
  *
- * - All of the file must be present in memory.  This limits the size of
- *   files that may be memory mapped (especially on MCUs with no significant
- *   RAM resources).
- * - All mapped files are read-only.  You can write to the in-memory image,
- *   but the file contents will not change.
+ * - The entire mapped range must be present in memory.  This limits the
+ *   size of files that may be memory mapped (especially on MCUs with no
+ *   significant RAM resources).
+ * - There is no way to detect which parts of a region were modified, so a
+ *   writable MAP_SHARED region is written back whole on msync() and when
+ *   the last reference is unmapped.
  * - There are not access privileges.
  */
 
@@ -58,7 +88,13 @@ struct fs_rammap_s
   struct fs_rammap_s *flink;       /* Implements a singly linked list */
   FAR void           *addr;        /* Start of allocated memory */
   size_t              length;      /* Length of region */
+  size_t              valid;       /* Bytes of the region backed by the file */
   off_t               offset;      /* File offset */
+  FAR struct inode   *inode;       /* Inode of the backing file (the key) */
+  struct file         file;        /* Write-back handle (RAMMAP_WRITEBACK) */
+  FAR struct rammap_user_s *users; /* Mappings of the region */
+  uint16_t            crefs;       /* Number of mappings sharing the region */
+  uint8_t             flags;       /* See RAMMAP_* definitions */
 };
 
 /* This structure defines all "mapped" files */
@@ -86,12 +122,17 @@ extern struct fs_allmaps_s g_rammaps;
  *
  * Description:
  *   Support simulation of memory mapped files by copying files into RAM.
+ *   A MAP_SHARED request for exactly the same range of the same file as an
+ *   existing MAP_SHARED region returns that region instead of making a new
+ *   copy.
  *
  * Input Parameters:
  *   filep   file descriptor of the backing file -- required.
  *   length  The length of the mapping.  For exception #1 above, this length
  *           ignored:  The entire underlying media is always accessible.
  *   offset  The offset into the file to map
+ *   prot    The PROT_* protections requested for the mapping
+ *   flags   The MAP_* flags requested for the mapping
  *   kernel  kmm_zalloc or kumm_zalloc
  *   mapped  The pointer to the mapped area
  *
@@ -107,8 +148,86 @@ extern struct fs_allmaps_s g_rammaps;
  *
  ****************************************************************************/
 
-int rammap(FAR struct file *filep, size_t length,
-           off_t offset, bool kernel, FAR void **mapped);
+int rammap(FAR struct file *filep, size_t length, off_t offset,
+           int prot, int flags, bool kernel, FAR void **mapped);
+
+/****************************************************************************
+ * Name: rammap_find
+ *
+ * Description:
+ *   Find the region that contains the address 'start'.  The caller must
+ *   hold g_rammaps.exclsem.
+ *
+ * Input Parameters:
+ *   start   An address inside of a mapped region
+ *   prev    Location to return the previous region in the list (may be
+ *           NULL)
+ *
+ * Returned Value:
+ *   The region containing 'start' or NULL if there is no such region.
+ *
+ ****************************************************************************/
+
+FAR struct fs_rammap_s *rammap_find(FAR const void *start,
+                                    FAR struct fs_rammap_s **prev);
+
+/****************************************************************************
+ * Name: rammap_unshare
+ *
+ * Description:
+ *   Remove one mapping owned by the calling task group from a region.  The
+ *   caller must hold g_rammaps.exclsem.
+ *
+ * Input Parameters:
+ *   map     The region being unmapped
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -EINVAL if the calling task group does not hold
+ *   a mapping of the region (for example, if it was already unmapped).
+ *
+ ****************************************************************************/
+
+int rammap_unshare(FAR struct fs_rammap_s *map);
+
+/****************************************************************************
+ * Name: rammap_writeback
+ *
+ * Description:
+ *   Write the modified contents of a region back to the backing file.  Only
+ *   the part of [start, start + length) that was originally loaded from the
+ *   file is written; the zero fill beyond the end of file is not.  The
+ *   caller must hold g_rammaps.exclsem.
+ *
+ * Input Parameters:
+ *   map     The region to write back
+ *   start   The first address to write back
+ *   length  The number of bytes to write back
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int rammap_writeback(FAR struct fs_rammap_s *map, FAR const void *start,
+                     size_t length);
+
+/****************************************************************************
+ * Name: rammap_release
+ *
+ * Description:
+ *   Write back (if needed) and free a region that has been removed from the
+ *   list of regions.
+ *
+ * Input Parameters:
+ *   map     The region to release
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value if the write-back failed.
+ *   The region is freed in either case.
+ *
+ ****************************************************************************/
+
+int rammap_release(FAR struct fs_rammap_s *map);
 
 #endif /* CONFIG_FS_RAMMAP */
 #endif /* __FS_MMAP_RAMMAP_H */
@@ -170,6 +170,10 @@
 
 #define NXFFS_NERASED             128
 
+/* Size of one entry in the on-FLASH inode index checkpoint */
+
+#define NXFFS_CKPT_ENTRYSIZE      8
+
 /* Quasi-standard definitions */
 
 #ifndef MIN
@@ -218,6 +222,23 @@ struct nxffs_data_s
 };
 #define SIZEOF_NXFFS_DATA_HDR 10
 
+/* This structure defines the header of each block of the on-FLASH inode
+ * index checkpoint.  The header is followed by 'count' packed entries, each
+ * holding the 32-bit FLASH offset of a valid inode header and the 32-bit
+ * hash of its name.
+ */
+
+struct nxffs_ckpt_s
+{
+  uint8_t                   magic[4];  /* 0-3: Magic number for checkpoint */
+  uint8_t                   crc[4];    /* 4-7: CRC32 of header and entries */
+  uint8_t                   seq[2];    /* 8-9: Index of this block */
+  uint8_t                   nblks[2];  /* 10-11: Number of checkpoint blocks */
+  uint8_t                   count[2];  /* 12-13: Number of entries here */
+  uint8_t                   inoffs[4]; /* 14-17: First valid inode offset */
+};
+#define SIZEOF_NXFFS_CKPT_HDR 18
+
 /* This is an in-memory representation of the NXFFS inode as extracted from
  * FLASH and with additional state information.
  */
@@ -269,6 +290,16 @@ struct nxffs_wrfile_s
   uint32_t                  crc;        /* Accumulated data block CRC */
 };
 
+/* One entry in the in-RAM inode index */
+
+#ifdef CONFIG_NXFFS_INDEX
+struct nxffs_index_s
+{
+  off_t                     hoffset;   /* FLASH offset to the inode header */
+  uint32_t                  hash;      /* Hash of the inode name */
+};
+#endif
+
 /* This structure represents the overall state of on NXFFS instance. */
 
 struct nxffs_volume_s
@@ -287,6 +318,16 @@ struct nxffs_volume_s
   FAR struct nxffs_ofile_s *ofiles;    /* A singly-linked list of open files */
   FAR uint8_t              *cache;     /* On cached erase block for general I/O */
   FAR uint8_t              *pack;      /* A full erase block to support packing */
+#ifdef CONFIG_NXFFS_INDEX
+  FAR struct nxffs_index_s *index;     /* Valid inodes, sorted by FLASH offset */
+  uint16_t                  nindex;    /* Number of entries in the index */
+  uint16_t                  maxindex;  /* Allocated size of the index */
+  bool                      idxvalid;  /* True: The index describes the FLASH */
+  bool                      idxdirty;  /* True: Changed since last checkpoint */
+#endif
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  off_t                     ckptblock; /* Valid checkpoint block or -1 */
+#endif
 };
 
 /* This structure describes the state of the blocks on the NXFFS volume */
@@ -321,6 +362,14 @@ extern const uint8_t g_inodemagic[NXFFS_MAGICSIZE];
 
 extern const uint8_t g_datamagic[NXFFS_MAGICSIZE];
 
+/* The magic number that appears that the beginning of each block of the
+ * inode index checkpoint.
+ */
+
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+extern const uint8_t g_ckptmagic[NXFFS_MAGICSIZE];
+#endif
+
 /* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
  * allocated NXFFS volume instance.
  */
@@ -1068,6 +1117,231 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name);
 
 int nxffs_pack(FAR struct nxffs_volume_s *volume);
 
+/****************************************************************************
+ * Name: nxffs_idxinvalidate
+ *
+ * Description:
+ *   Discard the in-RAM inode index.  This must be called whenever inodes
+ *   are moved on the FLASH, as by nxffs_pack() or nxffs_reformat().  The
+ *   index will be rebuilt the next time that it is needed.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_idxinvalidate(FAR struct nxffs_volume_s *volume);
+#else
+#  define nxffs_idxinvalidate(v)
+#endif
+
+#ifdef CONFIG_NXFFS_INDEX
+
+/****************************************************************************
+ * Name: nxffs_idxreset
+ *
+ * Description:
+ *   Empty the in-RAM inode index and mark it valid.  Called before the
+ *   inodes are enumerated by nxffs_limits() or nxffs_idxavail().
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+void nxffs_idxreset(FAR struct nxffs_volume_s *volume);
+
+/****************************************************************************
+ * Name: nxffs_idxadd
+ *
+ * Description:
+ *   Add a valid inode to the in-RAM inode index.  If the index cannot be
+ *   extended, it is invalidated and lookups fall back to scanning FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   entry  - Describes the inode that was found or written
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+void nxffs_idxadd(FAR struct nxffs_volume_s *volume,
+                  FAR const struct nxffs_entry_s *entry);
+
+/****************************************************************************
+ * Name: nxffs_idxremove
+ *
+ * Description:
+ *   Remove a deleted inode from the in-RAM inode index.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - FLASH offset to the inode header
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+void nxffs_idxremove(FAR struct nxffs_volume_s *volume, off_t hoffset);
+
+/****************************************************************************
+ * Name: nxffs_idxavail
+ *
+ * Description:
+ *   Return true if the in-RAM inode index can be used for lookups,
+ *   rebuilding it from FLASH first if it was invalidated.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   True if nxffs_idxfind() and nxffs_idxnext() may be used.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+bool nxffs_idxavail(FAR struct nxffs_volume_s *volume);
+
+/****************************************************************************
+ * Name: nxffs_idxfind
+ *
+ * Description:
+ *   Find the inode with the provided name using the in-RAM inode index.
+ *   Only inodes whose name hash matches are read from FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   name   - The name of the inode to find
+ *   entry  - The location to return information about the inode.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure (-ENOENT if there is no inode
+ *   with this name).
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_idxfind(FAR struct nxffs_volume_s *volume, FAR const char *name,
+                  FAR struct nxffs_entry_s *entry);
+
+/****************************************************************************
+ * Name: nxffs_idxnext
+ *
+ * Description:
+ *   Return the first valid inode at or after the provided FLASH offset
+ *   using the in-RAM inode index.  This is the indexed equivalent of
+ *   nxffs_nextentry().
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   offset - The FLASH memory offset to begin searching.
+ *   entry  - A pointer to memory provided by the caller in which to return
+ *     the inode description.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_idxnext(FAR struct nxffs_volume_s *volume, off_t offset,
+                  FAR struct nxffs_entry_s *entry);
+
+#endif /* CONFIG_NXFFS_INDEX */
+
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+
+/****************************************************************************
+ * Name: nxffs_idxload
+ *
+ * Description:
+ *   Try to restore the in-RAM inode index and the file system limits from
+ *   the checkpoint written by nxffs_idxsave().  The checkpoint is used
+ *   only if it is the last thing written to the FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero if the index, volume->inoffset and volume->froffset were restored.
+ *   Otherwise, a negated errno value is returned and the caller must
+ *   fall back to nxffs_limits().
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_idxload(FAR struct nxffs_volume_s *volume);
+
+/****************************************************************************
+ * Name: nxffs_idxsave
+ *
+ * Description:
+ *   Append a checkpoint of the in-RAM inode index to the FLASH so that the
+ *   next nxffs_initialize() need not scan the volume.  Nothing is written
+ *   if the index has not changed since the last checkpoint.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_idxsave(FAR struct nxffs_volume_s *volume);
+
+/****************************************************************************
+ * Name: nxffs_ckptdiscard
+ *
+ * Description:
+ *   Invalidate the checkpoint found by nxffs_idxload() or written by
+ *   nxffs_idxsave() by programming its magic number.  This must be done
+ *   before the FLASH is modified in any way:  Otherwise, packing could
+ *   leave the stale checkpoint as the last thing on the FLASH and it would
+ *   be trusted at the next initialization.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_ckptdiscard(FAR struct nxffs_volume_s *volume);
+
+#endif /* CONFIG_NXFFS_INDEX_CHECKPOINT */
+
 /****************************************************************************
  * Standard mountpoint operation methods
  *
@@ -98,6 +98,18 @@ int nxffs_wrcache(FAR struct nxffs_volume_s *volume)
 {
   size_t nxfrd;
 
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  int ret;
+
+  /* Any checkpoint on the FLASH is stale once the FLASH is modified */
+
+  ret = nxffs_ckptdiscard(volume);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+#endif
   /* Write the current block from the cache */
 
   nxfrd = MTD_BWRITE(volume->mtd, volume->cblock, 1, volume->cache);
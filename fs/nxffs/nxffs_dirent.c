@@ -120,7 +120,16 @@ int nxffs_readdir(FAR struct inode *mountpt, FAR struct fs_dirent_s *dir)
   /* Read the next inode header from the offset */
 
   offset = dir->u.nxffs.nx_offset;
-  ret = nxffs_nextentry(volume, offset, &entry);
+#ifdef CONFIG_NXFFS_INDEX
+  if (nxffs_idxavail(volume))
+    {
+      ret = nxffs_idxnext(volume, offset, &entry);
+    }
+  else
+#endif
+    {
+      ret = nxffs_nextentry(volume, offset, &entry);
+    }
 
   /* If the read was successful, then handle the reported inode.  Note
    * that when the last inode has been reported, the value -ENOENT will
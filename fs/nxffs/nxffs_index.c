@@ -0,0 +1,999 @@
+/****************************************************************************
+ * fs/nxffs/nxffs_index.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <crc32.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/mtd/mtd.h>
+
+#include "nxffs.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Initial number of entries allocated for the index.  The allocation is
+ * doubled each time that it fills.
+ */
+
+#define NXFFS_INDEX_INITIAL       16
+
+/* The CRC in the checkpoint block header covers everything after the CRC
+ * field itself.
+ */
+
+#define NXFFS_CKPT_CRCSTART       8
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_idxhash
+ *
+ * Description:
+ *   Return the 32-bit FNV-1a hash of an inode name.
+ *
+ ****************************************************************************/
+
+static uint32_t nxffs_idxhash(FAR const char *name)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*name != '\0')
+    {
+      hash ^= (uint8_t)*name++;
+      hash *= 16777619u;
+    }
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxsearch
+ *
+ * Description:
+ *   Return the position of the first index entry whose inode header lies
+ *   at or after the provided FLASH offset.
+ *
+ ****************************************************************************/
+
+static int nxffs_idxsearch(FAR struct nxffs_volume_s *volume, off_t offset)
+{
+  int low  = 0;
+  int high = volume->nindex;
+
+  while (low < high)
+    {
+      int mid = (low + high) >> 1;
+
+      if (volume->index[mid].hoffset < offset)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+
+  return low;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxdelete
+ *
+ * Description:
+ *   Remove the index entry at the provided position.
+ *
+ ****************************************************************************/
+
+static void nxffs_idxdelete(FAR struct nxffs_volume_s *volume, int pos)
+{
+  volume->nindex--;
+  memmove(&volume->index[pos], &volume->index[pos + 1],
+          (volume->nindex - pos) * sizeof(struct nxffs_index_s));
+  volume->idxdirty = true;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxentry
+ *
+ * Description:
+ *   Read the inode described by the index entry at the provided position.
+ *   If there is no longer a valid inode at that FLASH offset (it was
+ *   deleted after the index was restored from a checkpoint), then the
+ *   stale index entry is removed and -ENOENT is returned.
+ *
+ ****************************************************************************/
+
+static int nxffs_idxentry(FAR struct nxffs_volume_s *volume, int pos,
+                          FAR struct nxffs_entry_s *entry)
+{
+  off_t hoffset = volume->index[pos].hoffset;
+  int ret;
+
+  ret = nxffs_nextentry(volume, hoffset, entry);
+  if (ret == OK && entry->hoffset != hoffset)
+    {
+      nxffs_freeentry(entry);
+      ret = -ENOENT;
+    }
+
+  if (ret == -ENOENT)
+    {
+      finfo("Stale index entry at offset %jd\n", (intmax_t)hoffset);
+      nxffs_idxdelete(volume, pos);
+    }
+
+  return ret;
+}
+
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+
+/****************************************************************************
+ * Name: nxffs_ckptper
+ *
+ * Description:
+ *   Return the number of index entries that fit in one checkpoint block.
+ *
+ ****************************************************************************/
+
+static uint16_t nxffs_ckptper(FAR struct nxffs_volume_s *volume)
+{
+  return (volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR -
+          SIZEOF_NXFFS_CKPT_HDR) / NXFFS_CKPT_ENTRYSIZE;
+}
+
+/****************************************************************************
+ * Name: nxffs_ckpterased
+ *
+ * Description:
+ *   Return true if all of the bytes in the buffer are in the erased state.
+ *
+ ****************************************************************************/
+
+static bool nxffs_ckpterased(FAR const uint8_t *buffer, size_t buflen)
+{
+  while (buflen-- > 0)
+    {
+      if (*buffer++ != CONFIG_NXFFS_ERASEDSTATE)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: nxffs_ckptused
+ *
+ * Description:
+ *   Return true if the block in the volume cache holds any data.  Like
+ *   nxffs_limits(), this presumes that a run of NXFFS_NERASED erased bytes
+ *   marks the start of free FLASH.
+ *
+ ****************************************************************************/
+
+static bool nxffs_ckptused(FAR struct nxffs_volume_s *volume)
+{
+  size_t len = MIN(NXFFS_NERASED,
+                   volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR);
+
+  return !nxffs_ckpterased(&volume->cache[SIZEOF_NXFFS_BLOCK_HDR], len);
+}
+
+/****************************************************************************
+ * Name: nxffs_ckptgood
+ *
+ * Description:
+ *   Load the first good block in the range [block, last] into the volume
+ *   cache.  Returns the block number or -1 if there is no good block in the
+ *   range.
+ *
+ ****************************************************************************/
+
+static off_t nxffs_ckptgood(FAR struct nxffs_volume_s *volume, off_t block,
+                            off_t last)
+{
+  for (; block <= last; block++)
+    {
+      if (nxffs_verifyblock(volume, block) == OK)
+        {
+          return block;
+        }
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: nxffs_ckptlast
+ *
+ * Description:
+ *   Find the last block that holds any data.  NXFFS writes the FLASH
+ *   sequentially and packing erases the tail, so the used blocks are
+ *   always followed only by unused blocks and a binary search suffices.
+ *
+ ****************************************************************************/
+
+static off_t nxffs_ckptlast(FAR struct nxffs_volume_s *volume)
+{
+  off_t low  = 0;
+  off_t high = volume->nblocks - 1;
+  off_t last = -1;
+  off_t block;
+
+  while (low <= high)
+    {
+      off_t mid = low + ((high - low) >> 1);
+
+      block = nxffs_ckptgood(volume, mid, high);
+      if (block >= 0 && nxffs_ckptused(volume))
+        {
+          last = block;
+          low  = block + 1;
+        }
+      else
+        {
+          high = mid - 1;
+        }
+    }
+
+  return last;
+}
+
+/****************************************************************************
+ * Name: nxffs_ckptverify
+ *
+ * Description:
+ *   Return the checkpoint header in the volume cache if the cached block
+ *   holds a well-formed checkpoint block; NULL otherwise.
+ *
+ ****************************************************************************/
+
+static FAR struct nxffs_ckpt_s *
+nxffs_ckptverify(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_ckpt_s *ckpt;
+  uint16_t count;
+  size_t len;
+  uint32_t crc;
+
+  ckpt = (FAR struct nxffs_ckpt_s *)&volume->cache[SIZEOF_NXFFS_BLOCK_HDR];
+  if (memcmp(ckpt->magic, g_ckptmagic, NXFFS_MAGICSIZE) != 0)
+    {
+      return NULL;
+    }
+
+  count = nxffs_rdle16(ckpt->count);
+  if (count > nxffs_ckptper(volume))
+    {
+      return NULL;
+    }
+
+  len = SIZEOF_NXFFS_CKPT_HDR + count * NXFFS_CKPT_ENTRYSIZE;
+  crc = crc32((FAR const uint8_t *)ckpt + NXFFS_CKPT_CRCSTART,
+              len - NXFFS_CKPT_CRCSTART);
+  if (crc != nxffs_rdle32(ckpt->crc))
+    {
+      ferr("ERROR: Bad checkpoint CRC in block %jd\n",
+           (intmax_t)volume->cblock);
+      return NULL;
+    }
+
+  return ckpt;
+}
+
+#endif /* CONFIG_NXFFS_INDEX_CHECKPOINT */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_idxinvalidate
+ *
+ * Description:
+ *   Discard the in-RAM inode index.  This must be called whenever inodes
+ *   are moved on the FLASH, as by nxffs_pack() or nxffs_reformat().  The
+ *   index will be rebuilt the next time that it is needed.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxffs_idxinvalidate(FAR struct nxffs_volume_s *volume)
+{
+  volume->nindex   = 0;
+  volume->idxvalid = false;
+  volume->idxdirty = true;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxreset
+ *
+ * Description:
+ *   Empty the in-RAM inode index and mark it valid.  Called before the
+ *   inodes are enumerated by nxffs_limits() or nxffs_idxavail().
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxffs_idxreset(FAR struct nxffs_volume_s *volume)
+{
+  volume->nindex   = 0;
+  volume->idxvalid = true;
+  volume->idxdirty = true;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxadd
+ *
+ * Description:
+ *   Add a valid inode to the in-RAM inode index.  If the index cannot be
+ *   extended, it is invalidated and lookups fall back to scanning FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   entry  - Describes the inode that was found or written
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxffs_idxadd(FAR struct nxffs_volume_s *volume,
+                  FAR const struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_index_s *index;
+  int pos;
+
+  if (!volume->idxvalid)
+    {
+      return;
+    }
+
+  /* Extend the index if it is full */
+
+  if (volume->nindex >= volume->maxindex)
+    {
+      uint32_t maxindex = volume->maxindex ? 2 * (uint32_t)volume->maxindex :
+                          NXFFS_INDEX_INITIAL;
+
+      maxindex = MIN(maxindex, UINT16_MAX);
+      if (maxindex <= volume->nindex)
+        {
+          nxffs_idxinvalidate(volume);
+          return;
+        }
+
+      index = (FAR struct nxffs_index_s *)
+        kmm_realloc(volume->index, maxindex * sizeof(struct nxffs_index_s));
+      if (index == NULL)
+        {
+          fwarn("WARNING: Failed to extend the inode index\n");
+          nxffs_idxinvalidate(volume);
+          return;
+        }
+
+      volume->index    = index;
+      volume->maxindex = maxindex;
+    }
+
+  /* New inodes are normally written after all existing ones, but keep the
+   * index sorted regardless.
+   */
+
+  pos = nxffs_idxsearch(volume, entry->hoffset);
+  if (pos >= volume->nindex || volume->index[pos].hoffset != entry->hoffset)
+    {
+      memmove(&volume->index[pos + 1], &volume->index[pos],
+              (volume->nindex - pos) * sizeof(struct nxffs_index_s));
+      volume->nindex++;
+    }
+
+  volume->index[pos].hoffset = entry->hoffset;
+  volume->index[pos].hash    = nxffs_idxhash(entry->name);
+  volume->idxdirty           = true;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxremove
+ *
+ * Description:
+ *   Remove a deleted inode from the in-RAM inode index.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - FLASH offset to the inode header
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxffs_idxremove(FAR struct nxffs_volume_s *volume, off_t hoffset)
+{
+  int pos;
+
+  if (volume->idxvalid)
+    {
+      pos = nxffs_idxsearch(volume, hoffset);
+      if (pos < volume->nindex && volume->index[pos].hoffset == hoffset)
+        {
+          nxffs_idxdelete(volume, pos);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxffs_idxavail
+ *
+ * Description:
+ *   Return true if the in-RAM inode index can be used for lookups,
+ *   rebuilding it from FLASH first if it was invalidated.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   True if nxffs_idxfind() and nxffs_idxnext() may be used.
+ *
+ ****************************************************************************/
+
+bool nxffs_idxavail(FAR struct nxffs_volume_s *volume)
+{
+  struct nxffs_entry_s entry;
+  off_t offset;
+  int ret;
+
+  if (volume->idxvalid)
+    {
+      return true;
+    }
+
+  /* Walk all of the inodes once, just as nxffs_findinode() would */
+
+  finfo("Rebuilding the inode index\n");
+  nxffs_idxreset(volume);
+
+  offset = volume->inoffset;
+  while ((ret = nxffs_nextentry(volume, offset, &entry)) == OK)
+    {
+      nxffs_idxadd(volume, &entry);
+      offset = nxffs_inodeend(volume, &entry);
+      nxffs_freeentry(&entry);
+    }
+
+  /* -ENOENT just means that the end of the FLASH was reached */
+
+  if (ret != -ENOENT)
+    {
+      ferr("ERROR: Failed to rebuild the inode index: %d\n", -ret);
+      nxffs_idxinvalidate(volume);
+    }
+
+  return volume->idxvalid;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxfind
+ *
+ * Description:
+ *   Find the inode with the provided name using the in-RAM inode index.
+ *   Only inodes whose name hash matches are read from FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   name   - The name of the inode to find
+ *   entry  - The location to return information about the inode.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure (-ENOENT if there is no inode
+ *   with this name).
+ *
+ ****************************************************************************/
+
+int nxffs_idxfind(FAR struct nxffs_volume_s *volume, FAR const char *name,
+                  FAR struct nxffs_entry_s *entry)
+{
+  uint32_t hash = nxffs_idxhash(name);
+  int pos = 0;
+  int ret;
+
+  while (pos < volume->nindex)
+    {
+      if (volume->index[pos].hash != hash)
+        {
+          pos++;
+          continue;
+        }
+
+      /* Read the candidate inode.  On -ENOENT, the stale entry has been
+       * removed and 'pos' now refers to the following entry.
+       */
+
+      ret = nxffs_idxentry(volume, pos, entry);
+      if (ret == -ENOENT)
+        {
+          continue;
+        }
+      else if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Hash collisions are possible; compare the names */
+
+      if (strcmp(name, entry->name) == 0)
+        {
+          return OK;
+        }
+
+      nxffs_freeentry(entry);
+      pos++;
+    }
+
+  finfo("No inode found\n");
+  return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxnext
+ *
+ * Description:
+ *   Return the first valid inode at or after the provided FLASH offset
+ *   using the in-RAM inode index.  This is the indexed equivalent of
+ *   nxffs_nextentry().
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   offset - The FLASH memory offset to begin searching.
+ *   entry  - A pointer to memory provided by the caller in which to return
+ *     the inode description.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_idxnext(FAR struct nxffs_volume_s *volume, off_t offset,
+                  FAR struct nxffs_entry_s *entry)
+{
+  int pos = nxffs_idxsearch(volume, offset);
+  int ret;
+
+  while (pos < volume->nindex)
+    {
+      ret = nxffs_idxentry(volume, pos, entry);
+      if (ret != -ENOENT)
+        {
+          return ret;
+        }
+    }
+
+  return -ENOENT;
+}
+
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+
+/****************************************************************************
+ * Name: nxffs_idxload
+ *
+ * Description:
+ *   Try to restore the in-RAM inode index and the file system limits from
+ *   the checkpoint written by nxffs_idxsave().  The checkpoint is used
+ *   only if it is the last thing written to the FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero if the index, volume->inoffset and volume->froffset were restored.
+ *   Otherwise, a negated errno value is returned and the caller must
+ *   fall back to nxffs_limits().
+ *
+ ****************************************************************************/
+
+int nxffs_idxload(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_index_s *index;
+  FAR struct nxffs_ckpt_s *ckpt;
+  FAR const uint8_t *src;
+  off_t froffset;
+  off_t inoffset;
+  off_t block;
+  off_t last;
+  uint32_t total;
+  uint16_t nblks;
+  uint16_t count;
+  uint16_t per;
+  uint16_t seq;
+  size_t end;
+  int ret;
+  int i;
+
+  /* The checkpoint must be in the last block holding any data */
+
+  last = nxffs_ckptlast(volume);
+  if (last < 0)
+    {
+      finfo("Empty volume\n");
+      return -ENOENT;
+    }
+
+  /* Make sure that the next good block is really unused */
+
+  if (nxffs_ckptgood(volume, last + 1, volume->nblocks - 1) >= 0 &&
+      nxffs_ckptused(volume))
+    {
+      ferr("ERROR: Data follows block %jd\n", (intmax_t)last);
+      return -EINVAL;
+    }
+
+  ret = nxffs_verifyblock(volume, last);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ckpt = nxffs_ckptverify(volume);
+  if (ckpt == NULL)
+    {
+      finfo("No checkpoint in block %jd\n", (intmax_t)last);
+      return -ENOENT;
+    }
+
+  /* Whether or not it is used, this checkpoint must be discarded before
+   * the FLASH is next modified.
+   */
+
+  volume->ckptblock = last;
+
+  /* Nothing may have been written after the checkpoint */
+
+  nblks = nxffs_rdle16(ckpt->nblks);
+  count = nxffs_rdle16(ckpt->count);
+  end   = SIZEOF_NXFFS_BLOCK_HDR + SIZEOF_NXFFS_CKPT_HDR +
+          count * NXFFS_CKPT_ENTRYSIZE;
+
+  if (nblks == 0 || nxffs_rdle16(ckpt->seq) != nblks - 1 ||
+      !nxffs_ckpterased(&volume->cache[end], volume->geo.blocksize - end))
+    {
+      finfo("Checkpoint in block %jd is not current\n", (intmax_t)last);
+      return -ENOENT;
+    }
+
+  per   = nxffs_ckptper(volume);
+  total = (uint32_t)(nblks - 1) * per + count;
+  if (total > UINT16_MAX)
+    {
+      return -EINVAL;
+    }
+
+  froffset = last * volume->geo.blocksize + end;
+  inoffset = nxffs_rdle32(ckpt->inoffs);
+
+  /* Size the index to hold the whole checkpoint */
+
+  nxffs_idxinvalidate(volume);
+  if (total > volume->maxindex)
+    {
+      index = (FAR struct nxffs_index_s *)
+        kmm_realloc(volume->index, total * sizeof(struct nxffs_index_s));
+      if (index == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      volume->index    = index;
+      volume->maxindex = total;
+    }
+
+  /* Then copy the entries, walking the checkpoint blocks backward and
+   * skipping over any bad blocks in between.
+   */
+
+  block = last;
+  seq   = nblks - 1;
+
+  for (; ; )
+    {
+      ckpt = nxffs_ckptverify(volume);
+      if (ckpt == NULL || nxffs_rdle16(ckpt->seq) != seq ||
+          nxffs_rdle16(ckpt->nblks) != nblks)
+        {
+          ferr("ERROR: Checkpoint block %u not found\n", seq);
+          return -EINVAL;
+        }
+
+      count = nxffs_rdle16(ckpt->count);
+      if (seq < nblks - 1 && count != per)
+        {
+          return -EINVAL;
+        }
+
+      src   = (FAR const uint8_t *)ckpt + SIZEOF_NXFFS_CKPT_HDR;
+      index = &volume->index[(uint32_t)seq * per];
+
+      for (i = 0; i < count; i++, src += NXFFS_CKPT_ENTRYSIZE)
+        {
+          index[i].hoffset = nxffs_rdle32(src);
+          index[i].hash    = nxffs_rdle32(src + 4);
+        }
+
+      if (seq == 0)
+        {
+          break;
+        }
+
+      /* Find the preceding good block */
+
+      seq--;
+      do
+        {
+          if (--block < 0)
+            {
+              return -EINVAL;
+            }
+
+          ret = nxffs_verifyblock(volume, block);
+          if (ret == -EIO)
+            {
+              return ret;
+            }
+        }
+      while (ret < 0);
+    }
+
+  /* All indexed inodes must precede the checkpoint, in order */
+
+  index = volume->index;
+  for (i = 0; i < (int)total; i++)
+    {
+      if (index[i].hoffset >= block * volume->geo.blocksize ||
+          (i > 0 && index[i].hoffset <= index[i - 1].hoffset))
+        {
+          ferr("ERROR: Corrupted checkpoint entry %d\n", i);
+          return -EINVAL;
+        }
+    }
+
+  volume->nindex   = total;
+  volume->idxvalid = true;
+  volume->idxdirty = false;
+  volume->inoffset = total > 0 ? inoffset : froffset;
+  volume->froffset = froffset;
+
+  finfo("Restored %u inodes, inoffset: %jd froffset: %jd\n",
+        volume->nindex, (intmax_t)volume->inoffset,
+        (intmax_t)volume->froffset);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxsave
+ *
+ * Description:
+ *   Append a checkpoint of the in-RAM inode index to the FLASH so that the
+ *   next nxffs_initialize() need not scan the volume.  Nothing is written
+ *   if the index has not changed since the last checkpoint.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_idxsave(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_ckpt_s *ckpt;
+  FAR uint8_t *dest;
+  off_t block;
+  uint16_t nblks;
+  uint16_t count;
+  uint16_t per;
+  uint16_t seq;
+  uint32_t crc;
+  size_t len;
+  int pos;
+  int ret;
+  int i;
+
+  if (!volume->idxvalid || !volume->idxdirty)
+    {
+      return OK;
+    }
+
+  per = nxffs_ckptper(volume);
+  if (per == 0)
+    {
+      return -ENOSYS;
+    }
+
+  nblks = (volume->nindex + per - 1) / per;
+  if (nblks == 0)
+    {
+      nblks = 1;
+    }
+
+  /* The checkpoint begins in the first block that holds no data */
+
+  block = volume->froffset / volume->geo.blocksize;
+  if (volume->froffset - block * volume->geo.blocksize >
+      SIZEOF_NXFFS_BLOCK_HDR)
+    {
+      block++;
+    }
+
+  for (seq = 0, pos = 0; seq < nblks; seq++, block++)
+    {
+      ret = nxffs_validblock(volume, &block);
+      if (ret < 0)
+        {
+          ferr("ERROR: No space for checkpoint block %u\n", seq);
+          return ret;
+        }
+
+      len = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR;
+      if (!nxffs_ckpterased(&volume->cache[SIZEOF_NXFFS_BLOCK_HDR], len))
+        {
+          ferr("ERROR: Block %jd is not erased\n", (intmax_t)block);
+          return -EINVAL;
+        }
+
+      /* Build the checkpoint block in the volume cache */
+
+      count = MIN(per, volume->nindex - pos);
+      ckpt  = (FAR struct nxffs_ckpt_s *)
+              &volume->cache[SIZEOF_NXFFS_BLOCK_HDR];
+
+      memcpy(ckpt->magic, g_ckptmagic, NXFFS_MAGICSIZE);
+      nxffs_wrle16(ckpt->seq, seq);
+      nxffs_wrle16(ckpt->nblks, nblks);
+      nxffs_wrle16(ckpt->count, count);
+      nxffs_wrle32(ckpt->inoffs, volume->inoffset);
+
+      dest = (FAR uint8_t *)ckpt + SIZEOF_NXFFS_CKPT_HDR;
+      for (i = 0; i < count; i++, pos++, dest += NXFFS_CKPT_ENTRYSIZE)
+        {
+          nxffs_wrle32(dest, volume->index[pos].hoffset);
+          nxffs_wrle32(dest + 4, volume->index[pos].hash);
+        }
+
+      len = SIZEOF_NXFFS_CKPT_HDR + count * NXFFS_CKPT_ENTRYSIZE;
+      crc = crc32((FAR const uint8_t *)ckpt + NXFFS_CKPT_CRCSTART,
+                  len - NXFFS_CKPT_CRCSTART);
+      nxffs_wrle32(ckpt->crc, crc);
+
+      /* Whether or not the write succeeds, this FLASH is no longer free */
+
+      ret = nxffs_wrcache(volume);
+      volume->froffset = block * volume->geo.blocksize +
+                         SIZEOF_NXFFS_BLOCK_HDR + len;
+      if (ret < 0)
+        {
+          volume->cblock = (off_t)-1;
+          return ret;
+        }
+    }
+
+  volume->idxdirty  = false;
+  volume->ckptblock = block - 1;
+  finfo("Saved %u inodes in %u blocks\n", volume->nindex, nblks);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_ckptdiscard
+ *
+ * Description:
+ *   Invalidate the checkpoint found by nxffs_idxload() or written by
+ *   nxffs_idxsave() by programming its magic number.  Only the last
+ *   checkpoint block needs to be invalidated:  The others are never used
+ *   without it.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_ckptdiscard(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_ckpt_s *ckpt;
+  FAR uint8_t *buffer;
+  off_t block = volume->ckptblock;
+  size_t nxfrd;
+
+  if (block < 0)
+    {
+      return OK;
+    }
+
+  /* Patch the cached copy too, if any, so that a later nxffs_wrcache()
+   * does not write the old magic number back.  Otherwise, use the pack
+   * buffer so that the cache is left undisturbed.
+   */
+
+  if (volume->cblock == block)
+    {
+      buffer = volume->cache;
+    }
+  else
+    {
+      buffer = volume->pack;
+      nxfrd  = MTD_BREAD(volume->mtd, block, 1, buffer);
+      if (nxfrd != 1)
+        {
+          ferr("ERROR: Read block %jd failed: %zu\n", (intmax_t)block,
+               nxfrd);
+          return -EIO;
+        }
+    }
+
+  /* Only bits still in the erased state are programmed */
+
+  ckpt = (FAR struct nxffs_ckpt_s *)&buffer[SIZEOF_NXFFS_BLOCK_HDR];
+  memset(ckpt->magic, ~CONFIG_NXFFS_ERASEDSTATE & 0xff, NXFFS_MAGICSIZE);
+
+  nxfrd = MTD_BWRITE(volume->mtd, block, 1, buffer);
+  if (nxfrd != 1)
+    {
+      ferr("ERROR: Write block %jd failed: %zu\n", (intmax_t)block, nxfrd);
+      return -EIO;
+    }
+
+  volume->ckptblock = (off_t)-1;
+  return OK;
+}
+
+#endif /* CONFIG_NXFFS_INDEX_CHECKPOINT */
@@ -111,6 +111,17 @@ const uint8_t g_datamagic[NXFFS_MAGICSIZE] =
   'D', 'a', 't', 'a'
 };
 
+/* The magic number that appears that the beginning of each block of the
+ * inode index checkpoint.
+ */
+
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+const uint8_t g_ckptmagic[NXFFS_MAGICSIZE] =
+{
+  'C', 'k', 'p', 't'
+};
+#endif
+
 /* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
  * allocated NXFFS volume instance.
  */
@@ -171,6 +182,9 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
 
   volume->mtd    = mtd;
   volume->cblock = (off_t)-1;
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  volume->ckptblock = (off_t)-1;
+#endif
   nxsem_init(&volume->exclsem, 0, 1);
   nxsem_init(&volume->wrsem, 0, 1);
 
@@ -258,6 +272,19 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
     }
 #endif /* CONFIG_NXFFS_SCAN_VOLUME */
 
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  /* If the last thing written to FLASH is an inode index checkpoint, then
+   * the index and the file system limits can be restored without scanning
+   * the whole volume.
+   */
+
+  ret = nxffs_idxload(volume);
+  if (ret == OK)
+    {
+      return OK;
+    }
+#endif
+
   /* Get the file system limits */
 
   ret = nxffs_limits(volume);
@@ -300,6 +327,9 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   ferr("ERROR: Failed to calculate file system limits: %d\n", -ret);
 
 errout_with_buffer:
+#ifdef CONFIG_NXFFS_INDEX
+  kmm_free(volume->index);
+#endif
   kmm_free(volume->pack);
 errout_with_cache:
   kmm_free(volume->cache);
@@ -344,6 +374,12 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
   int nerased;
   int ret;
 
+#ifdef CONFIG_NXFFS_INDEX
+  /* All of the inodes are visited here, so rebuild the inode index too */
+
+  nxffs_idxreset(volume);
+#endif
+
   /* Get the offset to the first valid block on the FLASH */
 
   block = 0;
@@ -387,6 +423,10 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
       volume->inoffset = entry.hoffset;
       finfo("First inode at offset %jd\n", (intmax_t)volume->inoffset);
 
+#ifdef CONFIG_NXFFS_INDEX
+      nxffs_idxadd(volume, &entry);
+#endif
+
       /* Discard this entry and set the next offset. */
 
       offset = nxffs_inodeend(volume, &entry);
@@ -399,6 +439,10 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
     {
       while (nxffs_nextentry(volume, offset, &entry) == OK)
         {
+#ifdef CONFIG_NXFFS_INDEX
+          nxffs_idxadd(volume, &entry);
+#endif
+
           /* Discard the entry and guess the next offset. */
 
           offset = nxffs_inodeend(volume, &entry);
@@ -551,6 +595,10 @@ int nxffs_unbind(FAR void *handle, FAR struct inode **blkdriver,
 #ifndef CONFIG_NXFFS_PREALLOCATED
 #  error "No design to support dynamic allocation of volumes"
 #else
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  int ret;
+
+#endif
   /* This implementation currently only supports unmounting if there are no
    * open file references.
    */
@@ -560,6 +608,23 @@ int nxffs_unbind(FAR void *handle, FAR struct inode **blkdriver,
       return -ENOSYS;
     }
 
-  return g_volume.ofiles ? -EBUSY : OK;
+  if (g_volume.ofiles)
+    {
+      return -EBUSY;
+    }
+
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  /* Leave a checkpoint of the inode index so that the next initialization
+   * need not scan the volume.  This is only an optimization.
+   */
+
+  ret = nxffs_idxsave(&g_volume);
+  if (ret < 0)
+    {
+      fwarn("WARNING: Failed to save the inode index: %d\n", -ret);
+    }
+#endif
+
+  return OK;
 #endif
 }
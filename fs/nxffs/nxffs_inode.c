@@ -369,6 +369,17 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
   off_t offset;
   int ret;
 
+#ifdef CONFIG_NXFFS_INDEX
+  /* Use the in-RAM inode index, if available, so that only the inodes
+   * with a matching name hash need to be read from FLASH.
+   */
+
+  if (nxffs_idxavail(volume))
+    {
+      return nxffs_idxfind(volume, name, entry);
+    }
+#endif
+
   /* Start with the first valid inode that was discovered when the volume
    * was created (or modified after the last file system re-packing).
    */
@@ -1256,6 +1256,14 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
       ferr("ERROR: Failed to write inode header block %jd: %d\n",
            (intmax_t)volume->ioblock, -ret);
     }
+#ifdef CONFIG_NXFFS_INDEX
+  else
+    {
+      /* Only now is there a valid inode header at entry->hoffset */
+
+      nxffs_idxadd(volume, entry);
+    }
+#endif
 
   /* The volume is now available for other writers */
 
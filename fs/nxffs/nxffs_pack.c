@@ -1272,6 +1272,12 @@ int nxffs_pack(FAR struct nxffs_volume_s *volume)
   int i;
   int ret = OK;
 
+  /* Packing moves inodes, so the in-RAM inode index must be rebuilt
+   * afterward.
+   */
+
+  nxffs_idxinvalidate(volume);
+
   /* Get the offset to the first valid inode entry */
 
   wrfile = NULL;
@@ -1392,6 +1398,18 @@ int nxffs_pack(FAR struct nxffs_volume_s *volume)
 
 start_pack:
 
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  /* Packing could leave an older checkpoint as the last thing on the
+   * FLASH.  Discard it before anything is moved.
+   */
+
+  ret = nxffs_ckptdiscard(volume);
+  if (ret < 0)
+    {
+      goto errout_with_pack;
+    }
+
+#endif
   pack.ioblock     = nxffs_getblock(volume, iooffset);
   pack.iooffset    = nxffs_getoffset(volume, iooffset, pack.ioblock);
   volume->froffset = iooffset;
@@ -270,6 +270,13 @@ int nxffs_reformat(FAR struct nxffs_volume_s *volume)
 {
   int ret;
 
+  /* All inodes are lost */
+
+  nxffs_idxinvalidate(volume);
+#ifdef CONFIG_NXFFS_INDEX_CHECKPOINT
+  volume->ckptblock = (off_t)-1;
+#endif
+
   /* Erase and reformat the entire volume */
 
   ret = nxffs_format(volume);
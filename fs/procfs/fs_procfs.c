@@ -77,6 +77,7 @@ extern const struct procfs_operations version_operations;
  * configuration.
  */
 
+extern const struct procfs_operations bcache_procfsoperations;
 extern const struct procfs_operations net_procfsoperations;
 extern const struct procfs_operations net_procfs_routeoperations;
 extern const struct procfs_operations part_procfsoperations;
@@ -124,6 +125,10 @@ static const struct procfs_entry_s g_procfs_entries[] =
   { "modules",       &module_operations,          PROCFS_FILE_TYPE   },
 #endif
 
+#if defined(CONFIG_DRVR_BCACHE) && !defined(CONFIG_FS_PROCFS_EXCLUDE_BCACHE)
+  { "fs/bcache",     &bcache_procfsoperations,    PROCFS_FILE_TYPE   },
+#endif
+
 #ifndef CONFIG_FS_PROCFS_EXCLUDE_BLOCKS
   { "fs/blocks",     &mount_procfsoperations,     PROCFS_FILE_TYPE   },
 #endif
@@ -31,6 +31,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <inttypes.h>
 #include <string.h>
 #include <fcntl.h>
@@ -66,7 +67,12 @@
  * to handle the longest line generated by this logic.
  */
 
-#define STATUS_LINELEN 32
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+#  define STATUS_LINELEN 48
+#  define LATENCY_SHIFT  CONFIG_SCHED_CRITMONITOR_HISTOGRAM_SHIFT
+#else
+#  define STATUS_LINELEN 32
+#endif
 
 /****************************************************************************
  * Private Type Definitions
@@ -86,6 +92,9 @@ enum proc_node_e
 #endif
 #ifdef CONFIG_SCHED_CRITMONITOR
   PROC_CRITMON,                       /* Critical section monitor */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  PROC_LATENCY,                       /* Latency histograms */
 #endif
   PROC_STACK,                         /* Task stack info */
   PROC_GROUP,                         /* Group directory */
@@ -172,6 +181,11 @@ static ssize_t proc_critmon(FAR struct proc_file_s *procfile,
                  FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
                  off_t offset);
 #endif
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+static ssize_t proc_latency(FAR struct proc_file_s *procfile,
+                 FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
+                 off_t offset);
+#endif
 static ssize_t proc_stack(FAR struct proc_file_s *procfile,
                  FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
                  off_t offset);
@@ -268,6 +282,13 @@ static const struct proc_node_s g_critmon =
 };
 #endif
 
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+static const struct proc_node_s g_latency =
+{
+  "latency",       "latency", (uint8_t)PROC_LATENCY,     DTYPE_FILE        /* Latency histograms */
+};
+#endif
+
 static const struct proc_node_s g_stack =
 {
   "stack",        "stack",   (uint8_t)PROC_STACK,        DTYPE_FILE        /* Task stack info */
@@ -307,6 +328,9 @@ static FAR const struct proc_node_s * const g_nodeinfo[] =
 #endif
 #ifdef CONFIG_SCHED_CRITMONITOR
   &g_critmon,      /* Critical section Monitor */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  &g_latency,      /* Latency histograms */
 #endif
   &g_stack,        /* Task stack info */
   &g_group,        /* Group directory */
@@ -330,6 +354,9 @@ static const struct proc_node_s * const g_level0info[] =
 #endif
 #ifdef CONFIG_SCHED_CRITMONITOR
   &g_critmon,      /* Critical section monitor */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  &g_latency,      /* Latency histograms */
 #endif
   &g_stack,        /* Task stack info */
   &g_group,        /* Group directory */
@@ -879,6 +906,98 @@ static ssize_t proc_critmon(FAR struct proc_file_s *procfile,
 }
 #endif
 
+/****************************************************************************
+ * Name: proc_latency
+ *
+ * Description:
+ *   Show the histograms of the wakeup-to-run latency, the time pre-emption
+ *   was disabled and the time spent in critical sections.  Each line gives
+ *   the lower bound of one bucket in nanoseconds and the counts in that
+ *   bucket.  Reading to the end of the file resets the histograms.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+static ssize_t proc_latency(FAR struct proc_file_s *procfile,
+                            FAR struct tcb_s *tcb, FAR char *buffer,
+                            size_t buflen, off_t offset)
+{
+  struct timespec bound;
+  unsigned long nsec;
+  uint64_t units;
+  size_t remaining;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  int i;
+
+  remaining = buflen;
+  totalsize = 0;
+
+  linesize = procfs_snprintf(procfile->line, STATUS_LINELEN,
+                             "%10s %10s %10s %10s\n",
+                             "NSEC", "WAKEUP", "PREEMPT", "CSECTION");
+  copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining,
+                           &offset);
+
+  totalsize += copysize;
+  buffer    += copysize;
+  remaining -= copysize;
+
+  for (i = 0; i < CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS; i++)
+    {
+      if (totalsize >= buflen)
+        {
+          return totalsize;
+        }
+
+      /* Bucket i > 0 starts at 2^(i-1) units of the critmon timer.  The
+       * Kconfig ranges keep the shift below 64, but bounds beyond the
+       * 32-bit timer range cannot be converted.
+       */
+
+      nsec = 0;
+      if (i > 0)
+        {
+          units = UINT64_C(1) << (i - 1 + LATENCY_SHIFT);
+          if (units > UINT32_MAX)
+            {
+              nsec = ULONG_MAX;
+            }
+          else
+            {
+              up_critmon_convert((uint32_t)units, &bound);
+              nsec = bound.tv_sec >= ULONG_MAX / 1000000000 ? ULONG_MAX :
+                     bound.tv_sec * 1000000000ul + bound.tv_nsec;
+            }
+        }
+
+      linesize = procfs_snprintf(procfile->line, STATUS_LINELEN,
+                                 "%10lu %10lu %10lu %10lu\n", nsec,
+                                 (unsigned long)tcb->wake_hist[i],
+                                 (unsigned long)tcb->premp_hist[i],
+                                 (unsigned long)tcb->crit_hist[i]);
+      copysize = procfs_memcpy(procfile->line, linesize, buffer, remaining,
+                               &offset);
+
+      totalsize += copysize;
+      buffer    += copysize;
+      remaining -= copysize;
+    }
+
+  /* Everything has been read.  Start new histograms. */
+
+  if (totalsize < buflen)
+    {
+      memset(tcb->wake_hist, 0, sizeof(tcb->wake_hist));
+      memset(tcb->premp_hist, 0, sizeof(tcb->premp_hist));
+      memset(tcb->crit_hist, 0, sizeof(tcb->crit_hist));
+    }
+
+  return totalsize;
+}
+#endif
+
 /****************************************************************************
  * Name: proc_stack
  ****************************************************************************/
@@ -1472,6 +1591,11 @@ static ssize_t proc_read(FAR struct file *filep, FAR char *buffer,
     case PROC_CRITMON: /* Critical section monitor */
       ret = proc_critmon(procfile, tcb, buffer, buflen, filep->f_pos);
       break;
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+    case PROC_LATENCY: /* Latency histograms */
+      ret = proc_latency(procfile, tcb, buffer, buflen, filep->f_pos);
+      break;
 #endif
     case PROC_STACK: /* Task stack info */
       ret = proc_stack(procfile, tcb, buffer, buflen, filep->f_pos);
@@ -792,6 +792,8 @@ static size_t smartfs_status_read(FAR struct file *filep, FAR char *buffer,
   int       ret;
   size_t    len;
   int       utilization;
+  uint32_t  writeavg;
+  int       x;
 
   priv = (FAR struct smartfs_file_s *) filep->f_priv;
 
@@ -849,6 +851,54 @@ static size_t smartfs_status_read(FAR struct file *filep, FAR char *buffer,
                   , procfs_data.uneven_wearcount
 #endif
            );
+
+          /* Garbage collection and write latency statistics */
+
+          writeavg = 0;
+          if (procfs_data.writes > 0)
+            {
+              writeavg = procfs_data.writetotal / procfs_data.writes;
+            }
+
+          if (len < buflen)
+            {
+              len += snprintf(&buffer[len], buflen - len,
+                              "FG Collections:    %" PRIu32 "\n"
+#ifdef CONFIG_MTD_SMART_BGGC
+                              "BG Collections:    %" PRIu32 "\n"
+#endif
+                              "Sector Writes:     %" PRIu32 "\n"
+                              "Write Avg (us):    %" PRIu32 "\n"
+                              "Write Max (us):    %" PRIu32 "\n",
+                              procfs_data.fgcollections,
+#ifdef CONFIG_MTD_SMART_BGGC
+                              procfs_data.bgcollections,
+#endif
+                              procfs_data.writes, writeavg,
+                              procfs_data.writemax);
+            }
+
+          for (x = 0; x < SMART_WRITE_HIST_NBUCKETS && len < buflen; x++)
+            {
+              if (x < SMART_WRITE_HIST_NBUCKETS - 1)
+                {
+                  len += snprintf(&buffer[len], buflen - len,
+                                  "  < %7lu us:     %" PRIu32 "\n",
+                                  256ul << x, procfs_data.writehist[x]);
+                }
+              else
+                {
+                  len += snprintf(&buffer[len], buflen - len,
+                                  "  >=%7lu us:     %" PRIu32 "\n",
+                                  256ul << (x - 1),
+                                  procfs_data.writehist[x]);
+                }
+            }
+
+          if (len > buflen)
+            {
+              len = buflen;
+            }
         }
 
       /* Indicate we have already provided all the data */
@@ -221,6 +221,39 @@ static int file_vfcntl(FAR struct file *filep, int cmd, va_list ap)
         ret = -ENOSYS; /* Not implemented */
         break;
 
+      case F_SETPIPE_SZ:
+        /* Resize the buffer of the pipe or FIFO to the third argument,
+         * arg, taken as an integer of type int.  The new size is returned.
+         */
+
+        {
+          int size = va_arg(ap, int);
+
+          ret = file_ioctl(filep, PIPEIOC_SETSIZE, size);
+          if (ret >= 0)
+            {
+              ret = size;
+            }
+        }
+        break;
+
+      case F_GETPIPE_SZ:
+        /* Return the size of the buffer of the pipe or FIFO associated
+         * with fd.
+         */
+
+        {
+          int size;
+
+          ret = file_ioctl(filep, PIPEIOC_GETSIZE,
+                           (unsigned long)((uintptr_t)&size));
+          if (ret >= 0)
+            {
+              ret = size;
+            }
+        }
+        break;
+
       case F_GETPATH:
         /* Get the path of the file descriptor. The argument must be a buffer
          * of size PATH_MAX or greater.
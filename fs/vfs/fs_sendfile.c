@@ -244,6 +244,21 @@ static ssize_t copyfile(FAR struct file *outfile, FAR struct file *infile,
 ssize_t file_sendfile(FAR struct file *outfile, FAR struct file *infile,
                       off_t *offset, size_t count)
 {
+#ifdef CONFIG_PIPES
+  /* Is either side a pipe?  Then the data can be moved directly in or out
+   * of the pipe buffer.
+   */
+
+  if (offset == NULL)
+    {
+      ssize_t ret = pipe_splice(outfile, infile, count);
+      if (ret != -ENOSYS)
+        {
+          return ret;
+        }
+    }
+#endif
+
 #ifdef CONFIG_NET_SENDFILE
   /* Check the destination file descriptor:  Is it a (probable) file
    * descriptor?  Check the source file:  Is it a normal file?
@@ -136,6 +136,9 @@ struct aiocb
   struct sigwork_s aio_sigwork;  /* Signal work */
   volatile ssize_t aio_result;   /* Support for aio_error() and aio_return() */
   FAR void *aio_priv;            /* Used by signal handlers */
+#ifdef CONFIG_FS_AIO_EVENTFD
+  FAR void *aio_evfilep;         /* Eventfd file for SIGEV_EVENTFD */
+#endif
 };
 
 /****************************************************************************
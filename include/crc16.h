@@ -60,6 +60,18 @@ uint16_t crc16part(FAR const uint8_t *src, size_t len, uint16_t crc16val);
 
 uint16_t crc16(FAR const uint8_t *src, size_t len);
 
+/****************************************************************************
+ * Name: crc16_combine
+ *
+ * Description:
+ *   Return the CRC of the concatenation of two buffers given the CRC of
+ *   each buffer, as returned by crc16(), and the length of the second
+ *   buffer.
+ *
+ ****************************************************************************/
+
+uint16_t crc16_combine(uint16_t crc1, uint16_t crc2, size_t len2);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
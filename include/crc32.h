@@ -60,6 +60,18 @@ uint32_t crc32part(FAR const uint8_t *src, size_t len, uint32_t crc32val);
 
 uint32_t crc32(FAR const uint8_t *src, size_t len);
 
+/****************************************************************************
+ * Name: crc32_combine
+ *
+ * Description:
+ *   Return the CRC of the concatenation of two buffers given the CRC of
+ *   each buffer, as returned by crc32(), and the length of the second
+ *   buffer.
+ *
+ ****************************************************************************/
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -85,6 +85,18 @@ uint64_t crc64part(FAR const uint8_t *src, size_t len, uint64_t crc64val);
 
 uint64_t crc64(FAR const uint8_t *src, size_t len);
 
+/****************************************************************************
+ * Name: crc64_combine
+ *
+ * Description:
+ *   Return the CRC of the concatenation of two buffers given the CRC of
+ *   each buffer, as returned by crc64(), and the length of the second
+ *   buffer.
+ *
+ ****************************************************************************/
+
+uint64_t crc64_combine(uint64_t crc1, uint64_t crc2, size_t len2);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -34,6 +34,7 @@
 #include <elf.h>
 
 #include <nuttx/arch.h>
+#include <nuttx/symtab.h>
 #include <nuttx/binfmt/binfmt.h>
 
 /****************************************************************************
@@ -99,6 +100,11 @@ struct elf_loadinfo_s
   size_t            textalign;   /* Necessary alignment of .text */
 #endif
   size_t            datasize;    /* Size of the ELF .bss/.data memory allocation */
+  uintptr_t         entrypt;     /* Address of the entry point after loading */
+#ifdef CONFIG_ELF_XIP
+  uintptr_t         xipbase;     /* Address of the file in memory-mapped media */
+  bool              noxip;       /* Copy all sections, see elf_bind() */
+#endif
   off_t             filelen;     /* Length of the entire ELF file */
 
   Elf_Ehdr          ehdr;        /* Buffered ELF file header */
@@ -129,6 +135,23 @@ struct elf_loadinfo_s
   save_addrenv_t     oldenv;     /* Saved address environment */
 #endif
 
+  /* Symbol lookup state.
+   *
+   * symtab/strtab - The symbol and string tables read into memory by
+   *   elf_loadsymtab(), or NULL if they are read from the file as needed.
+   * exphash - Hash index over the exported symbols, built on the first
+   *   lookup of an undefined symbol.
+   */
+
+#ifdef CONFIG_ELF_CACHE_SYMTAB
+  FAR Elf_Sym       *symtab;     /* Cached symbol table */
+  FAR char          *strtab;     /* Cached, NUL terminated string table */
+  size_t             strtablen;  /* Size of the string table */
+#endif
+#ifdef CONFIG_SYMTAB_HASH
+  struct symtab_hash_s exphash;  /* Hash index over the exported symbols */
+#endif
+
   uint16_t           symtabidx;  /* Symbol table section index */
   uint16_t           strtabidx;  /* String table section index */
   uint16_t           buflen;     /* size of iobuffer[] */
@@ -0,0 +1,78 @@
+/****************************************************************************
+ * include/nuttx/drivers/bcache.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_DRIVERS_BCACHE_H
+#define __INCLUDE_NUTTX_DRIVERS_BCACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#ifdef CONFIG_DRVR_BCACHE
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: bcache_register
+ *
+ * Description:
+ *   Register a block driver that caches the sectors of another block
+ *   driver.  Any block-based file system (FAT, ROMFS, SMARTFS, ...) mounted
+ *   on the cache device shares one sector cache with LRU replacement,
+ *   write-back of dirty sectors after CONFIG_DRVR_BCACHE_FLUSHDELAY
+ *   milliseconds (or on BIOC_FLUSH and on the last close), and read-ahead
+ *   of CONFIG_DRVR_BCACHE_READAHEAD sectors on a miss.  Hit/miss
+ *   statistics of every cache are reported in /proc/fs/bcache.
+ *
+ * Input Parameters:
+ *   blkdev   - The path to the block driver to be cached, e.g. /dev/mmcsd0
+ *   cachedev - The path of the caching block driver to create
+ *   nsectors - The number of sectors to cache.  Zero selects
+ *              CONFIG_DRVR_BCACHE_NSECTORS.
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int bcache_register(FAR const char *blkdev, FAR const char *cachedev,
+                    uint16_t nsectors);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_DRVR_BCACHE */
+#endif /* __INCLUDE_NUTTX_DRIVERS_BCACHE_H */
@@ -410,6 +410,10 @@ struct file
  * You can get file instance in filelist by the follow methods:
  * (file descriptor / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK) as row index and
  * (file descriptor % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK) as column index.
+ *
+ * Rows are never moved or freed while the list exists so that a file
+ * descriptor can be translated without taking fl_sem.  fl_bitmap has one
+ * bit set for each file descriptor in use.
  */
 
 struct filelist
@@ -417,6 +421,7 @@ struct filelist
   sem_t             fl_sem;     /* Manage access to the file list */
   uint8_t           fl_rows;    /* The number of rows of fl_files array */
   FAR struct file **fl_files;   /* The pointer of two layer file descriptors array */
+  FAR uint32_t     *fl_bitmap;  /* File descriptors in use */
 };
 
 /* The following structure defines the list of files used for standard C I/O.
@@ -1223,6 +1228,19 @@ int file_mmap(FAR struct file *filep, FAR void *start, size_t length,
 
 int file_munmap(FAR void *start, size_t length);
 
+/****************************************************************************
+ * Name: file_msync
+ *
+ * Description:
+ *   Equivalent to the standard msync() function except it does not set
+ *   the errno variable.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP
+int file_msync(FAR void *start, size_t length, int flags);
+#endif
+
 /****************************************************************************
  * Name: file_ioctl
  *
@@ -1491,6 +1509,35 @@ int nx_pipe(int fd[2], size_t bufsize, int flags);
 int nx_mkfifo(FAR const char *pathname, mode_t mode, size_t bufsize);
 #endif
 
+/****************************************************************************
+ * Name: pipe_splice
+ *
+ * Description:
+ *   Move up to 'count' bytes between a pipe (or FIFO) and another file
+ *   without an intermediate buffer:  If 'infile' is the read end of a pipe,
+ *   the data is written to 'outfile' directly from the pipe buffer.  If
+ *   'outfile' is the write end of a pipe, the data is read from 'infile'
+ *   directly into the pipe buffer.  The other file may be any file or
+ *   socket.  Like read() and write() on the pipe, this blocks until at
+ *   least one byte can be moved unless the pipe is non-blocking.
+ *
+ * Input Parameters:
+ *   outfile - The file to move the data to
+ *   infile  - The file to move the data from
+ *   count   - The maximum number of bytes to move
+ *
+ * Returned Value:
+ *   The number of bytes moved, zero at the end of the input, or a negated
+ *   errno value on failure.  -ENOSYS is returned if neither file is a
+ *   pipe.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_PIPES
+ssize_t pipe_splice(FAR struct file *outfile, FAR struct file *infile,
+                    size_t count);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
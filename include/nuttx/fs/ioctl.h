@@ -400,6 +400,23 @@
                                              *       (default)
                                              *     1=fre when empty
                                              * OUT: None */
+#define PIPEIOC_SETSIZE   _PIPEIOC(0x0002)  /* Resize the pipe buffer
+                                             * IN: unsigned long integer
+                                             *     New buffer size in bytes
+                                             * OUT: None */
+#define PIPEIOC_GETSIZE   _PIPEIOC(0x0003)  /* Get the pipe buffer size
+                                             * IN: Pointer to int
+                                             * OUT: Buffer size in bytes */
+#define PIPEIOC_SPSC      _PIPEIOC(0x0004)  /* Single reader/writer mode
+                                             * IN: unsigned long integer
+                                             *     0=Serialize all accesses
+                                             *       (default)
+                                             *     1=Only one thread reads
+                                             *       and one thread writes
+                                             * OUT: None
+                                             * EBUSY if there is more than
+                                             * one reader or writer or a
+                                             * transfer is in progress */
 
 /* RTC driver ioctl definitions *********************************************/
 
@@ -29,6 +29,8 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
 
 #include <nuttx/fs/ioctl.h>
 
@@ -234,6 +236,52 @@ struct i2c_transfer_s
   size_t msgc;                /* Number of messages in the array. */
 };
 
+#ifdef CONFIG_I2C_QUEUE
+/* This describes one asynchronous request of an I2C queue.  A request
+ * performs one I2C_TRANSFER() of its messages and then calls its callback
+ * from the queue thread with the result of the transfer.  The request
+ * belongs to the queue from i2c_queue_submit() until the callback is called
+ * (or i2c_queue_cancel() succeeds) and must not be modified in that time.
+ */
+
+struct i2c_request_s;
+typedef CODE void (*i2c_callback_t)(FAR struct i2c_request_s *req,
+                                    int result);
+
+struct i2c_request_s
+{
+  /* The following are used internally by the queue.  The node must come
+   * first.
+   */
+
+  sq_entry_t node;
+  uint64_t submitted;
+  int result;                     /* The result passed to the callback */
+
+  /* The following are set up by the client */
+
+  FAR struct i2c_msg_s *msgs;     /* The messages of the transfer */
+  int nmsgs;                      /* The number of messages */
+  i2c_callback_t callback;        /* Called when the transfer is done */
+  FAR void *arg;                  /* Opaque argument for the callback */
+};
+
+/* Statistics of an I2C queue.  Times are in microseconds. */
+
+struct i2c_queue_stats_s
+{
+  uint32_t nrequests;             /* Number of requests performed */
+  uint32_t nbatches;              /* Number of I2C_TRANSFER() calls */
+  uint32_t maxbatch;              /* Largest number of requests per call */
+  uint32_t maxlatency;            /* Longest wait from submission to start */
+  uint64_t latency;               /* Total wait from submission to start */
+  uint64_t busy;                  /* Total time spent in I2C_TRANSFER() */
+  uint64_t elapsed;               /* Time since the statistics were reset */
+};
+
+struct i2c_queue_s;
+#endif
+
 /****************************************************************************
  * Public Functions Definitions
  ****************************************************************************/
@@ -347,6 +395,86 @@ int i2c_read(FAR struct i2c_master_s *dev,
              FAR const struct i2c_config_s *config,
              FAR uint8_t *buffer, int buflen);
 
+#ifdef CONFIG_I2C_QUEUE
+
+/****************************************************************************
+ * Name: i2c_queue_create
+ *
+ * Description:
+ *   Create a queue of asynchronous requests for an I2C bus.  The requests
+ *   are performed in submission order by a kernel thread.  Requests to the
+ *   same device that are queued back-to-back are combined into a single
+ *   I2C_TRANSFER() of up to CONFIG_I2C_QUEUE_MAXMSGS messages.  The STOP
+ *   conditions between the requests are kept.  If a combined transfer
+ *   fails, its requests are performed again one at a time so that each
+ *   completes with its own result; the requests that preceded the failure
+ *   are then performed twice.
+ *
+ * Input Parameters:
+ *   i2c - An instance of the lower half I2C driver
+ *
+ * Returned Value:
+ *   The new queue on success; NULL on failure.
+ *
+ ****************************************************************************/
+
+FAR struct i2c_queue_s *i2c_queue_create(FAR struct i2c_master_s *i2c);
+
+/****************************************************************************
+ * Name: i2c_queue_destroy
+ *
+ * Description:
+ *   Stop the queue thread and free the queue.  The callbacks of the
+ *   requests still queued are called with -ECANCELED.
+ *
+ ****************************************************************************/
+
+void i2c_queue_destroy(FAR struct i2c_queue_s *queue);
+
+/****************************************************************************
+ * Name: i2c_queue_submit
+ *
+ * Description:
+ *   Add a request to the end of the queue.  This may be called from an
+ *   interrupt handler or from a request callback.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int i2c_queue_submit(FAR struct i2c_queue_s *queue,
+                     FAR struct i2c_request_s *req);
+
+/****************************************************************************
+ * Name: i2c_queue_cancel
+ *
+ * Description:
+ *   Remove a request that has not been started from the queue.  Its
+ *   callback is not called.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOENT if the request is not queued (it is
+ *   being performed or is already done).
+ *
+ ****************************************************************************/
+
+int i2c_queue_cancel(FAR struct i2c_queue_s *queue,
+                     FAR struct i2c_request_s *req);
+
+/****************************************************************************
+ * Name: i2c_queue_stats
+ *
+ * Description:
+ *   Return the statistics of the queue and optionally reset them.
+ *
+ ****************************************************************************/
+
+void i2c_queue_stats(FAR struct i2c_queue_s *queue,
+                     FAR struct i2c_queue_stats_s *stats, bool reset);
+
+#endif /* CONFIG_I2C_QUEUE */
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
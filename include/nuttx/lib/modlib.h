@@ -28,6 +28,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdbool.h>
 #include <elf.h>
 
 #include <nuttx/arch.h>
@@ -175,6 +176,10 @@ struct module_s
 
   FAR struct module_s *dependencies[CONFIG_MODLIB_MAXDEPEND];
 #endif
+
+#ifdef CONFIG_SYMTAB_HASH
+  struct symtab_hash_s exphash;        /* Hash index over modinfo.exports */
+#endif
 };
 
 /* This struct provides a description of the currently loaded instantiation
@@ -196,10 +201,20 @@ struct mod_loadinfo_s
   size_t            datasize;    /* Size of the module .bss/.data memory allocation */
   size_t            textalign;   /* Necessary alignment of .text */
   size_t            dataalign;   /* Necessary alignment of .bss/.text */
+  uintptr_t         entrypt;     /* Address of the entry point after loading */
+#ifdef CONFIG_MODLIB_XIP
+  uintptr_t         xipbase;     /* Address of the file in memory-mapped media */
+  bool              noxip;       /* Copy all sections, see modlib_bind() */
+#endif
   off_t             filelen;     /* Length of the entire module file */
   Elf_Ehdr          ehdr;        /* Buffered module file header */
   FAR Elf_Shdr     *shdr;        /* Buffered module section headers */
   uint8_t          *iobuffer;    /* File I/O buffer */
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+  FAR Elf_Sym      *symtab;      /* Cached symbol table (or NULL) */
+  FAR char         *strtab;      /* Cached symbol string table (or NULL) */
+  size_t            strtablen;   /* Size of the cached string table */
+#endif
 
   uint16_t          symtabidx;   /* Symbol table section index */
   uint16_t          strtabidx;   /* String table section index */
@@ -281,6 +296,31 @@ void modlib_getsymtab(FAR const struct symtab_s **symtab, FAR int *nsymbols);
 
 void modlib_setsymtab(FAR const struct symtab_s *symtab, int nsymbols);
 
+/****************************************************************************
+ * Name: modlib_findexport
+ *
+ * Description:
+ *   Find a symbol in the symbol table exported by an installed module.
+ *   With CONFIG_SYMTAB_HASH, a hash index over the exported symbols is
+ *   built on first use and kept until the module is removed from the
+ *   registry.
+ *
+ * Input Parameters:
+ *   modp - The module whose exported symbols will be searched.
+ *   name - The name of the symbol to find.
+ *
+ * Returned Value:
+ *   A reference to the exported symbol is returned on success; NULL is
+ *   returned if the module does not export a symbol of that name.
+ *
+ * Assumptions:
+ *   The caller holds the lock on the module registry.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *modlib_findexport(FAR struct module_s *modp,
+                                             FAR const char *name);
+
 /****************************************************************************
  * Name: modlib_load
  *
@@ -295,6 +295,25 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd);
 
 int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd);
 
+/****************************************************************************
+ * Name: ftl_log_initialize_by_path
+ *
+ * Description:
+ *   Initialize a log-structured block driver wrapper around an MTD
+ *   interface.  ftl_initialize() and ftl_initialize_by_path() use this when
+ *   CONFIG_FTL_LOG is selected.
+ *
+ * Input Parameters:
+ *   path - The block device path.
+ *   mtd  - The MTD device that supports the FLASH interface.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOG
+int ftl_log_initialize_by_path(FAR const char *path,
+                               FAR struct mtd_dev_s *mtd);
+#endif
+
 /****************************************************************************
  * Name: smart_initialize
  *
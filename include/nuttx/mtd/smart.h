@@ -37,6 +37,13 @@
 #define SMART_DEBUG_CMD_SET_DEBUG_LEVEL   1
 #define SMART_DEBUG_CMD_SHOW_LOGMAP       2
 
+/* Number of buckets in the sector write latency histogram.  Bucket 0
+ * counts writes below 256 usec, bucket n those below 256 << n usec and the
+ * last bucket all longer ones.
+ */
+
+#define SMART_WRITE_HIST_NBUCKETS         12
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -81,6 +88,14 @@ struct mtd_smart_procfs_data_s
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
   uint32_t            uneven_wearcount; /* Number of uneven block erases */
 #endif
+  uint32_t            fgcollections;    /* Blocks collected during writes */
+#ifdef CONFIG_MTD_SMART_BGGC
+  uint32_t            bgcollections;    /* Blocks collected in the background */
+#endif
+  uint32_t            writes;           /* Number of sector writes */
+  uint32_t            writemax;         /* Longest sector write (usec) */
+  uint64_t            writetotal;       /* Sum of all sector writes (usec) */
+  uint32_t            writehist[SMART_WRITE_HIST_NBUCKETS];
 };
 
 /* The following defines debug command data passed from the procfs layer to
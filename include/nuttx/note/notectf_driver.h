@@ -0,0 +1,99 @@
+/****************************************************************************
+ * include/nuttx/note/notectf_driver.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_NOTE_NOTECTF_DRIVER_H
+#define __INCLUDE_NUTTX_NOTE_NOTECTF_DRIVER_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* A trace is written as a Common Trace Format (CTF 1.8) directory holding
+ * two files:
+ *
+ *   metadata - The TSDL description of the notes of this configuration
+ *   stream   - Packets of notes, each preceded by this 16 byte header:
+ *
+ *     uint32_t magic         NOTECTF_MAGIC
+ *     uint32_t stream_id     Always 0
+ *     uint32_t content_size  Size of the packet in bits
+ *     uint32_t packet_size   Size of the packet in bits
+ *
+ * All values are little endian.  The notes are those of
+ * include/nuttx/sched_note.h except that, with
+ * CONFIG_SCHED_INSTRUMENTATION_HIRES, the time stamp is rewritten as a
+ * 64-bit count of nanoseconds.  The trace can be opened with babeltrace,
+ * Trace Compass or any other CTF viewer.
+ */
+
+#define NOTECTF_MAGIC     0xc1fc1fc1
+#define NOTECTF_HDRSIZE   16
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#if defined(__KERNEL__) || defined(CONFIG_BUILD_FLAT)
+
+#ifdef CONFIG_DRIVER_NOTECTF
+
+/****************************************************************************
+ * Name: notectf_start
+ *
+ * Description:
+ *   Start streaming the notes of /dev/note to a CTF trace in the directory
+ *   'dirpath', which must exist.  This may be a local file system, a hostfs
+ *   mount or an rpmsgfs mount.  The notes are written by a kernel thread
+ *   until notectf_stop() is called.
+ *
+ * Input Parameters:
+ *   dirpath - The directory to hold the trace files.
+ *
+ * Returned Value:
+ *   Zero on success. A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+int notectf_start(FAR const char *dirpath);
+
+/****************************************************************************
+ * Name: notectf_stop
+ *
+ * Description:
+ *   Write the remaining notes and stop streaming.
+ *
+ * Returned Value:
+ *   Zero on success. A negated errno value is returned on a failure.
+ *
+ ****************************************************************************/
+
+int notectf_stop(void);
+
+#endif /* CONFIG_DRIVER_NOTECTF */
+
+#endif /* defined(__KERNEL__) || defined(CONFIG_BUILD_FLAT) */
+
+#endif /* __INCLUDE_NUTTX_NOTE_NOTECTF_DRIVER_H */
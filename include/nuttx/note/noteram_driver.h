@@ -50,6 +50,9 @@
  *                          noteram_get_taskname_s
  *                Result:   If -ESRCH, the corresponding task name doesn't
  *                          exist.
+ * NOTERAM_GETLOST
+ *              - Get the number of notes lost since the last clear
+ *                Argument: A writable pointer to struct noteram_lost_s
  */
 
 #ifdef CONFIG_DRIVER_NOTERAM
@@ -59,6 +62,7 @@
 #if CONFIG_DRIVER_NOTERAM_TASKNAME_BUFSIZE > 0
 #define NOTERAM_GETTASKNAME     _NOTERAMIOC(0x04)
 #endif
+#define NOTERAM_GETLOST         _NOTERAMIOC(0x05)
 #endif
 
 /* Overwrite mode definitions */
@@ -83,6 +87,16 @@ struct noteram_get_taskname_s
 };
 #endif
 
+/* This is the type of the argument passed to the NOTERAM_GETLOST ioctl */
+
+#ifdef CONFIG_DRIVER_NOTERAM
+struct noteram_lost_s
+{
+  unsigned int dropped;      /* Not recorded because the buffer was full */
+  unsigned int overwritten;  /* Overwritten before they were read */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -696,6 +696,13 @@ struct tcb_s
   uint32_t run_max;                      /* Max time thread run                 */
 #endif
 
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  uint32_t ready_start;                  /* Time when thread was unblocked      */
+  uint32_t wake_hist[CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS];
+  uint32_t premp_hist[CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS];
+  uint32_t crit_hist[CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS];
+#endif
+
   /* State save areas *******************************************************/
 
   /* The form and content of these fields are platform-specific.            */
@@ -55,6 +55,12 @@ extern "C"
  *                    x,y,z
  *                    2.1234,3.23443,2.23456
  *                    ...
+ *                 If NULL, an accelerometer, gyroscope or magnetic field
+ *                 sensor generates a sine wave at the interval set by
+ *                 SNIOC_SET_INTERVAL (1 ms by default).  Intervals shorter
+ *                 than the system tick are generated in bursts with exact
+ *                 timestamps, which makes this a high rate sensor to
+ *                 benchmark the readers with.
  *   devno       - The user specifies which device of this type, from 0.
  *   batch_number- The maximum number of batch
  ****************************************************************************/
@@ -297,4 +297,16 @@
 
 #define SNIOC_SELFTEST             _SNIOC(0x0086)
 
+/* Command:      SNIOC_SET_WATERMARK
+ * Description:  Set the number of events that must be buffered before
+ *               poll() reports POLLIN and a blocking read() returns.
+ * Argument:     This is the number of events, 1 (the default) wakes up
+ *               the readers on every event.
+ * Note:         With a watermark, a high rate sensor wakes up the reader
+ *               once per batch, and one read() returns the whole batch.
+ *               The watermark is limited to the depth of the buffer.
+ */
+
+#define SNIOC_SET_WATERMARK        _SNIOC(0x0087)
+
 #endif /* __INCLUDE_NUTTX_SENSORS_IOCTL_H */
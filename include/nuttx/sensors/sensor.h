@@ -461,6 +461,28 @@ struct sensor_event_impd    /* Type: Impedance */
   float imag;               /* Imaginary part, unit is Ohm(Ω) */
 };
 
+/* The header of the ring returned by mmap() on a sensor device.  The events
+ * follow the header at 'offset', event number 'n' is in the slot
+ * (n & (nevents - 1)).  The driver writes the event and then increments
+ * 'head', the reader consumes the event and then increments 'tail'.  The
+ * counters are free-running and wrap at 2^32.  When the ring is full, new
+ * events are dropped and counted in 'dropped'.  read() consumes events
+ * from the same ring.  The ring stays valid until the sensor is
+ * unregistered, even after the device is closed.  The buffer geometry is
+ * fixed once the ring exists:  SNIOC_SET_INTERVAL, SNIOC_BATCH and
+ * SNIOC_SET_BUFFER_NUMBER then fail with -EBUSY.
+ */
+
+struct sensor_ring_s
+{
+  uint32_t esize;            /* The size of one event in bytes */
+  uint32_t nevents;          /* The number of slots, a power of two */
+  uint32_t offset;           /* Offset of the first slot from the header */
+  volatile uint32_t head;    /* Number of events written by the driver */
+  volatile uint32_t tail;    /* Number of events consumed by the readers */
+  volatile uint32_t dropped; /* Number of events lost to a full ring */
+};
+
 /* The sensor lower half driver interface */
 
 struct sensor_lowerhalf_s;
@@ -137,6 +137,7 @@ struct uart_dmaxfer_s
   size_t           length;  /* Length of first DMA buffer */
   size_t           nlength; /* Length of next DMA buffer */
   size_t           nbytes;  /* Bytes actually transferred by DMA from both buffers */
+  size_t           ndone;   /* RX: Bytes already moved into the RX buffer */
 };
 #endif /* CONFIG_SERIAL_RXDMA || CONFIG_SERIAL_TXDMA */
 
@@ -214,7 +215,10 @@ struct uart_ops_s
 #endif
 
 #ifdef CONFIG_SERIAL_TXDMA
-  /* Start transfer bytes from the TX circular buffer using DMA */
+  /* Start transfer bytes from the TX circular buffer using DMA.  With
+   * CONFIG_SERIAL_TXDMA_ZEROCOPY, dmatx may instead describe the caller's
+   * buffer of a large write().
+   */
 
   CODE void (*dmasend)(FAR struct uart_dev_s *dev);
 #endif
@@ -308,6 +312,9 @@ struct uart_dev_s
 #ifdef CONFIG_SERIAL_TXDMA
   struct uart_dmaxfer_s dmatx;       /* Describes transmit DMA transfer */
 #endif
+#ifdef CONFIG_SERIAL_TXDMA_ZEROCOPY
+  volatile size_t      dmatxdirect;  /* Bytes of a zero-copy write left to send */
+#endif
 #ifdef CONFIG_SERIAL_RXDMA
   struct uart_dmaxfer_s dmarx;       /* Describes receive DMA transfer */
 #endif
@@ -484,6 +491,21 @@ void uart_recvchars_dma(FAR uart_dev_t *dev);
 void uart_recvchars_done(FAR uart_dev_t *dev);
 #endif
 
+/****************************************************************************
+ * Name: uart_recvchars_update
+ *
+ * Description:
+ *  Make the data received so far by a still running RX DMA transfer
+ *  available to readers.  This is called by the lower half on half-transfer,
+ *  double-buffer switch or idle-line events after it has updated
+ *  dmarx.nbytes.  The transfer remains armed.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SERIAL_RXDMA
+void uart_recvchars_update(FAR uart_dev_t *dev);
+#endif
+
 /****************************************************************************
  * Name: uart_reset_sem
  *
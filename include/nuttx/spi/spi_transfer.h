@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <queue.h>
 
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/spi/spi.h>
@@ -112,6 +113,63 @@ struct spi_sequence_s
   FAR struct spi_trans_s *trans;
 };
 
+#ifdef CONFIG_SPI_QUEUE
+/* This describes one asynchronous request of an SPI queue.  A request
+ * performs one sequence of transfers, exactly as spi_transfer() would, and
+ * then calls its callback from the queue thread with the result of the
+ * sequence.  The request belongs to the queue from spi_queue_submit() until
+ * the callback is called (or spi_queue_cancel() succeeds) and must not be
+ * modified in that time.
+ *
+ * Example usage:
+ *   static void mycallback(FAR struct spi_request_s *req, int result)
+ *   {
+ *     nxsem_post(req->arg);
+ *   }
+ *   ...
+ *   myreq.seq      = &myseq;
+ *   myreq.callback = mycallback;
+ *   myreq.arg      = &mysem;
+ *   spi_queue_submit(queue, &myreq);
+ */
+
+struct spi_request_s;
+typedef CODE void (*spi_callback_t)(FAR struct spi_request_s *req,
+                                    int result);
+
+struct spi_request_s
+{
+  /* The following are used internally by the queue.  The node must come
+   * first.
+   */
+
+  sq_entry_t node;
+  uint64_t submitted;
+  int result;
+
+  /* The following are set up by the client */
+
+  FAR struct spi_sequence_s *seq; /* The sequence of transfers */
+  spi_callback_t callback;        /* Called when the sequence is done */
+  FAR void *arg;                  /* Opaque argument for the callback */
+};
+
+/* Statistics of an SPI queue.  Times are in microseconds. */
+
+struct spi_queue_stats_s
+{
+  uint32_t nrequests;           /* Number of requests performed */
+  uint32_t nbatches;            /* Number of times the bus was locked */
+  uint32_t maxbatch;            /* Largest number of requests per lock */
+  uint32_t maxlatency;          /* Longest wait from submission to start */
+  uint64_t latency;             /* Total wait from submission to start */
+  uint64_t busy;                /* Total time the bus was locked */
+  uint64_t elapsed;             /* Time since the statistics were reset */
+};
+
+struct spi_queue_s;
+#endif
+
 /****************************************************************************
  * Public Functions Definitions
  ****************************************************************************/
@@ -161,6 +219,83 @@ int spi_transfer(FAR struct spi_dev_s *spi, FAR struct spi_sequence_s *seq);
 int spi_register(FAR struct spi_dev_s *spi, int bus);
 #endif
 
+#ifdef CONFIG_SPI_QUEUE
+
+/****************************************************************************
+ * Name: spi_queue_create
+ *
+ * Description:
+ *   Create a queue of asynchronous requests for an SPI bus.  The requests
+ *   are performed in submission order by a kernel thread.  Requests that
+ *   are queued back-to-back are performed in one batch, under a single
+ *   lock of the bus, and the bus is only reconfigured when the device or
+ *   the attributes of the sequence change.
+ *
+ * Input Parameters:
+ *   spi - An instance of the SPI device to use for the transfers
+ *
+ * Returned Value:
+ *   The new queue on success; NULL on failure.
+ *
+ ****************************************************************************/
+
+FAR struct spi_queue_s *spi_queue_create(FAR struct spi_dev_s *spi);
+
+/****************************************************************************
+ * Name: spi_queue_destroy
+ *
+ * Description:
+ *   Stop the queue thread and free the queue.  The callbacks of the
+ *   requests still queued are called with -ECANCELED.
+ *
+ ****************************************************************************/
+
+void spi_queue_destroy(FAR struct spi_queue_s *queue);
+
+/****************************************************************************
+ * Name: spi_queue_submit
+ *
+ * Description:
+ *   Add a request to the end of the queue.  This may be called from an
+ *   interrupt handler or from a request callback.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int spi_queue_submit(FAR struct spi_queue_s *queue,
+                     FAR struct spi_request_s *req);
+
+/****************************************************************************
+ * Name: spi_queue_cancel
+ *
+ * Description:
+ *   Remove a request that has not been started from the queue.  Its
+ *   callback is not called.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOENT if the request is not queued (it is
+ *   being performed or is already done).
+ *
+ ****************************************************************************/
+
+int spi_queue_cancel(FAR struct spi_queue_s *queue,
+                     FAR struct spi_request_s *req);
+
+/****************************************************************************
+ * Name: spi_queue_stats
+ *
+ * Description:
+ *   Return the statistics of the queue and optionally reset them.
+ *
+ ****************************************************************************/
+
+void spi_queue_stats(FAR struct spi_queue_s *queue,
+                     FAR struct spi_queue_stats_s *stats, bool reset);
+
+#endif /* CONFIG_SPI_QUEUE */
+
 #undef EXTERN
 #if defined(__cplusplus)
 #define EXTERN extern "C"
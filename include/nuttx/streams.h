@@ -39,6 +39,8 @@ typedef CODE int  (*lib_getc_t)(FAR struct lib_instream_s *this);
 
 struct lib_outstream_s;
 typedef CODE void (*lib_putc_t)(FAR struct lib_outstream_s *this, int ch);
+typedef CODE void (*lib_puts_t)(FAR struct lib_outstream_s *this,
+                                FAR const void *buf, int len);
 typedef CODE int  (*lib_flush_t)(FAR struct lib_outstream_s *this);
 
 struct lib_instream_s
@@ -51,6 +53,8 @@ struct lib_instream_s
 struct lib_outstream_s
 {
   lib_putc_t             put;     /* Put one character to the outstream */
+  lib_puts_t             puts;    /* Put a string to the outstream (optional,
+                                   * may be NULL, see lib_stream_puts()) */
   lib_flush_t            flush;   /* Flush any buffered characters in the outstream */
   int                    nput;    /* Total number of characters put.  Written
                                    * by put method, readable by user */
@@ -409,6 +413,18 @@ int lib_noflush(FAR struct lib_outstream_s *stream);
 
 int lib_snoflush(FAR struct lib_sostream_s *this);
 
+/****************************************************************************
+ * Name: lib_stream_puts
+ *
+ * Description:
+ *  Write 'len' bytes to an output stream with its puts method or, if the
+ *  stream has none, one character at a time with its put method.
+ *
+ ****************************************************************************/
+
+void lib_stream_puts(FAR struct lib_outstream_s *stream,
+                     FAR const void *buf, int len);
+
 /****************************************************************************
  * Name: lib_sprintf
  *
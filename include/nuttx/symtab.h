@@ -27,6 +27,8 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -55,6 +57,28 @@ struct symtab_s
   FAR const void *sym_value;         /* The value associated with the string */
 };
 
+#ifdef CONFIG_SYMTAB_HASH
+/* struct symtab_hash_s is a GNU-style hash index over a symbol table,
+ * built at run time by symtab_hashinit().  The symbol table itself is not
+ * modified, so it may reside in read-only memory.  Symbols are grouped
+ * into chains by bucket; chain[] holds the hash of each symbol (with the
+ * low bit set on the last entry of a chain) and order[] its index in the
+ * symbol table.  A small bloom filter rejects most absent names.
+ */
+
+struct symtab_hash_s
+{
+  FAR const struct symtab_s *symtab; /* The indexed symbol table */
+  FAR uint32_t *bloom;               /* Bloom filter, nbloom words */
+  FAR uint32_t *buckets;             /* First chain position of each bucket */
+  FAR uint32_t *chain;               /* Symbol hashes in bucket order */
+  FAR uint32_t *order;               /* Symbol table index of each hash */
+  uint32_t nbloom;                   /* Words in the bloom filter (2^n) */
+  uint32_t nbuckets;                 /* Number of hash buckets */
+  int nsyms;                         /* Number of symbols indexed */
+};
+#endif
+
 /****************************************************************************
  * Public Functions Definitions
  ****************************************************************************/
@@ -119,6 +143,53 @@ symtab_findbyvalue(FAR const struct symtab_s *symtab,
 
 void symtab_sortbyname(FAR struct symtab_s *symtab, int nsyms);
 
+#ifdef CONFIG_SYMTAB_HASH
+/****************************************************************************
+ * Name: symtab_hashinit
+ *
+ * Description:
+ *   Build a hash index over a symbol table.  The symbol table itself is
+ *   not modified and must remain valid as long as the index is in use.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOMEM if the index could not be allocated.
+ *
+ ****************************************************************************/
+
+int symtab_hashinit(FAR struct symtab_hash_s *hash,
+                    FAR const struct symtab_s *symtab, int nsyms);
+
+/****************************************************************************
+ * Name: symtab_hashfree
+ *
+ * Description:
+ *   Release the memory used by a hash index built by symtab_hashinit().
+ *
+ * Returned Value:
+ *   None.
+ *
+ ****************************************************************************/
+
+void symtab_hashfree(FAR struct symtab_hash_s *hash);
+
+/****************************************************************************
+ * Name: symtab_hashfind
+ *
+ * Description:
+ *   Find the symbol with the matching name using a hash index built by
+ *   symtab_hashinit().  Access time is independent of the size of the
+ *   symbol table.
+ *
+ * Returned Value:
+ *   A reference to the symbol table entry if an entry with the matching
+ *   name is found; NULL is returned if the entry is not found.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *
+symtab_hashfind(FAR const struct symtab_hash_s *hash, FAR const char *name);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
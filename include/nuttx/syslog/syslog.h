@@ -283,6 +283,10 @@ int syslog_flush(void);
  *   some compilers and passing of structures in the NuttX sycalls does
  *   not work.
  *
+ *   Returns the number of characters output.  With CONFIG_SYSLOG_BINARY,
+ *   a message recorded for deferred formatting is not measured; the size
+ *   of the record, or zero if the message was dropped, is returned.
+ *
  ****************************************************************************/
 
 int nx_vsyslog(int priority, FAR const IPTR char *src, FAR va_list *ap);
@@ -280,6 +280,10 @@
 #ifdef CONFIG_SIG_EVTHREAD
 #  define SIGEV_THREAD  3 /* A notification function is called */
 #endif
+#ifdef CONFIG_FS_AIO_EVENTFD
+#  define SIGEV_EVENTFD 4 /* Non-standard: Increment the eventfd in sival_int
+                           * (asynchronous I/O only) */
+#endif
 
 /* Special values of sa_handler used by sigaction and sigset.  They are all
  * treated like NULL for now.  This is okay for SIG_DFL and SIG_IGN because
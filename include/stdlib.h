@@ -258,6 +258,8 @@ FAR char *mkdtemp(FAR char *path_template);
 
 void      qsort(FAR void *base, size_t nel, size_t width,
                 CODE int (*compar)(FAR const void *, FAR const void *));
+int       mergesort(FAR void *base, size_t nel, size_t width,
+                    CODE int (*compar)(FAR const void *, FAR const void *));
 
 /* Binary search */
 
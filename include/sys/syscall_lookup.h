@@ -264,6 +264,7 @@ SYSCALL_LOOKUP(futimens,                   2)
 
 #if defined(CONFIG_FS_RAMMAP)
   SYSCALL_LOOKUP(munmap,                   2)
+  SYSCALL_LOOKUP(msync,                    3)
 #endif
 
 #if defined(CONFIG_PSEUDOFS_SOFTLINKS)
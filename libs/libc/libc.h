@@ -29,6 +29,7 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -53,6 +54,19 @@
 
 #define LIB_BUFLEN_UNKNOWN INT_MAX
 
+/* Helpers for the word-at-a-time string functions.  LIB_WORD_HASZERO(w) is
+ * nonzero if and only if some byte of the word w is zero.  A byte c can be
+ * found in a word by testing LIB_WORD_HASZERO(w ^ LIB_WORD_REPEAT(c)).
+ */
+
+#define LIB_WORD_SIZE        sizeof(uintptr_t)
+#define LIB_WORD_MASK        (LIB_WORD_SIZE - 1)
+#define LIB_WORD_ONES        ((uintptr_t)-1 / 0xff)
+#define LIB_WORD_HIGHS       (LIB_WORD_ONES << 7)
+#define LIB_WORD_REPEAT(c)   (LIB_WORD_ONES * (uint8_t)(c))
+#define LIB_WORD_HASZERO(w)  (((w) - LIB_WORD_ONES) & ~(w) & LIB_WORD_HIGHS)
+#define LIB_WORD_ALIGNED(p)  (((uintptr_t)(p) & LIB_WORD_MASK) == 0)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
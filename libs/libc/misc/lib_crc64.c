@@ -223,6 +223,664 @@ static const uint64_t crc64_tab[256] =
 };
 #endif
 
+/* Tables for slice-by-8.  crc64_slice8_tab[k][i] is the CRC of the byte i
+ * followed by k + 1 zero bytes.  Each row is derived from the previous one
+ * (crc64_tab for k = 0) as:
+ *
+ *   crc64_slice8_tab[k][i] = (prev[i] << 8) ^ crc64_tab[prev[i] >> 56]
+ */
+
+#ifdef CONFIG_LIBC_CRC64_SLICE8
+static const uint64_t crc64_slice8_tab[7][256] =
+{
+  {
+    0x0000000000000000, 0xaf052a6b538edf09, 0x1cfab53d0ef78881,
+    0xb3ff9f565d795788, 0x39f56a7a1def1102, 0x96f040114e61ce0b,
+    0x250fdf4713189983, 0x8a0af52c4096468a, 0x73ead4f43bde2204,
+    0xdceffe9f6850fd0d, 0x6f1061c93529aa85, 0xc0154ba266a7758c,
+    0x4a1fbe8e26313306, 0xe51a94e575bfec0f, 0x56e50bb328c6bb87,
+    0xf9e021d87b48648e, 0xe7d5a9e877bc4408, 0x48d0838324329b01,
+    0xfb2f1cd5794bcc89, 0x542a36be2ac51380, 0xde20c3926a53550a,
+    0x7125e9f939dd8a03, 0xc2da76af64a4dd8b, 0x6ddf5cc4372a0282,
+    0x943f7d1c4c62660c, 0x3b3a57771fecb905, 0x88c5c8214295ee8d,
+    0x27c0e24a111b3184, 0xadca1766518d770e, 0x02cf3d0d0203a807,
+    0xb130a25b5f7aff8f, 0x1e3588300cf42086, 0x8d5bb23b4692be83,
+    0x225e9850151c618a, 0x91a1070648653602, 0x3ea42d6d1bebe90b,
+    0xb4aed8415b7daf81, 0x1babf22a08f37088, 0xa8546d7c558a2700,
+    0x075147170604f809, 0xfeb166cf7d4c9c87, 0x51b44ca42ec2438e,
+    0xe24bd3f273bb1406, 0x4d4ef9992035cb0f, 0xc7440cb560a38d85,
+    0x684126de332d528c, 0xdbbeb9886e540504, 0x74bb93e33ddada0d,
+    0x6a8e1bd3312efa8b, 0xc58b31b862a02582, 0x7674aeee3fd9720a,
+    0xd97184856c57ad03, 0x537b71a92cc1eb89, 0xfc7e5bc27f4f3480,
+    0x4f81c49422366308, 0xe084eeff71b8bc01, 0x1964cf270af0d88f,
+    0xb661e54c597e0786, 0x059e7a1a0407500e, 0xaa9b507157898f07,
+    0x2091a55d171fc98d, 0x8f948f3644911684, 0x3c6b106019e8410c,
+    0x936e3a0b4a669e05, 0x5847859d24cf4b95, 0xf742aff67741949c,
+    0x44bd30a02a38c314, 0xebb81acb79b61c1d, 0x61b2efe739205a97,
+    0xceb7c58c6aae859e, 0x7d485ada37d7d216, 0xd24d70b164590d1f,
+    0x2bad51691f116991, 0x84a87b024c9fb698, 0x3757e45411e6e110,
+    0x9852ce3f42683e19, 0x12583b1302fe7893, 0xbd5d11785170a79a,
+    0x0ea28e2e0c09f012, 0xa1a7a4455f872f1b, 0xbf922c7553730f9d,
+    0x1097061e00fdd094, 0xa36899485d84871c, 0x0c6db3230e0a5815,
+    0x8667460f4e9c1e9f, 0x29626c641d12c196, 0x9a9df332406b961e,
+    0x3598d95913e54917, 0xcc78f88168ad2d99, 0x637dd2ea3b23f290,
+    0xd0824dbc665aa518, 0x7f8767d735d47a11, 0xf58d92fb75423c9b,
+    0x5a88b89026cce392, 0xe97727c67bb5b41a, 0x46720dad283b6b13,
+    0xd51c37a6625df516, 0x7a191dcd31d32a1f, 0xc9e6829b6caa7d97,
+    0x66e3a8f03f24a29e, 0xece95ddc7fb2e414, 0x43ec77b72c3c3b1d,
+    0xf013e8e171456c95, 0x5f16c28a22cbb39c, 0xa6f6e3525983d712,
+    0x09f3c9390a0d081b, 0xba0c566f57745f93, 0x15097c0404fa809a,
+    0x9f038928446cc610, 0x3006a34317e21919, 0x83f93c154a9b4e91,
+    0x2cfc167e19159198, 0x32c99e4e15e1b11e, 0x9dccb425466f6e17,
+    0x2e332b731b16399f, 0x813601184898e696, 0x0b3cf434080ea01c,
+    0xa439de5f5b807f15, 0x17c6410906f9289d, 0xb8c36b625577f794,
+    0x41234aba2e3f931a, 0xee2660d17db14c13, 0x5dd9ff8720c81b9b,
+    0xf2dcd5ec7346c492, 0x78d620c033d08218, 0xd7d30aab605e5d11,
+    0x642c95fd3d270a99, 0xcb29bf966ea9d590, 0xb08f0b3a499e972a,
+    0x1f8a21511a104823, 0xac75be0747691fab, 0x0370946c14e7c0a2,
+    0x897a614054718628, 0x267f4b2b07ff5921, 0x9580d47d5a860ea9,
+    0x3a85fe160908d1a0, 0xc365dfce7240b52e, 0x6c60f5a521ce6a27,
+    0xdf9f6af37cb73daf, 0x709a40982f39e2a6, 0xfa90b5b46fafa42c,
+    0x55959fdf3c217b25, 0xe66a008961582cad, 0x496f2ae232d6f3a4,
+    0x575aa2d23e22d322, 0xf85f88b96dac0c2b, 0x4ba017ef30d55ba3,
+    0xe4a53d84635b84aa, 0x6eafc8a823cdc220, 0xc1aae2c370431d29,
+    0x72557d952d3a4aa1, 0xdd5057fe7eb495a8, 0x24b0762605fcf126,
+    0x8bb55c4d56722e2f, 0x384ac31b0b0b79a7, 0x974fe9705885a6ae,
+    0x1d451c5c1813e024, 0xb24036374b9d3f2d, 0x01bfa96116e468a5,
+    0xaeba830a456ab7ac, 0x3dd4b9010f0c29a9, 0x92d1936a5c82f6a0,
+    0x212e0c3c01fba128, 0x8e2b265752757e21, 0x0421d37b12e338ab,
+    0xab24f910416de7a2, 0x18db66461c14b02a, 0xb7de4c2d4f9a6f23,
+    0x4e3e6df534d20bad, 0xe13b479e675cd4a4, 0x52c4d8c83a25832c,
+    0xfdc1f2a369ab5c25, 0x77cb078f293d1aaf, 0xd8ce2de47ab3c5a6,
+    0x6b31b2b227ca922e, 0xc43498d974444d27, 0xda0110e978b06da1,
+    0x75043a822b3eb2a8, 0xc6fba5d47647e520, 0x69fe8fbf25c93a29,
+    0xe3f47a93655f7ca3, 0x4cf150f836d1a3aa, 0xff0ecfae6ba8f422,
+    0x500be5c538262b2b, 0xa9ebc41d436e4fa5, 0x06eeee7610e090ac,
+    0xb51171204d99c724, 0x1a145b4b1e17182d, 0x901eae675e815ea7,
+    0x3f1b840c0d0f81ae, 0x8ce41b5a5076d626, 0x23e1313103f8092f,
+    0xe8c88ea76d51dcbf, 0x47cda4cc3edf03b6, 0xf4323b9a63a6543e,
+    0x5b3711f130288b37, 0xd13de4dd70becdbd, 0x7e38ceb6233012b4,
+    0xcdc751e07e49453c, 0x62c27b8b2dc79a35, 0x9b225a53568ffebb,
+    0x34277038050121b2, 0x87d8ef6e5878763a, 0x28ddc5050bf6a933,
+    0xa2d730294b60efb9, 0x0dd21a4218ee30b0, 0xbe2d851445976738,
+    0x1128af7f1619b831, 0x0f1d274f1aed98b7, 0xa0180d24496347be,
+    0x13e79272141a1036, 0xbce2b8194794cf3f, 0x36e84d35070289b5,
+    0x99ed675e548c56bc, 0x2a12f80809f50134, 0x8517d2635a7bde3d,
+    0x7cf7f3bb2133bab3, 0xd3f2d9d072bd65ba, 0x600d46862fc43232,
+    0xcf086ced7c4aed3b, 0x450299c13cdcabb1, 0xea07b3aa6f5274b8,
+    0x59f82cfc322b2330, 0xf6fd069761a5fc39, 0x65933c9c2bc3623c,
+    0xca9616f7784dbd35, 0x796989a12534eabd, 0xd66ca3ca76ba35b4,
+    0x5c6656e6362c733e, 0xf3637c8d65a2ac37, 0x409ce3db38dbfbbf,
+    0xef99c9b06b5524b6, 0x1679e868101d4038, 0xb97cc20343939f31,
+    0x0a835d551eeac8b9, 0xa586773e4d6417b0, 0x2f8c82120df2513a,
+    0x8089a8795e7c8e33, 0x3376372f0305d9bb, 0x9c731d44508b06b2,
+    0x824695745c7f2634, 0x2d43bf1f0ff1f93d, 0x9ebc20495288aeb5,
+    0x31b90a22010671bc, 0xbbb3ff0e41903736, 0x14b6d565121ee83f,
+    0xa7494a334f67bfb7, 0x084c60581ce960be, 0xf1ac418067a10430,
+    0x5ea96beb342fdb39, 0xed56f4bd69568cb1, 0x4253ded63ad853b8,
+    0xc8592bfa7a4e1532, 0x675c019129c0ca3b, 0xd4a39ec774b99db3,
+    0x7ba6b4ac273742ba
+  },
+  {
+    0x0000000000000000, 0x23eef79f3ad718c7, 0x47ddef3e75ae318e,
+    0x643318a14f792949, 0x8fbbde7ceb5c631c, 0xac5529e3d18b7bdb,
+    0xc86631429ef25292, 0xeb88c6dda4254a55, 0x5d875d127f52f0ab,
+    0x7e69aa8d4585e86c, 0x1a5ab22c0afcc125, 0x39b445b3302bd9e2,
+    0xd23c836e940e93b7, 0xf1d274f1aed98b70, 0x95e16c50e1a0a239,
+    0xb60f9bcfdb77bafe, 0xbb0eba24fea5e156, 0x98e04dbbc472f991,
+    0xfcd3551a8b0bd0d8, 0xdf3da285b1dcc81f, 0x34b5645815f9824a,
+    0x175b93c72f2e9a8d, 0x73688b666057b3c4, 0x50867cf95a80ab03,
+    0xe689e73681f711fd, 0xc56710a9bb20093a, 0xa1540808f4592073,
+    0x82baff97ce8e38b4, 0x6932394a6aab72e1, 0x4adcced5507c6a26,
+    0x2eefd6741f05436f, 0x0d0121eb25d25ba8, 0x34ed95a254a1f43f,
+    0x1703623d6e76ecf8, 0x73307a9c210fc5b1, 0x50de8d031bd8dd76,
+    0xbb564bdebffd9723, 0x98b8bc41852a8fe4, 0xfc8ba4e0ca53a6ad,
+    0xdf65537ff084be6a, 0x696ac8b02bf30494, 0x4a843f2f11241c53,
+    0x2eb7278e5e5d351a, 0x0d59d011648a2ddd, 0xe6d116ccc0af6788,
+    0xc53fe153fa787f4f, 0xa10cf9f2b5015606, 0x82e20e6d8fd64ec1,
+    0x8fe32f86aa041569, 0xac0dd81990d30dae, 0xc83ec0b8dfaa24e7,
+    0xebd03727e57d3c20, 0x0058f1fa41587675, 0x23b606657b8f6eb2,
+    0x47851ec434f647fb, 0x646be95b0e215f3c, 0xd2647294d556e5c2,
+    0xf18a850bef81fd05, 0x95b99daaa0f8d44c, 0xb6576a359a2fcc8b,
+    0x5ddface83e0a86de, 0x7e315b7704dd9e19, 0x1a0243d64ba4b750,
+    0x39ecb4497173af97, 0x69db2b44a943e87e, 0x4a35dcdb9394f0b9,
+    0x2e06c47adcedd9f0, 0x0de833e5e63ac137, 0xe660f538421f8b62,
+    0xc58e02a778c893a5, 0xa1bd1a0637b1baec, 0x8253ed990d66a22b,
+    0x345c7656d61118d5, 0x17b281c9ecc60012, 0x73819968a3bf295b,
+    0x506f6ef79968319c, 0xbbe7a82a3d4d7bc9, 0x98095fb5079a630e,
+    0xfc3a471448e34a47, 0xdfd4b08b72345280, 0xd2d5916057e60928,
+    0xf13b66ff6d3111ef, 0x95087e5e224838a6, 0xb6e689c1189f2061,
+    0x5d6e4f1cbcba6a34, 0x7e80b883866d72f3, 0x1ab3a022c9145bba,
+    0x395d57bdf3c3437d, 0x8f52cc7228b4f983, 0xacbc3bed1263e144,
+    0xc88f234c5d1ac80d, 0xeb61d4d367cdd0ca, 0x00e9120ec3e89a9f,
+    0x2307e591f93f8258, 0x4734fd30b646ab11, 0x64da0aaf8c91b3d6,
+    0x5d36bee6fde21c41, 0x7ed84979c7350486, 0x1aeb51d8884c2dcf,
+    0x3905a647b29b3508, 0xd28d609a16be7f5d, 0xf16397052c69679a,
+    0x95508fa463104ed3, 0xb6be783b59c75614, 0x00b1e3f482b0ecea,
+    0x235f146bb867f42d, 0x476c0ccaf71edd64, 0x6482fb55cdc9c5a3,
+    0x8f0a3d8869ec8ff6, 0xace4ca17533b9731, 0xc8d7d2b61c42be78,
+    0xeb3925292695a6bf, 0xe63804c20347fd17, 0xc5d6f35d3990e5d0,
+    0xa1e5ebfc76e9cc99, 0x820b1c634c3ed45e, 0x6983dabee81b9e0b,
+    0x4a6d2d21d2cc86cc, 0x2e5e35809db5af85, 0x0db0c21fa762b742,
+    0xbbbf59d07c150dbc, 0x9851ae4f46c2157b, 0xfc62b6ee09bb3c32,
+    0xdf8c4171336c24f5, 0x340487ac97496ea0, 0x17ea7033ad9e7667,
+    0x73d96892e2e75f2e, 0x50379f0dd83047e9, 0xd3b656895287d0fc,
+    0xf058a1166850c83b, 0x946bb9b72729e172, 0xb7854e281dfef9b5,
+    0x5c0d88f5b9dbb3e0, 0x7fe37f6a830cab27, 0x1bd067cbcc75826e,
+    0x383e9054f6a29aa9, 0x8e310b9b2dd52057, 0xaddffc0417023890,
+    0xc9ece4a5587b11d9, 0xea02133a62ac091e, 0x018ad5e7c689434b,
+    0x22642278fc5e5b8c, 0x46573ad9b32772c5, 0x65b9cd4689f06a02,
+    0x68b8ecadac2231aa, 0x4b561b3296f5296d, 0x2f650393d98c0024,
+    0x0c8bf40ce35b18e3, 0xe70332d1477e52b6, 0xc4edc54e7da94a71,
+    0xa0deddef32d06338, 0x83302a7008077bff, 0x353fb1bfd370c101,
+    0x16d14620e9a7d9c6, 0x72e25e81a6def08f, 0x510ca91e9c09e848,
+    0xba846fc3382ca21d, 0x996a985c02fbbada, 0xfd5980fd4d829393,
+    0xdeb7776277558b54, 0xe75bc32b062624c3, 0xc4b534b43cf13c04,
+    0xa0862c157388154d, 0x8368db8a495f0d8a, 0x68e01d57ed7a47df,
+    0x4b0eeac8d7ad5f18, 0x2f3df26998d47651, 0x0cd305f6a2036e96,
+    0xbadc9e397974d468, 0x993269a643a3ccaf, 0xfd0171070cdae5e6,
+    0xdeef8698360dfd21, 0x356740459228b774, 0x1689b7daa8ffafb3,
+    0x72baaf7be78686fa, 0x515458e4dd519e3d, 0x5c55790ff883c595,
+    0x7fbb8e90c254dd52, 0x1b8896318d2df41b, 0x386661aeb7faecdc,
+    0xd3eea77313dfa689, 0xf00050ec2908be4e, 0x9433484d66719707,
+    0xb7ddbfd25ca68fc0, 0x01d2241d87d1353e, 0x223cd382bd062df9,
+    0x460fcb23f27f04b0, 0x65e13cbcc8a81c77, 0x8e69fa616c8d5622,
+    0xad870dfe565a4ee5, 0xc9b4155f192367ac, 0xea5ae2c023f47f6b,
+    0xba6d7dcdfbc43882, 0x99838a52c1132045, 0xfdb092f38e6a090c,
+    0xde5e656cb4bd11cb, 0x35d6a3b110985b9e, 0x1638542e2a4f4359,
+    0x720b4c8f65366a10, 0x51e5bb105fe172d7, 0xe7ea20df8496c829,
+    0xc404d740be41d0ee, 0xa037cfe1f138f9a7, 0x83d9387ecbefe160,
+    0x6851fea36fcaab35, 0x4bbf093c551db3f2, 0x2f8c119d1a649abb,
+    0x0c62e60220b3827c, 0x0163c7e90561d9d4, 0x228d30763fb6c113,
+    0x46be28d770cfe85a, 0x6550df484a18f09d, 0x8ed81995ee3dbac8,
+    0xad36ee0ad4eaa20f, 0xc905f6ab9b938b46, 0xeaeb0134a1449381,
+    0x5ce49afb7a33297f, 0x7f0a6d6440e431b8, 0x1b3975c50f9d18f1,
+    0x38d7825a354a0036, 0xd35f4487916f4a63, 0xf0b1b318abb852a4,
+    0x9482abb9e4c17bed, 0xb76c5c26de16632a, 0x8e80e86faf65ccbd,
+    0xad6e1ff095b2d47a, 0xc95d0751dacbfd33, 0xeab3f0cee01ce5f4,
+    0x013b36134439afa1, 0x22d5c18c7eeeb766, 0x46e6d92d31979e2f,
+    0x65082eb20b4086e8, 0xd307b57dd0373c16, 0xf0e942e2eae024d1,
+    0x94da5a43a5990d98, 0xb734addc9f4e155f, 0x5cbc6b013b6b5f0a,
+    0x7f529c9e01bc47cd, 0x1b61843f4ec56e84, 0x388f73a074127643,
+    0x358e524b51c02deb, 0x1660a5d46b17352c, 0x7253bd75246e1c65,
+    0x51bd4aea1eb904a2, 0xba358c37ba9c4ef7, 0x99db7ba8804b5630,
+    0xfde86309cf327f79, 0xde069496f5e567be, 0x68090f592e92dd40,
+    0x4be7f8c61445c587, 0x2fd4e0675b3cecce, 0x0c3a17f861ebf409,
+    0xe7b2d125c5cebe5c, 0xc45c26baff19a69b, 0xa06f3e1bb0608fd2,
+    0x8381c9848ab79715
+  },
+  {
+    0x0000000000000000, 0xe59c4cf90ce5976b, 0x89c87819b0211845,
+    0x6c5434e0bcc48f2e, 0x516011d8c9a80619, 0xb4fc5d21c54d9172,
+    0xd8a869c179891e5c, 0x3d342538756c8937, 0xa2c023b193500c32,
+    0x475c6f489fb59b59, 0x2b085ba823711477, 0xce9417512f94831c,
+    0xf3a032695af80a2b, 0x163c7e90561d9d40, 0x7a684a70ead9126e,
+    0x9ff40689e63c8505, 0x0770a6888f4a2ef7, 0xe2ecea7183afb99c,
+    0x8eb8de913f6b36b2, 0x6b249268338ea1d9, 0x5610b75046e228ee,
+    0xb38cfba94a07bf85, 0xdfd8cf49f6c330ab, 0x3a4483b0fa26a7c0,
+    0xa5b085391c1a22c5, 0x402cc9c010ffb5ae, 0x2c78fd20ac3b3a80,
+    0xc9e4b1d9a0deadeb, 0xf4d094e1d5b224dc, 0x114cd818d957b3b7,
+    0x7d18ecf865933c99, 0x9884a0016976abf2, 0x0ee14d111e945dee,
+    0xeb7d01e81271ca85, 0x87293508aeb545ab, 0x62b579f1a250d2c0,
+    0x5f815cc9d73c5bf7, 0xba1d1030dbd9cc9c, 0xd64924d0671d43b2,
+    0x33d568296bf8d4d9, 0xac216ea08dc451dc, 0x49bd22598121c6b7,
+    0x25e916b93de54999, 0xc0755a403100def2, 0xfd417f78446c57c5,
+    0x18dd33814889c0ae, 0x74890761f44d4f80, 0x91154b98f8a8d8eb,
+    0x0991eb9991de7319, 0xec0da7609d3be472, 0x8059938021ff6b5c,
+    0x65c5df792d1afc37, 0x58f1fa4158767500, 0xbd6db6b85493e26b,
+    0xd1398258e8576d45, 0x34a5cea1e4b2fa2e, 0xab51c828028e7f2b,
+    0x4ecd84d10e6be840, 0x2299b031b2af676e, 0xc705fcc8be4af005,
+    0xfa31d9f0cb267932, 0x1fad9509c7c3ee59, 0x73f9a1e97b076177,
+    0x9665ed1077e2f61c, 0x1dc29a223d28bbdc, 0xf85ed6db31cd2cb7,
+    0x940ae23b8d09a399, 0x7196aec281ec34f2, 0x4ca28bfaf480bdc5,
+    0xa93ec703f8652aae, 0xc56af3e344a1a580, 0x20f6bf1a484432eb,
+    0xbf02b993ae78b7ee, 0x5a9ef56aa29d2085, 0x36cac18a1e59afab,
+    0xd3568d7312bc38c0, 0xee62a84b67d0b1f7, 0x0bfee4b26b35269c,
+    0x67aad052d7f1a9b2, 0x82369cabdb143ed9, 0x1ab23caab262952b,
+    0xff2e7053be870240, 0x937a44b302438d6e, 0x76e6084a0ea61a05,
+    0x4bd22d727bca9332, 0xae4e618b772f0459, 0xc21a556bcbeb8b77,
+    0x27861992c70e1c1c, 0xb8721f1b21329919, 0x5dee53e22dd70e72,
+    0x31ba67029113815c, 0xd4262bfb9df61637, 0xe9120ec3e89a9f00,
+    0x0c8e423ae47f086b, 0x60da76da58bb8745, 0x85463a23545e102e,
+    0x1323d73323bce632, 0xf6bf9bca2f597159, 0x9aebaf2a939dfe77,
+    0x7f77e3d39f78691c, 0x4243c6ebea14e02b, 0xa7df8a12e6f17740,
+    0xcb8bbef25a35f86e, 0x2e17f20b56d06f05, 0xb1e3f482b0ecea00,
+    0x547fb87bbc097d6b, 0x382b8c9b00cdf245, 0xddb7c0620c28652e,
+    0xe083e55a7944ec19, 0x051fa9a375a17b72, 0x694b9d43c965f45c,
+    0x8cd7d1bac5806337, 0x145371bbacf6c8c5, 0xf1cf3d42a0135fae,
+    0x9d9b09a21cd7d080, 0x7807455b103247eb, 0x45336063655ecedc,
+    0xa0af2c9a69bb59b7, 0xccfb187ad57fd699, 0x29675483d99a41f2,
+    0xb693520a3fa6c4f7, 0x530f1ef33343539c, 0x3f5b2a138f87dcb2,
+    0xdac766ea83624bd9, 0xe7f343d2f60ec2ee, 0x026f0f2bfaeb5585,
+    0x6e3b3bcb462fdaab, 0x8ba777324aca4dc0, 0x3b8534447a5177b8,
+    0xde1978bd76b4e0d3, 0xb24d4c5dca706ffd, 0x57d100a4c695f896,
+    0x6ae5259cb3f971a1, 0x8f796965bf1ce6ca, 0xe32d5d8503d869e4,
+    0x06b1117c0f3dfe8f, 0x994517f5e9017b8a, 0x7cd95b0ce5e4ece1,
+    0x108d6fec592063cf, 0xf511231555c5f4a4, 0xc825062d20a97d93,
+    0x2db94ad42c4ceaf8, 0x41ed7e34908865d6, 0xa47132cd9c6df2bd,
+    0x3cf592ccf51b594f, 0xd969de35f9fece24, 0xb53dead5453a410a,
+    0x50a1a62c49dfd661, 0x6d9583143cb35f56, 0x8809cfed3056c83d,
+    0xe45dfb0d8c924713, 0x01c1b7f48077d078, 0x9e35b17d664b557d,
+    0x7ba9fd846aaec216, 0x17fdc964d66a4d38, 0xf261859dda8fda53,
+    0xcf55a0a5afe35364, 0x2ac9ec5ca306c40f, 0x469dd8bc1fc24b21,
+    0xa30194451327dc4a, 0x3564795564c52a56, 0xd0f835ac6820bd3d,
+    0xbcac014cd4e43213, 0x59304db5d801a578, 0x6404688dad6d2c4f,
+    0x81982474a188bb24, 0xedcc10941d4c340a, 0x08505c6d11a9a361,
+    0x97a45ae4f7952664, 0x7238161dfb70b10f, 0x1e6c22fd47b43e21,
+    0xfbf06e044b51a94a, 0xc6c44b3c3e3d207d, 0x235807c532d8b716,
+    0x4f0c33258e1c3838, 0xaa907fdc82f9af53, 0x3214dfddeb8f04a1,
+    0xd7889324e76a93ca, 0xbbdca7c45bae1ce4, 0x5e40eb3d574b8b8f,
+    0x6374ce05222702b8, 0x86e882fc2ec295d3, 0xeabcb61c92061afd,
+    0x0f20fae59ee38d96, 0x90d4fc6c78df0893, 0x7548b095743a9ff8,
+    0x191c8475c8fe10d6, 0xfc80c88cc41b87bd, 0xc1b4edb4b1770e8a,
+    0x2428a14dbd9299e1, 0x487c95ad015616cf, 0xade0d9540db381a4,
+    0x2647ae664779cc64, 0xc3dbe29f4b9c5b0f, 0xaf8fd67ff758d421,
+    0x4a139a86fbbd434a, 0x7727bfbe8ed1ca7d, 0x92bbf34782345d16,
+    0xfeefc7a73ef0d238, 0x1b738b5e32154553, 0x84878dd7d429c056,
+    0x611bc12ed8cc573d, 0x0d4ff5ce6408d813, 0xe8d3b93768ed4f78,
+    0xd5e79c0f1d81c64f, 0x307bd0f611645124, 0x5c2fe416ada0de0a,
+    0xb9b3a8efa1454961, 0x213708eec833e293, 0xc4ab4417c4d675f8,
+    0xa8ff70f77812fad6, 0x4d633c0e74f76dbd, 0x70571936019be48a,
+    0x95cb55cf0d7e73e1, 0xf99f612fb1bafccf, 0x1c032dd6bd5f6ba4,
+    0x83f72b5f5b63eea1, 0x666b67a6578679ca, 0x0a3f5346eb42f6e4,
+    0xefa31fbfe7a7618f, 0xd2973a8792cbe8b8, 0x370b767e9e2e7fd3,
+    0x5b5f429e22eaf0fd, 0xbec30e672e0f6796, 0x28a6e37759ed918a,
+    0xcd3aaf8e550806e1, 0xa16e9b6ee9cc89cf, 0x44f2d797e5291ea4,
+    0x79c6f2af90459793, 0x9c5abe569ca000f8, 0xf00e8ab620648fd6,
+    0x1592c64f2c8118bd, 0x8a66c0c6cabd9db8, 0x6ffa8c3fc6580ad3,
+    0x03aeb8df7a9c85fd, 0xe632f42676791296, 0xdb06d11e03159ba1,
+    0x3e9a9de70ff00cca, 0x52cea907b33483e4, 0xb752e5febfd1148f,
+    0x2fd645ffd6a7bf7d, 0xca4a0906da422816, 0xa61e3de66686a738,
+    0x4382711f6a633053, 0x7eb654271f0fb964, 0x9b2a18de13ea2e0f,
+    0xf77e2c3eaf2ea121, 0x12e260c7a3cb364a, 0x8d16664e45f7b34f,
+    0x688a2ab749122424, 0x04de1e57f5d6ab0a, 0xe14252aef9333c61,
+    0xdc7677968c5fb556, 0x39ea3b6f80ba223d, 0x55be0f8f3c7ead13,
+    0xb0224376309b3a78
+  },
+  {
+    0x0000000000000000, 0x770a6888f4a2ef70, 0xee14d111e945dee0,
+    0x991eb9991de73190, 0x9ed943c87b618b53, 0xe9d32b408fc36423,
+    0x70cd92d9922455b3, 0x07c7fa516686bac3, 0x7f42667b5f292035,
+    0x08480ef3ab8bcf45, 0x9156b76ab66cfed5, 0xe65cdfe242ce11a5,
+    0xe19b25b32448ab66, 0x96914d3bd0ea4416, 0x0f8ff4a2cd0d7586,
+    0x78859c2a39af9af6, 0xfe84ccf6be52406a, 0x898ea47e4af0af1a,
+    0x10901de757179e8a, 0x679a756fa3b571fa, 0x605d8f3ec533cb39,
+    0x1757e7b631912449, 0x8e495e2f2c7615d9, 0xf94336a7d8d4faa9,
+    0x81c6aa8de17b605f, 0xf6ccc20515d98f2f, 0x6fd27b9c083ebebf,
+    0x18d81314fc9c51cf, 0x1f1fe9459a1aeb0c, 0x681581cd6eb8047c,
+    0xf10b3854735f35ec, 0x860150dc87fdda9c, 0xbff97806d54eb647,
+    0xc8f3108e21ec5937, 0x51eda9173c0b68a7, 0x26e7c19fc8a987d7,
+    0x21203bceae2f3d14, 0x562a53465a8dd264, 0xcf34eadf476ae3f4,
+    0xb83e8257b3c80c84, 0xc0bb1e7d8a679672, 0xb7b176f57ec57902,
+    0x2eafcf6c63224892, 0x59a5a7e49780a7e2, 0x5e625db5f1061d21,
+    0x2968353d05a4f251, 0xb0768ca41843c3c1, 0xc77ce42cece12cb1,
+    0x417db4f06b1cf62d, 0x3677dc789fbe195d, 0xaf6965e1825928cd,
+    0xd8630d6976fbc7bd, 0xdfa4f738107d7d7e, 0xa8ae9fb0e4df920e,
+    0x31b02629f938a39e, 0x46ba4ea10d9a4cee, 0x3e3fd28b3435d618,
+    0x4935ba03c0973968, 0xd02b039add7008f8, 0xa7216b1229d2e788,
+    0xa0e691434f545d4b, 0xd7ecf9cbbbf6b23b, 0x4ef24052a61183ab,
+    0x39f828da52b36cdb, 0x3d0211e603775a1d, 0x4a08796ef7d5b56d,
+    0xd316c0f7ea3284fd, 0xa41ca87f1e906b8d, 0xa3db522e7816d14e,
+    0xd4d13aa68cb43e3e, 0x4dcf833f91530fae, 0x3ac5ebb765f1e0de,
+    0x4240779d5c5e7a28, 0x354a1f15a8fc9558, 0xac54a68cb51ba4c8,
+    0xdb5ece0441b94bb8, 0xdc993455273ff17b, 0xab935cddd39d1e0b,
+    0x328de544ce7a2f9b, 0x45878dcc3ad8c0eb, 0xc386dd10bd251a77,
+    0xb48cb5984987f507, 0x2d920c015460c497, 0x5a986489a0c22be7,
+    0x5d5f9ed8c6449124, 0x2a55f65032e67e54, 0xb34b4fc92f014fc4,
+    0xc4412741dba3a0b4, 0xbcc4bb6be20c3a42, 0xcbced3e316aed532,
+    0x52d06a7a0b49e4a2, 0x25da02f2ffeb0bd2, 0x221df8a3996db111,
+    0x5517902b6dcf5e61, 0xcc0929b270286ff1, 0xbb03413a848a8081,
+    0x82fb69e0d639ec5a, 0xf5f10168229b032a, 0x6cefb8f13f7c32ba,
+    0x1be5d079cbdeddca, 0x1c222a28ad586709, 0x6b2842a059fa8879,
+    0xf236fb39441db9e9, 0x853c93b1b0bf5699, 0xfdb90f9b8910cc6f,
+    0x8ab367137db2231f, 0x13adde8a6055128f, 0x64a7b60294f7fdff,
+    0x63604c53f271473c, 0x146a24db06d3a84c, 0x8d749d421b3499dc,
+    0xfa7ef5caef9676ac, 0x7c7fa516686bac30, 0x0b75cd9e9cc94340,
+    0x926b7407812e72d0, 0xe5611c8f758c9da0, 0xe2a6e6de130a2763,
+    0x95ac8e56e7a8c813, 0x0cb237cffa4ff983, 0x7bb85f470eed16f3,
+    0x033dc36d37428c05, 0x7437abe5c3e06375, 0xed29127cde0752e5,
+    0x9a237af42aa5bd95, 0x9de480a54c230756, 0xeaeee82db881e826,
+    0x73f051b4a566d9b6, 0x04fa393c51c436c6, 0x7a0423cc06eeb43a,
+    0x0d0e4b44f24c5b4a, 0x9410f2ddefab6ada, 0xe31a9a551b0985aa,
+    0xe4dd60047d8f3f69, 0x93d7088c892dd019, 0x0ac9b11594cae189,
+    0x7dc3d99d60680ef9, 0x054645b759c7940f, 0x724c2d3fad657b7f,
+    0xeb5294a6b0824aef, 0x9c58fc2e4420a59f, 0x9b9f067f22a61f5c,
+    0xec956ef7d604f02c, 0x758bd76ecbe3c1bc, 0x0281bfe63f412ecc,
+    0x8480ef3ab8bcf450, 0xf38a87b24c1e1b20, 0x6a943e2b51f92ab0,
+    0x1d9e56a3a55bc5c0, 0x1a59acf2c3dd7f03, 0x6d53c47a377f9073,
+    0xf44d7de32a98a1e3, 0x8347156bde3a4e93, 0xfbc28941e795d465,
+    0x8cc8e1c913373b15, 0x15d658500ed00a85, 0x62dc30d8fa72e5f5,
+    0x651bca899cf45f36, 0x1211a2016856b046, 0x8b0f1b9875b181d6,
+    0xfc05731081136ea6, 0xc5fd5bcad3a0027d, 0xb2f733422702ed0d,
+    0x2be98adb3ae5dc9d, 0x5ce3e253ce4733ed, 0x5b241802a8c1892e,
+    0x2c2e708a5c63665e, 0xb530c913418457ce, 0xc23aa19bb526b8be,
+    0xbabf3db18c892248, 0xcdb55539782bcd38, 0x54abeca065ccfca8,
+    0x23a18428916e13d8, 0x24667e79f7e8a91b, 0x536c16f1034a466b,
+    0xca72af681ead77fb, 0xbd78c7e0ea0f988b, 0x3b79973c6df24217,
+    0x4c73ffb49950ad67, 0xd56d462d84b79cf7, 0xa2672ea570157387,
+    0xa5a0d4f41693c944, 0xd2aabc7ce2312634, 0x4bb405e5ffd617a4,
+    0x3cbe6d6d0b74f8d4, 0x443bf14732db6222, 0x333199cfc6798d52,
+    0xaa2f2056db9ebcc2, 0xdd2548de2f3c53b2, 0xdae2b28f49bae971,
+    0xade8da07bd180601, 0x34f6639ea0ff3791, 0x43fc0b16545dd8e1,
+    0x4706322a0599ee27, 0x300c5aa2f13b0157, 0xa912e33becdc30c7,
+    0xde188bb3187edfb7, 0xd9df71e27ef86574, 0xaed5196a8a5a8a04,
+    0x37cba0f397bdbb94, 0x40c1c87b631f54e4, 0x384454515ab0ce12,
+    0x4f4e3cd9ae122162, 0xd6508540b3f510f2, 0xa15aedc84757ff82,
+    0xa69d179921d14541, 0xd1977f11d573aa31, 0x4889c688c8949ba1,
+    0x3f83ae003c3674d1, 0xb982fedcbbcbae4d, 0xce8896544f69413d,
+    0x57962fcd528e70ad, 0x209c4745a62c9fdd, 0x275bbd14c0aa251e,
+    0x5051d59c3408ca6e, 0xc94f6c0529effbfe, 0xbe45048ddd4d148e,
+    0xc6c098a7e4e28e78, 0xb1caf02f10406108, 0x28d449b60da75098,
+    0x5fde213ef905bfe8, 0x5819db6f9f83052b, 0x2f13b3e76b21ea5b,
+    0xb60d0a7e76c6dbcb, 0xc10762f6826434bb, 0xf8ff4a2cd0d75860,
+    0x8ff522a42475b710, 0x16eb9b3d39928680, 0x61e1f3b5cd3069f0,
+    0x662609e4abb6d333, 0x112c616c5f143c43, 0x8832d8f542f30dd3,
+    0xff38b07db651e2a3, 0x87bd2c578ffe7855, 0xf0b744df7b5c9725,
+    0x69a9fd4666bba6b5, 0x1ea395ce921949c5, 0x19646f9ff49ff306,
+    0x6e6e0717003d1c76, 0xf770be8e1dda2de6, 0x807ad606e978c296,
+    0x067b86da6e85180a, 0x7171ee529a27f77a, 0xe86f57cb87c0c6ea,
+    0x9f653f437362299a, 0x98a2c51215e49359, 0xefa8ad9ae1467c29,
+    0x76b61403fca14db9, 0x01bc7c8b0803a2c9, 0x7939e0a131ac383f,
+    0x0e338829c50ed74f, 0x972d31b0d8e9e6df, 0xe02759382c4b09af,
+    0xe7e0a3694acdb36c, 0x90eacbe1be6f5c1c, 0x09f47278a3886d8c,
+    0x7efe1af0572a82fc
+  },
+  {
+    0x0000000000000000, 0xf40847980ddd6874, 0xaae06edbb250e67b,
+    0x5ee82943bf8d8e0f, 0x17303c5ccd4bfa65, 0xe3387bc4c0969211,
+    0xbdd052877f1b1c1e, 0x49d8151f72c6746a, 0x2e6078b99a97f4ca,
+    0xda683f21974a9cbe, 0x8480166228c712b1, 0x708851fa251a7ac5,
+    0x395044e557dc0eaf, 0xcd58037d5a0166db, 0x93b02a3ee58ce8d4,
+    0x67b86da6e85180a0, 0x5cc0f173352fe994, 0xa8c8b6eb38f281e0,
+    0xf6209fa8877f0fef, 0x0228d8308aa2679b, 0x4bf0cd2ff86413f1,
+    0xbff88ab7f5b97b85, 0xe110a3f44a34f58a, 0x1518e46c47e99dfe,
+    0x72a089caafb81d5e, 0x86a8ce52a265752a, 0xd840e7111de8fb25,
+    0x2c48a08910359351, 0x6590b59662f3e73b, 0x9198f20e6f2e8f4f,
+    0xcf70db4dd0a30140, 0x3b789cd5dd7e6934, 0xb981e2e66a5fd328,
+    0x4d89a57e6782bb5c, 0x13618c3dd80f3553, 0xe769cba5d5d25d27,
+    0xaeb1debaa714294d, 0x5ab99922aac94139, 0x0451b0611544cf36,
+    0xf059f7f91899a742, 0x97e19a5ff0c827e2, 0x63e9ddc7fd154f96,
+    0x3d01f4844298c199, 0xc909b31c4f45a9ed, 0x80d1a6033d83dd87,
+    0x74d9e19b305eb5f3, 0x2a31c8d88fd33bfc, 0xde398f40820e5388,
+    0xe54113955f703abc, 0x1149540d52ad52c8, 0x4fa17d4eed20dcc7,
+    0xbba93ad6e0fdb4b3, 0xf2712fc9923bc0d9, 0x067968519fe6a8ad,
+    0x58914112206b26a2, 0xac99068a2db64ed6, 0xcb216b2cc5e7ce76,
+    0x3f292cb4c83aa602, 0x61c105f777b7280d, 0x95c9426f7a6a4079,
+    0xdc11577008ac3413, 0x281910e805715c67, 0x76f139abbafcd268,
+    0x82f97e33b721ba1c, 0x31f324277d5590c3, 0xc5fb63bf7088f8b7,
+    0x9b134afccf0576b8, 0x6f1b0d64c2d81ecc, 0x26c3187bb01e6aa6,
+    0xd2cb5fe3bdc302d2, 0x8c2376a0024e8cdd, 0x782b31380f93e4a9,
+    0x1f935c9ee7c26409, 0xeb9b1b06ea1f0c7d, 0xb573324555928272,
+    0x417b75dd584fea06, 0x08a360c22a899e6c, 0xfcab275a2754f618,
+    0xa2430e1998d97817, 0x564b498195041063, 0x6d33d554487a7957,
+    0x993b92cc45a71123, 0xc7d3bb8ffa2a9f2c, 0x33dbfc17f7f7f758,
+    0x7a03e90885318332, 0x8e0bae9088eceb46, 0xd0e387d337616549,
+    0x24ebc04b3abc0d3d, 0x4353adedd2ed8d9d, 0xb75bea75df30e5e9,
+    0xe9b3c33660bd6be6, 0x1dbb84ae6d600392, 0x546391b11fa677f8,
+    0xa06bd629127b1f8c, 0xfe83ff6aadf69183, 0x0a8bb8f2a02bf9f7,
+    0x8872c6c1170a43eb, 0x7c7a81591ad72b9f, 0x2292a81aa55aa590,
+    0xd69aef82a887cde4, 0x9f42fa9dda41b98e, 0x6b4abd05d79cd1fa,
+    0x35a2944668115ff5, 0xc1aad3de65cc3781, 0xa612be788d9db721,
+    0x521af9e08040df55, 0x0cf2d0a33fcd515a, 0xf8fa973b3210392e,
+    0xb122822440d64d44, 0x452ac5bc4d0b2530, 0x1bc2ecfff286ab3f,
+    0xefcaab67ff5bc34b, 0xd4b237b22225aa7f, 0x20ba702a2ff8c20b,
+    0x7e52596990754c04, 0x8a5a1ef19da82470, 0xc3820beeef6e501a,
+    0x378a4c76e2b3386e, 0x696265355d3eb661, 0x9d6a22ad50e3de15,
+    0xfad24f0bb8b25eb5, 0x0eda0893b56f36c1, 0x503221d00ae2b8ce,
+    0xa43a6648073fd0ba, 0xede2735775f9a4d0, 0x19ea34cf7824cca4,
+    0x47021d8cc7a942ab, 0xb30a5a14ca742adf, 0x63e6484efaab2186,
+    0x97ee0fd6f77649f2, 0xc906269548fbc7fd, 0x3d0e610d4526af89,
+    0x74d6741237e0dbe3, 0x80de338a3a3db397, 0xde361ac985b03d98,
+    0x2a3e5d51886d55ec, 0x4d8630f7603cd54c, 0xb98e776f6de1bd38,
+    0xe7665e2cd26c3337, 0x136e19b4dfb15b43, 0x5ab60cabad772f29,
+    0xaebe4b33a0aa475d, 0xf05662701f27c952, 0x045e25e812faa126,
+    0x3f26b93dcf84c812, 0xcb2efea5c259a066, 0x95c6d7e67dd42e69,
+    0x61ce907e7009461d, 0x2816856102cf3277, 0xdc1ec2f90f125a03,
+    0x82f6ebbab09fd40c, 0x76feac22bd42bc78, 0x1146c18455133cd8,
+    0xe54e861c58ce54ac, 0xbba6af5fe743daa3, 0x4faee8c7ea9eb2d7,
+    0x0676fdd89858c6bd, 0xf27eba409585aec9, 0xac9693032a0820c6,
+    0x589ed49b27d548b2, 0xda67aaa890f4f2ae, 0x2e6fed309d299ada,
+    0x7087c47322a414d5, 0x848f83eb2f797ca1, 0xcd5796f45dbf08cb,
+    0x395fd16c506260bf, 0x67b7f82fefefeeb0, 0x93bfbfb7e23286c4,
+    0xf407d2110a630664, 0x000f958907be6e10, 0x5ee7bccab833e01f,
+    0xaaeffb52b5ee886b, 0xe337ee4dc728fc01, 0x173fa9d5caf59475,
+    0x49d7809675781a7a, 0xbddfc70e78a5720e, 0x86a75bdba5db1b3a,
+    0x72af1c43a806734e, 0x2c473500178bfd41, 0xd84f72981a569535,
+    0x919767876890e15f, 0x659f201f654d892b, 0x3b77095cdac00724,
+    0xcf7f4ec4d71d6f50, 0xa8c723623f4ceff0, 0x5ccf64fa32918784,
+    0x02274db98d1c098b, 0xf62f0a2180c161ff, 0xbff71f3ef2071595,
+    0x4bff58a6ffda7de1, 0x151771e54057f3ee, 0xe11f367d4d8a9b9a,
+    0x52156c6987feb145, 0xa61d2bf18a23d931, 0xf8f502b235ae573e,
+    0x0cfd452a38733f4a, 0x452550354ab54b20, 0xb12d17ad47682354,
+    0xefc53eeef8e5ad5b, 0x1bcd7976f538c52f, 0x7c7514d01d69458f,
+    0x887d534810b42dfb, 0xd6957a0baf39a3f4, 0x229d3d93a2e4cb80,
+    0x6b45288cd022bfea, 0x9f4d6f14ddffd79e, 0xc1a5465762725991,
+    0x35ad01cf6faf31e5, 0x0ed59d1ab2d158d1, 0xfaddda82bf0c30a5,
+    0xa435f3c10081beaa, 0x503db4590d5cd6de, 0x19e5a1467f9aa2b4,
+    0xedede6de7247cac0, 0xb305cf9dcdca44cf, 0x470d8805c0172cbb,
+    0x20b5e5a32846ac1b, 0xd4bda23b259bc46f, 0x8a558b789a164a60,
+    0x7e5dcce097cb2214, 0x3785d9ffe50d567e, 0xc38d9e67e8d03e0a,
+    0x9d65b724575db005, 0x696df0bc5a80d871, 0xeb948e8feda1626d,
+    0x1f9cc917e07c0a19, 0x4174e0545ff18416, 0xb57ca7cc522cec62,
+    0xfca4b2d320ea9808, 0x08acf54b2d37f07c, 0x5644dc0892ba7e73,
+    0xa24c9b909f671607, 0xc5f4f636773696a7, 0x31fcb1ae7aebfed3,
+    0x6f1498edc56670dc, 0x9b1cdf75c8bb18a8, 0xd2c4ca6aba7d6cc2,
+    0x26cc8df2b7a004b6, 0x7824a4b1082d8ab9, 0x8c2ce32905f0e2cd,
+    0xb7547ffcd88e8bf9, 0x435c3864d553e38d, 0x1db411276ade6d82,
+    0xe9bc56bf670305f6, 0xa06443a015c5719c, 0x546c0438181819e8,
+    0x0a842d7ba79597e7, 0xfe8c6ae3aa48ff93, 0x9934074542197f33,
+    0x6d3c40dd4fc41747, 0x33d4699ef0499948, 0xc7dc2e06fd94f13c,
+    0x8e043b198f528556, 0x7a0c7c81828fed22, 0x24e455c23d02632d,
+    0xd0ec125a30df0b59
+  },
+  {
+    0x0000000000000000, 0xc7cc909df556430c, 0xcd69c0d04346b08b,
+    0x0aa5504db610f387, 0xd823604b2f675785, 0x1feff0d6da311489,
+    0x154aa09b6c21e70e, 0xd28630069977a402, 0xf2b6217df7249999,
+    0x357ab1e00272da95, 0x3fdfe1adb4622912, 0xf813713041346a1e,
+    0x2a954136d843ce1c, 0xed59d1ab2d158d10, 0xe7fc81e69b057e97,
+    0x2030117b6e533d9b, 0xa79ca31047a305a1, 0x6050338db2f546ad,
+    0x6af563c004e5b52a, 0xad39f35df1b3f626, 0x7fbfc35b68c45224,
+    0xb87353c69d921128, 0xb2d6038b2b82e2af, 0x751a9316ded4a1a3,
+    0x552a826db0879c38, 0x92e612f045d1df34, 0x984342bdf3c12cb3,
+    0x5f8fd22006976fbf, 0x8d09e2269fe0cbbd, 0x4ac572bb6ab688b1,
+    0x406022f6dca67b36, 0x87acb26b29f0383a, 0x0dc9a7cb26ac3dd1,
+    0xca053756d3fa7edd, 0xc0a0671b65ea8d5a, 0x076cf78690bcce56,
+    0xd5eac78009cb6a54, 0x1226571dfc9d2958, 0x188307504a8ddadf,
+    0xdf4f97cdbfdb99d3, 0xff7f86b6d188a448, 0x38b3162b24dee744,
+    0x3216466692ce14c3, 0xf5dad6fb679857cf, 0x275ce6fdfeeff3cd,
+    0xe09076600bb9b0c1, 0xea35262dbda94346, 0x2df9b6b048ff004a,
+    0xaa5504db610f3870, 0x6d99944694597b7c, 0x673cc40b224988fb,
+    0xa0f05496d71fcbf7, 0x727664904e686ff5, 0xb5baf40dbb3e2cf9,
+    0xbf1fa4400d2edf7e, 0x78d334ddf8789c72, 0x58e325a6962ba1e9,
+    0x9f2fb53b637de2e5, 0x958ae576d56d1162, 0x524675eb203b526e,
+    0x80c045edb94cf66c, 0x470cd5704c1ab560, 0x4da9853dfa0a46e7,
+    0x8a6515a00f5c05eb, 0x1b934f964d587ba2, 0xdc5fdf0bb80e38ae,
+    0xd6fa8f460e1ecb29, 0x11361fdbfb488825, 0xc3b02fdd623f2c27,
+    0x047cbf4097696f2b, 0x0ed9ef0d21799cac, 0xc9157f90d42fdfa0,
+    0xe9256eebba7ce23b, 0x2ee9fe764f2aa137, 0x244cae3bf93a52b0,
+    0xe3803ea60c6c11bc, 0x31060ea0951bb5be, 0xf6ca9e3d604df6b2,
+    0xfc6fce70d65d0535, 0x3ba35eed230b4639, 0xbc0fec860afb7e03,
+    0x7bc37c1bffad3d0f, 0x71662c5649bdce88, 0xb6aabccbbceb8d84,
+    0x642c8ccd259c2986, 0xa3e01c50d0ca6a8a, 0xa9454c1d66da990d,
+    0x6e89dc80938cda01, 0x4eb9cdfbfddfe79a, 0x89755d660889a496,
+    0x83d00d2bbe995711, 0x441c9db64bcf141d, 0x969aadb0d2b8b01f,
+    0x51563d2d27eef313, 0x5bf36d6091fe0094, 0x9c3ffdfd64a84398,
+    0x165ae85d6bf44673, 0xd19678c09ea2057f, 0xdb33288d28b2f6f8,
+    0x1cffb810dde4b5f4, 0xce798816449311f6, 0x09b5188bb1c552fa,
+    0x031048c607d5a17d, 0xc4dcd85bf283e271, 0xe4ecc9209cd0dfea,
+    0x232059bd69869ce6, 0x298509f0df966f61, 0xee49996d2ac02c6d,
+    0x3ccfa96bb3b7886f, 0xfb0339f646e1cb63, 0xf1a669bbf0f138e4,
+    0x366af92605a77be8, 0xb1c64b4d2c5743d2, 0x760adbd0d90100de,
+    0x7caf8b9d6f11f359, 0xbb631b009a47b055, 0x69e52b0603301457,
+    0xae29bb9bf666575b, 0xa48cebd64076a4dc, 0x63407b4bb520e7d0,
+    0x43706a30db73da4b, 0x84bcfaad2e259947, 0x8e19aae098356ac0,
+    0x49d53a7d6d6329cc, 0x9b530a7bf4148dce, 0x5c9f9ae60142cec2,
+    0x563acaabb7523d45, 0x91f65a3642047e49, 0x37269f2c9ab0f744,
+    0xf0ea0fb16fe6b448, 0xfa4f5ffcd9f647cf, 0x3d83cf612ca004c3,
+    0xef05ff67b5d7a0c1, 0x28c96ffa4081e3cd, 0x226c3fb7f691104a,
+    0xe5a0af2a03c75346, 0xc590be516d946edd, 0x025c2ecc98c22dd1,
+    0x08f97e812ed2de56, 0xcf35ee1cdb849d5a, 0x1db3de1a42f33958,
+    0xda7f4e87b7a57a54, 0xd0da1eca01b589d3, 0x17168e57f4e3cadf,
+    0x90ba3c3cdd13f2e5, 0x5776aca12845b1e9, 0x5dd3fcec9e55426e,
+    0x9a1f6c716b030162, 0x48995c77f274a560, 0x8f55ccea0722e66c,
+    0x85f09ca7b13215eb, 0x423c0c3a446456e7, 0x620c1d412a376b7c,
+    0xa5c08ddcdf612870, 0xaf65dd916971dbf7, 0x68a94d0c9c2798fb,
+    0xba2f7d0a05503cf9, 0x7de3ed97f0067ff5, 0x7746bdda46168c72,
+    0xb08a2d47b340cf7e, 0x3aef38e7bc1cca95, 0xfd23a87a494a8999,
+    0xf786f837ff5a7a1e, 0x304a68aa0a0c3912, 0xe2cc58ac937b9d10,
+    0x2500c831662dde1c, 0x2fa5987cd03d2d9b, 0xe86908e1256b6e97,
+    0xc859199a4b38530c, 0x0f958907be6e1000, 0x0530d94a087ee387,
+    0xc2fc49d7fd28a08b, 0x107a79d1645f0489, 0xd7b6e94c91094785,
+    0xdd13b9012719b402, 0x1adf299cd24ff70e, 0x9d739bf7fbbfcf34,
+    0x5abf0b6a0ee98c38, 0x501a5b27b8f97fbf, 0x97d6cbba4daf3cb3,
+    0x4550fbbcd4d898b1, 0x829c6b21218edbbd, 0x88393b6c979e283a,
+    0x4ff5abf162c86b36, 0x6fc5ba8a0c9b56ad, 0xa8092a17f9cd15a1,
+    0xa2ac7a5a4fdde626, 0x6560eac7ba8ba52a, 0xb7e6dac123fc0128,
+    0x702a4a5cd6aa4224, 0x7a8f1a1160bab1a3, 0xbd438a8c95ecf2af,
+    0x2cb5d0bad7e88ce6, 0xeb79402722becfea, 0xe1dc106a94ae3c6d,
+    0x261080f761f87f61, 0xf496b0f1f88fdb63, 0x335a206c0dd9986f,
+    0x39ff7021bbc96be8, 0xfe33e0bc4e9f28e4, 0xde03f1c720cc157f,
+    0x19cf615ad59a5673, 0x136a3117638aa5f4, 0xd4a6a18a96dce6f8,
+    0x0620918c0fab42fa, 0xc1ec0111fafd01f6, 0xcb49515c4cedf271,
+    0x0c85c1c1b9bbb17d, 0x8b2973aa904b8947, 0x4ce5e337651dca4b,
+    0x4640b37ad30d39cc, 0x818c23e7265b7ac0, 0x530a13e1bf2cdec2,
+    0x94c6837c4a7a9dce, 0x9e63d331fc6a6e49, 0x59af43ac093c2d45,
+    0x799f52d7676f10de, 0xbe53c24a923953d2, 0xb4f692072429a055,
+    0x733a029ad17fe359, 0xa1bc329c4808475b, 0x6670a201bd5e0457,
+    0x6cd5f24c0b4ef7d0, 0xab1962d1fe18b4dc, 0x217c7771f144b137,
+    0xe6b0e7ec0412f23b, 0xec15b7a1b20201bc, 0x2bd9273c475442b0,
+    0xf95f173ade23e6b2, 0x3e9387a72b75a5be, 0x3436d7ea9d655639,
+    0xf3fa477768331535, 0xd3ca560c066028ae, 0x1406c691f3366ba2,
+    0x1ea396dc45269825, 0xd96f0641b070db29, 0x0be9364729077f2b,
+    0xcc25a6dadc513c27, 0xc680f6976a41cfa0, 0x014c660a9f178cac,
+    0x86e0d461b6e7b496, 0x412c44fc43b1f79a, 0x4b8914b1f5a1041d,
+    0x8c45842c00f74711, 0x5ec3b42a9980e313, 0x990f24b76cd6a01f,
+    0x93aa74fadac65398, 0x5466e4672f901094, 0x7456f51c41c32d0f,
+    0xb39a6581b4956e03, 0xb93f35cc02859d84, 0x7ef3a551f7d3de88,
+    0xac7595576ea47a8a, 0x6bb905ca9bf23986, 0x611c55872de2ca01,
+    0xa6d0c51ad8b4890d
+  },
+  {
+    0x0000000000000000, 0x6e4d3e593561ee88, 0xdc9a7cb26ac3dd10,
+    0xb2d742eb5fa23398, 0xfbc4188f7c6d8cb3, 0x958926d6490c623b,
+    0x275e643d16ae51a3, 0x49135a6423cfbf2b, 0xb578d0f551312ff5,
+    0xdb35eeac6450c17d, 0x69e2ac473bf2f2e5, 0x07af921e0e931c6d,
+    0x4ebcc87a2d5ca346, 0x20f1f623183d4dce, 0x9226b4c8479f7e56,
+    0xfc6b8a9172fe90de, 0x280140010b886979, 0x464c7e583ee987f1,
+    0xf49b3cb3614bb469, 0x9ad602ea542a5ae1, 0xd3c5588e77e5e5ca,
+    0xbd8866d742840b42, 0x0f5f243c1d2638da, 0x61121a652847d652,
+    0x9d7990f45ab9468c, 0xf334aead6fd8a804, 0x41e3ec46307a9b9c,
+    0x2faed21f051b7514, 0x66bd887b26d4ca3f, 0x08f0b62213b524b7,
+    0xba27f4c94c17172f, 0xd46aca907976f9a7, 0x500280021710d2f2,
+    0x3e4fbe5b22713c7a, 0x8c98fcb07dd30fe2, 0xe2d5c2e948b2e16a,
+    0xabc6988d6b7d5e41, 0xc58ba6d45e1cb0c9, 0x775ce43f01be8351,
+    0x1911da6634df6dd9, 0xe57a50f74621fd07, 0x8b376eae7340138f,
+    0x39e02c452ce22017, 0x57ad121c1983ce9f, 0x1ebe48783a4c71b4,
+    0x70f376210f2d9f3c, 0xc22434ca508faca4, 0xac690a9365ee422c,
+    0x7803c0031c98bb8b, 0x164efe5a29f95503, 0xa499bcb1765b669b,
+    0xcad482e8433a8813, 0x83c7d88c60f53738, 0xed8ae6d55594d9b0,
+    0x5f5da43e0a36ea28, 0x31109a673f5704a0, 0xcd7b10f64da9947e,
+    0xa3362eaf78c87af6, 0x11e16c44276a496e, 0x7fac521d120ba7e6,
+    0x36bf087931c418cd, 0x58f2362004a5f645, 0xea2574cb5b07c5dd,
+    0x84684a926e662b55, 0xa00500042e21a5e4, 0xce483e5d1b404b6c,
+    0x7c9f7cb644e278f4, 0x12d242ef7183967c, 0x5bc1188b524c2957,
+    0x358c26d2672dc7df, 0x875b6439388ff447, 0xe9165a600dee1acf,
+    0x157dd0f17f108a11, 0x7b30eea84a716499, 0xc9e7ac4315d35701,
+    0xa7aa921a20b2b989, 0xeeb9c87e037d06a2, 0x80f4f627361ce82a,
+    0x3223b4cc69bedbb2, 0x5c6e8a955cdf353a, 0x8804400525a9cc9d,
+    0xe6497e5c10c82215, 0x549e3cb74f6a118d, 0x3ad302ee7a0bff05,
+    0x73c0588a59c4402e, 0x1d8d66d36ca5aea6, 0xaf5a243833079d3e,
+    0xc1171a61066673b6, 0x3d7c90f07498e368, 0x5331aea941f90de0,
+    0xe1e6ec421e5b3e78, 0x8fabd21b2b3ad0f0, 0xc6b8887f08f56fdb,
+    0xa8f5b6263d948153, 0x1a22f4cd6236b2cb, 0x746fca9457575c43,
+    0xf007800639317716, 0x9e4abe5f0c50999e, 0x2c9dfcb453f2aa06,
+    0x42d0c2ed6693448e, 0x0bc39889455cfba5, 0x658ea6d0703d152d,
+    0xd759e43b2f9f26b5, 0xb914da621afec83d, 0x457f50f3680058e3,
+    0x2b326eaa5d61b66b, 0x99e52c4102c385f3, 0xf7a8121837a26b7b,
+    0xbebb487c146dd450, 0xd0f67625210c3ad8, 0x622134ce7eae0940,
+    0x0c6c0a974bcfe7c8, 0xd806c00732b91e6f, 0xb64bfe5e07d8f0e7,
+    0x049cbcb5587ac37f, 0x6ad182ec6d1b2df7, 0x23c2d8884ed492dc,
+    0x4d8fe6d17bb57c54, 0xff58a43a24174fcc, 0x91159a631176a144,
+    0x6d7e10f26388319a, 0x03332eab56e9df12, 0xb1e46c40094bec8a,
+    0xdfa952193c2a0202, 0x96ba087d1fe5bd29, 0xf8f736242a8453a1,
+    0x4a2074cf75266039, 0x246d4a9640478eb1, 0x02fae1e3f5a97d5b,
+    0x6cb7dfbac0c893d3, 0xde609d519f6aa04b, 0xb02da308aa0b4ec3,
+    0xf93ef96c89c4f1e8, 0x9773c735bca51f60, 0x25a485dee3072cf8,
+    0x4be9bb87d666c270, 0xb7823116a49852ae, 0xd9cf0f4f91f9bc26,
+    0x6b184da4ce5b8fbe, 0x055573fdfb3a6136, 0x4c462999d8f5de1d,
+    0x220b17c0ed943095, 0x90dc552bb236030d, 0xfe916b728757ed85,
+    0x2afba1e2fe211422, 0x44b69fbbcb40faaa, 0xf661dd5094e2c932,
+    0x982ce309a18327ba, 0xd13fb96d824c9891, 0xbf728734b72d7619,
+    0x0da5c5dfe88f4581, 0x63e8fb86ddeeab09, 0x9f837117af103bd7,
+    0xf1ce4f4e9a71d55f, 0x43190da5c5d3e6c7, 0x2d5433fcf0b2084f,
+    0x64476998d37db764, 0x0a0a57c1e61c59ec, 0xb8dd152ab9be6a74,
+    0xd6902b738cdf84fc, 0x52f861e1e2b9afa9, 0x3cb55fb8d7d84121,
+    0x8e621d53887a72b9, 0xe02f230abd1b9c31, 0xa93c796e9ed4231a,
+    0xc7714737abb5cd92, 0x75a605dcf417fe0a, 0x1beb3b85c1761082,
+    0xe780b114b388805c, 0x89cd8f4d86e96ed4, 0x3b1acda6d94b5d4c,
+    0x5557f3ffec2ab3c4, 0x1c44a99bcfe50cef, 0x720997c2fa84e267,
+    0xc0ded529a526d1ff, 0xae93eb7090473f77, 0x7af921e0e931c6d0,
+    0x14b41fb9dc502858, 0xa6635d5283f21bc0, 0xc82e630bb693f548,
+    0x813d396f955c4a63, 0xef700736a03da4eb, 0x5da745ddff9f9773,
+    0x33ea7b84cafe79fb, 0xcf81f115b800e925, 0xa1cccf4c8d6107ad,
+    0x131b8da7d2c33435, 0x7d56b3fee7a2dabd, 0x3445e99ac46d6596,
+    0x5a08d7c3f10c8b1e, 0xe8df9528aeaeb886, 0x8692ab719bcf560e,
+    0xa2ffe1e7db88d8bf, 0xccb2dfbeeee93637, 0x7e659d55b14b05af,
+    0x1028a30c842aeb27, 0x593bf968a7e5540c, 0x3776c7319284ba84,
+    0x85a185dacd26891c, 0xebecbb83f8476794, 0x178731128ab9f74a,
+    0x79ca0f4bbfd819c2, 0xcb1d4da0e07a2a5a, 0xa55073f9d51bc4d2,
+    0xec43299df6d47bf9, 0x820e17c4c3b59571, 0x30d9552f9c17a6e9,
+    0x5e946b76a9764861, 0x8afea1e6d000b1c6, 0xe4b39fbfe5615f4e,
+    0x5664dd54bac36cd6, 0x3829e30d8fa2825e, 0x713ab969ac6d3d75,
+    0x1f778730990cd3fd, 0xada0c5dbc6aee065, 0xc3edfb82f3cf0eed,
+    0x3f86711381319e33, 0x51cb4f4ab45070bb, 0xe31c0da1ebf24323,
+    0x8d5133f8de93adab, 0xc442699cfd5c1280, 0xaa0f57c5c83dfc08,
+    0x18d8152e979fcf90, 0x76952b77a2fe2118, 0xf2fd61e5cc980a4d,
+    0x9cb05fbcf9f9e4c5, 0x2e671d57a65bd75d, 0x402a230e933a39d5,
+    0x0939796ab0f586fe, 0x6774473385946876, 0xd5a305d8da365bee,
+    0xbbee3b81ef57b566, 0x4785b1109da925b8, 0x29c88f49a8c8cb30,
+    0x9b1fcda2f76af8a8, 0xf552f3fbc20b1620, 0xbc41a99fe1c4a90b,
+    0xd20c97c6d4a54783, 0x60dbd52d8b07741b, 0x0e96eb74be669a93,
+    0xdafc21e4c7106334, 0xb4b11fbdf2718dbc, 0x06665d56add3be24,
+    0x682b630f98b250ac, 0x2138396bbb7def87, 0x4f7507328e1c010f,
+    0xfda245d9d1be3297, 0x93ef7b80e4dfdc1f, 0x6f84f11196214cc1,
+    0x01c9cf48a340a249, 0xb31e8da3fce291d1, 0xdd53b3fac9837f59,
+    0x9440e99eea4cc072, 0xfa0dd7c7df2d2efa, 0x48da952c808f1d62,
+    0x2697ab75b5eef3ea
+  }
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: crc64_multmodp
+ *
+ * Description:
+ *   Multiply two polynomials modulo the CRC polynomial.
+ *
+ ****************************************************************************/
+
+static uint64_t crc64_multmodp(uint64_t a, uint64_t b)
+{
+  uint64_t m;
+  uint64_t p = 0;
+
+  for (m = (uint64_t)1 << 63; m != 0; m >>= 1)
+    {
+      p = (p & ((uint64_t)1 << 63)) != 0 ? (p << 1) ^ CRC64_POLY : p << 1;
+      if ((a & m) != 0)
+        {
+          p ^= b;
+        }
+    }
+
+  return p;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -240,6 +898,30 @@ uint64_t crc64part(FAR const uint8_t *src, size_t len, uint64_t crc64val)
 {
   size_t i;
 
+#ifdef CONFIG_LIBC_CRC64_SLICE8
+  /* Process eight bytes at a time with eight independent table lookups */
+
+  while (len >= 8)
+    {
+      crc64val ^= ((uint64_t)src[0] << 56) | ((uint64_t)src[1] << 48) |
+                  ((uint64_t)src[2] << 40) | ((uint64_t)src[3] << 32) |
+                  ((uint64_t)src[4] << 24) | ((uint64_t)src[5] << 16) |
+                  ((uint64_t)src[6] << 8) | (uint64_t)src[7];
+
+      crc64val = crc64_slice8_tab[6][crc64val >> 56] ^
+                 crc64_slice8_tab[5][(crc64val >> 48) & 0xff] ^
+                 crc64_slice8_tab[4][(crc64val >> 40) & 0xff] ^
+                 crc64_slice8_tab[3][(crc64val >> 32) & 0xff] ^
+                 crc64_slice8_tab[2][(crc64val >> 24) & 0xff] ^
+                 crc64_slice8_tab[1][(crc64val >> 16) & 0xff] ^
+                 crc64_slice8_tab[0][(crc64val >> 8) & 0xff] ^
+                 crc64_tab[crc64val & 0xff];
+
+      src += 8;
+      len -= 8;
+    }
+#endif
+
   for (i = 0; i < len; i++)
     {
       crc64val = crc64_tab[((crc64val >> 56) & 0xff) ^ src[i]] ^
@@ -287,4 +969,34 @@ uint64_t crc64(FAR const uint8_t *src, size_t len)
   return crc64part(src, len, CRC64_INIT) ^ CRC64_XOROUT;
 }
 
+/****************************************************************************
+ * Name: crc64_combine
+ *
+ * Description:
+ *   Return the CRC of the concatenation of two buffers given the CRC of
+ *   each buffer, as returned by crc64(), and the length of the second
+ *   buffer.
+ *
+ ****************************************************************************/
+
+uint64_t crc64_combine(uint64_t crc1, uint64_t crc2, size_t len2)
+{
+  uint64_t xpow = 0x100;
+  uint64_t p = 1;
+
+  /* Compute x^(8 * len2) modulo the polynomial by repeated squaring */
+
+  for (; len2 != 0; len2 >>= 1)
+    {
+      if ((len2 & 1) != 0)
+        {
+          p = crc64_multmodp(xpow, p);
+        }
+
+      xpow = crc64_multmodp(xpow, xpow);
+    }
+
+  return crc64_multmodp(p, crc1) ^ crc2;
+}
+
 #endif /* CONFIG_HAVE_LONG_LONG */
@@ -85,6 +85,40 @@ int modlib_findsymtab(FAR struct mod_loadinfo_s *loadinfo);
 int modlib_readsym(FAR struct mod_loadinfo_s *loadinfo, int index,
                    FAR Elf_Sym *sym);
 
+/****************************************************************************
+ * Name: modlib_loadsymtab
+ *
+ * Description:
+ *   Read the whole symbol table and its string table into memory so that
+ *   modlib_readsym() and the symbol name lookups need no file I/O.  This
+ *   is only an optimization; on failure, the tables continue to be read
+ *   from the file one entry at a time.
+ *
+ * Returned Value:
+ *   0 (OK) is returned on success and a negated errno is returned on
+ *   failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+int modlib_loadsymtab(FAR struct mod_loadinfo_s *loadinfo);
+#endif
+
+/****************************************************************************
+ * Name: modlib_findsymbol
+ *
+ * Description:
+ *   Find a symbol in the symbol table of the base code selected with
+ *   modlib_setsymtab().
+ *
+ * Returned Value:
+ *   A reference to the symbol is returned on success; NULL is returned if
+ *   the base code does not export a symbol of that name.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *modlib_findsymbol(FAR const char *name);
+
 /****************************************************************************
  * Name: modlib_symvalue
  *
@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -36,6 +37,18 @@
 #include "libc.h"
 #include "modlib/modlib.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Use clock monotonic, if possible, to time the relocations */
+
+#ifdef CONFIG_CLOCK_MONOTONIC
+#  define MODLIB_CLOCK CLOCK_MONOTONIC
+#else
+#  define MODLIB_CLOCK CLOCK_REALTIME
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -318,6 +331,17 @@ static int modlib_relocate(FAR struct module_s *modp,
         {
           berr("ERROR: Section %d reloc %d: Relocation failed: %d\n",
                relidx, i, ret);
+#ifdef CONFIG_MODLIB_XIP
+          /* The architecture reports a target out of range as -EINVAL.
+           * Tell modlib_bind() that loading without XIP may help.
+           */
+
+          if (ret == -EINVAL && loadinfo->xipbase != 0)
+            {
+              ret = -ERANGE;
+            }
+#endif
+
           break;
         }
     }
@@ -506,6 +530,17 @@ static int modlib_relocateadd(FAR struct module_s *modp,
         {
           berr("ERROR: Section %d reloc %d: Relocation failed: %d\n",
                relidx, i, ret);
+#ifdef CONFIG_MODLIB_XIP
+          /* The architecture reports a target out of range as -EINVAL.
+           * Tell modlib_bind() that loading without XIP may help.
+           */
+
+          if (ret == -EINVAL && loadinfo->xipbase != 0)
+            {
+              ret = -ERANGE;
+            }
+#endif
+
           break;
         }
     }
@@ -545,9 +580,17 @@ static int modlib_relocateadd(FAR struct module_s *modp,
 int modlib_bind(FAR struct module_s *modp,
                 FAR struct mod_loadinfo_s *loadinfo)
 {
+#ifdef CONFIG_DEBUG_BINFMT_INFO
+  struct timespec start;
+  struct timespec end;
+#endif
   int ret;
   int i;
 
+#ifdef CONFIG_DEBUG_BINFMT_INFO
+  clock_gettime(MODLIB_CLOCK, &start);
+#endif
+
   /* Find the symbol and string tables */
 
   ret = modlib_findsymtab(loadinfo);
@@ -556,6 +599,19 @@ int modlib_bind(FAR struct module_s *modp,
       return ret;
     }
 
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+  /* Read the symbol and string tables into memory so that resolving the
+   * relocations needs no further file I/O for symbols.  If there is not
+   * enough memory, the tables are read from the file as needed.
+   */
+
+  ret = modlib_loadsymtab(loadinfo);
+  if (ret < 0)
+    {
+      bwarn("WARNING: modlib_loadsymtab failed: %d\n", ret);
+    }
+#endif
+
   /* Allocate an I/O buffer.  This buffer is used by mod_symname() to
    * accumulate the variable length symbol name.
    */
@@ -613,5 +669,37 @@ int modlib_bind(FAR struct module_s *modp,
   up_coherent_dcache(loadinfo->textalloc, loadinfo->textsize);
   up_coherent_dcache(loadinfo->datastart, loadinfo->datasize);
 
+#ifdef CONFIG_MODLIB_XIP
+  /* A relocation may be unable to reach a section used in place, e.g. a
+   * branch from RAM into the media may be out of range.  Load the module
+   * again with all sections copied to RAM and retry.  Other errors, such
+   * as undefined symbols, would not go away.
+   */
+
+  if (ret == -ERANGE && loadinfo->xipbase != 0)
+    {
+      bwarn("WARNING: Relocation failed, retrying without XIP: %d\n", ret);
+
+      modlib_unload(loadinfo);
+      loadinfo->noxip = true;
+
+      ret = modlib_load(loadinfo);
+      if (ret < 0)
+        {
+          berr("ERROR: modlib_load failed: %d\n", ret);
+          return ret;
+        }
+
+      return modlib_bind(modp, loadinfo);
+    }
+#endif
+
+#ifdef CONFIG_DEBUG_BINFMT_INFO
+  clock_gettime(MODLIB_CLOCK, &end);
+  binfo("Relocation took %ld us\n",
+        (long)((end.tv_sec - start.tv_sec) * 1000000 +
+               (end.tv_nsec - start.tv_nsec) / 1000));
+#endif
+
   return ret;
 }
@@ -25,7 +25,10 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/statfs.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +37,8 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/lib/modlib.h>
 
 #include "libc.h"
@@ -63,6 +68,128 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: modlib_xipinit
+ *
+ * Description:
+ *   Get the address of the module file if it lies in memory-mapped media,
+ *   such as a ROMFS volume on a device that supports BIOC_XIPBASE.  Other
+ *   file systems, e.g. TMPFS, may also support FIOC_MMAP, but their files
+ *   can be modified or freed while the module is loaded.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MODLIB_XIP
+static void modlib_xipinit(FAR struct mod_loadinfo_s *loadinfo)
+{
+  FAR void *xipbase = NULL;
+  struct statfs buf;
+  int ret;
+
+  loadinfo->xipbase = 0;
+  if (loadinfo->noxip || fstatfs(loadinfo->filfd, &buf) < 0 ||
+      buf.f_type != ROMFS_MAGIC)
+    {
+      return;
+    }
+
+  ret = _NX_IOCTL(loadinfo->filfd, FIOC_MMAP,
+                  (unsigned long)((uintptr_t)&xipbase));
+  if (ret >= 0 && xipbase != NULL)
+    {
+      binfo("Executing in place at %p\n", xipbase);
+      loadinfo->xipbase = (uintptr_t)xipbase;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: modlib_xipsection
+ *
+ * Description:
+ *   Return true if the section can be used in place in the memory-mapped
+ *   file instead of being copied to RAM.  That is the case for read-only
+ *   sections with data in the file that are suitably aligned in the media
+ *   and that no relocation section modifies.  The media cannot be written,
+ *   so a .text section with external calls is always copied.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MODLIB_XIP
+static bool modlib_xipsection(FAR struct mod_loadinfo_s *loadinfo,
+                              int index)
+{
+  FAR Elf_Shdr *shdr = &loadinfo->shdr[index];
+  int i;
+
+  if (loadinfo->xipbase == 0 ||
+      (shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) != SHF_ALLOC ||
+      shdr->sh_type == SHT_NOBITS)
+    {
+      return false;
+    }
+
+  if (shdr->sh_addralign > 1 &&
+      (loadinfo->xipbase + shdr->sh_offset) % shdr->sh_addralign != 0)
+    {
+      return false;
+    }
+
+  for (i = 1; i < loadinfo->ehdr.e_shnum; i++)
+    {
+      FAR Elf_Shdr *relsec = &loadinfo->shdr[i];
+
+      if ((relsec->sh_type == SHT_REL || relsec->sh_type == SHT_RELA) &&
+          relsec->sh_info == index)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+#endif
+
+/****************************************************************************
+ * Name: modlib_xipentry
+ *
+ * Description:
+ *   e_entry is an offset into the read-only sections as they would be laid
+ *   out in the .text allocation.  If some of those sections are used in
+ *   place, find the section that holds the entry point and convert the
+ *   offset into an address within that section.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MODLIB_XIP
+static void modlib_xipentry(FAR struct mod_loadinfo_s *loadinfo)
+{
+  size_t textoff = 0;
+  int i;
+
+  for (i = 0; i < loadinfo->ehdr.e_shnum; i++)
+    {
+      FAR Elf_Shdr *shdr = &loadinfo->shdr[i];
+
+      if ((shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) != SHF_ALLOC)
+        {
+          continue;
+        }
+
+      textoff = _ALIGN_UP(textoff, shdr->sh_addralign);
+      if (loadinfo->ehdr.e_entry >= textoff &&
+          loadinfo->ehdr.e_entry < textoff + shdr->sh_size)
+        {
+          loadinfo->entrypt = shdr->sh_addr +
+                              (loadinfo->ehdr.e_entry - textoff);
+          return;
+        }
+
+      textoff += ELF_ALIGNUP(shdr->sh_size);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: modlib_elfsize
  *
@@ -109,6 +236,12 @@ static void modlib_elfsize(struct mod_loadinfo_s *loadinfo)
                   loadinfo->dataalign = shdr->sh_addralign;
                 }
             }
+#ifdef CONFIG_MODLIB_XIP
+          else if (modlib_xipsection(loadinfo, i))
+            {
+              /* The section will be used in place and needs no memory */
+            }
+#endif
           else
             {
               textsize = _ALIGN_UP(textsize, shdr->sh_addralign);
@@ -180,6 +313,20 @@ static inline int modlib_loadfile(FAR struct mod_loadinfo_s *loadinfo)
           pptr = &text;
         }
 
+#ifdef CONFIG_MODLIB_XIP
+      /* Use read-only sections in place if possible */
+
+      if (pptr == &text && modlib_xipsection(loadinfo, i))
+        {
+          binfo("%d. %08lx->%08lx (XIP)\n", i,
+                (unsigned long)shdr->sh_addr,
+                (unsigned long)(loadinfo->xipbase + shdr->sh_offset));
+
+          shdr->sh_addr = loadinfo->xipbase + shdr->sh_offset;
+          continue;
+        }
+#endif
+
       *pptr = (FAR uint8_t *)_ALIGN_UP((uintptr_t)*pptr, shdr->sh_addralign);
 
       /* SHT_NOBITS indicates that there is no data in the file for the
@@ -255,6 +402,12 @@ int modlib_load(FAR struct mod_loadinfo_s *loadinfo)
       goto errout_with_buffers;
     }
 
+#ifdef CONFIG_MODLIB_XIP
+  /* Check if the file can be executed in place */
+
+  modlib_xipinit(loadinfo);
+#endif
+
   /* Determine total size to allocate */
 
   modlib_elfsize(loadinfo);
@@ -302,6 +455,16 @@ int modlib_load(FAR struct mod_loadinfo_s *loadinfo)
       goto errout_with_buffers;
     }
 
+  /* Get the address of the entry point */
+
+  loadinfo->entrypt = loadinfo->textalloc + loadinfo->ehdr.e_entry;
+#ifdef CONFIG_MODLIB_XIP
+  if (loadinfo->xipbase != 0)
+    {
+      modlib_xipentry(loadinfo);
+    }
+#endif
+
   return OK;
 
   /* Error exits */
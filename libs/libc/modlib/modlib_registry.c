@@ -222,6 +222,11 @@ int modlib_registry_del(FAR struct module_s *modp)
     }
 
   modp->flink = NULL;
+
+#ifdef CONFIG_SYMTAB_HASH
+  symtab_hashfree(&modp->exphash);
+#endif
+
   return OK;
 }
 
@@ -33,6 +33,7 @@
 
 #include <nuttx/lib/modlib.h>
 
+#include "libc.h"
 #include "modlib/modlib.h"
 
 /****************************************************************************
@@ -63,7 +64,8 @@ struct mod_exportinfo_s
  * Name: modlib_symname
  *
  * Description:
- *   Get the symbol name in loadinfo->iobuffer[].
+ *   Get the symbol name, either in the cached string table or, if the
+ *   string table is not cached, in loadinfo->iobuffer[].
  *
  * Returned Value:
  *   0 (OK) is returned on success and a negated errno is returned on
@@ -76,7 +78,7 @@ struct mod_exportinfo_s
  ****************************************************************************/
 
 static int modlib_symname(FAR struct mod_loadinfo_s *loadinfo,
-                          FAR const Elf_Sym *sym)
+                          FAR const Elf_Sym *sym, FAR const char **name)
 {
   FAR uint8_t *buffer;
   off_t  offset;
@@ -94,6 +96,23 @@ static int modlib_symname(FAR struct mod_loadinfo_s *loadinfo,
       return -ESRCH;
     }
 
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+  /* The cached string table is always NUL terminated */
+
+  if (loadinfo->strtab != NULL)
+    {
+      if (sym->st_name >= loadinfo->strtablen)
+        {
+          berr("ERROR: Symbol name offset out of range\n");
+          return -EINVAL;
+        }
+
+      *name = &loadinfo->strtab[sym->st_name];
+      return OK;
+    }
+#endif
+
+  *name  = (FAR const char *)loadinfo->iobuffer;
   offset = loadinfo->shdr[loadinfo->strtabidx].sh_offset + sym->st_name;
 
   /* Loop until we get the entire symbol name into memory */
@@ -174,9 +193,7 @@ static int modlib_symcallback(FAR struct module_s *modp, FAR void *arg)
 
   /* Check if this module exports a symbol of that name */
 
-  exportinfo->symbol = symtab_findbyname(modp->modinfo.exports,
-                                         exportinfo->name,
-                                         modp->modinfo.nexports);
+  exportinfo->symbol = modlib_findexport(modp, exportinfo->name);
 
   if (exportinfo->symbol != NULL)
     {
@@ -265,12 +282,20 @@ int modlib_readsym(FAR struct mod_loadinfo_s *loadinfo, int index,
 
   /* Verify that the symbol table index lies within symbol table */
 
-  if (index < 0 || index > (symtab->sh_size / sizeof(Elf_Sym)))
+  if (index < 0 || index >= (symtab->sh_size / sizeof(Elf_Sym)))
     {
       berr("ERROR: Bad relocation symbol index: %d\n", index);
       return -EINVAL;
     }
 
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+  if (loadinfo->symtab != NULL)
+    {
+      memcpy(sym, &loadinfo->symtab[index], sizeof(Elf_Sym));
+      return OK;
+    }
+#endif
+
   /* Get the file offset to the symbol table entry */
 
   offset = symtab->sh_offset + sizeof(Elf_Sym) * index;
@@ -280,6 +305,73 @@ int modlib_readsym(FAR struct mod_loadinfo_s *loadinfo, int index,
   return modlib_read(loadinfo, (FAR uint8_t *)sym, sizeof(Elf_Sym), offset);
 }
 
+/****************************************************************************
+ * Name: modlib_loadsymtab
+ *
+ * Description:
+ *   Read the whole symbol table and its string table into memory so that
+ *   modlib_readsym() and the symbol name lookups need no file I/O.  This
+ *   is only an optimization; on failure, the tables continue to be read
+ *   from the file one entry at a time.
+ *
+ * Returned Value:
+ *   0 (OK) is returned on success and a negated errno is returned on
+ *   failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+int modlib_loadsymtab(FAR struct mod_loadinfo_s *loadinfo)
+{
+  FAR Elf_Shdr *symtab = &loadinfo->shdr[loadinfo->symtabidx];
+  FAR Elf_Shdr *strtab;
+  int ret;
+
+  if (loadinfo->strtabidx >= loadinfo->ehdr.e_shnum)
+    {
+      berr("ERROR: Bad string table index: %d\n", loadinfo->strtabidx);
+      return -EINVAL;
+    }
+
+  strtab = &loadinfo->shdr[loadinfo->strtabidx];
+
+  /* Allocate one more byte so that the string table is always terminated */
+
+  loadinfo->symtab = (FAR Elf_Sym *)lib_malloc(symtab->sh_size);
+  loadinfo->strtab = (FAR char *)lib_malloc(strtab->sh_size + 1);
+  if (loadinfo->symtab == NULL || loadinfo->strtab == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  ret = modlib_read(loadinfo, (FAR uint8_t *)loadinfo->symtab,
+                    symtab->sh_size, symtab->sh_offset);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  ret = modlib_read(loadinfo, (FAR uint8_t *)loadinfo->strtab,
+                    strtab->sh_size, strtab->sh_offset);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  loadinfo->strtab[strtab->sh_size] = '\0';
+  loadinfo->strtablen = strtab->sh_size;
+  return OK;
+
+errout:
+  lib_free(loadinfo->symtab);
+  lib_free(loadinfo->strtab);
+  loadinfo->symtab = NULL;
+  loadinfo->strtab = NULL;
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: modlib_symvalue
  *
@@ -309,8 +401,8 @@ int modlib_symvalue(FAR struct module_s *modp,
 {
   FAR const struct symtab_s *symbol;
   struct mod_exportinfo_s exportinfo;
+  FAR const char *name;
   uintptr_t secbase;
-  int nsymbols;
   int ret;
 
   switch (sym->st_shndx)
@@ -335,7 +427,7 @@ int modlib_symvalue(FAR struct module_s *modp,
       {
         /* Get the name of the undefined symbol */
 
-        ret = modlib_symname(loadinfo, sym);
+        ret = modlib_symname(loadinfo, sym, &name);
         if (ret < 0)
           {
             /* There are a few relocations for a few architectures that do
@@ -354,7 +446,7 @@ int modlib_symvalue(FAR struct module_s *modp,
          * recently installed will take precedence.
          */
 
-        exportinfo.name   = (FAR const char *)loadinfo->iobuffer;
+        exportinfo.name   = name;
         exportinfo.modp   = modp;
         exportinfo.symbol = NULL;
 
@@ -374,9 +466,7 @@ int modlib_symvalue(FAR struct module_s *modp,
 
         if (symbol == NULL)
           {
-            modlib_getsymtab(&symbol, &nsymbols);
-            symbol = symtab_findbyname(symbol, exportinfo.name,
-                                       nsymbols);
+            symbol = modlib_findsymbol(name);
           }
 
         /* Was the symbol found from any exporter? */
@@ -384,7 +474,7 @@ int modlib_symvalue(FAR struct module_s *modp,
         if (symbol == NULL)
           {
             berr("ERROR: SHN_UNDEF: Exported symbol \"%s\" not found\n",
-                 loadinfo->iobuffer);
+                 name);
             return -ENOENT;
           }
 
@@ -394,7 +484,7 @@ int modlib_symvalue(FAR struct module_s *modp,
 
         binfo("SHN_UNDEF: name=%s "
               "%08" PRIxPTR "+%08" PRIxPTR "=%08" PRIxPTR "\n",
-              loadinfo->iobuffer,
+              name,
               (uintptr_t)sym->st_value, (uintptr_t)symbol->sym_value,
               (uintptr_t)(sym->st_value + symbol->sym_value));
 
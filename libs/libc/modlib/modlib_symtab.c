@@ -29,6 +29,8 @@
 #include <nuttx/symtab.h>
 #include <nuttx/lib/modlib.h>
 
+#include "modlib/modlib.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -63,6 +65,14 @@ extern int CONFIG_MODLIB_NSYMBOLS_VAR;
 static FAR const struct symtab_s *g_modlib_symtab;
 static FAR int g_modlib_nsymbols;
 
+#ifdef CONFIG_SYMTAB_HASH
+/* Hash index over the kernel symbol table, rebuilt whenever a different
+ * symbol table is selected.  Protected by the registry lock.
+ */
+
+static struct symtab_hash_s g_modlib_symhash;
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -127,3 +137,98 @@ void modlib_setsymtab(FAR const struct symtab_s *symtab, int nsymbols)
   g_modlib_nsymbols = nsymbols;
   modlib_registry_unlock();
 }
+
+/****************************************************************************
+ * Name: modlib_findsymbol
+ *
+ * Description:
+ *   Find a symbol by name in the current kernel symbol table.  If
+ *   CONFIG_SYMTAB_HASH is selected, a hash index over the symbol table is
+ *   built on first use and the lookup does not scan the table.
+ *
+ * Input Parameters:
+ *   name - The name of the symbol to find.
+ *
+ * Returned Value:
+ *   A reference to the symbol table entry if found; NULL otherwise.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *modlib_findsymbol(FAR const char *name)
+{
+  FAR const struct symtab_s *symtab;
+  FAR const struct symtab_s *symbol;
+  int nsymbols;
+
+  modlib_registry_lock();
+  modlib_getsymtab(&symtab, &nsymbols);
+
+#ifdef CONFIG_SYMTAB_HASH
+  if (symtab != NULL && (g_modlib_symhash.symtab != symtab ||
+                         g_modlib_symhash.nsyms != nsymbols))
+    {
+      symtab_hashfree(&g_modlib_symhash);
+      symtab_hashinit(&g_modlib_symhash, symtab, nsymbols);
+    }
+
+  if (symtab != NULL && g_modlib_symhash.symtab == symtab)
+    {
+      symbol = symtab_hashfind(&g_modlib_symhash, name);
+    }
+  else
+#endif
+    {
+      symbol = symtab_findbyname(symtab, name, nsymbols);
+    }
+
+  modlib_registry_unlock();
+  return symbol;
+}
+
+/****************************************************************************
+ * Name: modlib_findexport
+ *
+ * Description:
+ *   Find a symbol by name in the symbols exported by a module.  If
+ *   CONFIG_SYMTAB_HASH is selected, a hash index over the exported symbols
+ *   is built on first use and released with the module.
+ *
+ *   The caller must hold the registry lock.
+ *
+ * Input Parameters:
+ *   modp - The module whose exported symbols will be searched.
+ *   name - The name of the symbol to find.
+ *
+ * Returned Value:
+ *   A reference to the symbol table entry if found; NULL otherwise.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *modlib_findexport(FAR struct module_s *modp,
+                                             FAR const char *name)
+{
+  DEBUGASSERT(modp != NULL && name != NULL);
+
+  if (modp->modinfo.exports == NULL || modp->modinfo.nexports <= 0)
+    {
+      return NULL;
+    }
+
+#ifdef CONFIG_SYMTAB_HASH
+  if (modp->exphash.symtab != modp->modinfo.exports ||
+      modp->exphash.nsyms != modp->modinfo.nexports)
+    {
+      symtab_hashfree(&modp->exphash);
+      symtab_hashinit(&modp->exphash, modp->modinfo.exports,
+                      modp->modinfo.nexports);
+    }
+
+  if (modp->exphash.symtab == modp->modinfo.exports)
+    {
+      return symtab_hashfind(&modp->exphash, name);
+    }
+#endif
+
+  return symtab_findbyname(modp->modinfo.exports, name,
+                           modp->modinfo.nexports);
+}
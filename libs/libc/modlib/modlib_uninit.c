@@ -95,5 +95,20 @@ int modlib_freebuffers(struct mod_loadinfo_s *loadinfo)
       loadinfo->buflen    = 0;
     }
 
+#ifdef CONFIG_MODLIB_CACHE_SYMTAB
+  if (loadinfo->symtab != NULL)
+    {
+      lib_free((FAR void *)loadinfo->symtab);
+      loadinfo->symtab    = NULL;
+    }
+
+  if (loadinfo->strtab != NULL)
+    {
+      lib_free((FAR void *)loadinfo->strtab);
+      loadinfo->strtab    = NULL;
+      loadinfo->strtablen = 0;
+    }
+#endif
+
   return OK;
 }
@@ -37,6 +37,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
+#include <stdbool.h>
 #include <math.h>
 
 #include "lib_dtoa_engine.h"
@@ -59,6 +62,286 @@
 #define MAX(a, b)     ((a) > (b) ? (a) : (b))
 #define MIN(a, b)     ((a) < (b) ? (a) : (b))
 
+/* The number of digits needed for 'dec' digits right of the decimal point
+ * when the leftmost digit has exponent 'exp'.  A value that starts below
+ * the last decimal keeps dec + 1 digits, which the caller uses to decide
+ * whether it rounds up to one unit in the last place.
+ */
+
+#define FIX_DIGITS(dec, exp) \
+  ((dec) + (exp) + 1 > 0 ? (dec) + (exp) + 1 : (dec) + 1)
+
+#ifdef CONFIG_LIBC_DTOA_GRISU
+/* The Grisu conversion scales the value by a cached power of ten so that
+ * its binary exponent lands in this range.  The integral part then fits in
+ * 32 bits and at least four bits are left above the fraction.
+ */
+
+#define GRISU_MIN_EXP (-60)
+#define GRISU_MAX_EXP (-32)
+
+/* 1 / log2(10) */
+
+#define GRISU_D_1_LOG2_10 0.30102999566398114
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_LIBC_DTOA_GRISU
+static const uint32_t g_grisu_pow10[] =
+{
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+  1000000000
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_LIBC_DTOA_GRISU
+
+/****************************************************************************
+ * Name: grisu_multiply
+ *
+ * Description:
+ *   Return the upper 64 bits of the 128-bit product x * y, rounded.
+ *
+ ****************************************************************************/
+
+static uint64_t grisu_multiply(uint64_t x, uint64_t y)
+{
+  uint64_t a = x >> 32;
+  uint64_t b = x & UINT32_MAX;
+  uint64_t c = y >> 32;
+  uint64_t d = y & UINT32_MAX;
+  uint64_t ac = a * c;
+  uint64_t bc = b * c;
+  uint64_t ad = a * d;
+  uint64_t bd = b * d;
+  uint64_t tmp;
+
+  tmp  = (bd >> 32) + (ad & UINT32_MAX) + (bc & UINT32_MAX);
+  tmp += UINT64_C(1) << 31;
+
+  return ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+}
+
+/****************************************************************************
+ * Name: grisu_round
+ *
+ * Description:
+ *   Round the generated digits given the remainder 'rest' of the scaled
+ *   value, the weight 'ten_kappa' of the last digit and the error bound
+ *   'unit', all in the same fixed-point scale.
+ *
+ * Returned Value:
+ *   True if the rounding is certain despite the error; false if the value
+ *   is too close to the midpoint to decide.
+ *
+ ****************************************************************************/
+
+static bool grisu_round(FAR char *digits, int len, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t unit,
+                        FAR int *kappa)
+{
+  int i;
+
+  if (unit >= ten_kappa || ten_kappa - unit <= unit)
+    {
+      return false;
+    }
+
+  /* Round down if even rest + unit is below the midpoint */
+
+  if (ten_kappa - rest > rest && ten_kappa - 2 * rest >= 2 * unit)
+    {
+      return true;
+    }
+
+  /* Round up if even rest - unit is above the midpoint */
+
+  if (rest > unit && ten_kappa - (rest - unit) <= rest - unit)
+    {
+      digits[len - 1]++;
+      for (i = len - 1; i > 0 && digits[i] > '9'; i--)
+        {
+          digits[i] = '0';
+          digits[i - 1]++;
+        }
+
+      if (digits[0] > '9')
+        {
+          digits[0] = '1';
+          (*kappa)++;
+        }
+
+      return true;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: grisu_dtoa
+ *
+ * Description:
+ *   Convert a positive, finite, non-zero value to correctly rounded decimal
+ *   digits with the Grisu algorithm: one multiplication by a cached power
+ *   of ten followed by integer digit generation, while tracking the error
+ *   of the multiplication.  The digit count is limited as described for
+ *   __dtoa_engine().
+ *
+ * Returned Value:
+ *   The number of digits generated, or zero if the error made the last
+ *   digit uncertain and the caller must use another method.
+ *
+ ****************************************************************************/
+
+static int grisu_dtoa(double x, FAR struct dtoa_s *dtoa, int max_digits,
+                      int max_decimals, FAR int32_t *exp)
+{
+  FAR const struct dtoa_cached_power_s *power;
+  union
+  {
+    double   d;
+    uint64_t u;
+  } bits;
+
+  uint64_t fractionals;
+  uint64_t ten_kappa;
+  uint64_t unit;
+  uint64_t rest;
+  uint64_t f;
+  uint32_t integrals;
+  uint32_t divisor;
+  double dk;
+  int requested;
+  int kappa;
+  int shift;
+  int len;
+  int e;
+  int k;
+
+  if (max_digits <= 0)
+    {
+      return 0;
+    }
+
+  /* Decompose the value into a normalized 64-bit significand and a binary
+   * exponent.
+   */
+
+  bits.d = x;
+  f = bits.u & ((UINT64_C(1) << 52) - 1);
+  e = (int)(bits.u >> 52) & 0x7ff;
+  if (e != 0)
+    {
+      f  = (f | (UINT64_C(1) << 52)) << 11;
+      e -= 1075 + 11;
+    }
+  else
+    {
+      for (e = -1074; (f & (UINT64_C(1) << 63)) == 0; e--)
+        {
+          f <<= 1;
+        }
+    }
+
+  /* Select the cached power of ten that brings the binary exponent of the
+   * product into [GRISU_MIN_EXP, GRISU_MAX_EXP].
+   */
+
+  dk = (GRISU_MIN_EXP - (e + 64) + 63) * GRISU_D_1_LOG2_10;
+  k  = (int)dk;
+  if (k < dk)
+    {
+      k++;
+    }
+
+  power = &g_dtoa_cached_powers[(k - DTOA_CACHED_POWER_MIN - 1) /
+                                DTOA_CACHED_POWER_STEP + 1];
+
+  f = grisu_multiply(f, power->f);
+  e = e + power->e + 64;
+  if (e < GRISU_MIN_EXP || e > GRISU_MAX_EXP)
+    {
+      return 0;
+    }
+
+  shift       = -e;
+  integrals   = (uint32_t)(f >> shift);
+  fractionals = f & ((UINT64_C(1) << shift) - 1);
+
+  for (kappa = 1; kappa < 10 && integrals >= g_grisu_pow10[kappa]; kappa++);
+
+  /* Now the exponent of the leading digit is known, limit the digits like
+   * the iterative conversion does.
+   */
+
+  *exp = kappa - 1 - power->k;
+  if (max_decimals != 0)
+    {
+      max_digits = MIN(max_digits, FIX_DIGITS(max_decimals, *exp));
+    }
+
+  /* Generate the integral digits, then the fractional ones */
+
+  requested = max_digits;
+  len       = 0;
+  unit      = 1;
+
+  while (kappa > 0)
+    {
+      divisor = g_grisu_pow10[--kappa];
+      dtoa->digits[len++] = integrals / divisor + '0';
+      integrals %= divisor;
+
+      if (--requested == 0)
+        {
+          break;
+        }
+    }
+
+  if (requested == 0)
+    {
+      rest      = ((uint64_t)integrals << shift) + fractionals;
+      ten_kappa = (uint64_t)divisor << shift;
+    }
+  else
+    {
+      while (requested > 0 && fractionals > unit)
+        {
+          fractionals *= 10;
+          unit        *= 10;
+          dtoa->digits[len++] = (fractionals >> shift) + '0';
+          fractionals &= (UINT64_C(1) << shift) - 1;
+          requested--;
+          kappa--;
+        }
+
+      if (requested != 0)
+        {
+          return 0;
+        }
+
+      rest      = fractionals;
+      ten_kappa = UINT64_C(1) << shift;
+    }
+
+  if (!grisu_round(dtoa->digits, len, rest, ten_kappa, unit, &kappa))
+    {
+      return 0;
+    }
+
+  *exp = kappa - power->k + len - 1;
+  return len;
+}
+
+#endif /* CONFIG_LIBC_DTOA_GRISU */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -90,6 +373,12 @@ int __dtoa_engine(double x, FAR struct dtoa_s *dtoa, int max_digits,
     {
       flags |= DTOA_INF;
     }
+#ifdef CONFIG_LIBC_DTOA_GRISU
+  else if ((i = grisu_dtoa(x, dtoa, max_digits, max_decimals, &exp)) > 0)
+    {
+      max_digits = i;
+    }
+#endif
   else
     {
       double y;
@@ -132,7 +421,7 @@ int __dtoa_engine(double x, FAR struct dtoa_s *dtoa, int max_digits,
 
       if (max_decimals != 0)
         {
-          max_digits = MIN(max_digits, max_decimals + MAX(exp + 1, 1));
+          max_digits = MIN(max_digits, FIX_DIGITS(max_decimals, exp));
         }
 
       /* Round nearest by adding 1/2 of the last digit before converting to
@@ -40,6 +40,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <stdint.h>
 #include <float.h>
 
@@ -160,6 +162,12 @@
 
 #define DTOA_ROUND_NUM        (DBL_DIG + 1)
 
+/* Range of the table of cached powers of ten used by the Grisu conversion */
+
+#define DTOA_CACHED_POWER_MIN  (-348)
+#define DTOA_CACHED_POWER_STEP 8
+#define DTOA_CACHED_POWER_NUM  87
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -171,6 +179,15 @@ struct dtoa_s
   char digits[DTOA_MAX_DIG + 1];
 };
 
+#ifdef CONFIG_LIBC_DTOA_GRISU
+struct dtoa_cached_power_s
+{
+  uint64_t f;     /* Normalized significand */
+  int16_t  e;     /* Binary exponent */
+  int16_t  k;     /* Decimal exponent */
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -178,6 +195,10 @@ struct dtoa_s
 extern const double g_dtoa_scale_up[];
 extern const double g_dtoa_scale_down[];
 extern const double g_dtoa_round[];
+#ifdef CONFIG_LIBC_DTOA_GRISU
+extern const struct dtoa_cached_power_s
+  g_dtoa_cached_powers[DTOA_CACHED_POWER_NUM];
+#endif
 
 /****************************************************************************
  * Public Function Prototypes
@@ -0,0 +1,60 @@
+/****************************************************************************
+ * libs/libc/stdio/lib_libstreamputs.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <nuttx/streams.h>
+
+#include "libc.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lib_stream_puts
+ *
+ * Description:
+ *  Write 'len' bytes to an output stream with its puts method or, if the
+ *  stream has none, one character at a time with its put method.
+ *
+ ****************************************************************************/
+
+void lib_stream_puts(FAR struct lib_outstream_s *stream,
+                     FAR const void *buf, int len)
+{
+  FAR const char *ptr = buf;
+
+  if (stream->puts != NULL)
+    {
+      stream->puts(stream, buf, len);
+    }
+  else
+    {
+      while (len-- > 0)
+        {
+          stream->put(stream, *ptr++);
+        }
+    }
+}
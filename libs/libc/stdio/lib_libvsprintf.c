@@ -74,6 +74,17 @@
 
 #define putc(c,stream)  (total_len++, (stream)->put(stream, c))
 
+/* Put a string, or a run of padding characters, in as few calls as the
+ * stream allows.
+ */
+
+#define putstring(s,n,stream) \
+  (total_len += (n), lib_stream_puts(stream, (FAR const char *)(s), n))
+#define putpad(ch,n,stream) \
+  (total_len += (n), vsprintf_pad(stream, ch, n))
+
+#define PAD_CHUNK          16
+
 /* Order is relevant here and matches order in format string */
 
 #define FL_ZFILL           0x0001
@@ -143,11 +154,33 @@ struct arg
  ****************************************************************************/
 
 static const char g_nullstring[] = "(null)";
+static const char g_spaces[PAD_CHUNK + 1] = "                ";
+static const char g_zeros[PAD_CHUNK + 1]  = "0000000000000000";
 
 /****************************************************************************
- * Public Functions
+ * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: vsprintf_pad
+ *
+ * Description:
+ *   Write 'count' copies of a space or zero padding character.
+ *
+ ****************************************************************************/
+
+static void vsprintf_pad(FAR struct lib_outstream_s *stream, char ch,
+                         int count)
+{
+  FAR const char *pad = ch == '0' ? g_zeros : g_spaces;
+
+  while (count > 0)
+    {
+      lib_stream_puts(stream, pad, count < PAD_CHUNK ? count : PAD_CHUNK);
+      count -= PAD_CHUNK;
+    }
+}
+
 static int vsprintf_internal(FAR struct lib_outstream_s *stream,
                              FAR struct arg *arglist, int numargs,
                              FAR const IPTR char *fmt, va_list ap)
@@ -186,6 +219,21 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
     {
       for (; ; )
         {
+#ifndef CONFIG_ARCH_ROMGETC
+          /* Copy the literal text up to the next conversion in one go */
+
+          for (pnt = fmt; *fmt != '\0' && *fmt != '%'; fmt++);
+
+#  ifdef CONFIG_LIBC_NUMBERED_ARGS
+          if (fmt != pnt && stream != NULL)
+#  else
+          if (fmt != pnt)
+#  endif
+            {
+              putstring(pnt, fmt - pnt, stream);
+            }
+#endif
+
           c = fmt_char(fmt);
           if (c == '\0')
             {
@@ -646,11 +694,8 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
                   width -= ndigs;
                   if ((flags & FL_LPAD) == 0)
                     {
-                      do
-                        {
-                          putc(' ', stream);
-                        }
-                      while (--width);
+                      putpad(' ', width, stream);
+                      width = 0;
                     }
                 }
               else
@@ -728,7 +773,7 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
             }
           else
             {
-              n = 5;              /* 1e+00 */
+              n = (exp <= -100 || exp >= 100) ? 6 : 5; /* 1e+00 */
             }
 
           if (sign != 0)
@@ -751,11 +796,8 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
 
           if ((flags & (FL_LPAD | FL_ZFILL)) == 0)
             {
-              while (width)
-                {
-                  putc(' ', stream);
-                  width--;
-                }
+              putpad(' ', width, stream);
+              width = 0;
             }
 
           if (sign != 0)
@@ -765,11 +807,8 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
 
           if ((flags & FL_LPAD) == 0)
             {
-              while (width)
-                {
-                  putc('0', stream);
-                  width--;
-                }
+              putpad('0', width, stream);
+              width = 0;
             }
 
           if ((flags & FL_FLTFIX) != 0)
@@ -842,13 +881,15 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
               putc(_dtoa.digits[0], stream);
               if (prec > 0)
                 {
-                  uint8_t pos;
-
-                  putc('.', stream);
-                  for (pos = 1; pos < 1 + prec; pos++)
+                  n = ndigs > 1 ? ndigs - 1 : 0;
+                  if (n > prec)
                     {
-                      putc(pos < ndigs ? _dtoa.digits[pos] : '0', stream);
+                      n = prec;
                     }
+
+                  putc('.', stream);
+                  putstring(&_dtoa.digits[1], n, stream);
+                  putpad('0', prec - n, stream);
                 }
               else if ((flags & FL_ALT) != 0)
                 {
@@ -866,13 +907,14 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
                 }
 
               putc(ndigs, stream);
-              for (ndigs = '0'; exp >= 10; exp -= 10)
+              if (exp >= 100)
                 {
-                  ndigs += 1;
+                  putc('0' + exp / 100, stream);
+                  exp %= 100;
                 }
 
-              putc(ndigs, stream);
-              putc('0' + exp, stream);
+              putc('0' + exp / 10, stream);
+              putc('0' + exp % 10, stream);
             }
 
           goto tail;
@@ -929,26 +971,14 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
           size = strnlen(pnt, (flags & FL_PREC) ? prec : ~0);
 
         str_lpad:
-          if ((flags & FL_LPAD) == 0)
+          if ((flags & FL_LPAD) == 0 && size < (size_t)width)
             {
-              while (size < width)
-                {
-                  putc(' ', stream);
-                  width--;
-                }
-            }
-
-          while (size)
-            {
-              putc(*pnt++, stream);
-              if (width != 0)
-                {
-                  width -= 1;
-                }
-
-              size -= 1;
+              putpad(' ', width - (int)size, stream);
+              width = (int)size;
             }
 
+          putstring(pnt, size, stream);
+          width = size < (size_t)width ? width - (int)size : 0;
           goto tail;
         }
 
@@ -1202,10 +1232,10 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
                 }
             }
 
-          while (len < width)
+          if (len < width)
             {
-              putc(' ', stream);
-              len++;
+              putpad(' ', width - len, stream);
+              len = width;
             }
         }
 
@@ -1235,26 +1265,29 @@ static int vsprintf_internal(FAR struct lib_outstream_s *stream,
           putc(z, stream);
         }
 
-      while (prec > c)
+      if (prec > c)
         {
-          putc('0', stream);
-          prec--;
+          putpad('0', prec - c, stream);
         }
 
-      while (c)
+      /* The digits were converted in reverse order */
+
+      for (len = 0; len < c / 2; len++)
         {
-          putc(buf[--c], stream);
+          unsigned char tmp = buf[len];
+
+          buf[len]         = buf[c - 1 - len];
+          buf[c - 1 - len] = tmp;
         }
 
+      putstring(buf, c, stream);
+
 tail:
 
       /* Tail is possible.  */
 
-      while (width)
-        {
-          putc(' ', stream);
-          width--;
-        }
+      putpad(' ', width, stream);
+      width = 0;
     }
 
 ret:
@@ -22,6 +22,7 @@
  * Included Files
  ****************************************************************************/
 
+#include <string.h>
 #include <assert.h>
 
 #include "libc.h"
@@ -54,6 +55,35 @@ static void memoutstream_putc(FAR struct lib_outstream_s *this, int ch)
     }
 }
 
+/****************************************************************************
+ * Name: memoutstream_puts
+ ****************************************************************************/
+
+static void memoutstream_puts(FAR struct lib_outstream_s *this,
+                              FAR const void *buf, int len)
+{
+  FAR struct lib_memoutstream_s *mthis =
+                                (FAR struct lib_memoutstream_s *)this;
+  size_t ncopy;
+
+  DEBUGASSERT(this);
+
+  /* Copy as much of the string as fits, truncating like putc() does */
+
+  if (len > 0 && this->nput >= 0 && (size_t)this->nput < mthis->buflen)
+    {
+      ncopy = mthis->buflen - (size_t)this->nput;
+      if (ncopy > (size_t)len)
+        {
+          ncopy = (size_t)len;
+        }
+
+      memcpy(mthis->buffer + this->nput, buf, ncopy);
+      this->nput += ncopy;
+      mthis->buffer[this->nput] = '\0';
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -79,6 +109,7 @@ void lib_memoutstream(FAR struct lib_memoutstream_s *outstream,
                       FAR char *bufstart, int buflen)
 {
   outstream->public.put   = memoutstream_putc;
+  outstream->public.puts  = memoutstream_puts;
   outstream->public.flush = lib_noflush;
   outstream->public.nput  = 0;          /* Will be buffer index */
   outstream->buffer       = bufstart;   /* Start of buffer */
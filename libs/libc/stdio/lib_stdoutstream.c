@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include <fcntl.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -64,6 +65,44 @@ static void stdoutstream_putc(FAR struct lib_outstream_s *this, int ch)
   while (get_errno() == EINTR);
 }
 
+/****************************************************************************
+ * Name: stdoutstream_puts
+ ****************************************************************************/
+
+static void stdoutstream_puts(FAR struct lib_outstream_s *this,
+                              FAR const void *buf, int len)
+{
+  FAR struct lib_stdoutstream_s *sthis =
+                               (FAR struct lib_stdoutstream_s *)this;
+  ssize_t result;
+
+  DEBUGASSERT(this && sthis->stream);
+
+  /* Loop until the string is transferred or an irrecoverable error
+   * occurs.
+   */
+
+  do
+    {
+      result = lib_fwrite(buf, len, sthis->stream);
+      if (result >= 0)
+        {
+          this->nput += result;
+
+          /* Keep the line buffering behavior of fputc() */
+
+          if ((sthis->stream->fs_flags & __FS_FLAG_LBF) != 0 &&
+              memchr(buf, '\n', len) != NULL)
+            {
+              lib_fflush(sthis->stream, true);
+            }
+
+          return;
+        }
+    }
+  while (get_errno() == EINTR);
+}
+
 /****************************************************************************
  * Name: stdoutstream_flush
  ****************************************************************************/
@@ -105,7 +144,8 @@ void lib_stdoutstream(FAR struct lib_stdoutstream_s *outstream,
 {
   /* Select the put operation */
 
-  outstream->public.put = stdoutstream_putc;
+  outstream->public.put  = stdoutstream_putc;
+  outstream->public.puts = stdoutstream_puts;
 
   /* Select the correct flush operation.  This flush is only called when
    * a newline is encountered in the output stream.  However, we do not
@@ -37,8 +37,73 @@
  * Included Files
  ****************************************************************************/
 
+#include <limits.h>
+
 #include "lib_ultoa_invert.h"
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Two decimal digits per entry, so that each division by 100 gives two
+ * characters of output.
+ */
+
+static const char g_dec_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ultoa_invert_dec
+ *
+ * Description:
+ *   Convert an unsigned long to inverted decimal, padding with zeros to at
+ *   least 'ndigits' digits.
+ *
+ ****************************************************************************/
+
+static FAR char *ultoa_invert_dec(unsigned long val, FAR char *str,
+                                  int ndigits)
+{
+  FAR char *start = str;
+  unsigned int v;
+
+  while (val >= 100)
+    {
+      v   = (unsigned int)(val % 100) * 2;
+      val = val / 100;
+
+      *str++ = g_dec_pairs[v + 1];
+      *str++ = g_dec_pairs[v];
+    }
+
+  v = (unsigned int)val * 2;
+  *str++ = g_dec_pairs[v + 1];
+  if (val >= 10)
+    {
+      *str++ = g_dec_pairs[v];
+    }
+
+  while (str - start < ndigits)
+    {
+      *str++ = '0';
+    }
+
+  return str;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -49,14 +114,50 @@ FAR char *__ultoa_invert(unsigned long long val, FAR char *str, int base)
 FAR char *__ultoa_invert(unsigned long val, FAR char *str, int base)
 #endif
 {
-  int upper = 0;
+  FAR const char *xdigits = "0123456789abcdef";
+  int shift;
+  int mask;
 
   if (base & XTOA_UPPER)
     {
-      upper = 1;
+      xdigits = "0123456789ABCDEF";
       base &= ~XTOA_UPPER;
     }
 
+  if (base == 10)
+    {
+#if defined(CONFIG_LIBC_LONG_LONG) && ULLONG_MAX > ULONG_MAX
+      /* Split off nine digits at a time until the rest fits in a long, so
+       * that the digits themselves need no long long divisions.
+       */
+
+      while (val > ULONG_MAX)
+        {
+          str = ultoa_invert_dec((unsigned long)(val % 1000000000), str, 9);
+          val = val / 1000000000;
+        }
+#endif
+
+      return ultoa_invert_dec((unsigned long)val, str, 0);
+    }
+
+  /* Power of two bases need only shifts and masks */
+
+  if (base == 16 || base == 8 || base == 2)
+    {
+      shift = base == 16 ? 4 : base == 8 ? 3 : 1;
+      mask  = base - 1;
+
+      do
+        {
+          *str++ = xdigits[val & mask];
+          val >>= shift;
+        }
+      while (val);
+
+      return str;
+    }
+
   do
     {
       int v;
@@ -70,10 +171,7 @@ FAR char *__ultoa_invert(unsigned long val, FAR char *str, int base)
         }
       else
         {
-          if (upper)
-            v += 'A' - 10;
-          else
-            v += 'a' - 10;
+          v = xdigits[v];
         }
 
       *str++ = v;
@@ -0,0 +1,233 @@
+/****************************************************************************
+ * libs/libc/stdlib/lib_mergesort.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "libc.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Runs of this many elements are insertion sorted before merging */
+
+#define MERGESORT_RUN 8
+
+#ifndef MIN
+#  define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mergesort_swap
+ ****************************************************************************/
+
+static void mergesort_swap(FAR char *a, FAR char *b, size_t width)
+{
+  char tmp;
+
+  while (width-- > 0)
+    {
+      tmp  = *a;
+      *a++ = *b;
+      *b++ = tmp;
+    }
+}
+
+/****************************************************************************
+ * Name: mergesort_insertion
+ *
+ * Description:
+ *   Sort a short run by insertion.  Equal elements are never exchanged, so
+ *   the sort is stable.
+ *
+ ****************************************************************************/
+
+static void mergesort_insertion(FAR char *base, size_t nel, size_t width,
+                                CODE int (*compar)(FAR const void *,
+                                FAR const void *))
+{
+  FAR char *pl;
+  FAR char *pm;
+
+  for (pm = base + width; pm < base + nel * width; pm += width)
+    {
+      for (pl = pm; pl > base && compar(pl - width, pl) > 0; pl -= width)
+        {
+          mergesort_swap(pl, pl - width, width);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: mergesort_merge
+ *
+ * Description:
+ *   Merge the sorted ranges [lo, mid) and [mid, hi) of 'src' into the same
+ *   range of 'dst'.  On equal elements, the one from the first range is
+ *   taken first, which keeps the sort stable.
+ *
+ ****************************************************************************/
+
+static void mergesort_merge(FAR const char *src, FAR char *dst,
+                            size_t lo, size_t mid, size_t hi, size_t width,
+                            CODE int (*compar)(FAR const void *,
+                            FAR const void *))
+{
+  FAR const char *pi = src + lo * width;
+  FAR const char *pj = src + mid * width;
+  FAR const char *pmid = pj;
+  FAR const char *phi = src + hi * width;
+  FAR char *pk = dst + lo * width;
+
+  /* Already in order?  This makes sorted input O(n) */
+
+  if (pj == phi || compar(pj - width, pj) <= 0)
+    {
+      memcpy(pk, pi, phi - pi);
+      return;
+    }
+
+  while (pi < pmid && pj < phi)
+    {
+      if (compar(pj, pi) < 0)
+        {
+          memcpy(pk, pj, width);
+          pj += width;
+        }
+      else
+        {
+          memcpy(pk, pi, width);
+          pi += width;
+        }
+
+      pk += width;
+    }
+
+  memcpy(pk, pi, pmid - pi);
+  pk += pmid - pi;
+  memcpy(pk, pj, phi - pj);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mergesort
+ *
+ * Description:
+ *   Sort an array like qsort(), but stably: elements that compare as equal
+ *   keep their original relative order.  The sort runs in O(n log n) time
+ *   and needs a temporary buffer as large as the array.
+ *
+ * Input Parameters:
+ *   base   - The initial element of the array to be sorted
+ *   nel    - The number of elements in the array
+ *   width  - The size in bytes of each element
+ *   compar - The comparison function, as for qsort()
+ *
+ * Returned Value:
+ *   Zero on success.  Otherwise, -1 is returned with errno set to EINVAL
+ *   if the array size overflows or to ENOMEM if the temporary buffer could
+ *   not be allocated.  The array is not modified on failure.
+ *
+ ****************************************************************************/
+
+int mergesort(FAR void *base, size_t nel, size_t width,
+              CODE int (*compar)(FAR const void *, FAR const void *))
+{
+  FAR char *src = base;
+  FAR char *dst;
+  FAR char *tmp;
+  FAR char *buf = NULL;
+  size_t run;
+  size_t lo;
+
+  if (nel < 2 || width == 0)
+    {
+      return 0;
+    }
+
+  if (nel > SIZE_MAX / width)
+    {
+      set_errno(EINVAL);
+      return -1;
+    }
+
+  if (nel > MERGESORT_RUN)
+    {
+      buf = lib_malloc(nel * width);
+      if (buf == NULL)
+        {
+          set_errno(ENOMEM);
+          return -1;
+        }
+    }
+
+  for (lo = 0; lo < nel; lo += MERGESORT_RUN)
+    {
+      mergesort_insertion(src + lo * width, MIN(MERGESORT_RUN, nel - lo),
+                          width, compar);
+    }
+
+  /* Merge runs of doubling length back and forth between the array and the
+   * buffer.
+   */
+
+  dst = buf;
+  for (run = MERGESORT_RUN; run < nel; run *= 2)
+    {
+      for (lo = 0; lo < nel; lo += 2 * run)
+        {
+          mergesort_merge(src, dst, lo, MIN(lo + run, nel),
+                          MIN(lo + 2 * run, nel), width, compar);
+        }
+
+      tmp = src;
+      src = dst;
+      dst = tmp;
+    }
+
+  if (src != base)
+    {
+      memcpy(base, src, nel * width);
+    }
+
+  if (buf != NULL)
+    {
+      lib_free(buf);
+    }
+
+  return 0;
+}
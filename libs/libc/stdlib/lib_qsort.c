@@ -47,6 +47,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdbool.h>
 #include <stdlib.h>
 
 /****************************************************************************
@@ -85,6 +86,14 @@
 
 #define vecswap(a, b, n) if ((n) > 0) swapfunc(a, b, n, swaptype)
 
+/* Partitions with fewer elements than this are insertion sorted */
+
+#define INSERTION_THRESHOLD 7
+
+/* A partial insertion sort gives up after this many element moves */
+
+#define PARTIAL_INSERTION_LIMIT 8
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -93,6 +102,21 @@ static inline void swapfunc(FAR char *a, FAR char *b, int n, int swaptype);
 static inline FAR char *med3(FAR char *a, FAR char *b, FAR char *c,
                              CODE int (*compar)(FAR const void *,
                              FAR const void *));
+static void insertion_sort(FAR char *base, size_t nel, size_t width,
+                           CODE int (*compar)(FAR const void *,
+                           FAR const void *), int swaptype);
+static bool partial_insertion_sort(FAR char *base, size_t nel, size_t width,
+                                   CODE int (*compar)(FAR const void *,
+                                   FAR const void *), int swaptype);
+static void sift_down(FAR char *base, size_t root, size_t nel, size_t width,
+                      CODE int (*compar)(FAR const void *,
+                      FAR const void *), int swaptype);
+static void heap_sort(FAR char *base, size_t nel, size_t width,
+                      CODE int (*compar)(FAR const void *,
+                      FAR const void *), int swaptype);
+static void introsort(FAR char *base, size_t nel, size_t width,
+                      CODE int (*compar)(FAR const void *,
+                      FAR const void *), int depth);
 
 /****************************************************************************
  * Private Functions
@@ -120,50 +144,139 @@ static inline FAR char *med3(FAR char *a, FAR char *b, FAR char *c,
 }
 
 /****************************************************************************
- * Public Function
+ * Name: insertion_sort
+ *
+ * Description:
+ *   Sort a small array by insertion.
+ *
  ****************************************************************************/
 
+static void insertion_sort(FAR char *base, size_t nel, size_t width,
+                           CODE int (*compar)(FAR const void *,
+                           FAR const void *), int swaptype)
+{
+  FAR char *pl;
+  FAR char *pm;
+
+  for (pm = base + width; pm < base + nel * width; pm += width)
+    {
+      for (pl = pm; pl > base && compar(pl - width, pl) > 0; pl -= width)
+        {
+          swap(pl, pl - width);
+        }
+    }
+}
+
 /****************************************************************************
- * Name: qsort
+ * Name: partial_insertion_sort
  *
  * Description:
- *   The qsort() function will sort an array of 'nel' objects, the initial
- *   element of which is pointed to by 'base'. The size of each object, in
- *   bytes, is specified by the 'width" argument. If the 'nel' argument has
- *   the value zero, the comparison function pointed to by 'compar' will not
- *   be called and no rearrangement will take place.
+ *   Attempt to sort an array that is expected to be already (nearly)
+ *   sorted by insertion.  Give up if more than a few elements have to be
+ *   moved so that adversarial inputs cannot make this quadratic.  The
+ *   array is still a permutation of its input when giving up.
  *
- *   The application will ensure that the comparison function pointed to by
- *   'compar' does not alter the contents of the array. The implementation
- *   may reorder elements of the array between calls to the comparison
- *   function, but will not alter the contents of any individual element.
+ * Returned Value:
+ *   true if the array was sorted; false if the attempt was abandoned.
  *
- *   When the same objects (consisting of 'width" bytes, irrespective of
- *   their current positions in the array) are passed more than once to
- *   the comparison function, the results will be consistent with one
- *   another. That is, they will define a total ordering on the array.
+ ****************************************************************************/
+
+static bool partial_insertion_sort(FAR char *base, size_t nel, size_t width,
+                                   CODE int (*compar)(FAR const void *,
+                                   FAR const void *), int swaptype)
+{
+  FAR char *pl;
+  FAR char *pm;
+  size_t moves = 0;
+
+  for (pm = base + width; pm < base + nel * width; pm += width)
+    {
+      for (pl = pm; pl > base && compar(pl - width, pl) > 0; pl -= width)
+        {
+          if (++moves > PARTIAL_INSERTION_LIMIT)
+            {
+              return false;
+            }
+
+          swap(pl, pl - width);
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: sift_down
  *
- *   The contents of the array will be sorted in ascending order according
- *   to a comparison function. The 'compar' argument is a pointer to the
- *   comparison function, which is called with two arguments that point to
- *   the elements being compared. The application will ensure that the
- *   function returns an integer less than, equal to, or greater than 0,
- *   if the first argument is considered respectively less than, equal to,
- *   or greater than the second. If two members compare as equal, their
- *   order in the sorted array is unspecified.
+ * Description:
+ *   Restore the max-heap property of the 'nel' element heap at 'base'
+ *   below element 'root'.
  *
- *   (Based on description from OpenGroup.org).
+ ****************************************************************************/
+
+static void sift_down(FAR char *base, size_t root, size_t nel, size_t width,
+                      CODE int (*compar)(FAR const void *,
+                      FAR const void *), int swaptype)
+{
+  size_t child;
+
+  while ((child = 2 * root + 1) < nel)
+    {
+      if (child + 1 < nel &&
+          compar(base + child * width, base + (child + 1) * width) < 0)
+        {
+          child++;
+        }
+
+      if (compar(base + root * width, base + child * width) >= 0)
+        {
+          break;
+        }
+
+      swap(base + root * width, base + child * width);
+      root = child;
+    }
+}
+
+/****************************************************************************
+ * Name: heap_sort
  *
- * Returned Value:
- *   The qsort() function will not return a value.
+ * Description:
+ *   Sort an array with heapsort.  This is used when quicksort keeps
+ *   choosing bad pivots and bounds the worst case to O(n log n).
  *
- * Notes from the original BSD version:
- *   Qsort routine from Bentley & McIlroy's "Engineering a Sort Function".
+ ****************************************************************************/
+
+static void heap_sort(FAR char *base, size_t nel, size_t width,
+                      CODE int (*compar)(FAR const void *,
+                      FAR const void *), int swaptype)
+{
+  size_t i;
+
+  for (i = nel / 2; i-- > 0; )
+    {
+      sift_down(base, i, nel, width, compar, swaptype);
+    }
+
+  for (i = nel - 1; i > 0; i--)
+    {
+      swap(base, base + i * width);
+      sift_down(base, 0, i, width, compar, swaptype);
+    }
+}
+
+/****************************************************************************
+ * Name: introsort
+ *
+ * Description:
+ *   Sort with Bentley & McIlroy's quicksort, bounded by a recursion depth
+ *   limit after which heapsort is used.  See qsort() below.
  *
  ****************************************************************************/
 
-void qsort(FAR void *base, size_t nel, size_t width,
-           CODE int(*compar)(FAR const void *, FAR const void *))
+static void introsort(FAR char *base, size_t nel, size_t width,
+                      CODE int (*compar)(FAR const void *,
+                      FAR const void *), int depth)
 {
   FAR char *pa;
   FAR char *pb;
@@ -172,6 +285,8 @@ void qsort(FAR void *base, size_t nel, size_t width,
   FAR char *pl;
   FAR char *pm;
   FAR char *pn;
+  size_t lnel;
+  size_t rnel;
   int swaptype;
   int swap_cnt;
   int d;
@@ -181,20 +296,19 @@ loop:
   SWAPINIT(base, width);
   swap_cnt = 0;
 
-  if (nel < 7)
+  if (nel < INSERTION_THRESHOLD)
     {
-      for (pm = (FAR char *)base + width;
-           pm < (FAR char *)base + nel * width;
-           pm += width)
-        {
-          for (pl = pm;
-               pl > (FAR char *)base && compar(pl - width, pl) > 0;
-               pl -= width)
-            {
-              swap(pl, pl - width);
-            }
-        }
+      insertion_sort(base, nel, width, compar, swaptype);
+      return;
+    }
+
+  /* If the partitions keep coming out unbalanced, the pivot selection is
+   * being defeated.  Switch to heapsort to keep the worst case O(n log n).
+   */
 
+  if (depth-- <= 0)
+    {
+      heap_sort(base, nel, width, compar, swaptype);
       return;
     }
 
@@ -255,25 +369,6 @@ loop:
       pc      -= width;
     }
 
-  if (swap_cnt == 0)
-    {
-      /* Switch to insertion sort */
-
-      for (pm = (FAR char *)base + width;
-           pm < (FAR char *)base + nel * width;
-           pm += width)
-        {
-          for (pl = pm;
-               pl > (FAR char *)base && compar(pl - width, pl) > 0;
-               pl -= width)
-            {
-              swap(pl, pl - width);
-            }
-        }
-
-      return;
-    }
-
   pn = (FAR char *)base + nel * width;
   r  = min(pa - (FAR char *)base, pb - pa);
   vecswap(base, pb - r, r);
@@ -281,17 +376,106 @@ loop:
   r  = min(pd - pc, pn - pd - width);
   vecswap(pb, pn - r, r);
 
-  if ((r = pb - pa) > width)
+  lnel = (pb - pa) / width;
+  rnel = (pd - pc) / width;
+
+  /* If partitioning swapped nothing, the input may be already sorted.  Try
+   * to finish both partitions with an insertion sort that gives up early.
+   */
+
+  if (swap_cnt == 0 &&
+      partial_insertion_sort(base, lnel, width, compar, swaptype) &&
+      partial_insertion_sort(pn - rnel * width, rnel, width, compar,
+                             swaptype))
     {
-      qsort(base, r / width, width, compar);
+      return;
     }
 
-  if ((r = pd - pc) > width)
+  /* Recurse into the smaller partition and iterate on the larger one so
+   * that the stack depth is O(log n).
+   */
+
+  if (lnel < rnel)
+    {
+      if (lnel > 1)
+        {
+          introsort(base, lnel, width, compar, depth);
+        }
+
+      base = pn - rnel * width;
+      nel  = rnel;
+    }
+  else
     {
-      /* Iterate rather than recurse to save stack space */
+      if (rnel > 1)
+        {
+          introsort(pn - rnel * width, rnel, width, compar, depth);
+        }
 
-      base = pn - r;
-      nel = r / width;
+      nel = lnel;
+    }
+
+  if (nel > 1)
+    {
       goto loop;
     }
 }
+
+/****************************************************************************
+ * Public Function
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: qsort
+ *
+ * Description:
+ *   The qsort() function will sort an array of 'nel' objects, the initial
+ *   element of which is pointed to by 'base'. The size of each object, in
+ *   bytes, is specified by the 'width" argument. If the 'nel' argument has
+ *   the value zero, the comparison function pointed to by 'compar' will not
+ *   be called and no rearrangement will take place.
+ *
+ *   The application will ensure that the comparison function pointed to by
+ *   'compar' does not alter the contents of the array. The implementation
+ *   may reorder elements of the array between calls to the comparison
+ *   function, but will not alter the contents of any individual element.
+ *
+ *   When the same objects (consisting of 'width" bytes, irrespective of
+ *   their current positions in the array) are passed more than once to
+ *   the comparison function, the results will be consistent with one
+ *   another. That is, they will define a total ordering on the array.
+ *
+ *   The contents of the array will be sorted in ascending order according
+ *   to a comparison function. The 'compar' argument is a pointer to the
+ *   comparison function, which is called with two arguments that point to
+ *   the elements being compared. The application will ensure that the
+ *   function returns an integer less than, equal to, or greater than 0,
+ *   if the first argument is considered respectively less than, equal to,
+ *   or greater than the second. If two members compare as equal, their
+ *   order in the sorted array is unspecified.
+ *
+ *   (Based on description from OpenGroup.org).
+ *
+ * Returned Value:
+ *   The qsort() function will not return a value.
+ *
+ * Notes from the original BSD version:
+ *   Qsort routine from Bentley & McIlroy's "Engineering a Sort Function".
+ *
+ ****************************************************************************/
+
+void qsort(FAR void *base, size_t nel, size_t width,
+           CODE int(*compar)(FAR const void *, FAR const void *))
+{
+  size_t n;
+  int depth;
+
+  /* Allow about twice the recursion depth of a perfectly balanced sort */
+
+  for (n = nel, depth = 0; n > 1; n >>= 1)
+    {
+      depth += 2;
+    }
+
+  introsort(base, nel, width, compar, depth);
+}
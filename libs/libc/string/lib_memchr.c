@@ -26,6 +26,8 @@
 
 #include <string.h>
 
+#include "libc.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -51,6 +53,30 @@ FAR void *memchr(FAR const void *s, int c, size_t n)
 
   if (s)
     {
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+      FAR const uintptr_t *wp;
+      uintptr_t mask;
+
+      for (; n > 0 && !LIB_WORD_ALIGNED(p); n--, p++)
+        {
+          if (*p == (unsigned char)c)
+            {
+              return (FAR void *)p;
+            }
+        }
+
+      /* Skip whole words that do not hold the byte.  Only words that lie
+       * entirely within the buffer are read.
+       */
+
+      mask = LIB_WORD_REPEAT(c);
+      for (wp = (FAR const uintptr_t *)p;
+           n >= LIB_WORD_SIZE && !LIB_WORD_HASZERO(*wp ^ mask);
+           n -= LIB_WORD_SIZE, wp++);
+
+      p = (FAR const unsigned char *)wp;
+#endif
+
       while (n--)
         {
           if (*p == (unsigned char)c)
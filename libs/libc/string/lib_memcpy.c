@@ -26,6 +26,8 @@
 #include <sys/types.h>
 #include <string.h>
 
+#include "libc.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -40,6 +42,46 @@ FAR void *memcpy(FAR void *dest, FAR const void *src, size_t n)
 {
   FAR unsigned char *pout = (FAR unsigned char *)dest;
   FAR unsigned char *pin  = (FAR unsigned char *)src;
+
+#ifdef CONFIG_MEMCPY_OPTSPEED
+  /* Copy whole words if both buffers can be brought to word alignment */
+
+  if ((((uintptr_t)pout ^ (uintptr_t)pin) & LIB_WORD_MASK) == 0)
+    {
+      FAR uintptr_t *wout;
+      FAR const uintptr_t *win;
+
+      while (n > 0 && !LIB_WORD_ALIGNED(pout))
+        {
+          *pout++ = *pin++;
+          n--;
+        }
+
+      wout = (FAR uintptr_t *)pout;
+      win  = (FAR const uintptr_t *)pin;
+
+      while (n >= 4 * LIB_WORD_SIZE)
+        {
+          wout[0] = win[0];
+          wout[1] = win[1];
+          wout[2] = win[2];
+          wout[3] = win[3];
+          wout   += 4;
+          win    += 4;
+          n      -= 4 * LIB_WORD_SIZE;
+        }
+
+      while (n >= LIB_WORD_SIZE)
+        {
+          *wout++ = *win++;
+          n      -= LIB_WORD_SIZE;
+        }
+
+      pout = (FAR unsigned char *)wout;
+      pin  = (FAR unsigned char *)win;
+    }
+#endif
+
   while (n-- > 0) *pout++ = *pin++;
   return dest;
 }
@@ -26,6 +26,8 @@
 
 #include <string.h>
 
+#include "libc.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -48,6 +50,54 @@
 #undef strchr /* See mm/README.txt */
 FAR char *strchr(FAR const char *s, int c)
 {
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+  FAR const uintptr_t *wp;
+  uintptr_t mask;
+  uintptr_t word;
+
+  if (s == NULL)
+    {
+      return NULL;
+    }
+
+  for (; !LIB_WORD_ALIGNED(s); s++)
+    {
+      if (*s == (char)c)
+        {
+          return (FAR char *)s;
+        }
+
+      if (*s == '\0')
+        {
+          return NULL;
+        }
+    }
+
+  /* Skip whole words that hold neither the terminator nor the character */
+
+  mask = LIB_WORD_REPEAT(c);
+  for (wp = (FAR const uintptr_t *)s; ; wp++)
+    {
+      word = *wp;
+      if (LIB_WORD_HASZERO(word) || LIB_WORD_HASZERO(word ^ mask))
+        {
+          break;
+        }
+    }
+
+  for (s = (FAR const char *)wp; ; s++)
+    {
+      if (*s == (char)c)
+        {
+          return (FAR char *)s;
+        }
+
+      if (*s == '\0')
+        {
+          return NULL;
+        }
+    }
+#else
   if (s)
     {
       for (; ; s++)
@@ -65,5 +115,6 @@ FAR char *strchr(FAR const char *s, int c)
     }
 
   return NULL;
+#endif
 }
 #endif
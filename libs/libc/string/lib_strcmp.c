@@ -26,6 +26,8 @@
 
 #include <string.h>
 
+#include "libc.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -34,6 +36,47 @@
 #undef strcmp /* See mm/README.txt */
 int strcmp(FAR const char *cs, FAR const char *ct)
 {
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+  FAR const unsigned char *s1 = (FAR const unsigned char *)cs;
+  FAR const unsigned char *s2 = (FAR const unsigned char *)ct;
+
+  /* Compare whole words while they are equal and hold no terminator.  This
+   * is only possible if both strings have the same word alignment.
+   */
+
+  if ((((uintptr_t)s1 ^ (uintptr_t)s2) & LIB_WORD_MASK) == 0)
+    {
+      FAR const uintptr_t *w1;
+      FAR const uintptr_t *w2;
+
+      for (; !LIB_WORD_ALIGNED(s1); s1++, s2++)
+        {
+          if (*s1 != *s2 || *s1 == '\0')
+            {
+              return *s1 - *s2;
+            }
+        }
+
+      w1 = (FAR const uintptr_t *)s1;
+      w2 = (FAR const uintptr_t *)s2;
+      while (*w1 == *w2 && !LIB_WORD_HASZERO(*w1))
+        {
+          w1++;
+          w2++;
+        }
+
+      s1 = (FAR const unsigned char *)w1;
+      s2 = (FAR const unsigned char *)w2;
+    }
+
+  while (*s1 == *s2 && *s1 != '\0')
+    {
+      s1++;
+      s2++;
+    }
+
+  return *s1 - *s2;
+#else
   register signed char result;
   for (; ; )
     {
@@ -42,5 +85,6 @@ int strcmp(FAR const char *cs, FAR const char *ct)
     }
 
   return result;
+#endif
 }
 #endif
@@ -26,6 +26,8 @@
 #include <sys/types.h>
 #include <string.h>
 
+#include "libc.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -35,7 +37,29 @@
 size_t strlen(const char *s)
 {
   const char *sc;
-  for (sc = s; *sc != '\0'; ++sc);
+
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+  FAR const uintptr_t *wp;
+
+  for (sc = s; !LIB_WORD_ALIGNED(sc); ++sc)
+    {
+      if (*sc == '\0')
+        {
+          return sc - s;
+        }
+    }
+
+  /* An aligned word never straddles a page or region boundary, so reading
+   * the whole word that holds the terminator is safe.
+   */
+
+  for (wp = (FAR const uintptr_t *)sc; !LIB_WORD_HASZERO(*wp); wp++);
+  sc = (FAR const char *)wp;
+#else
+  sc = s;
+#endif
+
+  for (; *sc != '\0'; ++sc);
   return sc - s;
 }
 #endif
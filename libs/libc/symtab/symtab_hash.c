@@ -0,0 +1,300 @@
+/****************************************************************************
+ * libs/libc/symtab/symtab_hash.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/symtab.h>
+
+#include "libc.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The second bloom filter bit is taken from the hash shifted by this
+ * amount, above the bits that select the first bit and the filter word.
+ */
+
+#define SYMTAB_BLOOM_SHIFT  16
+
+/* Marks a bucket with no symbols */
+
+#define SYMTAB_BUCKET_EMPTY UINT32_MAX
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: symtab_hashname
+ *
+ * Description:
+ *   The GNU ELF symbol hash function (h * 33 + c).
+ *
+ ****************************************************************************/
+
+static uint32_t symtab_hashname(FAR const char *name)
+{
+  uint32_t hash = 5381;
+  uint8_t ch;
+
+  while ((ch = (uint8_t)*name++) != '\0')
+    {
+      hash = (hash << 5) + hash + ch;
+    }
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name: symtab_bloommask
+ *
+ * Description:
+ *   Return the two bloom filter bits selected by a hash value.
+ *
+ ****************************************************************************/
+
+static uint32_t symtab_bloommask(uint32_t hash)
+{
+  return (UINT32_C(1) << (hash & 31)) |
+         (UINT32_C(1) << ((hash >> SYMTAB_BLOOM_SHIFT) & 31));
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: symtab_hashinit
+ *
+ * Description:
+ *   Build a hash index over a symbol table.  The symbol table itself is
+ *   not modified and must remain valid as long as the index is in use.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOMEM if the index could not be allocated.
+ *
+ ****************************************************************************/
+
+int symtab_hashinit(FAR struct symtab_hash_s *hash,
+                    FAR const struct symtab_s *symtab, int nsyms)
+{
+  FAR uint32_t *hashes;
+  FAR uint32_t *alloc;
+  uint32_t nbuckets;
+  uint32_t nbloom;
+  uint32_t bucket;
+  uint32_t end;
+  uint32_t sum;
+  int i;
+
+  DEBUGASSERT(hash != NULL && (symtab != NULL || nsyms == 0));
+
+  memset(hash, 0, sizeof(struct symtab_hash_s));
+
+  if (nsyms <= 0)
+    {
+      hash->symtab = symtab;
+      return OK;
+    }
+
+  /* Average two symbols per bucket and at least eight bloom filter bits per
+   * symbol, so that only about one lookup in twenty for an absent name gets
+   * past the filter.
+   */
+
+  nbuckets = (nsyms + 1) / 2;
+  for (nbloom = 1; nbloom * 4 < (uint32_t)nsyms; nbloom <<= 1);
+
+  alloc = lib_malloc((nbloom + nbuckets + 2 * nsyms) * sizeof(uint32_t));
+  if (alloc == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  hashes = lib_malloc(nsyms * sizeof(uint32_t));
+  if (hashes == NULL)
+    {
+      lib_free(alloc);
+      return -ENOMEM;
+    }
+
+  hash->symtab   = symtab;
+  hash->bloom    = alloc;
+  hash->buckets  = hash->bloom + nbloom;
+  hash->chain    = hash->buckets + nbuckets;
+  hash->order    = hash->chain + nsyms;
+  hash->nbloom   = nbloom;
+  hash->nbuckets = nbuckets;
+  hash->nsyms    = nsyms;
+
+  memset(hash->bloom, 0, (nbloom + nbuckets) * sizeof(uint32_t));
+
+  /* Hash every name, fill the bloom filter and count the bucket sizes */
+
+  for (i = 0; i < nsyms; i++)
+    {
+      hashes[i] = symtab_hashname(symtab[i].sym_name);
+      hash->bloom[(hashes[i] >> 5) & (nbloom - 1)] |=
+        symtab_bloommask(hashes[i]);
+      hash->buckets[hashes[i] % nbuckets]++;
+    }
+
+  /* Convert the counts to the end position of each bucket's chain */
+
+  for (bucket = 0, sum = 0; bucket < nbuckets; bucket++)
+    {
+      sum += hash->buckets[bucket];
+      hash->buckets[bucket] = sum;
+    }
+
+  /* Place the symbols in reverse so that each chain keeps the symbol table
+   * order and a duplicated name resolves the same way as with
+   * symtab_findbyname().  Afterward, each bucket holds its start position.
+   */
+
+  for (i = nsyms - 1; i >= 0; i--)
+    {
+      uint32_t pos = --hash->buckets[hashes[i] % nbuckets];
+
+      hash->chain[pos] = hashes[i] & ~UINT32_C(1);
+      hash->order[pos] = i;
+    }
+
+  /* Mark the last entry of each chain with the low bit of its hash */
+
+  for (bucket = 0; bucket < nbuckets; bucket++)
+    {
+      end = bucket + 1 < nbuckets ? hash->buckets[bucket + 1] : nsyms;
+      if (end > hash->buckets[bucket])
+        {
+          hash->chain[end - 1] |= 1;
+        }
+      else
+        {
+          hash->buckets[bucket] = SYMTAB_BUCKET_EMPTY;
+        }
+    }
+
+  lib_free(hashes);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: symtab_hashfree
+ *
+ * Description:
+ *   Release the memory used by a hash index built by symtab_hashinit().
+ *
+ * Returned Value:
+ *   None.
+ *
+ ****************************************************************************/
+
+void symtab_hashfree(FAR struct symtab_hash_s *hash)
+{
+  DEBUGASSERT(hash != NULL);
+
+  if (hash->bloom != NULL)
+    {
+      lib_free(hash->bloom);
+    }
+
+  memset(hash, 0, sizeof(struct symtab_hash_s));
+}
+
+/****************************************************************************
+ * Name: symtab_hashfind
+ *
+ * Description:
+ *   Find the symbol with the matching name using a hash index built by
+ *   symtab_hashinit().  Most absent names are rejected by the bloom filter
+ *   without touching the symbol table; otherwise only the names in one
+ *   hash chain whose full hash matches are compared.
+ *
+ * Returned Value:
+ *   A reference to the symbol table entry if an entry with the matching
+ *   name is found; NULL is returned if the entry is not found.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *
+symtab_hashfind(FAR const struct symtab_hash_s *hash, FAR const char *name)
+{
+  FAR const struct symtab_s *symbol;
+  uint32_t mask;
+  uint32_t code;
+  uint32_t pos;
+
+#ifdef CONFIG_SYMTAB_DECORATED
+  if (name[0] == '_')
+    {
+      name++;
+    }
+#endif
+
+  DEBUGASSERT(hash != NULL && name != NULL);
+
+  if (hash->nbuckets == 0)
+    {
+      return NULL;
+    }
+
+  code = symtab_hashname(name);
+  mask = symtab_bloommask(code);
+  if ((hash->bloom[(code >> 5) & (hash->nbloom - 1)] & mask) != mask)
+    {
+      return NULL;
+    }
+
+  pos = hash->buckets[code % hash->nbuckets];
+  if (pos == SYMTAB_BUCKET_EMPTY)
+    {
+      return NULL;
+    }
+
+  for (; ; pos++)
+    {
+      if ((hash->chain[pos] | 1) == (code | 1))
+        {
+          symbol = &hash->symtab[hash->order[pos]];
+          if (strcmp(name, symbol->sym_name) == 0)
+            {
+              return symbol;
+            }
+        }
+
+      if ((hash->chain[pos] & 1) != 0)
+        {
+          break;
+        }
+    }
+
+  return NULL;
+}
@@ -67,6 +67,9 @@ struct irq_info_s
   uint32_t lscount;  /* Number of interrupts on this IRQ (LS) */
 #endif
   uint32_t time;     /* Maximum execution time on this IRQ */
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  uint32_t hist[CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS];
+#endif
 #endif
 };
 
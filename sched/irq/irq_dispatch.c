@@ -69,6 +69,15 @@
 #  define CONFIG_SCHED_CRITMONITOR_MAXTIME_IRQ 0
 #endif
 
+/* IRQ_HIST_ADD - Count the execution time of the interrupt handler */
+
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+#  define IRQ_HIST_ADD(ndx, elapsed) \
+     nxsched_critmon_histogram(g_irqvector[ndx].hist, elapsed)
+#else
+#  define IRQ_HIST_ADD(ndx, elapsed)
+#endif
+
 #ifndef CONFIG_SCHED_IRQMONITOR
 #  define CALL_VECTOR(ndx, vector, irq, context, arg) \
      vector(irq, context, arg)
@@ -87,6 +96,7 @@
            { \
              g_irqvector[ndx].time = delta.tv_nsec; \
            } \
+         IRQ_HIST_ADD(ndx, elapsed); \
          if (CONFIG_SCHED_CRITMONITOR_MAXTIME_IRQ > 0 && \
              elapsed > CONFIG_SCHED_CRITMONITOR_MAXTIME_IRQ) \
            { \
@@ -25,7 +25,9 @@
 #include <nuttx/config.h>
 
 #include <sys/stat.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <string.h>
 #include <assert.h>
@@ -56,6 +58,15 @@
  * NOTE:  This assumes that an address can be represented in 32-bits.  In
  * the typical configuration where CONFIG_HAVE_LONG_LONG=y, the COUNT field
  * may not be wide enough.
+ *
+ * With CONFIG_SCHED_CRITMONITOR_HISTOGRAM, the header is followed by the
+ * lower bounds of the histogram buckets in nanoseconds and each IRQ by the
+ * count of its handler execution times in each bucket:
+ *
+ *   HIST(ns) 0 31 62 125 ...
+ *   ...
+ *   DDD XXXXXXXX XXXXXXXX DDDDDDDDDD DDDD.DDD DDDD
+ *       D D D D ...
  */
 
 #define HDR_FMT "IRQ HANDLER  ARGUMENT    COUNT    RATE    TIME\n"
@@ -66,7 +77,13 @@
  * bytes).
  */
 
-#define IRQ_LINELEN 50
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+#  define IRQ_NBUCKETS CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS
+#  define IRQ_SHIFT    CONFIG_SCHED_CRITMONITOR_HISTOGRAM_SHIFT
+#  define IRQ_LINELEN  (50 + 11 * IRQ_NBUCKETS)
+#else
+#  define IRQ_LINELEN  50
+#endif
 
 /****************************************************************************
  * Private Types
@@ -88,6 +105,14 @@ struct irq_file_s
  * Private Function Prototypes
  ****************************************************************************/
 
+/* Helpers */
+
+static void    irq_output(FAR struct irq_file_s *irqfile, size_t linesize);
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+static size_t  irq_histline(FAR char *line, FAR const char *prefix,
+                 FAR const unsigned long *values);
+#endif
+
 /* irq_foreach() callback function */
 
 static int     irq_callback(int irq, FAR struct irq_info_s *info,
@@ -134,6 +159,61 @@ const struct procfs_operations irq_operations =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: irq_output
+ *
+ * Description:
+ *   Copy the formatted line to the user buffer.
+ *
+ ****************************************************************************/
+
+static void irq_output(FAR struct irq_file_s *irqfile, size_t linesize)
+{
+  size_t copysize;
+
+  copysize  = procfs_memcpy(irqfile->line, linesize, irqfile->buffer,
+                            irqfile->remaining, &irqfile->offset);
+
+  irqfile->ncopied   += copysize;
+  irqfile->buffer    += copysize;
+  irqfile->remaining -= copysize;
+}
+
+/****************************************************************************
+ * Name: irq_histline
+ *
+ * Description:
+ *   Format one line of histogram values.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+static size_t irq_histline(FAR char *line, FAR const char *prefix,
+                           FAR const unsigned long *values)
+{
+  size_t linesize;
+  int i;
+
+  linesize = snprintf(line, IRQ_LINELEN, "%s", prefix);
+  for (i = 0; i < IRQ_NBUCKETS && linesize < IRQ_LINELEN - 1; i++)
+    {
+      linesize += snprintf(&line[linesize], IRQ_LINELEN - linesize,
+                           " %lu", values[i]);
+    }
+
+  if (linesize < IRQ_LINELEN - 1)
+    {
+      linesize += snprintf(&line[linesize], IRQ_LINELEN - linesize, "\n");
+    }
+
+  /* snprintf() returns the untruncated length; never report more than
+   * what is in the line buffer.
+   */
+
+  return linesize < IRQ_LINELEN ? linesize : IRQ_LINELEN - 1;
+}
+#endif
+
 /****************************************************************************
  * Name: irq_callback
  ****************************************************************************/
@@ -147,10 +227,13 @@ static int irq_callback(int irq, FAR struct irq_info_s *info,
   clock_t elapsed;
   clock_t now;
   size_t linesize;
-  size_t copysize;
   unsigned long intpart;
   unsigned long fracpart;
   unsigned long count;
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  unsigned long hist[IRQ_NBUCKETS];
+  int i;
+#endif
 
   DEBUGASSERT(irqfile != NULL);
 
@@ -167,6 +250,9 @@ static int irq_callback(int irq, FAR struct irq_info_s *info,
   info->lscount = 0;
 #endif
   info->time    = 0;
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  memset(info->hist, 0, sizeof(info->hist));
+#endif
   leave_critical_section(flags);
 
   /* Don't bother if count == 0.
@@ -242,12 +328,17 @@ static int irq_callback(int irq, FAR struct irq_info_s *info,
                       count, intpart, fracpart,
                       (unsigned long)copy.time / 1000);
 
-  copysize  = procfs_memcpy(irqfile->line, linesize, irqfile->buffer,
-                            irqfile->remaining, &irqfile->offset);
+  irq_output(irqfile, linesize);
 
-  irqfile->ncopied   += copysize;
-  irqfile->buffer    += copysize;
-  irqfile->remaining -= copysize;
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  for (i = 0; i < IRQ_NBUCKETS; i++)
+    {
+      hist[i] = copy.hist[i];
+    }
+
+  linesize = irq_histline(irqfile->line, "   ", hist);
+  irq_output(irqfile, linesize);
+#endif
 
   /* Return a non-zero value to stop the traversal if the user-provided
    * buffer is full.
@@ -337,6 +428,10 @@ static ssize_t irq_read(FAR struct file *filep, FAR char *buffer,
   FAR struct irq_file_s *irqfile;
   size_t linesize;
   size_t copysize;
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  unsigned long bounds[IRQ_NBUCKETS];
+  int i;
+#endif
 
   finfo("buffer=%p buflen=%d\n", buffer, (int)buflen);
 
@@ -362,6 +457,38 @@ static ssize_t irq_read(FAR struct file *filep, FAR char *buffer,
   irqfile->buffer    += copysize;
   irqfile->remaining -= copysize;
 
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  /* Followed by the lower bounds of the histogram buckets */
+
+  for (i = 0; i < IRQ_NBUCKETS; i++)
+    {
+      struct timespec ts =
+        {
+          0
+        };
+
+      uint64_t units = 0;
+
+      /* Bounds beyond the 32-bit timer range cannot be converted */
+
+      if (i > 0)
+        {
+          units = UINT64_C(1) << (i - 1 + IRQ_SHIFT);
+          if (units <= UINT32_MAX)
+            {
+              up_critmon_convert((uint32_t)units, &ts);
+            }
+        }
+
+      bounds[i] = units > UINT32_MAX ||
+                  ts.tv_sec >= ULONG_MAX / 1000000000 ? ULONG_MAX :
+                  ts.tv_sec * 1000000000ul + ts.tv_nsec;
+    }
+
+  linesize = irq_histline(irqfile->line, "HIST(ns)", bounds);
+  irq_output(irqfile, linesize);
+#endif
+
   /* Now traverse the list of attached interrupts, generating output for
    * each.
    */
@@ -233,8 +233,7 @@ FAR void *insmod(FAR const char *filename, FAR const char *modname)
 
   /* Get the module initializer entry point */
 
-  initializer = (mod_initializer_t)(loadinfo.textalloc +
-                                    loadinfo.ehdr.e_entry);
+  initializer = (mod_initializer_t)loadinfo.entrypt;
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MODULE)
   modp->initializer = initializer;
 #endif
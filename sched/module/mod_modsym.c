@@ -94,8 +94,7 @@ FAR const void *modsym(FAR void *handle, FAR const char *name)
 
   /* Search the symbol table for the matching symbol */
 
-  symbol = symtab_findbyname(modp->modinfo.exports, name,
-                             modp->modinfo.nexports);
+  symbol = modlib_findexport(modp, name);
   if (symbol == NULL)
     {
       berr("ERROR: Failed to find symbol in symbol \"%s\" in table\n", name);
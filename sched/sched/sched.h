@@ -406,6 +406,10 @@ void nxsched_resume_critmon(FAR struct tcb_s *tcb);
 void nxsched_suspend_critmon(FAR struct tcb_s *tcb);
 #endif
 
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+void nxsched_critmon_histogram(FAR uint32_t *hist, uint32_t elapsed);
+#endif
+
 /* TCB operations */
 
 bool nxsched_verify_tcb(FAR struct tcb_s *tcb);
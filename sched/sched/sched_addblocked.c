@@ -84,4 +84,10 @@ void nxsched_add_blocked(FAR struct tcb_s *btcb, tstate_t task_state)
   /* Make sure the TCB's state corresponds to the list */
 
   btcb->task_state = task_state;
+
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  /* A task that blocks again before it ran has no wakeup latency */
+
+  btcb->ready_start = 0;
+#endif
 }
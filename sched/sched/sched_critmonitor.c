@@ -26,6 +26,7 @@
 
 #include <sys/types.h>
 #include <sched.h>
+#include <strings.h>
 #include <assert.h>
 
 #include "sched/sched.h"
@@ -96,6 +97,19 @@
 #  define CHECK_THREAD(pid, elapsed)
 #endif
 
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+/* procfs computes the bucket bounds as 64-bit shifts */
+
+#  if CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS + \
+      CONFIG_SCHED_CRITMONITOR_HISTOGRAM_SHIFT > 64
+#    error NBUCKETS + SHIFT of the critmon histogram must not exceed 64
+#  endif
+
+#  define HIST_ADD(hist, elapsed) nxsched_critmon_histogram(hist, elapsed)
+#else
+#  define HIST_ADD(hist, elapsed)
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -128,6 +142,35 @@ uint32_t g_crit_max[1];
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nxsched_critmon_histogram
+ *
+ * Description:
+ *   Count one time in a log2 bucketed histogram.  Bucket 0 holds the times
+ *   of zero, bucket n the times from 2^(n-1) up to 2^n, and the last
+ *   bucket all longer times.
+ *
+ * Input Parameters:
+ *   hist    - The histogram of CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS
+ *             buckets
+ *   elapsed - The time in units of up_critmon_gettime()
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+void nxsched_critmon_histogram(FAR uint32_t *hist, uint32_t elapsed)
+{
+  int bucket = flsl(elapsed >> CONFIG_SCHED_CRITMONITOR_HISTOGRAM_SHIFT);
+
+  if (bucket >= CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS)
+    {
+      bucket = CONFIG_SCHED_CRITMONITOR_HISTOGRAM_NBUCKETS - 1;
+    }
+
+  hist[bucket]++;
+}
+#endif
+
 /****************************************************************************
  * Name: nxsched_critmon_preemption
  *
@@ -173,6 +216,7 @@ void nxsched_critmon_preemption(FAR struct tcb_s *tcb, bool state)
       DEBUGASSERT(now != 0);
 
       tcb->premp_start = 0;
+      HIST_ADD(tcb->premp_hist, elapsed);
       if (elapsed > tcb->premp_max)
         {
           tcb->premp_max = elapsed;
@@ -238,6 +282,7 @@ void nxsched_critmon_csection(FAR struct tcb_s *tcb, bool state)
       DEBUGASSERT(now != 0);
 
       tcb->crit_start = 0;
+      HIST_ADD(tcb->crit_hist, elapsed);
       if (elapsed > tcb->crit_max)
         {
           tcb->crit_max = elapsed;
@@ -283,6 +328,16 @@ void nxsched_resume_critmon(FAR struct tcb_s *tcb)
 
   tcb->run_start = current;
 
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  /* Was this task just unblocked?  Count the wakeup-to-run latency. */
+
+  if (tcb->ready_start != 0)
+    {
+      nxsched_critmon_histogram(tcb->wake_hist, current - tcb->ready_start);
+      tcb->ready_start = 0;
+    }
+#endif
+
   /* Did this task disable pre-emption? */
 
   if (tcb->lockcount > 0)
@@ -376,6 +431,7 @@ void nxsched_suspend_critmon(FAR struct tcb_s *tcb)
       elapsed = current - tcb->premp_start;
 
       tcb->premp_start = 0;
+      HIST_ADD(tcb->premp_hist, elapsed);
       if (elapsed > tcb->premp_max)
         {
           tcb->premp_max = elapsed;
@@ -392,6 +448,7 @@ void nxsched_suspend_critmon(FAR struct tcb_s *tcb)
       elapsed = current - tcb->crit_start;
 
       tcb->crit_start = 0;
+      HIST_ADD(tcb->crit_hist, elapsed);
       if (elapsed > tcb->crit_max)
         {
           tcb->crit_max = elapsed;
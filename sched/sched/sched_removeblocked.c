@@ -72,4 +72,10 @@ void nxsched_remove_blocked(FAR struct tcb_s *btcb)
    */
 
   btcb->task_state = TSTATE_TASK_INVALID;
+
+#ifdef CONFIG_SCHED_CRITMONITOR_HISTOGRAM
+  /* Start measuring the wakeup-to-run latency */
+
+  btcb->ready_start = up_critmon_gettime();
+#endif
 }
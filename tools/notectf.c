@@ -0,0 +1,400 @@
+/****************************************************************************
+ * tools/notectf.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sys/stat.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* These must agree with include/nuttx/note/notectf_driver.h */
+
+#define NOTECTF_MAGIC     0xc1fc1fc1
+#define NOTECTF_HDRSIZE   16
+
+#define PACKET_SIZE       4096
+#define MAX_PATH          1024
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct event_s
+{
+  int id;
+  const char *name;
+  const char *fields;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The note types of include/nuttx/sched_note.h.  The fields of the events
+ * that depend on the target configuration are patched in main().
+ */
+
+static struct event_s g_events[] =
+{
+  { 0,  "sched_start",      "string name;" },
+  { 1,  "sched_stop",       NULL },
+  { 2,  "sched_suspend",    "uint8_t state;" },
+  { 3,  "sched_resume",     NULL },
+  { 4,  "cpu_start",        "uint8_t target;" },
+  { 5,  "cpu_started",      NULL },
+  { 6,  "cpu_pause",        "uint8_t target;" },
+  { 7,  "cpu_paused",       NULL },
+  { 8,  "cpu_resume",       "uint8_t target;" },
+  { 9,  "cpu_resumed",      NULL },
+  { 10, "preempt_lock",     "uint16_t count;" },
+  { 11, "preempt_unlock",   "uint16_t count;" },
+  { 12, "csection_enter",   NULL },
+  { 13, "csection_leave",   NULL },
+  { 14, "spinlock_lock",    "uintptr_t spinlock; uint8_t value;" },
+  { 15, "spinlock_locked",  "uintptr_t spinlock; uint8_t value;" },
+  { 16, "spinlock_unlock",  "uintptr_t spinlock; uint8_t value;" },
+  { 17, "spinlock_abort",   "uintptr_t spinlock; uint8_t value;" },
+  { 18, "syscall_enter",
+        "uint8_t nr; uint8_t argc; uintptr_t args[argc];" },
+  { 19, "syscall_leave",    "uint8_t nr; uintptr_t result;" },
+  { 20, "irq_enter",        "uint8_t irq;" },
+  { 21, "irq_leave",        "uint8_t irq;" },
+};
+
+#define NEVENTS (sizeof(g_events) / sizeof(g_events[0]))
+
+static bool g_smp;
+static bool g_hires;
+static int g_ptrsize = 4;
+static unsigned long g_tickhz = 100;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void show_usage(const char *progname, int exitcode)
+{
+  fprintf(stderr, "USAGE: %s [-s] [-r] [-n] [-p <ptrsize>] [-t <hz>] "
+          "-o <outdir> <notefile>\n", progname);
+  fprintf(stderr, "\nConvert a raw dump of /dev/note to a CTF trace\n");
+  fprintf(stderr, "\nWhere:\n");
+  fprintf(stderr, "  -s           The target is SMP (notes have a CPU)\n");
+  fprintf(stderr, "  -r           CONFIG_SCHED_INSTRUMENTATION_HIRES\n");
+  fprintf(stderr, "  -n           CONFIG_TASK_NAME_SIZE is zero\n");
+  fprintf(stderr, "  -p ptrsize   Size of a target pointer (default 4)\n");
+  fprintf(stderr, "  -t hz        Tick rate without -r (default 100)\n");
+  fprintf(stderr, "  -o outdir    The trace directory to create\n");
+  fprintf(stderr, "  notefile     The notes read from /dev/note\n");
+  exit(exitcode);
+}
+
+static void putle32(uint8_t *dest, uint32_t value)
+{
+  dest[0] = value & 0xff;
+  dest[1] = (value >> 8) & 0xff;
+  dest[2] = (value >> 16) & 0xff;
+  dest[3] = (value >> 24) & 0xff;
+}
+
+static uint32_t getle32(const uint8_t *src)
+{
+  return src[0] | (uint32_t)src[1] << 8 | (uint32_t)src[2] << 16 |
+         (uint32_t)src[3] << 24;
+}
+
+static int write_metadata(const char *outdir)
+{
+  char path[MAX_PATH];
+  FILE *meta;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/metadata", outdir);
+  meta = fopen(path, "w");
+  if (meta == NULL)
+    {
+      fprintf(stderr, "ERROR: Failed to open %s: %s\n", path,
+              strerror(errno));
+      return -1;
+    }
+
+  fprintf(meta, "/* CTF 1.8 */\n\n");
+  for (i = 8; i <= 64; i <<= 1)
+    {
+      fprintf(meta, "typealias integer { size = %d; align = 8; "
+              "signed = false; } := uint%d_t;\n", i, i);
+    }
+
+  fprintf(meta, "typealias integer { size = %d; align = 8; "
+          "signed = false; base = hex; } := uintptr_t;\n\n",
+          8 * g_ptrsize);
+
+  fprintf(meta, "trace {\n  major = 1;\n  minor = 8;\n"
+          "  byte_order = le;\n");
+  fprintf(meta, "  packet.header := struct {\n"
+          "    uint32_t magic;\n    uint32_t stream_id;\n"
+          "  };\n};\n\n");
+
+  fprintf(meta, "clock {\n  name = monotonic;\n  freq = %lu;\n};\n\n",
+          g_hires ? 1000000000ul : g_tickhz);
+  fprintf(meta, "typealias integer { size = %d; align = 8; "
+          "signed = false;\n  map = clock.monotonic.value; } "
+          ":= clock_t;\n\n", g_hires ? 64 : 32);
+
+  fprintf(meta, "stream {\n  id = 0;\n");
+  fprintf(meta, "  packet.context := struct {\n"
+          "    uint32_t content_size;\n    uint32_t packet_size;\n"
+          "  };\n");
+  fprintf(meta, "  event.header := struct {\n"
+          "    uint8_t length;\n    uint8_t id;\n"
+          "    uint8_t priority;\n");
+  if (g_smp)
+    {
+      fprintf(meta, "    uint8_t cpu;\n");
+    }
+
+  fprintf(meta, "    uint16_t pid;\n    clock_t timestamp;\n"
+          "  };\n};\n\n");
+
+  for (i = 0; i < NEVENTS; i++)
+    {
+      fprintf(meta, "event {\n  id = %d;\n  name = \"%s\";\n"
+              "  stream_id = 0;\n", g_events[i].id, g_events[i].name);
+      if (g_events[i].fields != NULL)
+        {
+          fprintf(meta, "  fields := struct { %s };\n",
+                  g_events[i].fields);
+        }
+
+      fprintf(meta, "};\n\n");
+    }
+
+  return fclose(meta) == 0 ? 0 : -1;
+}
+
+static int write_packet(FILE *stream, uint8_t *packet, size_t size)
+{
+  putle32(&packet[0], NOTECTF_MAGIC);
+  putle32(&packet[4], 0);
+  putle32(&packet[8], 8 * size);
+  putle32(&packet[12], 8 * size);
+
+  return fwrite(packet, 1, size, stream) == size ? 0 : -1;
+}
+
+static int write_stream(const char *outdir, FILE *notes)
+{
+  static uint8_t packet[PACKET_SIZE];
+  char path[MAX_PATH];
+  FILE *stream;
+  size_t tsoffset;
+  size_t size;
+  int nnotes = 0;
+  int ret = 0;
+  int len;
+
+  snprintf(path, sizeof(path), "%s/stream", outdir);
+  stream = fopen(path, "wb");
+  if (stream == NULL)
+    {
+      fprintf(stderr, "ERROR: Failed to open %s: %s\n", path,
+              strerror(errno));
+      return -1;
+    }
+
+  /* The time stamp follows the length, type, priority, [cpu] and pid */
+
+  tsoffset = g_smp ? 6 : 5;
+  size     = NOTECTF_HDRSIZE;
+
+  while ((len = fgetc(notes)) != EOF)
+    {
+      uint8_t *note;
+
+      if (len < tsoffset + (g_hires ? 8 : 4))
+        {
+          fprintf(stderr, "ERROR: Bad note length %d at note %d\n",
+                  len, nnotes);
+          ret = -1;
+          break;
+        }
+
+      if (size + len > PACKET_SIZE)
+        {
+          ret = write_packet(stream, packet, size);
+          if (ret < 0)
+            {
+              break;
+            }
+
+          size = NOTECTF_HDRSIZE;
+        }
+
+      note    = &packet[size];
+      note[0] = len;
+      if (fread(&note[1], 1, len - 1, notes) != len - 1)
+        {
+          fprintf(stderr, "ERROR: Truncated note %d\n", nnotes);
+          ret = -1;
+          break;
+        }
+
+      /* Make one 64-bit nanosecond clock of the seconds and nanoseconds */
+
+      if (g_hires)
+        {
+          uint64_t systime;
+
+          systime = (uint64_t)getle32(&note[tsoffset]) * 1000000000 +
+                    getle32(&note[tsoffset + 4]);
+          putle32(&note[tsoffset], (uint32_t)systime);
+          putle32(&note[tsoffset + 4], (uint32_t)(systime >> 32));
+        }
+
+      size += len;
+      nnotes++;
+    }
+
+  if (ret == 0 && size > NOTECTF_HDRSIZE)
+    {
+      ret = write_packet(stream, packet, size);
+    }
+
+  if (fclose(stream) != 0)
+    {
+      ret = -1;
+    }
+
+  if (ret == 0)
+    {
+      printf("Converted %d notes\n", nnotes);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, char **argv, char **envp)
+{
+  const char *outdir = NULL;
+  FILE *notes;
+  int ret;
+  int ch;
+
+  while ((ch = getopt(argc, argv, ":srnp:t:o:h")) > 0)
+    {
+      switch (ch)
+        {
+          case 's':
+            g_smp = true;
+            break;
+
+          case 'r':
+            g_hires = true;
+            break;
+
+          case 'n':
+            g_events[0].fields = NULL;
+            break;
+
+          case 'p':
+            g_ptrsize = atoi(optarg);
+            if (g_ptrsize != 2 && g_ptrsize != 4 && g_ptrsize != 8)
+              {
+                fprintf(stderr, "ERROR: Bad pointer size %s\n", optarg);
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+            break;
+
+          case 't':
+            g_tickhz = strtoul(optarg, NULL, 0);
+            if (g_tickhz == 0)
+              {
+                fprintf(stderr, "ERROR: Bad tick rate %s\n", optarg);
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+            break;
+
+          case 'o':
+            outdir = optarg;
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            fprintf(stderr, "ERROR: Unrecognized option\n");
+            show_usage(argv[0], EXIT_FAILURE);
+        }
+    }
+
+  if (outdir == NULL || optind != argc - 1)
+    {
+      fprintf(stderr, "ERROR: Missing output directory or note file\n");
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  /* The count of csection notes is only present in SMP configurations */
+
+  if (g_smp)
+    {
+      g_events[12].fields = "uint16_t count;";
+      g_events[13].fields = "uint16_t count;";
+    }
+
+  notes = fopen(argv[optind], "rb");
+  if (notes == NULL)
+    {
+      fprintf(stderr, "ERROR: Failed to open %s: %s\n", argv[optind],
+              strerror(errno));
+      return EXIT_FAILURE;
+    }
+
+  if (mkdir(outdir, 0777) < 0 && errno != EEXIST)
+    {
+      fprintf(stderr, "ERROR: Failed to create %s: %s\n", outdir,
+              strerror(errno));
+      fclose(notes);
+      return EXIT_FAILURE;
+    }
+
+  ret = write_metadata(outdir);
+  if (ret == 0)
+    {
+      ret = write_stream(outdir, notes);
+    }
+
+  fclose(notes);
+  return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}